@@ -3,7 +3,9 @@
 
 #include "stdafx.h"
 
-#include "../../../../include/Logger/Logger.hpp"
+#include <iostream>
+
+#include "../../../../include/async_io/logger/logger.hpp"
 
 
 
@@ -11,27 +13,31 @@
 
 int _tmain(int argc, _TCHAR* argv[])
 {
-	
-	async::iocp::IODispatcher io(2);
+	async::service::io_dispatcher_t io([](const std::string &msg)
+	{
+		std::cerr << msg << std::endl;
+	});
 
 	try
 	{
-		async::logger::LoggerPtr logger(new async::logger::Logger(io, "Test"));
-		logger->UseFile("log.txt");
+		async::logger::logger_ptr logger(new async::logger::logger_t(io, L"log.txt"));
 
-		logger->Log("Test 1");
-		logger->Log("Test 2");
-		logger->Log("Test 3");
-		logger->Log("Test 4");
-		logger->Log("Test 5");
+		logger->info("Test {}", 1);
+		logger->info("Test {}", 2);
+		logger->warn("Test {} {}", 3, "warn");
+		logger->error("Test {} {}", 4, 4.5);
+		logger->debug("Test 5");
 
+		logger->flush();
 	}
-	catch(std::exception &e)
+	catch(const exception::exception_base &e)
 	{
+		e.dump();
 		std::cout << e.what() << std::endl;
 	}
 
+	io.stop();
+
 	system("pause");
 	return 0;
 }
-
@@ -0,0 +1,220 @@
+#ifndef __ASYNC_FILE_ALIGNED_BUFFER_HPP
+#define __ASYNC_FILE_ALIGNED_BUFFER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <malloc.h>
+#include <new>
+#include <utility>
+#include <vector>
+#include <mutex>
+
+#include "../basic.hpp"
+#include "../service/exception.hpp"
+
+
+namespace async { namespace filesystem {
+
+	// ҳ룬κС
+	static const std::size_t PAGE_ALIGNMENT = 4096;
+
+
+	// -------------------------------------------------
+	// class aligned_allocator_t
+
+	// STLstd::vectorΪNO_BUFFERINGдĻ
+	template < typename T, std::size_t AlignmentT = PAGE_ALIGNMENT >
+	class aligned_allocator_t
+	{
+	public:
+		typedef T					value_type;
+		typedef T *					pointer;
+		typedef const T *			const_pointer;
+		typedef T &					reference;
+		typedef const T &			const_reference;
+		typedef std::size_t			size_type;
+		typedef std::ptrdiff_t		difference_type;
+
+		template < typename U >
+		struct rebind
+		{
+			typedef aligned_allocator_t<U, AlignmentT> other;
+		};
+
+	public:
+		aligned_allocator_t()
+		{}
+
+		template < typename U >
+		aligned_allocator_t(const aligned_allocator_t<U, AlignmentT> &)
+		{}
+
+	public:
+		pointer allocate(size_type n, const void * = 0)
+		{
+			void *p = ::_aligned_malloc(n * sizeof(T), AlignmentT);
+			if( p == 0 )
+				throw std::bad_alloc();
+
+			return static_cast<pointer>(p);
+		}
+
+		void deallocate(pointer p, size_type)
+		{
+			::_aligned_free(p);
+		}
+
+		size_type max_size() const
+		{
+			return static_cast<size_type>(-1) / sizeof(T);
+		}
+
+		template < typename U, typename... Args >
+		void construct(U *p, Args &&...args)
+		{
+			::new((void *)p) U(std::forward<Args>(args)...);
+		}
+
+		template < typename U >
+		void destroy(U *p)
+		{
+			p->~U();
+		}
+	};
+
+	template < typename T, typename U, std::size_t AlignmentT >
+	inline bool operator==(const aligned_allocator_t<T, AlignmentT> &, const aligned_allocator_t<U, AlignmentT> &)
+	{
+		return true;
+	}
+
+	template < typename T, typename U, std::size_t AlignmentT >
+	inline bool operator!=(const aligned_allocator_t<T, AlignmentT> &, const aligned_allocator_t<U, AlignmentT> &)
+	{
+		return false;
+	}
+
+
+	// -------------------------------------------------
+	// class aligned_buffer_pool_t
+
+	// 黺أһVirtualAlloc鰴ҳ룬ֱNO_BUFFERINGд
+	// lockΪtrueʱVirtualLock鳣פڴ棬൱ԤעĻдڼ䲻ҳ
+	// Ҫʧʱ˻Ϊͨڴ棬is_locked()
+	class aligned_buffer_pool_t
+	{
+		typedef std::mutex					Mutex;
+		typedef std::lock_guard<Mutex>		Lock;
+
+	private:
+		char *base_;
+		std::size_t block_size_;
+		std::uint32_t count_;
+		bool locked_;
+
+		Mutex mutex_;
+		std::vector<char *> free_;
+
+	public:
+		aligned_buffer_pool_t(std::size_t block_size, std::uint32_t count, bool lock = false)
+			: base_(nullptr)
+			, block_size_((block_size + PAGE_ALIGNMENT - 1) & ~(PAGE_ALIGNMENT - 1))
+			, count_(count)
+			, locked_(false)
+		{
+			assert(block_size != 0 && count != 0);
+
+			const std::size_t total = block_size_ * count_;
+			base_ = static_cast<char *>(::VirtualAlloc(nullptr, total, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+			if( base_ == nullptr )
+				throw service::win32_exception_t("VirtualAlloc");
+
+			if( lock )
+				locked_ = _lock(total);
+
+			free_.reserve(count_);
+			for(std::uint32_t i = count_; i != 0; --i)
+				free_.push_back(base_ + (i - 1) * block_size_);
+		}
+
+		~aligned_buffer_pool_t()
+		{
+			assert(free_.size() == count_);
+
+			if( locked_ )
+				::VirtualUnlock(base_, block_size_ * count_);
+			::VirtualFree(base_, 0, MEM_RELEASE);
+		}
+
+	private:
+		aligned_buffer_pool_t(const aligned_buffer_pool_t &);
+		aligned_buffer_pool_t &operator=(const aligned_buffer_pool_t &);
+
+	public:
+		std::size_t block_size() const
+		{
+			return block_size_;
+		}
+
+		std::uint32_t count() const
+		{
+			return count_;
+		}
+
+		bool is_locked() const
+		{
+			return locked_;
+		}
+
+		bool contains(const void *p) const
+		{
+			const char *val = static_cast<const char *>(p);
+			return val >= base_ && val < base_ + block_size_ * count_;
+		}
+
+		std::uint32_t available()
+		{
+			Lock lock(mutex_);
+			return static_cast<std::uint32_t>(free_.size());
+		}
+
+		// þʱnullptr
+		char *allocate()
+		{
+			Lock lock(mutex_);
+			if( free_.empty() )
+				return nullptr;
+
+			char *p = free_.back();
+			free_.pop_back();
+			return p;
+		}
+
+		void deallocate(char *p)
+		{
+			assert(contains(p) && (p - base_) % block_size_ == 0);
+
+			Lock lock(mutex_);
+			free_.push_back(p);
+		}
+
+	private:
+		bool _lock(std::size_t total)
+		{
+			SIZE_T min_size = 0, max_size = 0;
+			HANDLE process = ::GetCurrentProcess();
+			if( !::GetProcessWorkingSetSize(process, &min_size, &max_size) )
+				return false;
+
+			if( !::SetProcessWorkingSetSize(process, min_size + total, max_size + total) )
+				return false;
+
+			return ::VirtualLock(base_, total) == TRUE;
+		}
+	};
+}
+}
+
+
+#endif
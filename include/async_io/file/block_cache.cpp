@@ -0,0 +1,253 @@
+#include "block_cache.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+#ifdef max
+#undef max
+#endif
+
+
+namespace async { namespace filesystem {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+	}
+
+
+	block_cache_t::block_cache_t(file_engine_t &file, const block_cache_config_t &config)
+		: file_(file)
+		, config_(config)
+		, file_size_(file.size())
+		, blocks_((file_size_ + config.block_size_ - 1) / config.block_size_)
+		, shard_capacity_(0)
+		, pending_(0)
+		, hits_(0)
+		, misses_(0)
+		, joined_(0)
+		, readahead_(0)
+		, readahead_hits_(0)
+		, evictions_(0)
+		, errors_(0)
+	{
+		if( config_.block_size_ == 0 || config_.block_size_ % file_.alignment() != 0 )
+			throw service::win32_exception_t("block size not aligned", ERROR_INVALID_PARAMETER);
+
+		const std::uint32_t shards = std::max<std::uint32_t>(config_.shards_, 1);
+		shard_capacity_ = std::max<std::uint32_t>(config_.capacity_ / shards, 1);
+
+		shards_.reserve(shards);
+		for(std::uint32_t i = 0; i != shards; ++i)
+			shards_.emplace_back(new shard_t);
+	}
+
+	block_cache_t::~block_cache_t()
+	{
+		Lock lock(mutex_);
+		cond_.wait(lock, [this]() { return pending_ == 0; });
+	}
+
+	void block_cache_t::async_get(std::uint64_t index, const block_handler_type &handler, stream_t *stream)
+	{
+		if( index >= blocks_ )
+		{
+			handler(std::error_code(ERROR_HANDLE_EOF, std::system_category()), cache_block_ptr());
+			return;
+		}
+
+		cache_block_ptr block;
+		bool load = false;
+		{
+			shard_t &shard = _shard(index);
+			Lock lock(shard.mutex_);
+
+			auto iter = shard.map_.find(index);
+			if( iter != shard.map_.end() )
+			{
+				shard.lru_.splice(shard.lru_.begin(), shard.lru_, iter->second);
+
+				entry_t &entry = *iter->second;
+				block = entry.block_;
+				if( entry.prefetched_ )
+				{
+					entry.prefetched_ = false;
+					++readahead_hits_;
+				}
+			}
+			else
+			{
+				// ڶĿֻǼǻص
+				auto loading = shard.loading_.find(index);
+				load = loading == shard.loading_.end();
+				if( load )
+					shard.loading_[index].push_back(handler);
+				else
+					loading->second.push_back(handler);
+			}
+		}
+
+		if( block )
+			++hits_;
+		else if( load )
+			++misses_;
+		else
+			++joined_;
+
+		if( load )
+			_read(index, false);
+
+		// ĶȷٷԤ
+		_readahead(index, stream);
+
+		if( block )
+			handler(std::error_code(), block);
+	}
+
+	block_cache_stats_t block_cache_t::stats()
+	{
+		block_cache_stats_t stats = {0};
+		stats.hits_ = hits_;
+		stats.misses_ = misses_;
+		stats.joined_ = joined_;
+		stats.readahead_ = readahead_;
+		stats.readahead_hits_ = readahead_hits_;
+		stats.evictions_ = evictions_;
+		stats.errors_ = errors_;
+
+		std::for_each(shards_.begin(), shards_.end(), [&stats](const std::unique_ptr<shard_t> &shard)
+		{
+			Lock lock(shard->mutex_);
+			stats.blocks_ += shard->lru_.size();
+		});
+
+		return stats;
+	}
+
+	void block_cache_t::_readahead(std::uint64_t index, stream_t *stream)
+	{
+		if( stream == nullptr || config_.readahead_ == 0 )
+			return;
+
+		// Сڿ˳ͬһ飬˳
+		if( index + 1 == stream->next_ )
+			return;
+
+		if( index == stream->next_ )
+			++stream->run_;
+		else
+		{
+			stream->run_ = 1;
+			stream->ahead_ = 0;
+		}
+		stream->next_ = index + 1;
+
+		if( stream->run_ < config_.sequential_ )
+			return;
+
+		// ǰƣѷĲֲټ
+		const std::uint64_t last = std::min(index + 1 + config_.readahead_, blocks_);
+		for(std::uint64_t i = std::max(index + 1, stream->ahead_); i < last; ++i)
+		{
+			{
+				shard_t &shard = _shard(i);
+				Lock lock(shard.mutex_);
+				if( shard.map_.find(i) != shard.map_.end() || shard.loading_.find(i) != shard.loading_.end() )
+					continue;
+
+				shard.loading_[i];
+			}
+
+			++readahead_;
+			_read(i, true);
+		}
+
+		stream->ahead_ = std::max(stream->ahead_, last);
+	}
+
+	void block_cache_t::_read(std::uint64_t index, bool prefetch)
+	{
+		std::shared_ptr<cache_block_t> block = std::make_shared<cache_block_t>();
+		block->index_ = index;
+		block->size_ = 0;
+		block->data_.resize(config_.block_size_);
+
+		{
+			Lock lock(mutex_);
+			++pending_;
+		}
+
+		try
+		{
+			service::mutable_buffer_t buf(block->data_.data(), config_.block_size_);
+			file_.async_read(buf, index * config_.block_size_, [this, block, prefetch](const std::error_code &error, std::uint32_t size)
+			{
+				_on_read(block, prefetch, error, size);
+			}, callback_pool());
+		}
+		catch(const exception::exception_base &)
+		{
+			_on_read(block, prefetch, std::make_error_code(std::errc::io_error), 0);
+		}
+	}
+
+	void block_cache_t::_on_read(const std::shared_ptr<cache_block_t> &block, bool prefetch, const std::error_code &error, std::uint32_t size)
+	{
+		// ʱ֪ĳڲӦļβ
+		const std::uint64_t offset = block->index_ * config_.block_size_;
+		const std::uint32_t expected = static_cast<std::uint32_t>(std::min<std::uint64_t>(config_.block_size_, file_size_ - offset));
+		const std::error_code result = !error && size < expected ? std::make_error_code(std::errc::io_error) : error;
+		block->size_ = expected;
+
+		std::vector<block_handler_type> handlers;
+		{
+			shard_t &shard = _shard(block->index_);
+			Lock lock(shard.mutex_);
+
+			auto loading = shard.loading_.find(block->index_);
+			assert(loading != shard.loading_.end());
+			handlers.swap(loading->second);
+			shard.loading_.erase(loading);
+
+			// ʧܵĿ鲻棬´ηض
+			if( !result )
+			{
+				entry_t entry = { block, prefetch && handlers.empty() };
+				shard.lru_.push_front(entry);
+				shard.map_[block->index_] = shard.lru_.begin();
+
+				while( shard.lru_.size() > shard_capacity_ )
+				{
+					shard.map_.erase(shard.lru_.back().block_->index_);
+					shard.lru_.pop_back();
+					++evictions_;
+				}
+			}
+		}
+
+		if( result )
+			++errors_;
+
+		const cache_block_ptr val = result ? cache_block_ptr() : cache_block_ptr(block);
+		std::for_each(handlers.begin(), handlers.end(), [&result, &val](const block_handler_type &handler)
+		{
+			handler(result, val);
+		});
+
+		// ֪ͨ漴
+		Lock lock(mutex_);
+		--pending_;
+		cond_.notify_all();
+	}
+}
+}
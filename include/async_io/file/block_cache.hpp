@@ -0,0 +1,171 @@
+#ifndef __ASYNC_FILE_BLOCK_CACHE_HPP
+#define __ASYNC_FILE_BLOCK_CACHE_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <system_error>
+
+#include "file_engine.hpp"
+
+
+namespace async { namespace filesystem {
+
+	// еһ飬ֻʱֱdata_block_ptrڼ䲻ᱻͷ
+	struct cache_block_t
+	{
+		typedef std::vector<char, aligned_allocator_t<char>> buffer_t;
+
+		std::uint64_t index_;
+		std::uint32_t size_;		// Чȣļһ϶
+		buffer_t data_;
+	};
+
+	typedef std::shared_ptr<const cache_block_t> cache_block_ptr;
+
+	struct block_cache_config_t
+	{
+		std::uint32_t block_size_;		// DIRECTģʽ밴
+		std::uint32_t capacity_;		// ĿƽֵƬ
+		std::uint32_t shards_;
+		std::uint32_t readahead_;		// ˳ʱǰĿ0ΪԤ
+		std::uint32_t sequential_;		// ʶٿʼԤ
+
+		block_cache_config_t()
+			: block_size_(64 * 1024)
+			, capacity_(4096)
+			, shards_(16)
+			, readahead_(8)
+			, sequential_(2)
+		{}
+	};
+
+	struct block_cache_stats_t
+	{
+		std::uint64_t hits_;
+		std::uint64_t misses_;			// ˶
+		std::uint64_t joined_;			// ȴڶĿ
+		std::uint64_t readahead_;		// ԤĿ
+		std::uint64_t readahead_hits_;	// ԤĿ֮󱻷
+		std::uint64_t evictions_;
+		std::uint64_t errors_;
+		std::uint64_t blocks_;			// ǰĿ
+	};
+
+
+	// -------------------------------------------------
+	// class block_cache_t
+
+	// Ķ棬ŷƬÿƬһһLRUδʱfile_engine_t첽룬
+	// ͬһĲֻһΣһص˳ʰ÷ṩstream_tʶ(ÿһ)
+	// ʴﵽsequential_󱣳readahead_Ԥshared_ptr̭Կɰȫʹ
+	class block_cache_t
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+	public:
+		typedef std::function<void(const std::error_code &error, const cache_block_ptr &block)> block_handler_type;
+
+		// һ˳״ֻ̬ڸĵ߳ʹ
+		struct stream_t
+		{
+			std::uint64_t next_;		// ˳ʱһ
+			std::uint32_t run_;			// ʵĿ
+			std::uint64_t ahead_;		// ѷԤһ֮
+
+			stream_t()
+				: next_(~0ULL)
+				, run_(0)
+				, ahead_(0)
+			{}
+		};
+
+	private:
+		struct entry_t
+		{
+			std::shared_ptr<cache_block_t> block_;
+			bool prefetched_;			// Ԥδ
+		};
+
+		typedef std::list<entry_t> lru_list_t;
+
+		struct shard_t
+		{
+			Mutex mutex_;
+			lru_list_t lru_;			// ͷΪ
+			std::unordered_map<std::uint64_t, lru_list_t::iterator> map_;
+			std::unordered_map<std::uint64_t, std::vector<block_handler_type>> loading_;
+		};
+
+		file_engine_t &file_;
+		const block_cache_config_t config_;
+		const std::uint64_t file_size_;
+		const std::uint64_t blocks_;
+		std::uint32_t shard_capacity_;
+		std::vector<std::unique_ptr<shard_t>> shards_;
+
+		// δɵĶʱȴ
+		Mutex mutex_;
+		std::condition_variable cond_;
+		std::uint32_t pending_;
+
+		std::atomic<std::uint64_t> hits_;
+		std::atomic<std::uint64_t> misses_;
+		std::atomic<std::uint64_t> joined_;
+		std::atomic<std::uint64_t> readahead_;
+		std::atomic<std::uint64_t> readahead_hits_;
+		std::atomic<std::uint64_t> evictions_;
+		std::atomic<std::uint64_t> errors_;
+
+	public:
+		// ļڹʱȷ֮ı仯ɼ
+		block_cache_t(file_engine_t &file, const block_cache_config_t &config = block_cache_config_t());
+		~block_cache_t();
+
+	private:
+		block_cache_t(const block_cache_t &);
+		block_cache_t &operator=(const block_cache_t &);
+
+	public:
+		std::uint32_t block_size() const
+		{
+			return config_.block_size_;
+		}
+
+		std::uint64_t file_size() const
+		{
+			return file_size_;
+		}
+
+		std::uint64_t block_count() const
+		{
+			return blocks_;
+		}
+
+		// ʱڵֱ߳ӻصɺIO̻߳صԽʱERROR_HANDLE_EOFص
+		void async_get(std::uint64_t index, const block_handler_type &handler, stream_t *stream = nullptr);
+
+		block_cache_stats_t stats();
+
+	private:
+		shard_t &_shard(std::uint64_t index)
+		{
+			return *shards_[static_cast<std::size_t>(index % shards_.size())];
+		}
+
+		void _readahead(std::uint64_t index, stream_t *stream);
+		void _read(std::uint64_t index, bool prefetch);
+		void _on_read(const std::shared_ptr<cache_block_t> &block, bool prefetch, const std::error_code &error, std::uint32_t size);
+	};
+}
+}
+
+
+#endif
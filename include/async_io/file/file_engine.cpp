@@ -0,0 +1,165 @@
+#include "file_engine.hpp"
+
+#include <cassert>
+
+
+namespace async { namespace filesystem {
+
+	namespace
+	{
+		// ·ھ߼С
+		std::uint32_t sector_size(const std::wstring &path)
+		{
+			wchar_t volume[MAX_PATH] = {0};
+			if( !::GetVolumePathNameW(path.c_str(), volume, MAX_PATH) )
+				return PAGE_ALIGNMENT;
+
+			DWORD sectors_per_cluster = 0, bytes_per_sector = 0, free_clusters = 0, total_clusters = 0;
+			if( !::GetDiskFreeSpaceW(volume, &sectors_per_cluster, &bytes_per_sector, &free_clusters, &total_clusters) )
+				return PAGE_ALIGNMENT;
+
+			return bytes_per_sector;
+		}
+	}
+
+
+	file_engine_t::file_engine_t(dispatcher_type &io, const std::wstring &path, std::uint32_t mode)
+		: io_(io)
+		, file_(INVALID_HANDLE_VALUE)
+		, mode_(mode)
+		, alignment_(1)
+		, skip_on_success_(false)
+	{
+		DWORD access = 0;
+		if( mode & READ )
+			access |= GENERIC_READ;
+		if( mode & WRITE )
+			access |= GENERIC_WRITE;
+
+		DWORD creation = OPEN_EXISTING;
+		if( (mode & CREATE) && (mode & TRUNCATE) )
+			creation = CREATE_ALWAYS;
+		else if( mode & CREATE )
+			creation = OPEN_ALWAYS;
+		else if( mode & TRUNCATE )
+			creation = TRUNCATE_EXISTING;
+
+		DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED;
+		if( mode & DIRECT )
+			flags |= FILE_FLAG_NO_BUFFERING;
+		if( mode & WRITE_THROUGH )
+			flags |= FILE_FLAG_WRITE_THROUGH;
+		flags |= (mode & RANDOM) ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+
+		file_ = ::CreateFileW(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, creation, flags, nullptr);
+		if( file_ == INVALID_HANDLE_VALUE )
+			throw service::win32_exception_t("CreateFile");
+
+		if( mode & DIRECT )
+			alignment_ = sector_size(path);
+
+		try
+		{
+			io_.bind(file_);
+		}
+		catch(...)
+		{
+			close();
+			throw;
+		}
+
+		// ͬʱͶ֪ͨҲþϵ¼֧ʱͬ԰첽
+		skip_on_success_ = ::SetFileCompletionNotificationModes(file_,
+			FILE_SKIP_COMPLETION_PORT_ON_SUCCESS | FILE_SKIP_SET_EVENT_ON_HANDLE) == TRUE;
+	}
+
+	file_engine_t::~file_engine_t()
+	{
+		close();
+	}
+
+	std::uint64_t file_engine_t::size() const
+	{
+		LARGE_INTEGER size = {0};
+		if( !::GetFileSizeEx(file_, &size) )
+			throw service::win32_exception_t("GetFileSizeEx");
+
+		return size.QuadPart;
+	}
+
+	void file_engine_t::set_size(std::uint64_t size)
+	{
+		assert(size % alignment_ == 0);
+
+		FILE_END_OF_FILE_INFO info = {0};
+		info.EndOfFile.QuadPart = size;
+		if( !::SetFileInformationByHandle(file_, FileEndOfFileInfo, &info, sizeof(info)) )
+			throw service::win32_exception_t("SetFileInformationByHandle");
+	}
+
+	void file_engine_t::flush()
+	{
+		if( !::FlushFileBuffers(file_) )
+			throw service::win32_exception_t("FlushFileBuffers");
+	}
+
+	void file_engine_t::cancel()
+	{
+		if( is_open() )
+			::CancelIoEx(file_, nullptr);
+	}
+
+	void file_engine_t::close()
+	{
+		if( file_ != INVALID_HANDLE_VALUE )
+		{
+			::CloseHandle(file_);
+			file_ = INVALID_HANDLE_VALUE;
+		}
+	}
+
+	file_engine_t::submit_t file_engine_t::_submit(bool write, char *data, std::uint32_t length, std::uint64_t offset, OVERLAPPED *overlapped, std::uint32_t &size, std::error_code &error)
+	{
+		overlapped->Offset		= static_cast<DWORD>(offset & 0xFFFFFFFF);
+		overlapped->OffsetHigh	= static_cast<DWORD>(offset >> 32);
+
+		DWORD bytes = 0;
+		const BOOL ret = write
+			? ::WriteFile(file_, data, length, &bytes, overlapped)
+			: ::ReadFile(file_, data, length, &bytes, overlapped);
+
+		if( ret )
+		{
+			// δFILE_SKIP_COMPLETION_PORT_ON_SUCCESSʱɶ˿Իյ֪ͨ
+			if( !skip_on_success_ )
+				return SUBMIT_PENDING;
+
+			size = bytes;
+			return SUBMIT_DONE;
+		}
+
+		const DWORD err = ::GetLastError();
+		if( err == ERROR_IO_PENDING )
+			return SUBMIT_PENDING;
+
+		error = std::error_code(err, std::system_category());
+		return SUBMIT_FAILED;
+	}
+
+	void file_engine_t::_check(const void *data, std::uint32_t length, std::uint64_t offset) const
+	{
+		if( !is_open() )
+			throw service::win32_exception_t("file not open", ERROR_INVALID_HANDLE);
+
+		if( alignment_ == 1 )
+			return;
+
+		// NO_BUFFERINGҪƫơȡַ룬ReadFileERROR_INVALID_PARAMETER
+		const std::uint64_t mask = alignment_ - 1;
+		if( (offset & mask) != 0
+			|| (length & mask) != 0
+			|| (reinterpret_cast<std::uintptr_t>(data) & mask) != 0 )
+			throw service::win32_exception_t("unaligned direct file io", ERROR_INVALID_PARAMETER);
+	}
+}
+}
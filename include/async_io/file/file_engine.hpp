@@ -0,0 +1,340 @@
+#ifndef __ASYNC_FILE_FILE_ENGINE_HPP
+#define __ASYNC_FILE_FILE_ENGINE_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "../service/dispatcher.hpp"
+#include "../service/read_write_buffer.hpp"
+#include "../service/exception.hpp"
+#include "aligned_buffer.hpp"
+
+
+namespace async { namespace filesystem {
+
+	// деһɺsize_error_
+	struct file_request_t
+	{
+		std::uint64_t offset_;
+		char *data_;
+		std::uint32_t length_;
+
+		std::uint32_t size_;
+		std::error_code error_;
+	};
+
+
+	namespace detail
+	{
+		struct file_batch_base_t;
+	}
+
+
+	// -------------------------------------------------
+	// class file_engine_t
+
+	// ɶ˿ڵĶλдûļָ룬߳̿ͬʱͬһͶƫƵĶд
+	// DIRECTģʽFILE_FLAG_NO_BUFFERING򿪣ƹϵͳ棬ƫơڴַ밴alignment()룬
+	// aligned_buffer_pool_taligned_allocator_t䡣
+	// ͬʱֱڵ̻߳صɶ˿ڣдֻһΣȫɺصһ
+	class file_engine_t
+	{
+	public:
+		typedef service::io_dispatcher_t	dispatcher_type;
+
+		enum
+		{
+			READ			= 0x01,
+			WRITE			= 0x02,
+			CREATE			= 0x04,		// ʱ
+			TRUNCATE		= 0x08,		// ʱ
+			DIRECT			= 0x10,		// ϵͳ
+			WRITE_THROUGH	= 0x20,		// дֱ豸
+			RANDOM			= 0x40		// ʣرԤ
+		};
+
+	private:
+		dispatcher_type &io_;
+		HANDLE file_;
+		std::uint32_t mode_;
+		std::uint32_t alignment_;
+		bool skip_on_success_;
+
+	public:
+		file_engine_t(dispatcher_type &io, const std::wstring &path, std::uint32_t mode);
+		~file_engine_t();
+
+	private:
+		file_engine_t(const file_engine_t &);
+		file_engine_t &operator=(const file_engine_t &);
+
+	public:
+		HANDLE native_handle() const
+		{
+			return file_;
+		}
+
+		bool is_open() const
+		{
+			return file_ != INVALID_HANDLE_VALUE;
+		}
+
+		bool is_direct() const
+		{
+			return (mode_ & DIRECT) != 0;
+		}
+
+		// DIRECTģʽΪСΪ1
+		std::uint32_t alignment() const
+		{
+			return alignment_;
+		}
+
+		std::uint64_t size() const;
+		// DIRECTģʽ밴alignment()룬βͷͨģʽض
+		void set_size(std::uint64_t size);
+		void flush();
+		// ȡδɵĶдERROR_OPERATION_ABORTED
+		void cancel();
+		void close();
+
+		// 첽handler(error, size)ļβʱsizeС󳤶ȣʼƫԽļβʱԴɡsizeΪ0
+		template < typename HandlerT, typename AllocatorT >
+		void async_read(service::mutable_buffer_t &buf, std::uint64_t offset, HandlerT &&handler, AllocatorT &allocator);
+
+		template < typename HandlerT, typename AllocatorT >
+		void async_write(const service::const_buffer_t &buf, std::uint64_t offset, HandlerT &&handler, AllocatorT &allocator);
+
+		// һͶݶƫƣreqsڻصǰ뱣Чȫɺhandler(error, count)
+		// errorΪһʧĴcountΪɹÿĽfile_request_t
+		template < typename HandlerT, typename AllocatorT >
+		void async_read(file_request_t *reqs, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator);
+
+		template < typename HandlerT, typename AllocatorT >
+		void async_write(file_request_t *reqs, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator);
+
+	private:
+		enum submit_t { SUBMIT_PENDING, SUBMIT_DONE, SUBMIT_FAILED };
+		submit_t _submit(bool write, char *data, std::uint32_t length, std::uint64_t offset, OVERLAPPED *overlapped, std::uint32_t &size, std::error_code &error);
+		void _check(const void *data, std::uint32_t length, std::uint64_t offset) const;
+
+		template < typename HandlerT, typename AllocatorT >
+		void _async_single(bool write, char *data, std::uint32_t length, std::uint64_t offset, HandlerT &&handler, AllocatorT &allocator);
+
+		template < typename HandlerT, typename AllocatorT >
+		void _async_batch(bool write, file_request_t *reqs, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator);
+	};
+
+
+	namespace detail
+	{
+		// ÿһͷͬһڴУͷ
+		struct file_batch_op_t
+			: service::async_callback_base_t
+		{
+			file_batch_base_t *batch_;
+			file_request_t *req_;
+
+			virtual void invoke(const std::error_code &error, std::uint32_t size);
+			virtual void deallocate();
+		};
+
+		struct file_batch_base_t
+		{
+			file_request_t *reqs_;
+			file_batch_op_t *ops_;					// ֮
+			std::uint32_t count_;
+			std::atomic<std::uint32_t> pending_;	// δɵύڼһ
+			std::atomic<std::uint32_t> refs_;		// δͷŵύڼһ
+
+			file_batch_base_t(file_request_t *reqs, std::uint32_t count)
+				: reqs_(reqs)
+				, ops_(nullptr)
+				, count_(count)
+				, pending_(count + 1)
+				, refs_(count + 1)
+			{}
+
+			virtual ~file_batch_base_t() {}
+
+			void complete()
+			{
+				if( --pending_ != 0 )
+					return;
+
+				std::error_code error;
+				std::uint32_t succeeded = 0;
+				for(std::uint32_t i = 0; i != count_; ++i)
+				{
+					if( !reqs_[i].error_ )
+						++succeeded;
+					else if( !error )
+						error = reqs_[i].error_;
+				}
+
+				_invoke(error, succeeded);
+			}
+
+			// صһinvokeִУڴdispatcherͷźŹ黹
+			void release()
+			{
+				if( --refs_ == 0 )
+					_deallocate();
+			}
+
+			virtual void _invoke(const std::error_code &error, std::uint32_t count) = 0;
+			virtual void _deallocate() = 0;
+		};
+
+		inline void file_batch_op_t::invoke(const std::error_code &error, std::uint32_t size)
+		{
+			req_->error_ = error;
+			req_->size_ = size;
+			batch_->complete();
+		}
+
+		inline void file_batch_op_t::deallocate()
+		{
+			batch_->release();
+		}
+
+		template < typename HandlerT, typename AllocatorT >
+		struct file_batch_t
+			: file_batch_base_t
+		{
+			typedef file_batch_t<HandlerT, AllocatorT> this_t;
+
+			HandlerT handler_;
+			AllocatorT &allocator_;
+
+			file_batch_t(file_request_t *reqs, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator)
+				: file_batch_base_t(reqs, count)
+				, handler_(std::move(handler))
+				, allocator_(allocator)
+			{
+				ops_ = reinterpret_cast<file_batch_op_t *>(this + 1);
+			}
+
+			static std::size_t alloc_size(std::uint32_t count)
+			{
+				return sizeof(this_t) + count * sizeof(file_batch_op_t);
+			}
+
+			virtual void _invoke(const std::error_code &error, std::uint32_t count)
+			{
+				handler_(error, count);
+			}
+
+			virtual void _deallocate()
+			{
+				const std::size_t size = alloc_size(count_);
+				for(std::uint32_t i = 0; i != count_; ++i)
+					ops_[i].~file_batch_op_t();
+
+				char *p = reinterpret_cast<char *>(this);
+				this->~file_batch_t();
+				allocator_.deallocate(p, size);
+			}
+		};
+	}
+
+
+	template < typename HandlerT, typename AllocatorT >
+	void file_engine_t::async_read(service::mutable_buffer_t &buf, std::uint64_t offset, HandlerT &&handler, AllocatorT &allocator)
+	{
+		_async_single(false, buf.data(), static_cast<std::uint32_t>(buf.size()), offset, std::forward<HandlerT>(handler), allocator);
+	}
+
+	template < typename HandlerT, typename AllocatorT >
+	void file_engine_t::async_write(const service::const_buffer_t &buf, std::uint64_t offset, HandlerT &&handler, AllocatorT &allocator)
+	{
+		_async_single(true, const_cast<char *>(buf.data()), static_cast<std::uint32_t>(buf.size()), offset, std::forward<HandlerT>(handler), allocator);
+	}
+
+	template < typename HandlerT, typename AllocatorT >
+	void file_engine_t::async_read(file_request_t *reqs, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator)
+	{
+		_async_batch(false, reqs, count, std::forward<HandlerT>(handler), allocator);
+	}
+
+	template < typename HandlerT, typename AllocatorT >
+	void file_engine_t::async_write(file_request_t *reqs, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator)
+	{
+		_async_batch(true, reqs, count, std::forward<HandlerT>(handler), allocator);
+	}
+
+	template < typename HandlerT, typename AllocatorT >
+	void file_engine_t::_async_single(bool write, char *data, std::uint32_t length, std::uint64_t offset, HandlerT &&handler, AllocatorT &allocator)
+	{
+		_check(data, length, offset);
+
+		service::async_callback_base_ptr async_result(service::make_async_callback(std::forward<HandlerT>(handler), allocator));
+
+		std::uint32_t size = 0;
+		std::error_code error;
+		switch( _submit(write, data, length, offset, async_result.get(), size, error) )
+		{
+		case SUBMIT_PENDING:
+			async_result.release();
+			break;
+		case SUBMIT_DONE:
+			async_result->invoke(std::error_code(), size);
+			break;
+		default:
+			// ļβɴsocketһ쳣
+			if( error.value() != ERROR_HANDLE_EOF )
+				throw service::win32_exception_t(write ? "WriteFile" : "ReadFile", error.value());
+			async_result->invoke(error, 0);
+			break;
+		}
+	}
+
+	template < typename HandlerT, typename AllocatorT >
+	void file_engine_t::_async_batch(bool write, file_request_t *reqs, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator)
+	{
+		typedef detail::file_batch_t<typename std::decay<HandlerT>::type, AllocatorT> batch_t;
+
+		for(std::uint32_t i = 0; i != count; ++i)
+			_check(reqs[i].data_, reqs[i].length_, reqs[i].offset_);
+
+		batch_t *batch = reinterpret_cast<batch_t *>(allocator.allocate(batch_t::alloc_size(count)));
+		typename std::decay<HandlerT>::type handler_val(std::forward<HandlerT>(handler));
+		new(batch) batch_t(reqs, count, std::move(handler_val), allocator);
+
+		for(std::uint32_t i = 0; i != count; ++i)
+		{
+			detail::file_batch_op_t *op = new(batch->ops_ + i) detail::file_batch_op_t;
+			op->batch_ = batch;
+			op->req_ = reqs + i;
+
+			reqs[i].size_ = 0;
+			reqs[i].error_.clear();
+		}
+
+		// ύʧܵ¼󣬲Ӱ
+		for(std::uint32_t i = 0; i != count; ++i)
+		{
+			detail::file_batch_op_t *op = batch->ops_ + i;
+
+			std::uint32_t size = 0;
+			std::error_code error;
+			const submit_t ret = _submit(write, reqs[i].data_, reqs[i].length_, reqs[i].offset_, op, size, error);
+			if( ret == SUBMIT_PENDING )
+				continue;
+
+			service::async_callback_base_ptr val(op);
+			val->invoke(error, size);
+		}
+
+		// ͷύڼеļȫͬʱڴ˻ص
+		batch->complete();
+		batch->release();
+	}
+}
+}
+
+
+#endif
@@ -1,52 +1,284 @@
 #include "file_monitor.hpp"
 
+#include <cassert>
+#include <algorithm>
 
-namespace async
-{
-	namespace filesystem
+#include "../service/clock.hpp"
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+
+namespace async { namespace filesystem {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		// ͬһ·ǰα仯ϲĶ0ʾ໥
+		std::uint32_t merge_action(std::uint32_t prev, std::uint32_t next)
+		{
+			if( prev == FILE_ACTION_ADDED && next == FILE_ACTION_MODIFIED )
+				return FILE_ACTION_ADDED;
+			if( prev == FILE_ACTION_ADDED && next == FILE_ACTION_REMOVED )
+				return 0;
+			if( prev == FILE_ACTION_REMOVED && next == FILE_ACTION_ADDED )
+				return FILE_ACTION_MODIFIED;
+
+			return next;
+		}
+	}
+
+
+	change_monitor::change_monitor(dispatcher_type &io, DWORD filter)
+		: io_(io)
+		, file_(INVALID_HANDLE_VALUE)
+		, filter_(filter)
+		, sub_dir_(true)
+		, window_us_(0)
+		, deadline_id_(0)
+		, seq_(0)
+	{}
+
+	change_monitor::change_monitor(dispatcher_type &io, const std::wstring &path, DWORD filter)
+		: io_(io)
+		, file_(INVALID_HANDLE_VALUE)
+		, filter_(filter)
+		, sub_dir_(true)
+		, window_us_(0)
+		, deadline_id_(0)
+		, seq_(0)
 	{
+		open(path);
+	}
 
-		change_monitor::change_monitor(dispatcher_type &io, DWORD filter)
-			: io_(io)
-			, file_(INVALID_HANDLE_VALUE)
-			, filter_(filter)
-		{}
+	change_monitor::~change_monitor()
+	{
+		close();
+	}
 
-		change_monitor::change_monitor(dispatcher_type &io, LPCTSTR path, DWORD filter)
-			: io_(io)
-			, file_(INVALID_HANDLE_VALUE)
-			, filter_(filter)
+	void change_monitor::open(const std::wstring &path)
+	{
+		assert(!is_open());
+		if( is_open() )
+			return;
+
+		file_ = ::CreateFileW(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if( file_ == INVALID_HANDLE_VALUE )
+			throw service::win32_exception_t("CreateFile");
+
+		try
 		{
-			open(path);
+			io_.bind(file_);
 		}
-		change_monitor::~change_monitor()
+		catch(...)
 		{
 			close();
+			throw;
 		}
+	}
 
+	void change_monitor::close()
+	{
+		std::uint32_t id = 0;
+		{
+			Lock lock(mutex_);
+			std::swap(id, deadline_id_);
+			pending_.clear();
+		}
 
-		void change_monitor::open(LPCTSTR path)
+		if( id != 0 )
+			io_.remove_tick_handler(id);
+
+		if( is_open() )
 		{
-			assert(!is_open());
-			if( is_open() )
-				return;
+			::CloseHandle(file_);
+			file_ = INVALID_HANDLE_VALUE;
+		}
+	}
 
-			file_ = ::CreateFile(path,  FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-				0, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, 0);
-			if( file_ == INVALID_HANDLE_VALUE )
-				throw iocp::win32_exception("CreateFile");
+	void change_monitor::set_coalesce_window(std::uint32_t window_ms)
+	{
+		Lock lock(mutex_);
+		window_us_ = window_ms * 1000ULL;
+	}
 
-			io_.bind(file_);
+	void change_monitor::monitor(const change_handler_t &handler, bool sub_dir)
+	{
+		if( !is_open() )
+			throw service::win32_exception_t("directory not open", ERROR_INVALID_HANDLE);
+
+		handler_ = handler;
+		sub_dir_ = sub_dir;
+
+		{
+			Lock lock(mutex_);
+			if( window_us_ != 0 && deadline_id_ == 0 )
+			{
+				// صֻ߳
+				std::weak_ptr<change_monitor> weak_val = shared_from_this();
+				deadline_id_ = io_.add_deadline_handler([weak_val](std::uint64_t now_us)
+				{
+					auto this_val = weak_val.lock();
+					return this_val ? this_val->_flush(now_us) : service::io_dispatcher_t::DEADLINE_NONE;
+				});
+			}
+		}
+
+		_read();
+	}
+
+	void change_monitor::_read()
+	{
+		auto this_val = shared_from_this();
+		service::async_callback_base_ptr async_result(service::make_async_callback(
+			[this_val](const std::error_code &error, std::uint32_t size)
+		{
+			this_val->_on_change(error, size);
+		}, callback_pool()));
+
+		DWORD ret = 0;
+		if( !::ReadDirectoryChangesW(file_, &buffer_, BUFFER_LEN, sub_dir_ ? TRUE : FALSE,
+			filter_, &ret, async_result.get(), nullptr) )
+			throw service::win32_exception_t("ReadDirectoryChangesW");
+
+		async_result.release();
+	}
+
+	void change_monitor::_on_change(const std::error_code &error, std::uint32_t size)
+	{
+		if( error )
+		{
+			handler_(error, 0, std::wstring());
+			return;
+		}
+
+		// һͶݸãȡȫ֪ͨ
+		std::vector<std::pair<std::uint32_t, std::wstring>> changes;
+		if( size != 0 )
+		{
+			const char *p = reinterpret_cast<const char *>(&buffer_);
+			for(;;)
+			{
+				const FILE_NOTIFY_INFORMATION *notify = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(p);
+				changes.push_back(std::make_pair(static_cast<std::uint32_t>(notify->Action),
+					std::wstring(notify->FileName, notify->FileNameLength / sizeof(wchar_t))));
+
+				if( notify->NextEntryOffset == 0 )
+					break;
+				p += notify->NextEntryOffset;
+			}
 		}
 
-		void change_monitor::close()
+		try
 		{
 			if( is_open() )
+				_read();
+		}
+		catch(const exception::exception_base &)
+		{
+			handler_(std::make_error_code(std::errc::io_error), 0, std::wstring());
+			return;
+		}
+
+		// СΪ0˵֪̫ͨࡢŲ£ϵͳѶ
+		if( size == 0 )
+		{
+			handler_(std::error_code(ERROR_NOTIFY_ENUM_DIR, std::system_category()), 0, std::wstring());
+			return;
+		}
+
+		bool coalesce = false;
+		{
+			Lock lock(mutex_);
+			coalesce = deadline_id_ != 0;
+		}
+
+		if( coalesce )
+		{
+			_coalesce(changes);
+			return;
+		}
+
+		std::for_each(changes.begin(), changes.end(), [this](const std::pair<std::uint32_t, std::wstring> &val)
+		{
+			handler_(std::error_code(), val.first, val.second);
+		});
+	}
+
+	void change_monitor::_coalesce(const std::vector<std::pair<std::uint32_t, std::wstring>> &changes)
+	{
+		const std::uint64_t now = service::now_us();
+		std::uint64_t due = service::io_dispatcher_t::DEADLINE_NONE;
+
+		{
+			Lock lock(mutex_);
+			std::for_each(changes.begin(), changes.end(), [&](const std::pair<std::uint32_t, std::wstring> &val)
+			{
+				auto iter = pending_.find(val.second);
+				if( iter == pending_.end() )
+				{
+					pending_t entry = { val.first, now + window_us_, seq_++ };
+					pending_.insert(std::make_pair(val.second, entry));
+					due = std::min(due, entry.due_);
+					return;
+				}
+
+				// ½ɾļ֪ͨ
+				const std::uint32_t action = merge_action(iter->second.action_, val.first);
+				if( action == 0 )
+					pending_.erase(iter);
+				else
+					iter->second.action_ = action;
+			});
+		}
+
+		// еĽֹʱʱỽ
+		if( due != service::io_dispatcher_t::DEADLINE_NONE )
+			io_.wake_at(due);
+	}
+
+	std::uint64_t change_monitor::_flush(std::uint64_t now_us)
+	{
+		typedef std::pair<std::uint64_t, std::pair<std::uint32_t, std::wstring>> ready_t;
+		std::vector<ready_t> ready;
+		std::uint64_t next_due = service::io_dispatcher_t::DEADLINE_NONE;
+
+		{
+			Lock lock(mutex_);
+			for(auto iter = pending_.begin(); iter != pending_.end(); )
 			{
-				::CloseHandle(file_);
-				file_ = INVALID_HANDLE_VALUE;
+				if( iter->second.due_ > now_us )
+				{
+					next_due = std::min(next_due, iter->second.due_);
+					++iter;
+					continue;
+				}
+
+				ready.push_back(std::make_pair(iter->second.seq_, std::make_pair(iter->second.action_, iter->first)));
+				iter = pending_.erase(iter);
 			}
 		}
 
+		// һα仯Ⱥ󽻸
+		std::sort(ready.begin(), ready.end(), [](const ready_t &lhs, const ready_t &rhs)
+		{
+			return lhs.first < rhs.first;
+		});
+
+		std::for_each(ready.begin(), ready.end(), [this](const ready_t &val)
+		{
+			handler_(std::error_code(), val.second.first, val.second.second);
+		});
+
+		return next_due;
 	}
-}
\ No newline at end of file
+}
+}
@@ -1,88 +1,115 @@
 #ifndef __FILESYSTEM_FILE_CHANGE_HPP
 #define __FILESYSTEM_FILE_CHANGE_HPP
 
-#include "../iocp/dispatcher.hpp"
-#include "detail/file_change_notify_hook.hpp"
-#include "detail/file_change_callback.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <system_error>
+#include <type_traits>
+
+#include "../service/dispatcher.hpp"
+#include "../service/exception.hpp"
+
+
+namespace async { namespace filesystem {
+
+	// -------------------------------------------------
+	// class change_monitor
+
+	// Ŀ¼仯ӣReadDirectoryChangesWɶ˿ڷأÿ֪ͨͶٻص
+	// sub_dirΪtrueʱһҪĿ¼עᡣ
+	// úϲںͬһ·ڴڵĶα仯ֻصһ(縴ƴļʱĴд֪ͨ)
+	// ڴӸ·ĵһα仯𣬵ںdispatcherĽֹʱصIO߳Ͻ
+	// ֪ͨʱERROR_NOTIFY_ENUM_DIRصpathΪգҪɨĿ¼
+	class change_monitor
+		: public std::enable_shared_from_this<change_monitor>
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
 
+	public:
+		typedef service::io_dispatcher_t	dispatcher_type;
 
-namespace async
-{
+		// handler(error, action, path)actionΪFILE_ACTION_XXXpathڼĿ¼
+		typedef std::function<void(const std::error_code &, std::uint32_t, const std::wstring &)> change_handler_t;
 
-	namespace filesystem
-	{
+		static const DWORD DEFAULT_FILTER = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES |
+			FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_LAST_ACCESS |
+			FILE_NOTIFY_CHANGE_CREATION | FILE_NOTIFY_CHANGE_SECURITY;
+
+		static const std::uint32_t BUFFER_LEN = 64 * 1024;
 
-		class change_monitor
+	private:
+		struct pending_t
 		{
-			typedef iocp::io_dispatcher dispatcher_type;
-		private:
-			// File Handle
-			HANDLE file_;
-			DWORD filter_;
-
-			// IO
-			dispatcher_type &io_;
-
-		public:
-			explicit change_monitor(dispatcher_type &, 
-				DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES |
-				FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_LAST_ACCESS |
-				FILE_NOTIFY_CHANGE_CREATION | FILE_NOTIFY_CHANGE_SECURITY);
-			change_monitor(dispatcher_type &, LPCTSTR,
-				DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES |
-				FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_LAST_ACCESS |
-				FILE_NOTIFY_CHANGE_CREATION | FILE_NOTIFY_CHANGE_SECURITY);
-			~change_monitor();
-
-			// non-copyable
-		private:
-			change_monitor(const change_monitor &);
-			change_monitor &operator=(const change_monitor &);
-
-
-		public:
-			// explicitת
-			operator HANDLE()					{ return file_; }
-			operator const HANDLE () const		{ return file_; }
-
-			// ʾȡ
-			HANDLE native_handle()				{ return file_; }
-			const HANDLE native_handle() const	{ return file_; }
-
-		public:
-			void open(LPCTSTR path);
-
-			void close();
-
-			bool is_open() const
-			{
-				return file_ != INVALID_HANDLE_VALUE;
-			}
-
-		public:
-			template < typename HandlerT >
-			void monitor(const HandlerT &handler, bool sub_dir = true)
-			{
-				if( !is_open() )
-					throw iocp::win32_exception("File Path Not Valid");
-
-				typedef detail::file_change_handle_t<HandlerT> FileChangeHandleHook;
-				iocp::file_change_callback_ptr asynResult(iocp::make_async_callback(FileChangeHandleHook(*this, handler)));
-				
-				DWORD ret = 0;
-				BOOL suc = ::ReadDirectoryChangesW(file_, &asynResult->buffer_, iocp::file_change_callback::BUFFER_LEN, sub_dir ? TRUE : FALSE, 
-					filter_, &ret, asynResult.get(), 0);
-				
-				if( !suc )
-					throw iocp::win32_exception("ReadDirectoryChangesW");
-
-				asynResult.release();
-			}
+			std::uint32_t action_;
+			std::uint64_t due_;
+			std::uint64_t seq_;			// һα仯˳򣬽ʱ
 		};
-	}
+
+		// ϲе·ԭִСдϵͳһ
+		typedef std::unordered_map<std::wstring, pending_t> pending_map_t;
+
+		dispatcher_type &io_;
+		HANDLE file_;
+		DWORD filter_;
+		bool sub_dir_;
+
+		std::aligned_storage<BUFFER_LEN, sizeof(DWORD)>::type buffer_;
+		change_handler_t handler_;
+
+		Mutex mutex_;
+		std::uint64_t window_us_;
+		std::uint32_t deadline_id_;
+		pending_map_t pending_;
+		std::uint64_t seq_;
+
+	public:
+		explicit change_monitor(dispatcher_type &io, DWORD filter = DEFAULT_FILTER);
+		change_monitor(dispatcher_type &io, const std::wstring &path, DWORD filter = DEFAULT_FILTER);
+		~change_monitor();
+
+	private:
+		change_monitor(const change_monitor &);
+		change_monitor &operator=(const change_monitor &);
+
+	public:
+		HANDLE native_handle() const
+		{
+			return file_;
+		}
+
+		bool is_open() const
+		{
+			return file_ != INVALID_HANDLE_VALUE;
+		}
+
+		void open(const std::wstring &path);
+		// δɵļȡصںϲڵı仯
+		void close();
+
+		// 0Ϊϲ(Ĭ)ÿ֪ͨصmonitor֮ǰ
+		void set_coalesce_window(std::uint32_t window_ms);
+
+		// ʼӣshared_ptr
+		void monitor(const change_handler_t &handler, bool sub_dir = true);
+
+	private:
+		void _read();
+		void _on_change(const std::error_code &error, std::uint32_t size);
+		void _coalesce(const std::vector<std::pair<std::uint32_t, std::wstring>> &changes);
+		std::uint64_t _flush(std::uint64_t now_us);
+	};
+
+	typedef std::shared_ptr<change_monitor> change_monitor_ptr;
+}
 }
 
 
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,345 @@
+#include "file_pipeline.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+#include "../service/clock.hpp"
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+#ifdef max
+#undef max
+#endif
+
+
+namespace async { namespace filesystem {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		// ɶ˿ڷصļβΪSTATUS_END_OF_FILEͬصΪERROR_HANDLE_EOF
+		const int END_OF_FILE_STATUS = static_cast<int>(0xC0000011);
+
+		bool is_eof(const std::error_code &error)
+		{
+			return error.value() == ERROR_HANDLE_EOF || error.value() == END_OF_FILE_STATUS;
+		}
+	}
+
+
+	file_pipeline_t::file_pipeline_t(file_engine_t &file, std::uint32_t chunk_size, std::uint32_t depth)
+		: file_(file)
+		, chunk_size_(chunk_size)
+		, depth_(depth)
+		, buffers_(chunk_size, depth)
+		, slots_(depth)
+		, begin_(0)
+		, end_(0)
+		, chunks_(0)
+		, next_read_(0)
+		, next_stage_(0)
+		, staging_(false)
+		, pumping_(false)
+		, started_(false)
+		, finished_(false)
+		, start_us_(0)
+		, bytes_(0)
+		, in_flight_(0)
+		, ready_(0)
+		, max_ready_(0)
+		, depth_sum_(0)
+		, completions_(0)
+	{
+		if( chunk_size_ % file_.alignment() != 0 )
+			throw service::win32_exception_t("unaligned chunk size", ERROR_INVALID_PARAMETER);
+
+		for(auto &slot : slots_)
+		{
+			slot.data_ = buffers_.allocate();
+			slot.state_ = SLOT_FREE;
+			slot.index_ = 0;
+			slot.size_ = 0;
+		}
+	}
+
+	file_pipeline_t::~file_pipeline_t()
+	{
+		for(auto &slot : slots_)
+			buffers_.deallocate(slot.data_);
+	}
+
+	void file_pipeline_t::start(std::uint64_t offset, std::uint64_t length, const stage_handler_type &stage, const done_handler_type &done)
+	{
+		assert(offset % file_.alignment() == 0);
+
+		const std::uint64_t size = file_.size();
+
+		{
+			Lock lock(mutex_);
+			assert(!started_);
+
+			started_ = true;
+			stage_handler_ = stage;
+			done_handler_ = done;
+
+			begin_ = std::min<std::uint64_t>(offset, size);
+			end_ = length == ~0ULL || size - begin_ < length ? size : begin_ + length;
+			chunks_ = (end_ - begin_ + chunk_size_ - 1) / chunk_size_;
+			// ֹʱڲͬ߳϶ȡþȷʱӶǸIO̵߳
+			start_us_ = service::monotonic_us();
+		}
+
+		_issue();
+
+		// ڴֱӽ
+		_pump();
+	}
+
+	void file_pipeline_t::release()
+	{
+		{
+			Lock lock(mutex_);
+			assert(staging_);
+
+			slot_t &slot = slots_[next_stage_ % depth_];
+			assert(slot.state_ == SLOT_STAGED && slot.index_ == next_stage_);
+
+			bytes_ += slot.size_;
+			slot.state_ = SLOT_FREE;
+			staging_ = false;
+			++next_stage_;
+		}
+
+		// ڳĻһ
+		_issue();
+		_pump();
+	}
+
+	void file_pipeline_t::stop()
+	{
+		{
+			Lock lock(mutex_);
+			_fail(std::make_error_code(std::errc::operation_canceled));
+		}
+
+		_pump();
+	}
+
+	file_pipeline_stats_t file_pipeline_t::stats()
+	{
+		Lock lock(mutex_);
+		return _stats();
+	}
+
+	void file_pipeline_t::_issue()
+	{
+		// n̶ʹòn % depthۿ˵n - depthѽ
+		for(;;)
+		{
+			std::uint64_t index = 0;
+			{
+				Lock lock(mutex_);
+				if( error_ || finished_ || next_read_ >= chunks_ )
+					return;
+
+				slot_t &slot = slots_[next_read_ % depth_];
+				if( slot.state_ != SLOT_FREE )
+					return;
+
+				slot.state_ = SLOT_READING;
+				slot.index_ = next_read_;
+				slot.size_ = 0;
+				index = next_read_++;
+				++in_flight_;
+			}
+
+			_read(index);
+		}
+	}
+
+	void file_pipeline_t::_read(std::uint64_t index)
+	{
+		std::uint32_t length = 0;
+		{
+			Lock lock(mutex_);
+			length = _expected(index);
+		}
+
+		// DIRECTģʽβ鰴ȡʵʶֽɽ
+		const std::uint32_t mask = file_.alignment() - 1;
+		length = (length + mask) & ~mask;
+
+		service::mutable_buffer_t buf(slots_[index % depth_].data_, length);
+		auto this_val = shared_from_this();
+
+		try
+		{
+			file_.async_read(buf, begin_ + index * chunk_size_, [this_val, index](const std::error_code &error, std::uint32_t size)
+			{
+				this_val->_on_read(index, error, size);
+			}, callback_pool());
+		}
+		catch(const exception::exception_base &)
+		{
+			_on_read(index, std::make_error_code(std::errc::io_error), 0);
+		}
+	}
+
+	void file_pipeline_t::_on_read(std::uint64_t index, const std::error_code &error, std::uint32_t size)
+	{
+		{
+			Lock lock(mutex_);
+
+			depth_sum_ += in_flight_;
+			++completions_;
+			--in_flight_;
+
+			slot_t &slot = slots_[index % depth_];
+			assert(slot.state_ == SLOT_READING && slot.index_ == index);
+
+			if( error && !is_eof(error) )
+			{
+				_fail(error);
+				slot.state_ = SLOT_FREE;
+			}
+			else
+			{
+				// ļڴڼ䱻ض̣ĲΪһ
+				const std::uint32_t expected = _expected(index);
+				if( error || size < expected )
+					chunks_ = std::min<std::uint64_t>(chunks_, size != 0 && !error ? index + 1 : index);
+
+				if( index < chunks_ )
+				{
+					slot.size_ = std::min(size, expected);
+					slot.state_ = SLOT_READY;
+					max_ready_ = std::max(max_ready_, ++ready_);
+				}
+				else
+				{
+					slot.state_ = SLOT_FREE;
+				}
+			}
+		}
+
+		_pump();
+	}
+
+	void file_pipeline_t::_pump()
+	{
+		Lock lock(mutex_);
+
+		// ͬһʱֻһ߳̽׶ͬreleaseʱѭݹ
+		if( pumping_ )
+			return;
+
+		pumping_ = true;
+		while( !finished_ )
+		{
+			if( _finished() )
+			{
+				pumping_ = false;
+				_done(lock);
+				return;
+			}
+
+			if( staging_ || error_ || next_stage_ >= chunks_ )
+				break;
+
+			slot_t &slot = slots_[next_stage_ % depth_];
+			if( slot.state_ != SLOT_READY || slot.index_ != next_stage_ )
+				break;
+
+			slot.state_ = SLOT_STAGED;
+			staging_ = true;
+			--ready_;
+
+			const file_chunk_t chunk = { next_stage_, begin_ + next_stage_ * chunk_size_, slot.data_, slot.size_ };
+			lock.unlock();
+
+			bool failed = false;
+			try
+			{
+				stage_handler_(chunk);
+			}
+			catch(const std::exception &)
+			{
+				failed = true;
+			}
+
+			lock.lock();
+
+			// ׶׳쳣Ϊÿ飬Դ
+			if( failed && staging_ && slots_[chunk.index_ % depth_].state_ == SLOT_STAGED )
+			{
+				slots_[chunk.index_ % depth_].state_ = SLOT_FREE;
+				staging_ = false;
+				_fail(std::make_error_code(std::errc::io_error));
+			}
+		}
+
+		pumping_ = false;
+	}
+
+	std::uint32_t file_pipeline_t::_expected(std::uint64_t index) const
+	{
+		const std::uint64_t offset = begin_ + index * chunk_size_;
+		return offset >= end_ ? 0 : static_cast<std::uint32_t>(std::min<std::uint64_t>(chunk_size_, end_ - offset));
+	}
+
+	file_pipeline_stats_t file_pipeline_t::_stats() const
+	{
+		file_pipeline_stats_t stats = {0};
+		stats.bytes_ = bytes_;
+		stats.chunks_ = next_stage_;
+		stats.elapsed_us_ = started_ ? service::monotonic_us() - start_us_ : 0;
+		stats.throughput_ = stats.elapsed_us_ == 0 ? 0 : bytes_ * 1000000 / stats.elapsed_us_;
+		stats.in_flight_ = in_flight_;
+		stats.ready_ = ready_;
+		stats.max_ready_ = max_ready_;
+		stats.avg_depth_ = completions_ == 0 ? 0.0 : double(depth_sum_) / completions_;
+		return stats;
+	}
+
+	void file_pipeline_t::_fail(const std::error_code &error)
+	{
+		if( !error_ )
+			error_ = error;
+	}
+
+	bool file_pipeline_t::_finished() const
+	{
+		if( !started_ || finished_ || in_flight_ != 0 || staging_ )
+			return false;
+
+		return error_ || next_stage_ >= chunks_;
+	}
+
+	void file_pipeline_t::_done(Lock &lock)
+	{
+		finished_ = true;
+
+		const std::error_code error = error_;
+		const file_pipeline_stats_t stats = _stats();
+
+		// ͷŴ׶γеãƿܵѭ
+		done_handler_type handler;
+		std::swap(handler, done_handler_);
+		stage_handler_type stage;
+		std::swap(stage, stage_handler_);
+
+		lock.unlock();
+
+		if( handler )
+			handler(error, stats);
+	}
+}
+}
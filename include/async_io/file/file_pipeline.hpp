@@ -0,0 +1,142 @@
+#ifndef __ASYNC_FILE_FILE_PIPELINE_HPP
+#define __ASYNC_FILE_FILE_PIPELINE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <system_error>
+
+#include "file_engine.hpp"
+
+
+namespace async { namespace filesystem {
+
+	// ׶εһ
+	struct file_chunk_t
+	{
+		std::uint64_t index_;		// ţ0ʼ
+		std::uint64_t offset_;		// ļƫ
+		const char *data_;
+		std::uint32_t size_;
+	};
+
+	struct file_pipeline_stats_t
+	{
+		std::uint64_t bytes_;		// ѽ׶βͷŵֽ
+		std::uint64_t chunks_;
+		std::uint64_t elapsed_us_;
+		std::uint64_t throughput_;	// ֽ/
+		std::uint32_t in_flight_;	// ǰδɵĶ
+		std::uint32_t ready_;		// Ѷꡢȴ򽻸Ŀ
+		std::uint32_t max_ready_;
+		double avg_depth_;			// ÿζʱ;ƽֵ
+	};
+
+
+	// -------------------------------------------------
+	// class file_pipeline_t
+
+	// ļ˳ͬʱdepthĶ;Ŀ鰴ļ˳׶(У顢ѹ͵)
+	// ׶εrelease()ÿĻڶһ飬ڴ̶Ϊdepth * chunk_size
+	// ׶ͬһʱֻһ飬ͬǰreleaseҲ첽(socketд)ɺrelease
+	// stop()ٷ¶;ĶȫغԵһصdone
+	class file_pipeline_t
+		: public std::enable_shared_from_this<file_pipeline_t>
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+	public:
+		typedef std::function<void(const file_chunk_t &chunk)>										stage_handler_type;
+		typedef std::function<void(const std::error_code &error, const file_pipeline_stats_t &stats)>	done_handler_type;
+
+		static const std::uint32_t DEFAULT_CHUNK_SIZE	= 1024 * 1024;
+		static const std::uint32_t DEFAULT_DEPTH		= 8;
+
+	private:
+		enum slot_state_t { SLOT_FREE, SLOT_READING, SLOT_READY, SLOT_STAGED };
+
+		struct slot_t
+		{
+			char *data_;
+			slot_state_t state_;
+			std::uint64_t index_;
+			std::uint32_t size_;
+			std::error_code error_;
+		};
+
+		file_engine_t &file_;
+		const std::uint32_t chunk_size_;
+		const std::uint32_t depth_;
+		aligned_buffer_pool_t buffers_;
+
+		Mutex mutex_;
+		std::vector<slot_t> slots_;
+
+		std::uint64_t begin_;
+		std::uint64_t end_;
+		std::uint64_t chunks_;			// ܿļβʱ
+		std::uint64_t next_read_;
+		std::uint64_t next_stage_;
+
+		bool staging_;					// ׶γһ
+		bool pumping_;					// ߳ڽѭ
+		bool started_;
+		bool finished_;
+		std::error_code error_;
+
+		std::uint64_t start_us_;
+		std::uint64_t bytes_;
+		std::uint32_t in_flight_;
+		std::uint32_t ready_;
+		std::uint32_t max_ready_;
+		std::uint64_t depth_sum_;
+		std::uint64_t completions_;
+
+		stage_handler_type stage_handler_;
+		done_handler_type done_handler_;
+
+	public:
+		// DIRECTģʽļchunk_size밴
+		file_pipeline_t(file_engine_t &file, std::uint32_t chunk_size = DEFAULT_CHUNK_SIZE, std::uint32_t depth = DEFAULT_DEPTH);
+		~file_pipeline_t();
+
+	private:
+		file_pipeline_t(const file_pipeline_t &);
+		file_pipeline_t &operator=(const file_pipeline_t &);
+
+	public:
+		// [offset, offset + length)lengthΪ~0ʱļβֻܵһΡ
+		// DIRECTģʽoffset밴
+		void start(std::uint64_t offset, std::uint64_t length, const stage_handler_type &stage, const done_handler_type &done);
+
+		// ׶δ굱ǰ飬̵߳
+		void release();
+
+		// ٷ¶doneĴΪoperation_canceled׶γеĿrelease
+		void stop();
+
+		file_pipeline_stats_t stats();
+
+	private:
+		void _issue();
+		void _read(std::uint64_t index);
+		void _on_read(std::uint64_t index, const std::error_code &error, std::uint32_t size);
+		void _pump();
+
+		// µʱ
+		std::uint32_t _expected(std::uint64_t index) const;
+		file_pipeline_stats_t _stats() const;
+		void _fail(const std::error_code &error);
+		bool _finished() const;
+		void _done(Lock &lock);
+	};
+
+	typedef std::shared_ptr<file_pipeline_t> file_pipeline_ptr;
+}
+}
+
+
+#endif
@@ -0,0 +1,367 @@
+#include "mapped_file.hpp"
+
+#include <cassert>
+#include <memory>
+
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+// Win10 1703SDKŶ
+#ifndef FILE_MAP_LARGE_PAGES
+#define FILE_MAP_LARGE_PAGES 0x20000000
+#endif
+
+
+namespace async { namespace filesystem {
+
+	namespace {
+
+		// ɻصӳִ֮Уʹþ̬
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		// Win8PrefetchVirtualMemoryʱңûʱ˻Ϊҳ
+		struct memory_range_t
+		{
+			PVOID address_;
+			SIZE_T size_;
+		};
+
+		typedef BOOL (WINAPI *prefetch_virtual_memory_t)(HANDLE, ULONG_PTR, memory_range_t *, ULONG);
+
+		prefetch_virtual_memory_t load_prefetch()
+		{
+			HMODULE kernel = ::GetModuleHandleW(L"kernel32.dll");
+			return kernel == nullptr ? nullptr
+				: reinterpret_cast<prefetch_virtual_memory_t>(::GetProcAddress(kernel, "PrefetchVirtualMemory"));
+		}
+
+		const prefetch_virtual_memory_t prefetch_virtual_memory = load_prefetch();
+
+		bool prefetch(const char *data, std::uint64_t length)
+		{
+			if( prefetch_virtual_memory == nullptr )
+				return false;
+
+			memory_range_t range = { const_cast<char *>(data), static_cast<SIZE_T>(length) };
+			return prefetch_virtual_memory(::GetCurrentProcess(), 1, &range, 0) == TRUE;
+		}
+
+		// ÿҳһֽڴȱҳļʧʱӳ׳ṹ쳣
+		bool touch(const char *data, std::uint64_t length)
+		{
+			SYSTEM_INFO info = {0};
+			::GetSystemInfo(&info);
+
+			__try
+			{
+				volatile char val = 0;
+				for(std::uint64_t i = 0; i < length; i += info.dwPageSize)
+					val = data[i];
+				if( length != 0 )
+					val = data[length - 1];
+			}
+			__except(::GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+			{
+				return false;
+			}
+
+			return true;
+		}
+
+		// ڴҳҪȨޣûиȨʱʧ
+		bool enable_lock_memory()
+		{
+			HANDLE token = nullptr;
+			if( !::OpenProcessToken(::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token) )
+				return false;
+
+			TOKEN_PRIVILEGES privileges = {0};
+			privileges.PrivilegeCount = 1;
+			privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+			bool ret = ::LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+				&& ::AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+				&& ::GetLastError() == ERROR_SUCCESS;
+
+			::CloseHandle(token);
+			return ret;
+		}
+
+		struct prefetch_work_t
+		{
+			mapped_file_t *file_;
+			const char *data_;
+			std::uint64_t length_;
+			mapped_file_t::prefetch_handler_t handler_;
+		};
+	}
+
+
+	mapped_file_t::mapped_file_t(dispatcher_type &io, const std::wstring &path, std::uint32_t mode, std::uint64_t size)
+		: io_(io)
+		, file_(INVALID_HANDLE_VALUE)
+		, mapping_(nullptr)
+		, data_(nullptr)
+		, size_(0)
+		, mode_(mode)
+		, large_pages_(false)
+		, pending_(0)
+	{
+		try
+		{
+			if( path.empty() )
+				_open_anonymous(size);
+			else
+				_open(path, size);
+		}
+		catch(...)
+		{
+			_close();
+			throw;
+		}
+	}
+
+	mapped_file_t::~mapped_file_t()
+	{
+		{
+			Lock lock(mutex_);
+			cond_.wait(lock, [this]() { return pending_ == 0; });
+		}
+
+		_close();
+	}
+
+	service::mutable_buffer_t mapped_file_t::span(std::uint64_t offset, std::uint64_t length)
+	{
+		_check(offset, length);
+		return service::mutable_buffer_t(data_ + offset, static_cast<std::size_t>(length));
+	}
+
+	service::const_buffer_t mapped_file_t::span(std::uint64_t offset, std::uint64_t length) const
+	{
+		_check(offset, length);
+		return service::const_buffer_t(data_ + offset, static_cast<std::size_t>(length));
+	}
+
+	void mapped_file_t::flush(std::uint64_t offset, std::uint64_t length)
+	{
+		_check(offset, length);
+		if( data_ == nullptr || !is_writable() )
+			return;
+
+		if( !::FlushViewOfFile(data_ + offset, static_cast<SIZE_T>(length)) )
+			throw service::win32_exception_t("FlushViewOfFile");
+
+		// FlushViewOfFileֻύд룬̻Ҫˢļ
+		if( file_ != INVALID_HANDLE_VALUE && !::FlushFileBuffers(file_) )
+			throw service::win32_exception_t("FlushFileBuffers");
+	}
+
+	void mapped_file_t::advise(std::uint64_t offset, std::uint64_t length, advice_t advice)
+	{
+		_check(offset, length);
+		if( length == 0 )
+			length = size_ - offset;
+		if( length == 0 )
+			return;
+
+		switch( advice )
+		{
+		case WILL_NEED:
+			prefetch(data_ + offset, length);
+			break;
+		case DONT_NEED:
+			// δҳVirtualUnlockƳERROR_NOT_LOCKED
+			::VirtualUnlock(data_ + offset, static_cast<SIZE_T>(length));
+			break;
+		default:
+			assert(0);
+			break;
+		}
+	}
+
+	void mapped_file_t::_open(const std::wstring &path, std::uint64_t size)
+	{
+		DWORD access = GENERIC_READ;
+		if( mode_ & WRITE )
+			access |= GENERIC_WRITE;
+
+		DWORD flags = FILE_ATTRIBUTE_NORMAL;
+		if( mode_ & SEQUENTIAL )
+			flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+		else if( mode_ & RANDOM )
+			flags |= FILE_FLAG_RANDOM_ACCESS;
+
+		file_ = ::CreateFileW(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+			(mode_ & CREATE) ? OPEN_ALWAYS : OPEN_EXISTING, flags, nullptr);
+		if( file_ == INVALID_HANDLE_VALUE )
+			throw service::win32_exception_t("CreateFile");
+
+		LARGE_INTEGER file_size = {0};
+		if( !::GetFileSizeEx(file_, &file_size) )
+			throw service::win32_exception_t("GetFileSizeEx");
+
+		// ֻʱܳļдʱӳ䳤ȴļļ
+		size_ = static_cast<std::uint64_t>(file_size.QuadPart);
+		if( size != 0 )
+		{
+			if( size > size_ && !is_writable() )
+				throw service::win32_exception_t("mapping beyond end of read-only file", ERROR_INVALID_PARAMETER);
+			size_ = size;
+		}
+
+		// ļ޷ӳ䣬data()Ϊnullptr
+		if( size_ == 0 )
+			return;
+
+		mapping_ = ::CreateFileMappingW(file_, nullptr, is_writable() ? PAGE_READWRITE : PAGE_READONLY,
+			static_cast<DWORD>(size_ >> 32), static_cast<DWORD>(size_), nullptr);
+		if( mapping_ == nullptr )
+			throw service::win32_exception_t("CreateFileMapping");
+
+		_map(is_writable() ? FILE_MAP_WRITE : FILE_MAP_READ);
+	}
+
+	void mapped_file_t::_open_anonymous(std::uint64_t size)
+	{
+		if( size == 0 )
+			throw service::win32_exception_t("anonymous mapping needs a size", ERROR_INVALID_PARAMETER);
+
+		mode_ |= WRITE;
+		size_ = size;
+
+		// ҳӳ밴ҳС룬ύȫڴ
+		if( (mode_ & LARGE_PAGES) && enable_lock_memory() )
+		{
+			const std::uint64_t page = ::GetLargePageMinimum();
+			if( page != 0 )
+			{
+				const std::uint64_t total = (size + page - 1) / page * page;
+				mapping_ = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES,
+					static_cast<DWORD>(total >> 32), static_cast<DWORD>(total), nullptr);
+				large_pages_ = mapping_ != nullptr;
+			}
+		}
+
+		if( mapping_ == nullptr )
+		{
+			mapping_ = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+			if( mapping_ == nullptr )
+				throw service::win32_exception_t("CreateFileMapping");
+		}
+
+		_map(large_pages_ ? FILE_MAP_WRITE | FILE_MAP_LARGE_PAGES : FILE_MAP_WRITE);
+	}
+
+	void mapped_file_t::_map(DWORD access)
+	{
+		// ҳӳڣѰҳȡ
+		const SIZE_T length = large_pages_ ? 0 : static_cast<SIZE_T>(size_);
+		data_ = static_cast<char *>(::MapViewOfFile(mapping_, access, 0, 0, length));
+
+		// ϵͳʶFILE_MAP_LARGE_PAGESҳڱѾҳС
+		if( data_ == nullptr && (access & FILE_MAP_LARGE_PAGES) )
+			data_ = static_cast<char *>(::MapViewOfFile(mapping_, access & ~FILE_MAP_LARGE_PAGES, 0, 0, length));
+
+		if( data_ == nullptr )
+			throw service::win32_exception_t("MapViewOfFile");
+	}
+
+	void mapped_file_t::_close()
+	{
+		if( data_ != nullptr )
+		{
+			::UnmapViewOfFile(data_);
+			data_ = nullptr;
+		}
+
+		if( mapping_ != nullptr )
+		{
+			::CloseHandle(mapping_);
+			mapping_ = nullptr;
+		}
+
+		if( file_ != INVALID_HANDLE_VALUE )
+		{
+			::CloseHandle(file_);
+			file_ = INVALID_HANDLE_VALUE;
+		}
+	}
+
+	void mapped_file_t::_check(std::uint64_t offset, std::uint64_t length) const
+	{
+		if( offset > size_ || length > size_ - offset )
+			throw service::win32_exception_t("mapped file range out of bounds", ERROR_INVALID_PARAMETER);
+	}
+
+	void mapped_file_t::_queue_prefetch(std::uint64_t offset, std::uint64_t length, const prefetch_handler_t &handler)
+	{
+		if( length == 0 )
+			length = size_ - offset;
+
+		prefetch_work_t *work = new prefetch_work_t;
+		work->file_ = this;
+		work->data_ = data_ + offset;
+		work->length_ = length;
+		work->handler_ = handler;
+
+		{
+			Lock lock(mutex_);
+			++pending_;
+		}
+
+		// ȱҳϳʱ䣬֪̳߳߳
+		if( !::QueueUserWorkItem(&mapped_file_t::_on_prefetch, work, WT_EXECUTELONGFUNCTION) )
+		{
+			delete work;
+
+			Lock lock(mutex_);
+			--pending_;
+			cond_.notify_all();
+
+			throw service::win32_exception_t("QueueUserWorkItem");
+		}
+	}
+
+	DWORD WINAPI mapped_file_t::_on_prefetch(void *param)
+	{
+		std::unique_ptr<prefetch_work_t> work(static_cast<prefetch_work_t *>(param));
+		mapped_file_t *file = work->file_;
+
+		// һύĶҳʱڴڶ
+		prefetch(work->data_, work->length_);
+
+		std::error_code error;
+		if( !touch(work->data_, work->length_) )
+			error = std::error_code(ERROR_READ_FAULT, std::system_category());
+
+		try
+		{
+			const std::uint64_t size = error ? 0 : work->length_;
+			prefetch_handler_t handler;
+			handler.swap(work->handler_);
+
+			file->io_.post([handler, error, size](const std::error_code &, std::uint32_t)
+			{
+				handler(error, size);
+			}, callback_pool());
+		}
+		catch(::exception::exception_base &e)
+		{
+			e.dump();
+		}
+
+		work.reset();
+
+		Lock lock(file->mutex_);
+		--file->pending_;
+		file->cond_.notify_all();
+
+		return 0;
+	}
+}
+}
@@ -0,0 +1,142 @@
+#ifndef __ASYNC_FILE_MAPPED_FILE_HPP
+#define __ASYNC_FILE_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <functional>
+#include <system_error>
+
+#include "../service/dispatcher.hpp"
+#include "../service/read_write_buffer.hpp"
+#include "../service/exception.hpp"
+#include "../../utility/move_wrapper.hpp"
+
+
+namespace async { namespace filesystem {
+
+	// -------------------------------------------------
+	// class mapped_file_t
+
+	// ڴӳļļӳΪһڴ棬дڴʣȱҳļIOʺ϶дٵļ
+	// ģʽڴʱ(SEQUENTIAL/RANDOMӦϵͳԤ)Ԥȡ붪advise
+	// async_prefetch̳߳ϰڴ棬ɺdispatcherIO߳ϻص
+	// pathΪʱҳļ֧ŵӳ䣬ʱLARGE_PAGES(ҪSeLockMemoryPrivilegeʧʱ˻ͨҳ)
+	class mapped_file_t
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+	public:
+		typedef service::io_dispatcher_t	dispatcher_type;
+		typedef std::function<void(const std::error_code &, std::uint64_t)> prefetch_handler_t;
+
+		enum
+		{
+			READ			= 0x01,
+			WRITE			= 0x02,		// дӳ䣬ļ
+			CREATE			= 0x04,		// ʱ
+			SEQUENTIAL		= 0x08,		// ˳ʣӴԤ
+			RANDOM			= 0x10,		// ʣرԤ
+			LARGE_PAGES		= 0x20		// ӳ
+		};
+
+		enum advice_t
+		{
+			WILL_NEED,		// ύԤȴ
+			DONT_NEED		// Ƴ̹ҳԻд
+		};
+
+	private:
+		dispatcher_type &io_;
+		HANDLE file_;
+		HANDLE mapping_;
+		char *data_;
+		std::uint64_t size_;
+		std::uint32_t mode_;
+		bool large_pages_;
+
+		// ̳߳δɵԤȡʱȴ
+		Mutex mutex_;
+		std::condition_variable cond_;
+		std::uint32_t pending_;
+
+	public:
+		// sizeļʱ(WRITE)ļΪ0ʱӳļ
+		mapped_file_t(dispatcher_type &io, const std::wstring &path, std::uint32_t mode, std::uint64_t size = 0);
+		~mapped_file_t();
+
+	private:
+		mapped_file_t(const mapped_file_t &);
+		mapped_file_t &operator=(const mapped_file_t &);
+
+	public:
+		char *data()
+		{
+			return data_;
+		}
+
+		const char *data() const
+		{
+			return data_;
+		}
+
+		std::uint64_t size() const
+		{
+			return size_;
+		}
+
+		bool is_writable() const
+		{
+			return (mode_ & WRITE) != 0;
+		}
+
+		bool is_large_pages() const
+		{
+			return large_pages_;
+		}
+
+		// Խʱ쳣
+		service::mutable_buffer_t span(std::uint64_t offset, std::uint64_t length);
+		service::const_buffer_t span(std::uint64_t offset, std::uint64_t length) const;
+
+		// Ϊ0ʱˢӳ䣬ȴд豸
+		void flush(std::uint64_t offset = 0, std::uint64_t length = 0);
+
+		void advise(std::uint64_t offset, std::uint64_t length, advice_t advice);
+
+		// ̳߳ϰڴ棬handler(error, size)ҳʧ(ļϿ)ʱERROR_READ_FAULTص
+		// ɻصڲľ̬ͶݣallocatorֻڱεڼЧ
+		template < typename HandlerT, typename AllocatorT >
+		void async_prefetch(std::uint64_t offset, std::uint64_t length, HandlerT &&handler, AllocatorT &allocator);
+
+	private:
+		void _open(const std::wstring &path, std::uint64_t size);
+		void _open_anonymous(std::uint64_t size);
+		void _map(DWORD access);
+		void _close();
+		void _check(std::uint64_t offset, std::uint64_t length) const;
+
+		void _queue_prefetch(std::uint64_t offset, std::uint64_t length, const prefetch_handler_t &handler);
+		static DWORD WINAPI _on_prefetch(void *param);
+	};
+
+
+	template < typename HandlerT, typename AllocatorT >
+	void mapped_file_t::async_prefetch(std::uint64_t offset, std::uint64_t length, HandlerT &&handler, AllocatorT &allocator)
+	{
+		_check(offset, length);
+
+		auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
+
+		_queue_prefetch(offset, length, [handler_val](const std::error_code &error, std::uint64_t size)
+		{
+			handler_val.value_(error, size);
+		});
+	}
+}
+}
+
+
+#endif
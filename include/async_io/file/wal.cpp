@@ -0,0 +1,488 @@
+#include "wal.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <cwchar>
+#include <algorithm>
+
+#include "mapped_file.hpp"
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+#ifdef max
+#undef max
+#endif
+
+
+namespace async { namespace filesystem {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		// ¼ͷУ鸲ݡLSNȫľݲᱻ¼
+		struct record_header_t
+		{
+			std::uint32_t size_;
+			std::uint32_t crc_;
+			std::uint64_t lsn_;
+		};
+
+		std::uint32_t record_size(std::uint32_t size)
+		{
+			return static_cast<std::uint32_t>((sizeof(record_header_t) + size + 7) & ~static_cast<std::size_t>(7));
+		}
+
+		// CRC32C(Castagnoli)ڼʱ
+		struct crc_table_t
+		{
+			std::uint32_t table_[256];
+
+			crc_table_t()
+			{
+				for(std::uint32_t i = 0; i != 256; ++i)
+				{
+					std::uint32_t crc = i;
+					for(int j = 0; j != 8; ++j)
+						crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+					table_[i] = crc;
+				}
+			}
+		};
+
+		const crc_table_t crc_table;
+
+		std::uint32_t crc32c(const void *data, std::size_t size, std::uint32_t crc = 0)
+		{
+			const unsigned char *p = static_cast<const unsigned char *>(data);
+
+			crc = ~crc;
+			for(std::size_t i = 0; i != size; ++i)
+				crc = crc_table.table_[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+
+			return ~crc;
+		}
+
+		std::uint32_t record_crc(std::uint32_t data_crc, std::uint32_t size, std::uint64_t lsn)
+		{
+			const std::uint32_t crc = crc32c(&size, sizeof(size), data_crc);
+			return crc32c(&lsn, sizeof(lsn), crc);
+		}
+
+		// յ黺
+		const std::size_t MAX_FREE_GROUPS = 4;
+	}
+
+
+	wal_t::wal_t(dispatcher_type &io, const std::wstring &dir, const wal_config_t &config)
+		: io_(io)
+		, dir_(dir)
+		, config_(config)
+		, alignment_(1)
+		, next_lsn_(0)
+		, tail_lsn_(0)
+		, writing_(false)
+		, pumping_(false)
+		, current_segment_(0)
+		, records_(0)
+		, groups_written_(0)
+		, bytes_(0)
+		, segments_created_(0)
+		, durable_lsn_(0)
+	{
+		if( !::CreateDirectoryW(dir_.c_str(), nullptr) && ::GetLastError() != ERROR_ALREADY_EXISTS )
+			throw service::win32_exception_t("CreateDirectory");
+
+		// еĶΰʼLSN
+		WIN32_FIND_DATAW data = {0};
+		HANDLE find = ::FindFirstFileW((dir_ + L"\\*.wal").c_str(), &data);
+		if( find != INVALID_HANDLE_VALUE )
+		{
+			do
+			{
+				wchar_t *end = nullptr;
+				const std::uint64_t segment = ::_wcstoui64(data.cFileName, &end, 16);
+				if( end != data.cFileName + 16 || ::_wcsicmp(end, L".wal") != 0 )
+					continue;
+
+				const std::uint64_t size = (static_cast<std::uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+				existing_.push_back(std::make_pair(segment, size));
+			} while( ::FindNextFileW(find, &data) );
+
+			::FindClose(find);
+		}
+		std::sort(existing_.begin(), existing_.end());
+
+		// ¼¼һ֮¶οʼٸдеĶ
+		std::for_each(existing_.begin(), existing_.end(), [this](const std::pair<std::uint64_t, std::uint64_t> &val)
+		{
+			segments_.push_back(val.first);
+			next_lsn_ = std::max(next_lsn_, val.first + val.second);
+		});
+		next_lsn_ = (next_lsn_ + config_.segment_size_ - 1) / config_.segment_size_ * config_.segment_size_;
+		durable_lsn_ = next_lsn_;
+		tail_lsn_ = next_lsn_;
+
+		// СԵһڵľΪ׼
+		current_segment_ = next_lsn_;
+		current_ = _create(current_segment_);
+		alignment_ = current_->alignment();
+		tail_.assign(alignment_, 0);
+
+		segments_.push_back(current_segment_);
+		++segments_created_;
+	}
+
+	wal_t::~wal_t()
+	{
+		Lock lock(mutex_);
+		cond_.wait(lock, [this]() { return groups_.empty() && !writing_ && !pumping_; });
+	}
+
+	std::uint64_t wal_t::append(const void *data, std::uint32_t size, const commit_handler_type &handler)
+	{
+		if( size > config_.segment_size_ - sizeof(record_header_t) - 8 )
+			throw service::win32_exception_t("wal record too large", ERROR_INVALID_PARAMETER);
+
+		const std::uint32_t total = record_size(size);
+
+		// ݵУ
+		const std::uint32_t data_crc = crc32c(data, size);
+
+		Lock lock(mutex_);
+		if( error_ )
+			throw service::win32_exception_t("wal write failed", error_.value());
+
+		std::uint64_t segment = next_lsn_ - next_lsn_ % config_.segment_size_;
+		std::uint64_t offset = next_lsn_ - segment;
+		if( offset + total > config_.segment_size_ )
+		{
+			segment += config_.segment_size_;
+			offset = 0;
+		}
+
+		// λʱյǰ飬βյ˳򴫵
+		group_t *group = groups_.empty() ? nullptr : groups_.back().get();
+		if( group != nullptr && !group->closed_ && !group->waiters_.empty()
+			&& (group->segment_ != segment || group->data_.size() + total > config_.group_size_) )
+			_close(group);
+
+		if( group == nullptr || group->closed_ )
+			group = _group(segment, offset);
+
+		const std::uint64_t lsn = segment + offset;
+		const record_header_t header = { size, record_crc(data_crc, size, lsn), lsn };
+
+		const std::size_t pos = group->data_.size();
+		group->data_.resize(pos + total);
+		std::memcpy(group->data_.data() + pos, &header, sizeof(header));
+		std::memcpy(group->data_.data() + pos + sizeof(header), data, size);
+
+		group->waiters_.resize(group->waiters_.size() + 1);
+		group->waiters_.back().lsn_ = lsn;
+		group->waiters_.back().handler_ = handler;
+		group->end_lsn_ = lsn + total;
+		next_lsn_ = lsn + total;
+
+		// д;ʱֻ飬дɺύ
+		if( writing_ || pumping_ )
+			return lsn;
+
+		pumping_ = true;
+		_pump(lock);
+
+		return lsn;
+	}
+
+	void wal_t::flush()
+	{
+		Lock lock(mutex_);
+		const std::uint64_t target = groups_.empty() ? 0 : groups_.back()->end_lsn_;
+		cond_.wait(lock, [this, target]() { return error_ || durable_lsn_ >= target; });
+
+		if( error_ )
+			throw service::win32_exception_t("wal write failed", error_.value());
+	}
+
+	void wal_t::replay(const replay_handler_type &handler)
+	{
+		std::vector<std::pair<std::uint64_t, std::uint64_t>> segments;
+		{
+			Lock lock(mutex_);
+			segments = existing_;
+		}
+
+		std::for_each(segments.begin(), segments.end(), [this, &handler](const std::pair<std::uint64_t, std::uint64_t> &val)
+		{
+			if( val.second < sizeof(record_header_t) )
+				return;
+
+			mapped_file_t file(io_, _path(val.first), mapped_file_t::READ | mapped_file_t::SEQUENTIAL);
+			const char *data = file.data();
+
+			for(std::uint64_t pos = 0; pos + sizeof(record_header_t) <= file.size(); )
+			{
+				record_header_t header = {0};
+				std::memcpy(&header, data + pos, sizeof(header));
+
+				if( header.lsn_ != val.first + pos || header.size_ > file.size() - pos - sizeof(header) )
+					break;
+
+				const char *payload = data + pos + sizeof(header);
+				if( record_crc(crc32c(payload, header.size_), header.size_, header.lsn_) != header.crc_ )
+					break;
+
+				handler(header.lsn_, payload, header.size_);
+				pos += record_size(header.size_);
+			}
+		});
+	}
+
+	void wal_t::remove_before(std::uint64_t lsn)
+	{
+		std::vector<std::uint64_t> removed;
+		{
+			Lock lock(mutex_);
+			lsn = std::min(lsn, durable_lsn_);
+
+			// һдʼձ
+			while( segments_.size() > 1 && segments_[1] <= lsn )
+			{
+				removed.push_back(segments_.front());
+				segments_.pop_front();
+			}
+
+			existing_.erase(std::remove_if(existing_.begin(), existing_.end(), [&removed](const std::pair<std::uint64_t, std::uint64_t> &val)
+			{
+				return std::find(removed.begin(), removed.end(), val.first) != removed.end();
+			}), existing_.end());
+		}
+
+		std::for_each(removed.begin(), removed.end(), [this](std::uint64_t segment)
+		{
+			::DeleteFileW(_path(segment).c_str());
+		});
+	}
+
+	std::uint64_t wal_t::durable_lsn()
+	{
+		Lock lock(mutex_);
+		return durable_lsn_;
+	}
+
+	wal_stats_t wal_t::stats()
+	{
+		Lock lock(mutex_);
+		const wal_stats_t stats = { records_, groups_written_, bytes_, segments_created_, durable_lsn_ };
+		return stats;
+	}
+
+	void wal_t::_pump(Lock &lock)
+	{
+		// ͬһʱֻһддǰļ¼һ
+		while( !writing_ && !groups_.empty() )
+		{
+			group_t *group = groups_.front().get();
+			if( !group->closed_ )
+				_close(group);
+
+			const std::error_code error = error_;
+			writing_ = true;
+			lock.unlock();
+
+			_write(group, error);
+
+			// д;ʱ׼һΣʱصȴļ
+			if( !spare_ && !error )
+			{
+				try
+				{
+					spare_ = _create(current_segment_ + config_.segment_size_);
+				}
+				catch(const exception::exception_base &)
+				{
+					// ʱԣʧٱ
+				}
+			}
+
+			lock.lock();
+		}
+
+		pumping_ = false;
+		cond_.notify_all();
+	}
+
+	void wal_t::_write(group_t *group, const std::error_code &error)
+	{
+		// ֮ǰдʧܣ鲻д
+		if( error )
+		{
+			_on_write(error);
+			return;
+		}
+
+		try
+		{
+			file_engine_t *file = _segment(group->segment_);
+			const std::uint32_t length = static_cast<std::uint32_t>(group->data_.size());
+
+			service::const_buffer_t buf(group->data_.data(), length);
+			file->async_write(buf, group->offset_, [this, length](const std::error_code &error, std::uint32_t size)
+			{
+				_on_write(!error && size != length ? std::make_error_code(std::errc::io_error) : error);
+			}, callback_pool());
+		}
+		catch(const exception::exception_base &)
+		{
+			_on_write(std::make_error_code(std::errc::io_error));
+		}
+	}
+
+	void wal_t::_on_write(const std::error_code &error)
+	{
+		group_t *group = nullptr;
+		{
+			Lock lock(mutex_);
+			group = groups_.front().get();
+
+			if( error )
+			{
+				if( !error_ )
+					error_ = error;
+			}
+			else
+			{
+				durable_lsn_ = group->end_lsn_;
+				records_ += group->waiters_.size();
+				bytes_ += group->data_.size();
+				++groups_written_;
+			}
+		}
+
+		// صڼwriting_Ϊtrueһ鲻ῪʼĻصLSN˳
+		std::for_each(group->waiters_.begin(), group->waiters_.end(), [&error](const waiter_t &waiter)
+		{
+			waiter.handler_(error, waiter.lsn_);
+		});
+		group->waiters_.clear();
+
+		Lock lock(mutex_);
+		if( free_.size() < MAX_FREE_GROUPS )
+			free_.push_back(std::move(groups_.front()));
+		groups_.pop_front();
+
+		writing_ = false;
+		cond_.notify_all();
+
+		if( pumping_ || groups_.empty() )
+			return;
+
+		pumping_ = true;
+		_pump(lock);
+	}
+
+	file_engine_t *wal_t::_segment(std::uint64_t segment)
+	{
+		if( segment == current_segment_ )
+			return current_.get();
+
+		// ¼ΣһֻһΣǰһεдȫɣԹر
+		assert(segment == current_segment_ + config_.segment_size_);
+
+		file_ptr file = spare_ ? std::move(spare_) : _create(segment);
+		current_ = std::move(file);
+		current_segment_ = segment;
+
+		Lock lock(mutex_);
+		segments_.push_back(segment);
+		++segments_created_;
+
+		return current_.get();
+	}
+
+	wal_t::file_ptr wal_t::_create(std::uint64_t segment)
+	{
+		file_ptr file(new file_engine_t(io_, _path(segment), file_engine_t::WRITE | file_engine_t::CREATE
+			| file_engine_t::DIRECT | file_engine_t::WRITE_THROUGH));
+
+		if( config_.segment_size_ % file->alignment() != 0 )
+			throw service::win32_exception_t("wal segment size not aligned", ERROR_INVALID_PARAMETER);
+
+		// Ԥοռ䲢ļȣ֮дļڣչļͬ
+		FILE_ALLOCATION_INFO alloc = {0};
+		alloc.AllocationSize.QuadPart = config_.segment_size_;
+		if( !::SetFileInformationByHandle(file->native_handle(), FileAllocationInfo, &alloc, sizeof(alloc)) )
+			throw service::win32_exception_t("SetFileInformationByHandle");
+
+		file->set_size(config_.segment_size_);
+
+		// SE_MANAGE_VOLUME_NAMEȨʱϵͳ㣻ûʱдЧ֮ϵͳ㣬ͬ
+		::SetFileValidData(file->native_handle(), config_.segment_size_);
+
+		return file;
+	}
+
+	std::wstring wal_t::_path(std::uint64_t segment) const
+	{
+		wchar_t name[32] = {0};
+		::swprintf_s(name, _countof(name), L"%016I64x.wal", segment);
+		return dir_ + L"\\" + name;
+	}
+
+	wal_t::group_t *wal_t::_group(std::uint64_t segment, std::uint64_t offset)
+	{
+		group_ptr group;
+		if( !free_.empty() )
+		{
+			group = std::move(free_.back());
+			free_.pop_back();
+		}
+		else
+		{
+			group.reset(new group_t);
+			group->data_.reserve(config_.group_size_ + alignment_);
+		}
+
+		const std::uint64_t begin = offset & ~static_cast<std::uint64_t>(alignment_ - 1);
+		group->segment_ = segment;
+		group->offset_ = begin;
+		group->end_lsn_ = segment + offset;
+		group->closed_ = false;
+		group->data_.clear();
+		group->waiters_.clear();
+
+		// һ鹲õдһд
+		if( begin != offset )
+		{
+			assert(tail_lsn_ == segment + begin);
+			group->data_.assign(tail_.begin(), tail_.begin() + static_cast<std::size_t>(offset - begin));
+		}
+
+		groups_.push_back(std::move(group));
+		return groups_.back().get();
+	}
+
+	void wal_t::_close(group_t *group)
+	{
+		const std::size_t size = group->data_.size();
+		const std::size_t length = (size + alignment_ - 1) & ~static_cast<std::size_t>(alignment_ - 1);
+		group->data_.resize(length, 0);
+		group->closed_ = true;
+
+		// һûдһ￪ʼ
+		if( size != length )
+		{
+			const std::size_t last = length - alignment_;
+			std::copy(group->data_.begin() + last, group->data_.end(), tail_.begin());
+			tail_lsn_ = group->segment_ + group->offset_ + last;
+		}
+	}
+}
+}
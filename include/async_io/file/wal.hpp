@@ -0,0 +1,157 @@
+#ifndef __ASYNC_FILE_WAL_HPP
+#define __ASYNC_FILE_WAL_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <system_error>
+
+#include "file_engine.hpp"
+
+
+namespace async { namespace filesystem {
+
+	struct wal_config_t
+	{
+		std::uint32_t segment_size_;	// ļȣʱԤ䣬밴
+		std::uint32_t group_size_;		// һд
+
+		wal_config_t()
+			: segment_size_(64 * 1024 * 1024)
+			, group_size_(1024 * 1024)
+		{}
+	};
+
+	struct wal_stats_t
+	{
+		std::uint64_t records_;			// ̵ļ¼
+		std::uint64_t groups_;			// д
+		std::uint64_t bytes_;			// дֽдβ
+		std::uint64_t segments_;		// ùĶ
+		std::uint64_t durable_lsn_;		// ֮ǰļ¼
+	};
+
+
+	// -------------------------------------------------
+	// class wal_t
+
+	// Ԥд־߳ͬʱ׷ӣ¼Ƚ빲黺һдɺһд룬ڵĵȴһԸԵLSNص
+	// ļNO_BUFFERING | WRITE_THROUGH򿪣дɼѵ豸ˢ̣õ֮ǰԤռ䣬д벻չļ
+	// LSNΪ¼־еֽƫƣļʼLSN¼ΣβŲʱһοʼ
+	// صIO߳ϰLSN˳ִУдͬʱ׷ӵִ߳УصвӦ쳣дʧܺ־ٿã֮append쳣
+	class wal_t
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+		typedef std::vector<char, aligned_allocator_t<char>> buffer_t;
+
+	public:
+		typedef service::io_dispatcher_t	dispatcher_type;
+
+		typedef std::function<void(const std::error_code &error, std::uint64_t lsn)>			commit_handler_type;
+		typedef std::function<void(std::uint64_t lsn, const char *data, std::uint32_t size)>	replay_handler_type;
+
+	private:
+		struct waiter_t
+		{
+			std::uint64_t lsn_;
+			commit_handler_type handler_;
+		};
+
+		// һд룬߽翪ʼͷһһе
+		struct group_t
+		{
+			std::uint64_t segment_;		// εʼLSN
+			std::uint64_t offset_;		// дƫ
+			std::uint64_t end_lsn_;
+			buffer_t data_;
+			std::vector<waiter_t> waiters_;
+			bool closed_;				// ׷ӣdata_Ѳ뵽
+		};
+
+		typedef std::unique_ptr<group_t>		group_ptr;
+		typedef std::unique_ptr<file_engine_t>	file_ptr;
+
+		dispatcher_type &io_;
+		const std::wstring dir_;
+		const wal_config_t config_;
+		std::uint32_t alignment_;
+
+		// ʱеĶΣreplay
+		std::vector<std::pair<std::uint64_t, std::uint64_t>> existing_;
+
+		Mutex mutex_;
+		std::condition_variable cond_;
+		std::uint64_t next_lsn_;
+		std::deque<group_ptr> groups_;			// ׿д
+		std::vector<group_ptr> free_;
+		buffer_t tail_;							// һβ
+		std::uint64_t tail_lsn_;				// tail_־еλ
+		std::deque<std::uint64_t> segments_;	// ϵĶΣLSN
+		bool writing_;
+		bool pumping_;
+		std::error_code error_;
+
+		// ֻɳpumping_̷߳
+		file_ptr current_;
+		std::uint64_t current_segment_;
+		file_ptr spare_;						// Ԥȴһ
+
+		std::uint64_t records_;
+		std::uint64_t groups_written_;
+		std::uint64_t bytes_;
+		std::uint64_t segments_created_;
+		std::uint64_t durable_lsn_;
+
+	public:
+		// dirʱжʱһ֮¶οʼ׷
+		wal_t(dispatcher_type &io, const std::wstring &dir, const wal_config_t &config = wal_config_t());
+		// ȴȫ¼
+		~wal_t();
+
+	private:
+		wal_t(const wal_t &);
+		wal_t &operator=(const wal_t &);
+
+	public:
+		// ׷һ¼LSN̺handler(error, lsn)dataڷǰѿ
+		std::uint64_t append(const void *data, std::uint32_t size, const commit_handler_type &handler);
+
+		// ǰ׷ӵļ¼ȫ
+		void flush();
+
+		// ζʱеļ¼ȱļ¼תһ
+		void replay(const replay_handler_type &handler);
+
+		// ɾ¼СlsnĶΣlsn̵λʱ̴
+		void remove_before(std::uint64_t lsn);
+
+		std::uint64_t durable_lsn();
+
+		wal_stats_t stats();
+
+	private:
+		void _write(group_t *group, const std::error_code &error);
+		void _on_write(const std::error_code &error);
+		file_engine_t *_segment(std::uint64_t segment);
+		file_ptr _create(std::uint64_t segment);
+		std::wstring _path(std::uint64_t segment) const;
+
+		// µʱ
+		void _pump(Lock &lock);
+		group_t *_group(std::uint64_t segment, std::uint64_t offset);
+		void _close(group_t *group);
+	};
+
+	typedef std::shared_ptr<wal_t> wal_ptr;
+}
+}
+
+
+#endif
@@ -0,0 +1,558 @@
+#include "http_parser.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include <emmintrin.h>
+#include <intrin.h>
+
+#ifdef min
+#undef min
+#endif
+
+
+namespace async { namespace http {
+
+	namespace {
+
+		inline char to_lower(char c)
+		{
+			return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+		}
+
+		inline bool is_ows(char c)
+		{
+			return c == ' ' || c == '\t';
+		}
+
+		inline bool is_digit(char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		// һַ(0x00-0x1F0x7F)λãûзlastÿαȽ16ֽ
+		const char *find_ctl(const char *first, const char *last)
+		{
+			const __m128i limit = _mm_set1_epi8(0x1F);
+			const __m128i del = _mm_set1_epi8(0x7F);
+
+			while( last - first >= 16 )
+			{
+				const __m128i val = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+				const __m128i ctl = _mm_or_si128(
+					_mm_cmpeq_epi8(_mm_min_epu8(val, limit), val),
+					_mm_cmpeq_epi8(val, del));
+
+				const int mask = _mm_movemask_epi8(ctl);
+				if( mask != 0 )
+				{
+					unsigned long idx = 0;
+					_BitScanForward(&idx, static_cast<unsigned long>(mask));
+					return first + idx;
+				}
+
+				first += 16;
+			}
+
+			while( first != last )
+			{
+				const unsigned char c = static_cast<unsigned char>(*first);
+				if( c <= 0x1F || c == 0x7F )
+					break;
+				++first;
+			}
+
+			return first;
+		}
+
+		// β'\n'λãݲ㷵last\tĿַ\rnullptr
+		const char *find_eol(const char *first, const char *last)
+		{
+			for(;;)
+			{
+				const char *pos = find_ctl(first, last);
+				if( pos == last || *pos == '\n' )
+					return pos;
+
+				if( *pos == '\r' )
+				{
+					if( pos + 1 == last )
+						return last;
+					return pos[1] == '\n' ? pos + 1 : nullptr;
+				}
+
+				if( *pos != '\t' )
+					return nullptr;
+
+				first = pos + 1;
+			}
+		}
+
+		bool parse_length(const char *first, const char *last, std::uint64_t &val)
+		{
+			if( first == last || last - first > 18 )
+				return false;
+
+			val = 0;
+			for(; first != last; ++first)
+			{
+				if( !is_digit(*first) )
+					return false;
+				val = val * 10 + (*first - '0');
+			}
+
+			return true;
+		}
+	}
+
+
+	bool equals(const view_t &lhs, const char *rhs)
+	{
+		const std::size_t len = std::strlen(rhs);
+		if( lhs.size() != len )
+			return false;
+
+		for(std::size_t i = 0; i != len; ++i)
+		{
+			if( to_lower(lhs.data()[i]) != to_lower(rhs[i]) )
+				return false;
+		}
+
+		return true;
+	}
+
+	bool has_token(const view_t &list, const char *token)
+	{
+		const char *cur = list.begin();
+		const char *const last = list.end();
+
+		while( cur != last )
+		{
+			const char *comma = std::find(cur, last, ',');
+
+			const char *first = cur;
+			const char *end = comma;
+			while( first != end && is_ows(*first) )
+				++first;
+			while( end != first && is_ows(end[-1]) )
+				--end;
+
+			if( equals(view_t(first, end - first), token) )
+				return true;
+
+			cur = comma == last ? last : comma + 1;
+		}
+
+		return false;
+	}
+
+
+	view_t request_t::header(const char *name) const
+	{
+		for(auto iter = headers_.begin(); iter != headers_.end(); ++iter)
+		{
+			if( equals(iter->name_, name) )
+				return iter->value_;
+		}
+
+		return view_t();
+	}
+
+	bool request_t::is_method(const char *method) const
+	{
+		// ִСд
+		const std::size_t len = std::strlen(method);
+		return method_.size() == len && std::memcmp(method_.data(), method, len) == 0;
+	}
+
+
+	request_parser_t::request_parser_t(std::uint32_t max_header, std::uint32_t max_body)
+		: max_header_(max_header)
+		, max_body_(max_body)
+	{
+		reset();
+	}
+
+	void request_parser_t::reset()
+	{
+		state_ = REQUEST_LINE;
+		pos_ = 0;
+		status_ = 0;
+
+		method_.offset_ = method_.size_ = 0;
+		uri_.offset_ = uri_.size_ = 0;
+		version_major_ = 1;
+		version_minor_ = 1;
+		headers_.clear();
+
+		chunked_ = false;
+		keep_alive_ = true;
+		has_length_ = false;
+		content_length_ = 0;
+
+		body_start_ = 0;
+		body_end_ = 0;
+		chunk_left_ = 0;
+	}
+
+	request_parser_t::result_t request_parser_t::parse(char *data, std::size_t len, request_t &req, std::size_t &consumed)
+	{
+		assert(len < 0xFFFFFFFF);
+		const std::uint32_t size = static_cast<std::uint32_t>(len);
+
+		result_t ret = PARSE_MORE;
+		if( state_ == REQUEST_LINE || state_ == HEADER_LINE )
+		{
+			ret = _parse_headers(data, size);
+			if( ret != PARSE_DONE )
+				return ret;
+		}
+
+		if( state_ == BODY )
+			ret = _parse_body(data, size);
+		else if( state_ != DONE )
+			ret = _parse_chunked(data, size);
+
+		if( state_ != DONE )
+			return ret;
+
+		_fill(data, req);
+		consumed = pos_;
+
+		return PARSE_DONE;
+	}
+
+	request_parser_t::result_t request_parser_t::_parse_headers(char *data, std::uint32_t len)
+	{
+		// δɵ´δɨ裬ɵвɨ
+		for(;;)
+		{
+			const char *eol = find_eol(data + pos_, data + len);
+			if( eol == nullptr )
+				return _error(400);
+
+			if( eol == data + len )
+				return len > max_header_ ? _error(431) : PARSE_MORE;
+
+			const std::uint32_t next = static_cast<std::uint32_t>(eol - data) + 1;
+			if( next > max_header_ )
+				return _error(431);
+
+			std::uint32_t last = next - 1;
+			if( last != pos_ && data[last - 1] == '\r' )
+				--last;
+
+			if( state_ == REQUEST_LINE )
+			{
+				// ǰĿ
+				if( last != pos_ && !_request_line(data, pos_, last) )
+					return PARSE_ERROR;
+
+				if( last != pos_ )
+					state_ = HEADER_LINE;
+			}
+			else if( last == pos_ )
+			{
+				pos_ = next;
+				return _headers_done() ? PARSE_DONE : PARSE_ERROR;
+			}
+			else if( !_header_line(data, pos_, last) )
+				return PARSE_ERROR;
+
+			pos_ = next;
+		}
+	}
+
+	request_parser_t::result_t request_parser_t::_parse_body(char *, std::uint32_t len)
+	{
+		if( len - body_start_ < content_length_ )
+			return PARSE_MORE;
+
+		body_end_ = body_start_ + static_cast<std::uint32_t>(content_length_);
+		pos_ = body_end_;
+		state_ = DONE;
+
+		return PARSE_DONE;
+	}
+
+	request_parser_t::result_t request_parser_t::_parse_chunked(char *data, std::uint32_t len)
+	{
+		for(;;)
+		{
+			switch( state_ )
+			{
+			case CHUNK_SIZE:
+				{
+					const char *eol = find_eol(data + pos_, data + len);
+					if( eol == nullptr )
+						return _error(400);
+					if( eol == data + len )
+						return len - pos_ > 1024 ? _error(400) : PARSE_MORE;
+
+					// ʮƳȣchunkչ
+					std::uint64_t size = 0;
+					std::uint32_t digits = 0;
+					for(const char *cur = data + pos_; cur != eol; ++cur, ++digits)
+					{
+						const char c = to_lower(*cur);
+						if( is_digit(c) )
+							size = (size << 4) | (c - '0');
+						else if( c >= 'a' && c <= 'f' )
+							size = (size << 4) | (c - 'a' + 10);
+						else
+							break;
+					}
+
+					if( digits == 0 || digits > 15 )
+						return _error(400);
+
+					pos_ = static_cast<std::uint32_t>(eol - data) + 1;
+					chunk_left_ = size;
+
+					if( size == 0 )
+						state_ = CHUNK_TRAILER;
+					else if( body_end_ - body_start_ + size > max_body_ )
+						return _error(413);
+					else
+						state_ = CHUNK_DATA;
+				}
+				break;
+
+			case CHUNK_DATA:
+				{
+					const std::uint32_t cnt = static_cast<std::uint32_t>(std::min<std::uint64_t>(chunk_left_, len - pos_));
+					if( cnt == 0 )
+						return PARSE_MORE;
+
+					// ȥֿͷǰƴӳ
+					if( body_end_ != pos_ )
+						std::memmove(data + body_end_, data + pos_, cnt);
+
+					body_end_ += cnt;
+					pos_ += cnt;
+					chunk_left_ -= cnt;
+
+					if( chunk_left_ != 0 )
+						return PARSE_MORE;
+
+					state_ = CHUNK_DATA_END;
+				}
+				break;
+
+			case CHUNK_DATA_END:
+				if( pos_ == len )
+					return PARSE_MORE;
+
+				if( data[pos_] == '\r' )
+				{
+					if( pos_ + 1 == len )
+						return PARSE_MORE;
+					if( data[pos_ + 1] != '\n' )
+						return _error(400);
+					pos_ += 2;
+				}
+				else if( data[pos_] == '\n' )
+					pos_ += 1;
+				else
+					return _error(400);
+
+				state_ = CHUNK_SIZE;
+				break;
+
+			case CHUNK_TRAILER:
+				{
+					// trailerֱֶӶ
+					const char *eol = find_eol(data + pos_, data + len);
+					if( eol == nullptr )
+						return _error(400);
+					if( eol == data + len )
+						return len - pos_ > max_header_ ? _error(431) : PARSE_MORE;
+
+					const std::uint32_t next = static_cast<std::uint32_t>(eol - data) + 1;
+					const bool empty = next - pos_ == 1 || (next - pos_ == 2 && data[pos_] == '\r');
+					pos_ = next;
+
+					if( empty )
+					{
+						state_ = DONE;
+						return PARSE_DONE;
+					}
+				}
+				break;
+
+			default:
+				assert(0);
+				return _error(400);
+			}
+		}
+	}
+
+	bool request_parser_t::_request_line(const char *data, std::uint32_t first, std::uint32_t last)
+	{
+		status_ = 400;
+
+		const char *const begin = data + first;
+		const char *const end = data + last;
+
+		const char *sp1 = std::find(begin, end, ' ');
+		if( sp1 == begin || sp1 == end )
+			return false;
+
+		const char *sp2 = std::find(sp1 + 1, end, ' ');
+		if( sp2 == sp1 + 1 || sp2 == end )
+			return false;
+
+		// HTTP/x.y
+		const char *ver = sp2 + 1;
+		if( end - ver != 8 || std::memcmp(ver, "HTTP/", 5) != 0 || !is_digit(ver[5]) || ver[6] != '.' || !is_digit(ver[7]) )
+			return false;
+
+		version_major_ = ver[5] - '0';
+		version_minor_ = ver[7] - '0';
+		if( version_major_ != 1 )
+		{
+			status_ = 505;
+			return false;
+		}
+
+		method_.offset_ = first;
+		method_.size_ = static_cast<std::uint32_t>(sp1 - begin);
+		uri_.offset_ = static_cast<std::uint32_t>(sp1 + 1 - data);
+		uri_.size_ = static_cast<std::uint32_t>(sp2 - sp1 - 1);
+
+		// 1.1Ĭϳӣ1.0Ҫʽkeep-alive
+		keep_alive_ = version_minor_ >= 1;
+
+		status_ = 0;
+		return true;
+	}
+
+	bool request_parser_t::_header_line(const char *data, std::uint32_t first, std::uint32_t last)
+	{
+		status_ = 400;
+
+		// ֧obs-fold
+		if( is_ows(data[first]) )
+			return false;
+
+		const char *const begin = data + first;
+		const char *const end = data + last;
+
+		const char *colon = std::find(begin, end, ':');
+		if( colon == begin || colon == end )
+			return false;
+
+		// ֶð֮䲻հףֹ˽
+		if( std::find_if(begin, colon, is_ows) != colon )
+			return false;
+
+		const char *value = colon + 1;
+		const char *value_end = end;
+		while( value != value_end && is_ows(*value) )
+			++value;
+		while( value_end != value && is_ows(value_end[-1]) )
+			--value_end;
+
+		if( headers_.size() == MAX_HEADERS )
+		{
+			status_ = 431;
+			return false;
+		}
+
+		header_span_t header = {0};
+		header.name_.offset_ = first;
+		header.name_.size_ = static_cast<std::uint32_t>(colon - begin);
+		header.value_.offset_ = static_cast<std::uint32_t>(value - data);
+		header.value_.size_ = static_cast<std::uint32_t>(value_end - value);
+		headers_.push_back(header);
+
+		const view_t name(begin, colon - begin);
+		const view_t val(value, value_end - value);
+
+		if( equals(name, "content-length") )
+		{
+			std::uint64_t length = 0;
+			if( !parse_length(value, value_end, length) )
+				return false;
+			if( has_length_ && length != content_length_ )
+				return false;
+
+			has_length_ = true;
+			content_length_ = length;
+		}
+		else if( equals(name, "transfer-encoding") )
+		{
+			// ֻ֧chunkedֵ֧
+			if( !equals(val, "chunked") )
+			{
+				status_ = 501;
+				return false;
+			}
+
+			chunked_ = true;
+		}
+		else if( equals(name, "connection") )
+		{
+			if( has_token(val, "close") )
+				keep_alive_ = false;
+			else if( has_token(val, "keep-alive") )
+				keep_alive_ = true;
+		}
+
+		status_ = 0;
+		return true;
+	}
+
+	bool request_parser_t::_headers_done()
+	{
+		body_start_ = pos_;
+		body_end_ = pos_;
+
+		// ͬʱʱ޷ȷ߽
+		if( chunked_ && has_length_ )
+		{
+			status_ = 400;
+			return false;
+		}
+
+		if( chunked_ )
+			state_ = CHUNK_SIZE;
+		else if( content_length_ != 0 )
+		{
+			if( content_length_ > max_body_ )
+			{
+				status_ = 413;
+				return false;
+			}
+
+			state_ = BODY;
+		}
+		else
+			state_ = DONE;
+
+		return true;
+	}
+
+	void request_parser_t::_fill(const char *data, request_t &req) const
+	{
+		req.method_ = view_t(data + method_.offset_, method_.size_);
+		req.uri_ = view_t(data + uri_.offset_, uri_.size_);
+		req.version_major_ = version_major_;
+		req.version_minor_ = version_minor_;
+
+		req.headers_.clear();
+		for(auto iter = headers_.begin(); iter != headers_.end(); ++iter)
+		{
+			header_t header;
+			header.name_ = view_t(data + iter->name_.offset_, iter->name_.size_);
+			header.value_ = view_t(data + iter->value_.offset_, iter->value_.size_);
+			req.headers_.push_back(header);
+		}
+
+		req.body_ = view_t(data + body_start_, body_end_ - body_start_);
+		req.chunked_ = chunked_;
+		req.keep_alive_ = keep_alive_;
+	}
+}
+}
@@ -0,0 +1,170 @@
+#ifndef __ASYNC_HTTP_HTTP_PARSER_HPP
+#define __ASYNC_HTTP_HTTP_PARSER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "../service/read_write_buffer.hpp"
+
+
+namespace async { namespace http {
+
+	// ָջͼ
+	typedef service::const_buffer_t view_t;
+
+	// Сд޹رȽ
+	bool equals(const view_t &lhs, const char *rhs);
+	// ŷָtokenбǷtokenConnection: keep-alive, Upgrade
+	bool has_token(const view_t &list, const char *token);
+
+
+	// -------------------------------------------------
+	// struct request_t
+
+	struct header_t
+	{
+		view_t name_;
+		view_t value_;
+	};
+
+	struct request_t
+	{
+		view_t method_;
+		view_t uri_;
+		std::uint32_t version_major_;
+		std::uint32_t version_minor_;
+		std::vector<header_t> headers_;
+
+		// chunkedڻԭȥֿ
+		view_t body_;
+		bool chunked_;
+		bool keep_alive_;
+
+		request_t()
+			: version_major_(1)
+			, version_minor_(1)
+			, chunked_(false)
+			, keep_alive_(true)
+		{}
+
+		// ûʱؿͼ
+		view_t header(const char *name) const;
+
+		bool is_method(const char *method) const;
+	};
+
+
+	// -------------------------------------------------
+	// class request_parser_t
+
+	// ÿδʼĩβȫݣϴͣµλü
+	// ֻδһлɨ衣βǷַSSE2ÿαȽ16ֽڲң
+	// мֻ¼ƫƣݰƺȻЧʱͼ
+	// chunkedԭѹdataд
+	class request_parser_t
+	{
+	public:
+		enum result_t
+		{
+			PARSE_MORE,
+			PARSE_DONE,
+			PARSE_ERROR
+		};
+
+		static const std::uint32_t DEFAULT_MAX_HEADER = 64 * 1024;
+		static const std::uint32_t DEFAULT_MAX_BODY = 8 * 1024 * 1024;
+		static const std::uint32_t MAX_HEADERS = 100;
+
+	private:
+		enum state_t
+		{
+			REQUEST_LINE,
+			HEADER_LINE,
+			BODY,
+			CHUNK_SIZE,
+			CHUNK_DATA,
+			CHUNK_DATA_END,
+			CHUNK_TRAILER,
+			DONE
+		};
+
+		struct span_t
+		{
+			std::uint32_t offset_;
+			std::uint32_t size_;
+		};
+
+		struct header_span_t
+		{
+			span_t name_;
+			span_t value_;
+		};
+
+		std::uint32_t max_header_;
+		std::uint32_t max_body_;
+
+		state_t state_;
+		std::uint32_t pos_;			// ɨλ
+		std::uint32_t status_;		// ʱظ״̬
+
+		span_t method_;
+		span_t uri_;
+		std::uint32_t version_major_;
+		std::uint32_t version_minor_;
+		std::vector<header_span_t> headers_;
+
+		bool chunked_;
+		bool keep_alive_;
+		bool has_length_;
+		std::uint64_t content_length_;
+
+		std::uint32_t body_start_;
+		std::uint32_t body_end_;		// chunkedʱλ
+		std::uint64_t chunk_left_;
+
+	public:
+		explicit request_parser_t(std::uint32_t max_header = DEFAULT_MAX_HEADER, std::uint32_t max_body = DEFAULT_MAX_BODY);
+
+	public:
+		// PARSE_DONEʱreqconsumedΪռõֽ֮һ
+		result_t parse(char *data, std::size_t len, request_t &req, std::size_t &consumed);
+
+		// ʼһ
+		void reset();
+
+		// յͷڵȴ
+		bool in_body() const
+		{
+			return state_ > HEADER_LINE && state_ != DONE;
+		}
+
+		// PARSE_ERRORʱӦ״̬룺400/413/431/501
+		std::uint32_t error_status() const
+		{
+			return status_;
+		}
+
+	private:
+		result_t _parse_headers(char *data, std::uint32_t len);
+		result_t _parse_body(char *data, std::uint32_t len);
+		result_t _parse_chunked(char *data, std::uint32_t len);
+
+		bool _request_line(const char *data, std::uint32_t first, std::uint32_t last);
+		bool _header_line(const char *data, std::uint32_t first, std::uint32_t last);
+		bool _headers_done();
+
+		result_t _error(std::uint32_t status)
+		{
+			status_ = status;
+			return PARSE_ERROR;
+		}
+
+		void _fill(const char *data, request_t &req) const;
+	};
+}
+}
+
+
+
+
+#endif
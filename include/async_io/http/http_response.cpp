@@ -0,0 +1,317 @@
+#include "http_response.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#ifdef min
+#undef min
+#endif
+
+
+namespace async { namespace http {
+
+	namespace {
+
+		void append_number(std::string &str, std::uint64_t val)
+		{
+			char buf[24] = {0};
+			char *pos = buf + sizeof(buf);
+			do
+			{
+				*--pos = static_cast<char>('0' + val % 10);
+				val /= 10;
+			} while( val != 0 );
+
+			str.append(pos, buf + sizeof(buf));
+		}
+
+		void append_hex(std::string &str, std::uint64_t val)
+		{
+			static const char digits[] = "0123456789abcdef";
+
+			char buf[24] = {0};
+			char *pos = buf + sizeof(buf);
+			do
+			{
+				*--pos = digits[val & 0xF];
+				val >>= 4;
+			} while( val != 0 );
+
+			str.append(pos, buf + sizeof(buf));
+		}
+
+		// 1xx204304û
+		bool without_body(std::uint32_t status)
+		{
+			return status < 200 || status == 204 || status == 304;
+		}
+
+		// TransmitPacketsԪسΪULONGļֳɶ
+		const std::uint64_t MAX_FILE_ELEMENT = 1024 * 1024 * 1024;
+	}
+
+	const char *status_text(std::uint32_t status)
+	{
+		switch( status )
+		{
+		case 100: return "Continue";
+		case 101: return "Switching Protocols";
+		case 200: return "OK";
+		case 201: return "Created";
+		case 202: return "Accepted";
+		case 204: return "No Content";
+		case 206: return "Partial Content";
+		case 301: return "Moved Permanently";
+		case 302: return "Found";
+		case 304: return "Not Modified";
+		case 400: return "Bad Request";
+		case 401: return "Unauthorized";
+		case 403: return "Forbidden";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		case 408: return "Request Timeout";
+		case 411: return "Length Required";
+		case 412: return "Precondition Failed";
+		case 413: return "Payload Too Large";
+		case 414: return "URI Too Long";
+		case 416: return "Range Not Satisfiable";
+		case 426: return "Upgrade Required";
+		case 431: return "Request Header Fields Too Large";
+		case 500: return "Internal Server Error";
+		case 501: return "Not Implemented";
+		case 502: return "Bad Gateway";
+		case 503: return "Service Unavailable";
+		case 505: return "HTTP Version Not Supported";
+		default:  return "Unknown";
+		}
+	}
+
+
+	response_t::response_t()
+	{
+		reset();
+	}
+
+	void response_t::prepare(const request_t &req)
+	{
+		version_minor_ = req.version_minor_;
+		keep_alive_ = req.keep_alive_;
+		head_only_ = req.is_method("HEAD");
+	}
+
+	void response_t::reset()
+	{
+		status_ = 200;
+		version_minor_ = 1;
+		keep_alive_ = true;
+		head_only_ = false;
+		chunked_ = false;
+
+		headers_.clear();
+		head_.clear();
+		framing_.clear();
+		body_.clear();
+		owned_.clear();
+		holders_.clear();
+
+		file_ = INVALID_HANDLE_VALUE;
+		file_offset_ = 0;
+		file_size_ = 0;
+
+		upgrade_ = nullptr;
+	}
+
+	void response_t::add_header(const char *name, const char *value)
+	{
+		headers_.append(name);
+		headers_.append(": ", 2);
+		headers_.append(value);
+		headers_.append("\r\n", 2);
+	}
+
+	void response_t::add_header(const char *name, const std::string &value)
+	{
+		headers_.append(name);
+		headers_.append(": ", 2);
+		headers_.append(value);
+		headers_.append("\r\n", 2);
+	}
+
+	void response_t::add_header(const char *name, const view_t &value)
+	{
+		headers_.append(name);
+		headers_.append(": ", 2);
+		headers_.append(value.data(), value.size());
+		headers_.append("\r\n", 2);
+	}
+
+	void response_t::add_header(const char *name, std::uint64_t value)
+	{
+		headers_.append(name);
+		headers_.append(": ", 2);
+		append_number(headers_, value);
+		headers_.append("\r\n", 2);
+	}
+
+	void response_t::add_headers(const std::string &lines)
+	{
+		headers_.append(lines);
+	}
+
+	void response_t::append_body(std::string &&body)
+	{
+		if( body.empty() )
+			return;
+
+		// dequepush_backƶԪأ֮ǰͼȻЧ
+		owned_.push_back(std::move(body));
+		body_.push_back(service::const_buffer_t(owned_.back().data(), owned_.back().size()));
+	}
+
+	void response_t::append_body(const char *data, std::size_t size)
+	{
+		append_body(std::string(data, size));
+	}
+
+	void response_t::append_body(const service::const_buffer_t &buffer, const std::shared_ptr<const void> &holder)
+	{
+		if( buffer.size() == 0 )
+			return;
+
+		if( holder )
+			holders_.push_back(holder);
+		body_.push_back(buffer);
+	}
+
+	void response_t::set_file(HANDLE file, std::uint64_t offset, std::uint64_t size, const std::shared_ptr<const void> &holder)
+	{
+		assert(body_.empty() && !chunked_);
+
+		file_ = file;
+		file_offset_ = offset;
+		file_size_ = size;
+
+		if( holder )
+			holders_.push_back(holder);
+	}
+
+	std::uint64_t response_t::body_size() const
+	{
+		std::uint64_t size = file_size_;
+		for(auto iter = body_.begin(); iter != body_.end(); ++iter)
+			size += iter->size();
+
+		return size;
+	}
+
+	void response_t::serialize(std::vector<service::const_buffer_t> &buffers)
+	{
+		assert(!has_file());
+		_serialize(buffers);
+	}
+
+	void response_t::serialize(std::vector<TRANSMIT_PACKETS_ELEMENT> &elements)
+	{
+		// ڴ沿WSASend·ͬ
+		buffers_.clear();
+		_serialize(buffers_);
+
+		for(auto iter = buffers_.begin(); iter != buffers_.end(); ++iter)
+		{
+			TRANSMIT_PACKETS_ELEMENT element = {0};
+			element.dwElFlags = TP_ELEMENT_MEMORY;
+			element.cLength = static_cast<ULONG>(iter->size());
+			element.pBuffer = const_cast<char *>(iter->data());
+			elements.push_back(element);
+		}
+
+		if( !has_file() || head_only_ || without_body(status_) )
+			return;
+
+		for(std::uint64_t offset = 0; offset < file_size_; offset += MAX_FILE_ELEMENT)
+		{
+			TRANSMIT_PACKETS_ELEMENT element = {0};
+			element.dwElFlags = TP_ELEMENT_FILE;
+			element.cLength = static_cast<ULONG>(std::min(file_size_ - offset, MAX_FILE_ELEMENT));
+			element.nFileOffset.QuadPart = file_offset_ + offset;
+			element.hFile = file_;
+			elements.push_back(element);
+		}
+	}
+
+	void response_t::_serialize(std::vector<service::const_buffer_t> &buffers)
+	{
+		const bool no_body = without_body(status_);
+		const bool chunked = chunked_ && !no_body && version_minor_ >= 1;
+
+		head_.clear();
+		head_.append(version_minor_ >= 1 ? "HTTP/1.1 " : "HTTP/1.0 ");
+		append_number(head_, status_);
+		head_.push_back(' ');
+		head_.append(status_text(status_));
+		head_.append("\r\n", 2);
+		head_.append(headers_);
+
+		if( chunked )
+			head_.append("Transfer-Encoding: chunked\r\n");
+		else if( !no_body )
+		{
+			head_.append("Content-Length: ");
+			append_number(head_, body_size());
+			head_.append("\r\n", 2);
+		}
+
+		if( !keep_alive_ )
+			head_.append("Connection: close\r\n");
+		else if( version_minor_ == 0 )
+			head_.append("Connection: keep-alive\r\n");
+
+		head_.append("\r\n", 2);
+		buffers.push_back(service::const_buffer_t(head_.data(), head_.size()));
+
+		if( no_body || head_only_ )
+			return;
+
+		if( !chunked )
+		{
+			buffers.insert(buffers.end(), body_.begin(), body_.end());
+			return;
+		}
+
+		// ȫֿͷȡͼstringʹͼʧЧ
+		std::vector<std::size_t> offsets;
+		offsets.reserve(body_.size() + 1);
+
+		framing_.clear();
+		for(auto iter = body_.begin(); iter != body_.end(); ++iter)
+		{
+			offsets.push_back(framing_.size());
+			if( iter != body_.begin() )
+				framing_.append("\r\n", 2);
+			append_hex(framing_, iter->size());
+			framing_.append("\r\n", 2);
+		}
+		offsets.push_back(framing_.size());
+		framing_.append(body_.empty() ? "0\r\n\r\n" : "\r\n0\r\n\r\n");
+
+		for(std::size_t i = 0; i != body_.size(); ++i)
+		{
+			buffers.push_back(service::const_buffer_t(framing_.data() + offsets[i], offsets[i + 1] - offsets[i]));
+			buffers.push_back(body_[i]);
+		}
+		buffers.push_back(service::const_buffer_t(framing_.data() + offsets.back(), framing_.size() - offsets.back()));
+	}
+
+
+	void stock_response(response_t &resp, std::uint32_t status)
+	{
+		resp.set_status(status);
+		resp.add_header("Content-Type", "text/plain");
+
+		std::string body = status_text(status);
+		body.append("\r\n", 2);
+		resp.append_body(std::move(body));
+	}
+}
+}
@@ -0,0 +1,146 @@
+#ifndef __ASYNC_HTTP_HTTP_RESPONSE_HPP
+#define __ASYNC_HTTP_HTTP_RESPONSE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+
+#include "../basic.hpp"
+#include "http_parser.hpp"
+#include "../network.hpp"
+
+
+namespace async { namespace http {
+
+	const char *status_text(std::uint32_t status);
+
+
+	// -------------------------------------------------
+	// class response_t
+
+	// Ӧɶλɣ״̬ͷġchunkedֿͷԶ
+	// ʱһξۼдĲƴӿⲿholderдɡ
+	// Ҳļ䣬TransmitPacketsںֱӷ͡
+	// ϸãresetѷڴ
+	class response_t
+	{
+	public:
+		// Э101ӦдárestΪͬһζȡ֮յݣֻڻصЧ
+		typedef std::function<void(const network::session_ptr &session, const service::const_buffer_t &rest)> upgrade_handler_type;
+
+	private:
+		std::uint32_t status_;
+		std::uint32_t version_minor_;
+		bool keep_alive_;
+		bool head_only_;
+		bool chunked_;
+
+		std::string headers_;
+		std::string head_;
+		std::string framing_;
+
+		std::vector<service::const_buffer_t> body_;
+		std::deque<std::string> owned_;
+		std::vector<std::shared_ptr<const void>> holders_;
+
+		HANDLE file_;
+		std::uint64_t file_offset_;
+		std::uint64_t file_size_;
+
+		std::vector<service::const_buffer_t> buffers_;
+
+		upgrade_handler_type upgrade_;
+
+	public:
+		response_t();
+
+	public:
+		// ð汾HEAD
+		void prepare(const request_t &req);
+		void reset();
+
+		void set_status(std::uint32_t status)
+		{
+			status_ = status;
+		}
+
+		std::uint32_t status() const
+		{
+			return status_;
+		}
+
+		void set_keep_alive(bool keep_alive)
+		{
+			keep_alive_ = keep_alive;
+		}
+
+		bool keep_alive() const
+		{
+			return keep_alive_;
+		}
+
+		// δ֪ʱʹchunked룬ÿһֿ
+		void set_chunked(bool chunked)
+		{
+			chunked_ = chunked;
+		}
+
+		bool head_only() const
+		{
+			return head_only_;
+		}
+
+		// ӦдỰhandlerӲٴHTTP
+		void set_upgrade(const upgrade_handler_type &handler)
+		{
+			upgrade_ = handler;
+		}
+
+		const upgrade_handler_type &upgrade() const
+		{
+			return upgrade_;
+		}
+
+		// Content-LengthTransfer-EncodingɿɣConnectionset_keep_alive
+		void add_header(const char *name, const char *value);
+		void add_header(const char *name, const std::string &value);
+		void add_header(const char *name, const view_t &value);
+		void add_header(const char *name, std::uint64_t value);
+		// ԤɵĶͷÿ\r\nβ
+		void add_headers(const std::string &lines);
+
+		void append_body(std::string &&body);
+		void append_body(const char *data, std::size_t size);
+		void append_body(const service::const_buffer_t &buffer, const std::shared_ptr<const void> &holder);
+
+		// ļģڴĻchunkedͬʱʹáholderļд
+		void set_file(HANDLE file, std::uint64_t offset, std::uint64_t size, const std::shared_ptr<const void> &holder);
+
+		bool has_file() const
+		{
+			return file_ != INVALID_HANDLE_VALUE;
+		}
+
+		std::uint64_t body_size() const;
+
+		// ӦĻ׷ӵbuffersд֮ǰ޸Ļresetļ
+		void serialize(std::vector<service::const_buffer_t> &buffers);
+		// TransmitPacketsԪУļİ䷢
+		void serialize(std::vector<TRANSMIT_PACKETS_ELEMENT> &elements);
+
+	private:
+		void _serialize(std::vector<service::const_buffer_t> &buffers);
+	};
+
+	// ԤɵĴӦ
+	void stock_response(response_t &resp, std::uint32_t status);
+}
+}
+
+
+
+
+#endif
@@ -0,0 +1,250 @@
+#include "http_server.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+
+namespace async { namespace http {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+	}
+
+	// δɵĶдصУỰϿͷ
+	struct server_t::connection_t
+		: std::enable_shared_from_this<connection_t>
+	{
+		server_t &server_;
+		network::session_ptr session_;
+
+		// [begin_, end_)Ϊδݣbegin_ǵǰʼ
+		std::vector<char> buffer_;
+		std::size_t begin_;
+		std::size_t end_;
+		std::size_t max_buffer_;
+
+		request_parser_t parser_;
+		request_t request_;
+
+		// Ӧдɺ
+		std::vector<std::unique_ptr<response_t>> responses_;
+		std::size_t count_;
+		std::vector<service::const_buffer_t> buffers_;
+		std::vector<TRANSMIT_PACKETS_ELEMENT> elements_;
+		bool close_;
+		bool upgrade_;
+
+		connection_t(server_t &server, const network::session_ptr &session)
+			: server_(server)
+			, session_(session)
+			, buffer_(DEFAULT_BUFFER_SIZE)
+			, begin_(0)
+			, end_(0)
+			// chunkedķֿͷڻԭȥ󲻻գĵ
+			, max_buffer_(server.max_header_ + server.max_body_ * 2)
+			, parser_(server.max_header_, server.max_body_)
+			, count_(0)
+			, close_(false)
+			, upgrade_(false)
+		{}
+
+		void read()
+		{
+			// ֮ǰд꣬δɵᵽͷֻ¼ƫ
+			if( begin_ != 0 )
+			{
+				std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+				end_ -= begin_;
+				begin_ = 0;
+			}
+
+			if( end_ == buffer_.size() )
+			{
+				if( buffer_.size() >= max_buffer_ )
+				{
+					response_t &resp = next_response();
+					stock_response(resp, 413);
+					resp.set_keep_alive(false);
+					close_ = true;
+
+					write();
+					return;
+				}
+
+				buffer_.resize(std::min(buffer_.size() * 2, max_buffer_));
+			}
+
+			auto this_val = shared_from_this();
+			service::mutable_buffer_t buf(buffer_.data() + end_, buffer_.size() - end_);
+			session_->async_read_some(buf, 0, [this_val](const network::session_ptr &, std::uint32_t size)
+			{
+				this_val->end_ += size;
+				this_val->process();
+			}, callback_pool());
+		}
+
+		void process()
+		{
+			assert(count_ == 0);
+
+			while( !close_ && !upgrade_ && begin_ != end_ )
+			{
+				std::size_t consumed = 0;
+				const request_parser_t::result_t ret = parser_.parse(buffer_.data() + begin_, end_ - begin_, request_, consumed);
+				if( ret == request_parser_t::PARSE_MORE )
+					break;
+
+				response_t &resp = next_response();
+				if( ret == request_parser_t::PARSE_ERROR )
+				{
+					stock_response(resp, parser_.error_status());
+					resp.set_keep_alive(false);
+					close_ = true;
+					break;
+				}
+
+				resp.prepare(request_);
+				handle(resp);
+
+				if( !resp.keep_alive() )
+					close_ = true;
+				else if( resp.upgrade() )
+					upgrade_ = true;
+
+				begin_ += consumed;
+				parser_.reset();
+			}
+
+			if( count_ == 0 )
+				read();
+			else
+				write();
+		}
+
+		void handle(response_t &resp)
+		{
+			try
+			{
+				server_.handler_(request_, resp);
+				return;
+			}
+			catch(::exception::exception_base &e)
+			{
+				e.dump();
+			}
+			catch(std::exception &)
+			{
+			}
+
+			resp.reset();
+			resp.prepare(request_);
+			stock_response(resp, 500);
+		}
+
+		response_t &next_response()
+		{
+			if( count_ == responses_.size() )
+				responses_.emplace_back(new response_t);
+
+			return *responses_[count_++];
+		}
+
+		void write()
+		{
+			auto this_val = shared_from_this();
+
+			// ļʱTransmitPacketsӦ˳
+			const bool has_file = std::any_of(responses_.begin(), responses_.begin() + count_, 
+				[](const std::unique_ptr<response_t> &resp) { return resp->has_file(); });
+			if( has_file )
+			{
+				elements_.clear();
+				for(std::size_t i = 0; i != count_; ++i)
+					responses_[i]->serialize(elements_);
+
+				session_->async_transmit(elements_.data(), static_cast<std::uint32_t>(elements_.size()),
+					[this_val](const network::session_ptr &, std::uint32_t)
+				{
+					this_val->on_written();
+				}, callback_pool());
+				return;
+			}
+
+			buffers_.clear();
+			for(std::size_t i = 0; i != count_; ++i)
+				responses_[i]->serialize(buffers_);
+
+			session_->async_writev(buffers_.data(), static_cast<std::uint32_t>(buffers_.size()),
+				[this_val](const network::session_ptr &, std::uint32_t)
+			{
+				this_val->on_written();
+			}, callback_pool());
+		}
+
+		void on_written()
+		{
+			// ӦǱһ
+			response_t::upgrade_handler_type upgrade;
+			if( upgrade_ )
+				upgrade = responses_[count_ - 1]->upgrade();
+
+			// ͷĵholder
+			for(std::size_t i = 0; i != count_; ++i)
+				responses_[i]->reset();
+			count_ = 0;
+
+			if( close_ )
+			{
+				session_->disconnect();
+				return;
+			}
+
+			if( upgrade )
+			{
+				upgrade(session_, service::const_buffer_t(buffer_.data() + begin_, end_ - begin_));
+				return;
+			}
+
+			// пк
+			process();
+		}
+	};
+
+
+	server_t::server_t(const handler_type &handler, std::uint32_t max_header, std::uint32_t max_body)
+		: handler_(handler)
+		, max_header_(max_header)
+		, max_body_(max_body)
+	{
+	}
+
+	void server_t::attach(network::server &svr)
+	{
+		svr.register_accept_handler([this](const network::session_ptr &session, const std::string &)
+		{
+			serve(session);
+			return true;
+		});
+	}
+
+	void server_t::serve(const network::session_ptr &session)
+	{
+		auto connection = std::make_shared<connection_t>(*this, session);
+		connection->read();
+	}
+}
+}
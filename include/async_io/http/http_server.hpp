@@ -0,0 +1,56 @@
+#ifndef __ASYNC_HTTP_HTTP_SERVER_HPP
+#define __ASYNC_HTTP_HTTP_SERVER_HPP
+
+#include <cstdint>
+#include <functional>
+
+#include "http_parser.hpp"
+#include "http_response.hpp"
+#include "../network.hpp"
+
+
+namespace async { namespace http {
+
+	// -------------------------------------------------
+	// class server_t
+
+	// network::serverỰϵHTTP/1.1һζĶˮνhandler
+	// Ӧ˳ܳһһξۼдٴȡ
+	// ͼӦдǰЧhandlerͬдӦ
+	class server_t
+	{
+		struct connection_t;
+
+	public:
+		typedef std::function<void(const request_t &, response_t &)> handler_type;
+
+		static const std::uint32_t DEFAULT_BUFFER_SIZE = 8 * 1024;
+
+	private:
+		handler_type handler_;
+		std::uint32_t max_header_;
+		std::uint32_t max_body_;
+
+	public:
+		explicit server_t(const handler_type &handler,
+			std::uint32_t max_header = request_parser_t::DEFAULT_MAX_HEADER,
+			std::uint32_t max_body = request_parser_t::DEFAULT_MAX_BODY);
+
+	private:
+		server_t(const server_t &);
+		server_t &operator=(const server_t &);
+
+	public:
+		// ӹsvracceptص»ỰΪHTTP
+		void attach(network::server &svr);
+
+		// ڻỰϿʼHTTPҲԼacceptصе
+		void serve(const network::session_ptr &session);
+	};
+}
+}
+
+
+
+
+#endif
@@ -0,0 +1,441 @@
+#include "static_files.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+
+#include "../service/exception.hpp"
+#include "../service/clock.hpp"
+
+
+namespace async { namespace http {
+
+	namespace {
+
+		int hex_value(char c)
+		{
+			if( c >= '0' && c <= '9' )
+				return c - '0';
+			if( c >= 'a' && c <= 'f' )
+				return c - 'a' + 10;
+			if( c >= 'A' && c <= 'F' )
+				return c - 'A' + 10;
+			return -1;
+		}
+
+		// Windows豸չ豸ļCONnul.txtCOM1.log
+		bool is_device_name(const char *seg, std::size_t len)
+		{
+			// ֻһ'.'֮ǰĲ֣ĩβĿոᱻWindowsȥ
+			std::size_t base = std::find(seg, seg + len, '.') - seg;
+			while( base != 0 && seg[base - 1] == ' ' )
+				--base;
+
+			static const char *const names[] = { "CON", "PRN", "AUX", "NUL", "CONIN$", "CONOUT$" };
+			const view_t name(seg, base);
+			for(auto iter = std::begin(names); iter != std::end(names); ++iter)
+			{
+				if( equals(name, *iter) )
+					return true;
+			}
+
+			// COM1-9LPT1-9Լϱ123βд(UTF-8ΪC2 B9/B2/B3)
+			if( base < 4 || (!equals(view_t(seg, 3), "COM") && !equals(view_t(seg, 3), "LPT")) )
+				return false;
+
+			if( base == 4 )
+				return seg[3] >= '1' && seg[3] <= '9';
+
+			return base == 5 && seg[3] == '\xC2' && (seg[4] == '\xB9' || seg[4] == '\xB2' || seg[4] == '\xB3');
+		}
+
+		// ȥѯ룬'/'ָĹ淶·ܾ..NULбܡðš豸
+		// Լ'.'ոβĶ(Windowsȥǣɽ˷ͬһļı)
+		bool normalize(const view_t &uri, std::string &path)
+		{
+			const char *first = uri.begin();
+			const char *const last = std::find_if(first, uri.end(), [](char c) { return c == '?' || c == '#'; });
+			if( first == last || *first != '/' )
+				return false;
+
+			std::string decoded;
+			decoded.reserve(last - first);
+			for(; first != last; ++first)
+			{
+				char c = *first;
+				if( c == '%' )
+				{
+					if( last - first < 3 || hex_value(first[1]) < 0 || hex_value(first[2]) < 0 )
+						return false;
+
+					c = static_cast<char>((hex_value(first[1]) << 4) | hex_value(first[2]));
+					first += 2;
+				}
+
+				if( c == '\0' || c == '\\' || c == ':' )
+					return false;
+
+				decoded.push_back(c);
+			}
+
+			path.clear();
+			for(std::size_t pos = 1; pos <= decoded.size(); )
+			{
+				std::size_t end = decoded.find('/', pos);
+				if( end == std::string::npos )
+					end = decoded.size();
+
+				const std::size_t len = end - pos;
+				if( len == 1 && decoded[pos] == '.' )
+					;
+				else if( len != 0 )
+				{
+					if( decoded[end - 1] == '.' || decoded[end - 1] == ' ' || is_device_name(decoded.data() + pos, len) )
+						return false;
+
+					path.push_back('/');
+					path.append(decoded, pos, len);
+				}
+
+				pos = end + 1;
+			}
+
+			if( path.empty() || decoded.back() == '/' )
+				path.append("/index.html");
+
+			return true;
+		}
+
+		bool to_native(const std::wstring &root, const std::string &path, std::wstring &file)
+		{
+			const int len = ::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, path.data(), static_cast<int>(path.size()), nullptr, 0);
+			if( len <= 0 )
+				return false;
+
+			file = root;
+			const std::size_t offset = file.size();
+			file.resize(offset + len);
+			::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, path.data(), static_cast<int>(path.size()), &file[offset], len);
+
+			std::replace(file.begin() + offset, file.end(), L'/', L'\\');
+			return true;
+		}
+
+		const char *content_type(const std::string &path)
+		{
+			static const struct { const char *ext_; const char *type_; } types[] =
+			{
+				{ "html",	"text/html" },
+				{ "htm",	"text/html" },
+				{ "css",	"text/css" },
+				{ "js",		"application/javascript" },
+				{ "json",	"application/json" },
+				{ "txt",	"text/plain" },
+				{ "xml",	"text/xml" },
+				{ "png",	"image/png" },
+				{ "jpg",	"image/jpeg" },
+				{ "jpeg",	"image/jpeg" },
+				{ "gif",	"image/gif" },
+				{ "svg",	"image/svg+xml" },
+				{ "ico",	"image/x-icon" },
+				{ "webp",	"image/webp" },
+				{ "woff",	"font/woff" },
+				{ "woff2",	"font/woff2" },
+				{ "pdf",	"application/pdf" },
+				{ "wasm",	"application/wasm" },
+				{ "mp4",	"video/mp4" },
+				{ "zip",	"application/zip" },
+			};
+
+			const std::size_t dot = path.rfind('.');
+			if( dot != std::string::npos && path.find('/', dot) == std::string::npos )
+			{
+				const view_t ext(path.data() + dot + 1, path.size() - dot - 1);
+				for(auto iter = std::begin(types); iter != std::end(types); ++iter)
+				{
+					if( equals(ext, iter->ext_) )
+						return iter->type_;
+				}
+			}
+
+			return "application/octet-stream";
+		}
+
+		std::string http_date(const FILETIME &time)
+		{
+			static const char *days[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+			static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+			SYSTEMTIME st = {0};
+			::FileTimeToSystemTime(&time, &st);
+
+			char buf[64] = {0};
+			::sprintf_s(buf, "%s, %02u %s %04u %02u:%02u:%02u GMT", days[st.wDayOfWeek], st.wDay, months[st.wMonth - 1],
+				st.wYear, st.wHour, st.wMinute, st.wSecond);
+
+			return buf;
+		}
+
+		std::uint64_t to_uint64(DWORD high, DWORD low)
+		{
+			return (static_cast<std::uint64_t>(high) << 32) | low;
+		}
+
+		HANDLE open_file(const std::wstring &file)
+		{
+			return ::CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		}
+	}
+
+
+	struct static_files_t::entry_t
+	{
+		std::string path_;
+		std::wstring file_;
+
+		// Content-TypeETagLast-Modified
+		std::string headers_;
+		std::string etag_;
+		std::string last_modified_;
+
+		FILETIME write_time_;
+		std::uint64_t size_;
+
+		// Ϊin_memory_Ϊfalseʱÿδļ
+		std::string body_;
+		bool in_memory_;
+
+		DWORD checked_;
+		std::uint64_t cost_;
+		lru_list_t::iterator lru_;
+	};
+
+
+	static_files_t::static_files_t(const std::string &root, std::uint64_t cache_size, std::uint64_t max_cached_file, std::uint32_t check_interval)
+		: cache_size_(cache_size)
+		, max_cached_file_(max_cached_file)
+		, check_interval_(check_interval)
+		, cached_bytes_(0)
+	{
+		std::string dir = root;
+		while( !dir.empty() && (dir.back() == '/' || dir.back() == '\\') )
+			dir.pop_back();
+
+		if( dir.empty() || !to_native(std::wstring(), dir, root_) )
+			throw service::network_exception("invalid static files root: " + root);
+	}
+
+	void static_files_t::serve(const request_t &req, response_t &resp)
+	{
+		if( !req.is_method("GET") && !req.is_method("HEAD") )
+		{
+			stock_response(resp, 405);
+			resp.add_header("Allow", "GET, HEAD");
+			return;
+		}
+
+		std::string path;
+		if( !normalize(req.uri_, path) )
+		{
+			stock_response(resp, 400);
+			return;
+		}
+
+		entry_ptr entry = _find(path);
+		if( !entry )
+		{
+			stock_response(resp, 404);
+			return;
+		}
+
+		// RFC 7232: If-None-MatchʱIf-Modified-Since
+		const view_t none_match = req.header("If-None-Match");
+		const view_t modified_since = req.header("If-Modified-Since");
+		const bool not_modified = none_match.size() != 0
+			? (equals(none_match, "*") || has_token(none_match, entry->etag_.c_str()))
+			: (modified_since.size() != 0 && equals(modified_since, entry->last_modified_.c_str()));
+
+		if( not_modified )
+		{
+			resp.set_status(304);
+			resp.add_headers(entry->headers_);
+			return;
+		}
+
+		if( entry->in_memory_ )
+		{
+			// entry̭¼غholderֵд
+			resp.add_headers(entry->headers_);
+			resp.append_body(service::const_buffer_t(entry->body_.data(), entry->body_.size()), entry);
+			return;
+		}
+
+		HANDLE file = open_file(entry->file_);
+		if( file == INVALID_HANDLE_VALUE )
+		{
+			_erase(path);
+			stock_response(resp, 404);
+			return;
+		}
+
+		std::shared_ptr<void> holder(file, ::CloseHandle);
+
+		LARGE_INTEGER size = {0};
+		::GetFileSizeEx(file, &size);
+
+		resp.add_headers(entry->headers_);
+		resp.set_file(file, 0, std::min<std::uint64_t>(entry->size_, size.QuadPart), holder);
+	}
+
+	void static_files_t::clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		entries_.clear();
+		lru_.clear();
+		cached_bytes_ = 0;
+	}
+
+	std::uint64_t static_files_t::cached_bytes()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return cached_bytes_;
+	}
+
+	static_files_t::entry_ptr static_files_t::_find(const std::string &path)
+	{
+		const DWORD now = static_cast<DWORD>(service::now_ms());
+
+		entry_ptr entry;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto iter = entries_.find(path);
+			if( iter != entries_.end() )
+			{
+				entry = iter->second;
+				lru_.splice(lru_.begin(), lru_, entry->lru_);
+
+				if( now - entry->checked_ < check_interval_ )
+					return entry;
+
+				// ڼʹõǰ
+				entry->checked_ = now;
+			}
+		}
+
+		std::wstring file;
+		if( !to_native(root_, path, file) )
+			return entry_ptr();
+
+		WIN32_FILE_ATTRIBUTE_DATA attr = {0};
+		if( !::GetFileAttributesExW(file.c_str(), GetFileExInfoStandard, &attr)
+			|| (attr.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0 )
+		{
+			if( entry )
+				_erase(path);
+			return entry_ptr();
+		}
+
+		if( entry
+			&& ::CompareFileTime(&entry->write_time_, &attr.ftLastWriteTime) == 0
+			&& entry->size_ == to_uint64(attr.nFileSizeHigh, attr.nFileSizeLow) )
+			return entry;
+
+		entry = _load(path, attr);
+		if( entry )
+			_insert(entry);
+
+		return entry;
+	}
+
+	static_files_t::entry_ptr static_files_t::_load(const std::string &path, const WIN32_FILE_ATTRIBUTE_DATA &attr)
+	{
+		auto entry = std::make_shared<entry_t>();
+		entry->path_ = path;
+		to_native(root_, path, entry->file_);
+
+		entry->write_time_ = attr.ftLastWriteTime;
+		entry->size_ = to_uint64(attr.nFileSizeHigh, attr.nFileSizeLow);
+		entry->in_memory_ = entry->size_ <= max_cached_file_;
+		entry->checked_ = static_cast<DWORD>(service::now_ms());
+
+		if( entry->in_memory_ )
+		{
+			HANDLE file = open_file(entry->file_);
+			if( file == INVALID_HANDLE_VALUE )
+				return entry_ptr();
+
+			std::shared_ptr<void> holder(file, ::CloseHandle);
+
+			// ȡڼļ޸ʱʵʶΪ׼´μʱ¼
+			entry->body_.resize(static_cast<std::size_t>(entry->size_));
+			DWORD read = 0;
+			if( entry->size_ != 0
+				&& !::ReadFile(file, &entry->body_[0], static_cast<DWORD>(entry->size_), &read, nullptr) )
+				return entry_ptr();
+
+			entry->body_.resize(read);
+		}
+
+		char etag[64] = {0};
+		::sprintf_s(etag, "\"%llx-%llx\"", to_uint64(attr.ftLastWriteTime.dwHighDateTime, attr.ftLastWriteTime.dwLowDateTime), entry->size_);
+		entry->etag_ = etag;
+		entry->last_modified_ = http_date(attr.ftLastWriteTime);
+
+		entry->headers_.append("Content-Type: ").append(content_type(path)).append("\r\n");
+		entry->headers_.append("ETag: ").append(entry->etag_).append("\r\n");
+		entry->headers_.append("Last-Modified: ").append(entry->last_modified_).append("\r\n");
+
+		entry->cost_ = entry->body_.size() + entry->headers_.size() + path.size() * 2 + sizeof(entry_t);
+
+		return entry;
+	}
+
+	void static_files_t::_insert(const entry_ptr &entry)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto iter = entries_.find(entry->path_);
+		if( iter != entries_.end() )
+		{
+			cached_bytes_ -= iter->second->cost_;
+			lru_.erase(iter->second->lru_);
+			entries_.erase(iter);
+		}
+
+		// ܴСĲ棬Ȼʹ
+		if( entry->cost_ > cache_size_ )
+			return;
+
+		while( cached_bytes_ + entry->cost_ > cache_size_ && !lru_.empty() )
+		{
+			auto victim = entries_.find(lru_.back());
+			assert(victim != entries_.end());
+
+			cached_bytes_ -= victim->second->cost_;
+			entries_.erase(victim);
+			lru_.pop_back();
+		}
+
+		entry->lru_ = lru_.insert(lru_.begin(), entry->path_);
+		entries_.insert(std::make_pair(entry->path_, entry));
+		cached_bytes_ += entry->cost_;
+	}
+
+	void static_files_t::_erase(const std::string &path)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto iter = entries_.find(path);
+		if( iter == entries_.end() )
+			return;
+
+		cached_bytes_ -= iter->second->cost_;
+		lru_.erase(iter->second->lru_);
+		entries_.erase(iter);
+	}
+}
+}
@@ -0,0 +1,77 @@
+#ifndef __ASYNC_HTTP_STATIC_FILES_HPP
+#define __ASYNC_HTTP_STATIC_FILES_HPP
+
+#include <cstdint>
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "http_parser.hpp"
+#include "http_response.hpp"
+
+
+namespace async { namespace http {
+
+	// -------------------------------------------------
+	// class static_files_t
+
+	// ̬ļСļͬԤɵͷڴУLRṶܴСޣ
+	// ļֻͷTransmitPacketsļֱӷ͡
+	// check_intervalٴʱȽļ޸ʱС仯¼ء
+	// ֧If-None-MatchIf-Modified-Since(Last-Modifiedȫͬʱ)304
+	class static_files_t
+	{
+		struct entry_t;
+		typedef std::shared_ptr<entry_t>			entry_ptr;
+		typedef std::list<std::string>				lru_list_t;
+
+	public:
+		static const std::uint64_t DEFAULT_CACHE_SIZE = 64 * 1024 * 1024;
+		static const std::uint64_t DEFAULT_MAX_CACHED_FILE = 256 * 1024;
+		static const std::uint32_t DEFAULT_CHECK_INTERVAL = 1000;
+
+	private:
+		std::wstring root_;
+		std::uint64_t cache_size_;
+		std::uint64_t max_cached_file_;
+		std::uint32_t check_interval_;
+
+		std::mutex mutex_;
+		std::unordered_map<std::string, entry_ptr> entries_;
+		lru_list_t lru_;
+		std::uint64_t cached_bytes_;
+
+	public:
+		// rootΪUTF-8Ŀ¼·
+		explicit static_files_t(const std::string &root,
+			std::uint64_t cache_size = DEFAULT_CACHE_SIZE,
+			std::uint64_t max_cached_file = DEFAULT_MAX_CACHED_FILE,
+			std::uint32_t check_interval = DEFAULT_CHECK_INTERVAL);
+
+	private:
+		static_files_t(const static_files_t &);
+		static_files_t &operator=(const static_files_t &);
+
+	public:
+		// ֻGETHEADظ405Ŀ¼ӳ䵽index.html
+		void serve(const request_t &req, response_t &resp);
+
+		void clear();
+
+		std::uint64_t cached_bytes();
+
+	private:
+		entry_ptr _find(const std::string &path);
+		entry_ptr _load(const std::string &path, const WIN32_FILE_ATTRIBUTE_DATA &attr);
+		void _insert(const entry_ptr &entry);
+		void _erase(const std::string &path);
+	};
+}
+}
+
+
+
+
+#endif
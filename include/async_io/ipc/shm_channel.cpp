@@ -0,0 +1,349 @@
+#include "shm_channel.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "../basic.hpp"
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+
+namespace async { namespace ipc {
+
+	namespace {
+
+		// صͨͷ֮Ź黹ʹõ÷ͨķ
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		const std::uint32_t CHANNEL_MAGIC	= 0x53484D43;	// 'SHMC'
+
+		const std::uint32_t COMMITTED		= 0x80000000;
+		const std::uint32_t PADDING			= 0x40000000;
+		const std::uint32_t SIZE_MASK		= 0x3FFFFFFF;
+
+		std::uint64_t align8(std::uint64_t val)
+		{
+			return (val + 7) & ~7ULL;
+		}
+	}
+
+	// ͷλöռУд˻
+	struct shm_channel_t::header_t
+	{
+		std::uint32_t magic_;
+		std::uint32_t capacity_;
+		char padding0_[56];
+
+		std::atomic<std::uint64_t> reserve_;	// дԤλ
+		char padding1_[56];
+
+		std::atomic<std::uint64_t> read_;		// λã֮ǰĿռ
+		char padding2_[56];
+
+		std::atomic<std::uint32_t> waiting_;	// ѹдSetEvent
+		char padding3_[60];
+	};
+
+	// ¼ͷlen_COMMITTED־ʾддꡣPADDING¼βŲµĿռ
+	struct shm_channel_t::record_t
+	{
+		std::atomic<std::uint32_t> len_;
+		std::uint32_t reserved_;
+	};
+
+
+	shm_channel_t::shm_channel_t(dispatcher_type &io, const std::string &name, std::uint32_t capacity)
+		: io_(io)
+		, mapping_(nullptr)
+		, event_(nullptr)
+		, header_(nullptr)
+		, data_(nullptr)
+		, mask_(0)
+		, spin_(DEFAULT_SPIN)
+		, wait_(nullptr)
+		, cancel_(false)
+		, pending_data_(nullptr)
+		, pending_size_(0)
+	{
+		if( capacity < 4096 || (capacity & (capacity - 1)) != 0 )
+			throw service::network_exception("shm channel capacity must be a power of 2 and at least 4096");
+
+		_map(name, capacity, true);
+	}
+
+	shm_channel_t::shm_channel_t(dispatcher_type &io, const std::string &name)
+		: io_(io)
+		, mapping_(nullptr)
+		, event_(nullptr)
+		, header_(nullptr)
+		, data_(nullptr)
+		, mask_(0)
+		, spin_(DEFAULT_SPIN)
+		, wait_(nullptr)
+		, cancel_(false)
+		, pending_data_(nullptr)
+		, pending_size_(0)
+	{
+		_map(name, 0, false);
+	}
+
+	shm_channel_t::~shm_channel_t()
+	{
+		// Ķshared_ptrʱеȴ
+		assert(wait_ == nullptr);
+
+		if( header_ != nullptr )
+			::UnmapViewOfFile(header_);
+		if( mapping_ != nullptr )
+			::CloseHandle(mapping_);
+		if( event_ != nullptr )
+			::CloseHandle(event_);
+	}
+
+	void shm_channel_t::_map(const std::string &name, std::uint32_t capacity, bool create)
+	{
+		const std::string event_name = name + "_event";
+
+		if( create )
+		{
+			const std::uint64_t size = sizeof(header_t) + capacity;
+			mapping_ = ::CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), name.c_str());
+			if( mapping_ == nullptr )
+				throw service::win32_exception_t("CreateFileMapping");
+			if( ::GetLastError() == ERROR_ALREADY_EXISTS )
+				throw service::network_exception("shm channel already exists: " + name);
+
+			event_ = ::CreateEventA(nullptr, FALSE, FALSE, event_name.c_str());
+			if( event_ == nullptr )
+				throw service::win32_exception_t("CreateEvent");
+		}
+		else
+		{
+			mapping_ = ::OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+			if( mapping_ == nullptr )
+				throw service::win32_exception_t("OpenFileMapping");
+
+			event_ = ::OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, event_name.c_str());
+			if( event_ == nullptr )
+				throw service::win32_exception_t("OpenEvent");
+		}
+
+		void *view = ::MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+		if( view == nullptr )
+			throw service::win32_exception_t("MapViewOfFile");
+
+		header_ = static_cast<header_t *>(view);
+		data_ = static_cast<char *>(view) + sizeof(header_t);
+
+		// ӳҳ㣬λ¼ͷΪ0
+		if( create )
+		{
+			header_->capacity_ = capacity;
+			std::atomic_thread_fence(std::memory_order_release);
+			header_->magic_ = CHANNEL_MAGIC;
+		}
+		else
+		{
+			if( header_->magic_ != CHANNEL_MAGIC )
+				throw service::network_exception("shm channel not initialized: " + name);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+
+		mask_ = header_->capacity_ - 1;
+	}
+
+	bool shm_channel_t::write(const service::const_buffer_t &buf)
+	{
+		const std::uint32_t size = static_cast<std::uint32_t>(buf.size());
+		const std::uint64_t need = align8(sizeof(record_t) + size);
+		const std::uint64_t capacity = mask_ + 1;
+
+		if( need > capacity / 2 )
+			throw service::network_exception("shm channel message too large");
+
+		std::uint64_t pos = header_->reserve_.load(std::memory_order_relaxed);
+		std::uint64_t total = 0;
+		for(;;)
+		{
+			// βŲʱͬβһԤβдPADDING
+			const std::uint64_t tail = capacity - (pos & mask_);
+			total = need <= tail ? need : tail + need;
+
+			if( pos + total - header_->read_.load(std::memory_order_acquire) > capacity )
+				return false;
+
+			if( header_->reserve_.compare_exchange_weak(pos, pos + total, std::memory_order_acq_rel, std::memory_order_relaxed) )
+				break;
+		}
+
+		if( total != need )
+		{
+			const std::uint64_t tail = total - need;
+			reinterpret_cast<record_t *>(data_ + (pos & mask_))->len_.store(COMMITTED | PADDING | static_cast<std::uint32_t>(tail), std::memory_order_release);
+			pos += tail;
+		}
+
+		record_t *rec = reinterpret_cast<record_t *>(data_ + (pos & mask_));
+		std::memcpy(rec + 1, buf.data(), size);
+		rec->len_.store(COMMITTED | size, std::memory_order_release);
+
+		_notify();
+		return true;
+	}
+
+	bool shm_channel_t::try_read(service::mutable_buffer_t &buf, std::uint32_t &size)
+	{
+		const pop_result_t ret = _pop(buf, size);
+		if( ret == POP_MORE_DATA )
+			throw service::network_exception("shm channel read buffer too small");
+
+		return ret == POP_OK;
+	}
+
+	void shm_channel_t::cancel()
+	{
+		{
+			Lock lock(mutex_);
+			if( !pending_handler_ )
+				return;
+
+			cancel_ = true;
+		}
+
+		// ѵȴ_resumeERROR_OPERATION_ABORTEDص
+		::SetEvent(event_);
+	}
+
+	shm_channel_t::pop_result_t shm_channel_t::_pop(service::mutable_buffer_t &buf, std::uint32_t &size)
+	{
+		std::uint64_t pos = header_->read_.load(std::memory_order_relaxed);
+		for(;;)
+		{
+			record_t *rec = reinterpret_cast<record_t *>(data_ + (pos & mask_));
+			const std::uint32_t len = rec->len_.load(std::memory_order_acquire);
+			if( (len & COMMITTED) == 0 )
+				return POP_EMPTY;
+
+			// ĿռŹ黹дˣһȦļ¼ͷǴ0ʼ
+			if( (len & PADDING) != 0 )
+			{
+				const std::uint32_t skip = len & SIZE_MASK;
+				std::memset(rec, 0, skip);
+				pos += skip;
+				header_->read_.store(pos, std::memory_order_release);
+				continue;
+			}
+
+			size = len & SIZE_MASK;
+			if( size > buf.size() )
+				return POP_MORE_DATA;
+
+			std::memcpy(buf.data(), rec + 1, size);
+
+			const std::uint64_t need = align8(sizeof(record_t) + size);
+			std::memset(rec, 0, static_cast<std::size_t>(need));
+			header_->read_.store(pos + need, std::memory_order_release);
+
+			return POP_OK;
+		}
+	}
+
+	shm_channel_t::pop_result_t shm_channel_t::_spin_pop(service::mutable_buffer_t &buf, std::uint32_t &size)
+	{
+		pop_result_t ret = _pop(buf, size);
+		for(std::uint32_t i = 0; ret == POP_EMPTY && i != spin_; ++i)
+		{
+			::YieldProcessor();
+			ret = _pop(buf, size);
+		}
+
+		return ret;
+	}
+
+	void shm_channel_t::_notify()
+	{
+		// _parkԳƣύȴ־֮Ҫȫ
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if( header_->waiting_.load(std::memory_order_relaxed) != 0 &&
+			header_->waiting_.exchange(0) != 0 )
+			::SetEvent(event_);
+	}
+
+	void shm_channel_t::_park()
+	{
+		header_->waiting_.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		std::error_code error;
+		std::uint32_t size = 0;
+
+		Lock lock(mutex_);
+
+		// ñ־ټһΣд˵ύʧ
+		service::mutable_buffer_t buf(pending_data_, pending_size_);
+		pop_result_t ret = cancel_ ? POP_EMPTY : _pop(buf, size);
+		if( ret == POP_EMPTY && !cancel_ )
+		{
+			if( ::RegisterWaitForSingleObject(&wait_, event_, &shm_channel_t::_on_signal, this, INFINITE, WT_EXECUTEONLYONCE) )
+				return;
+
+			wait_ = nullptr;
+			error = std::error_code(::GetLastError(), std::system_category());
+		}
+		else if( cancel_ )
+			error = std::error_code(ERROR_OPERATION_ABORTED, std::system_category());
+		else if( ret == POP_MORE_DATA )
+			error = std::error_code(ERROR_MORE_DATA, std::system_category());
+
+		header_->waiting_.store(0, std::memory_order_relaxed);
+
+		read_handler_t handler;
+		handler.swap(pending_handler_);
+		std::shared_ptr<shm_channel_t> self;
+		self.swap(pending_self_);
+		cancel_ = false;
+		lock.unlock();
+
+		handler(error, size);
+	}
+
+	void shm_channel_t::_resume()
+	{
+		{
+			Lock lock(mutex_);
+
+			// һԵȴѾע
+			if( wait_ != nullptr )
+			{
+				::UnregisterWaitEx(wait_, nullptr);
+				wait_ = nullptr;
+			}
+		}
+
+		_park();
+	}
+
+	void CALLBACK shm_channel_t::_on_signal(PVOID param, BOOLEAN)
+	{
+		// ڼpending_self_ͨ
+		auto channel = static_cast<shm_channel_t *>(param);
+
+		try
+		{
+			channel->io_.post([channel](const std::error_code &, std::uint32_t)
+			{
+				channel->_resume();
+			}, callback_pool());
+		}
+		catch(::exception::exception_base &e)
+		{
+			e.dump();
+		}
+	}
+}
+}
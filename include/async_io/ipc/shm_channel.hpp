@@ -0,0 +1,149 @@
+#ifndef __ASYNC_IPC_SHM_CHANNEL_HPP
+#define __ASYNC_IPC_SHM_CHANNEL_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <functional>
+#include <system_error>
+
+#include "../service/dispatcher.hpp"
+#include "../service/read_write_buffer.hpp"
+#include "../service/exception.hpp"
+#include "../../utility/move_wrapper.hpp"
+
+
+namespace async { namespace ipc {
+
+	// -------------------------------------------------
+	// class shm_channel_t
+
+	// ڹڴ滷λĵϢ֮ͨͬʹá
+	// д˿ж(̻߳)ͨCASԤռ䣬дλ¼ͷύֻһ
+	// ȴȻûʱڹͷõȴ־дֻڿñ־ʱSetEvent
+	// ˶æʱд벻κϵͳáڼ̳߳صȴ¼ѺdispatcherIO߳ϻص
+	// socketһѾʱֱڵ̻߳ص
+	class shm_channel_t
+		: public std::enable_shared_from_this<shm_channel_t>
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+	public:
+		typedef service::io_dispatcher_t	dispatcher_type;
+		typedef std::function<void(const std::error_code &, std::uint32_t)> read_handler_t;
+
+		static const std::uint32_t DEFAULT_SPIN = 4000;
+
+	private:
+		struct header_t;
+		struct record_t;
+
+		dispatcher_type &io_;
+		HANDLE mapping_;
+		HANDLE event_;
+		header_t *header_;
+		char *data_;
+		std::uint64_t mask_;
+		std::uint32_t spin_;
+
+		// Ķͬһʱһ
+		Mutex mutex_;
+		HANDLE wait_;
+		bool cancel_;
+		char *pending_data_;
+		std::size_t pending_size_;
+		read_handler_t pending_handler_;
+		std::shared_ptr<shm_channel_t> pending_self_;
+
+	public:
+		// ͨcapacityΪ2ݣϢcapacity / 2
+		shm_channel_t(dispatcher_type &io, const std::string &name, std::uint32_t capacity);
+		// Ѵͨ
+		shm_channel_t(dispatcher_type &io, const std::string &name);
+		~shm_channel_t();
+
+	private:
+		shm_channel_t(const shm_channel_t &);
+		shm_channel_t &operator=(const shm_channel_t &);
+
+	public:
+		std::uint32_t capacity() const
+		{
+			return static_cast<std::uint32_t>(mask_ + 1);
+		}
+
+		// ǰ
+		void set_spin(std::uint32_t spin)
+		{
+			spin_ = spin;
+		}
+
+		// дһϢռ䲻ʱfalse
+		bool write(const service::const_buffer_t &buf);
+
+		// ȡһϢûϢʱfalsebufʱ쳣Ϣͨ
+		bool try_read(service::mutable_buffer_t &buf, std::uint32_t &size);
+
+		// 첽ȡһϢhandler(error, size)bufʱERROR_MORE_DATAصsizeΪϢȣ
+		// ϢͨСshared_ptrУڼ䱣ִ
+		// Ļͨڲľ̬ͶݣallocatorֻڱεڼЧ
+		template < typename HandlerT, typename AllocatorT >
+		void async_read(service::mutable_buffer_t &buf, HandlerT &&handler, AllocatorT &allocator);
+
+		// ȡĶERROR_OPERATION_ABORTEDص
+		void cancel();
+
+	private:
+		void _map(const std::string &name, std::uint32_t capacity, bool create);
+
+		enum pop_result_t { POP_EMPTY, POP_OK, POP_MORE_DATA };
+		pop_result_t _pop(service::mutable_buffer_t &buf, std::uint32_t &size);
+		pop_result_t _spin_pop(service::mutable_buffer_t &buf, std::uint32_t &size);
+		void _notify();
+
+		void _park();
+		void _resume();
+		static void CALLBACK _on_signal(PVOID param, BOOLEAN timeout);
+	};
+
+	typedef std::shared_ptr<shm_channel_t> shm_channel_ptr;
+
+
+	template < typename HandlerT, typename AllocatorT >
+	void shm_channel_t::async_read(service::mutable_buffer_t &buf, HandlerT &&handler, AllocatorT &allocator)
+	{
+		std::uint32_t size = 0;
+		const pop_result_t ret = _spin_pop(buf, size);
+		if( ret != POP_EMPTY )
+		{
+			handler(ret == POP_OK ? std::error_code() : std::error_code(ERROR_MORE_DATA, std::system_category()), size);
+			return;
+		}
+
+		auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
+
+		Lock lock(mutex_);
+		if( pending_handler_ )
+			throw service::network_exception("shm channel already has a pending read");
+
+		pending_data_ = buf.data();
+		pending_size_ = buf.size();
+		pending_handler_ = [handler_val](const std::error_code &error, std::uint32_t size)
+		{
+			handler_val.value_(error, size);
+		};
+		pending_self_ = shared_from_this();
+		lock.unlock();
+
+		_park();
+	}
+}
+}
+
+
+
+
+#endif
@@ -0,0 +1,338 @@
+#ifndef __ASYNC_LOGGER_DETAIL_LOG_RECORD_HPP
+#define __ASYNC_LOGGER_DETAIL_LOG_RECORD_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+
+namespace async { namespace logger { namespace detail {
+
+	// -------------------------------------------------
+	// д¼̨߳ٸʽ
+
+	typedef std::string out_buffer_t;
+
+	inline void append(out_buffer_t &out, bool val)
+	{
+		out.append(val ? "true" : "false");
+	}
+
+	inline void append(out_buffer_t &out, char val)
+	{
+		out.push_back(val);
+	}
+
+	inline void append(out_buffer_t &out, std::int64_t val)
+	{
+		char buf[32] = {0};
+		::_i64toa_s(val, buf, _countof(buf), 10);
+		out.append(buf);
+	}
+
+	inline void append(out_buffer_t &out, std::uint64_t val)
+	{
+		char buf[32] = {0};
+		::_ui64toa_s(val, buf, _countof(buf), 10);
+		out.append(buf);
+	}
+
+	inline void append(out_buffer_t &out, double val)
+	{
+		char buf[64] = {0};
+		const int len = ::_snprintf_s(buf, _countof(buf), _TRUNCATE, "%g", val);
+		out.append(buf, len < 0 ? std::strlen(buf) : len);
+	}
+
+	inline void append(out_buffer_t &out, const void *val)
+	{
+		char buf[32] = {0};
+		const int len = ::_snprintf_s(buf, _countof(buf), _TRUNCATE, "0x%p", val);
+		out.append(buf, len < 0 ? std::strlen(buf) : len);
+	}
+
+
+	// ͡öٺָ밴ֵ
+	template < typename T, typename EnableT = void >
+	struct arg_traits_t
+	{
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+			"log argument must be arithmetic, enum, pointer or string");
+
+		static std::size_t size(const T &)
+		{
+			return sizeof(T);
+		}
+
+		static char *encode(char *p, const T &val)
+		{
+			std::memcpy(p, &val, sizeof(T));
+			return p + sizeof(T);
+		}
+
+		static const char *format(out_buffer_t &out, const char *p)
+		{
+			T val;
+			std::memcpy(&val, p, sizeof(T));
+			_append(out, val, std::integral_constant<int,
+				std::is_same<T, bool>::value || std::is_same<T, char>::value ? 0 :
+				std::is_floating_point<T>::value ? 1 :
+				std::is_pointer<T>::value ? 2 :
+				std::is_signed<T>::value || std::is_enum<T>::value ? 3 : 4>());
+			return p + sizeof(T);
+		}
+
+	private:
+		static void _append(out_buffer_t &out, const T &val, std::integral_constant<int, 0>)	{ append(out, val); }
+		static void _append(out_buffer_t &out, const T &val, std::integral_constant<int, 1>)	{ append(out, static_cast<double>(val)); }
+		static void _append(out_buffer_t &out, const T &val, std::integral_constant<int, 2>)	{ append(out, reinterpret_cast<const void *>(val)); }
+		static void _append(out_buffer_t &out, const T &val, std::integral_constant<int, 3>)	{ append(out, static_cast<std::int64_t>(val)); }
+		static void _append(out_buffer_t &out, const T &val, std::integral_constant<int, 4>)	{ append(out, static_cast<std::uint64_t>(val)); }
+	};
+
+	// ַݣǰ
+	struct string_traits_t
+	{
+		static std::size_t size(const char *val, std::size_t len)
+		{
+			return sizeof(std::uint32_t) + len;
+		}
+
+		static char *encode(char *p, const char *val, std::size_t len)
+		{
+			const std::uint32_t size = static_cast<std::uint32_t>(len);
+			std::memcpy(p, &size, sizeof(size));
+			std::memcpy(p + sizeof(size), val, len);
+			return p + sizeof(size) + len;
+		}
+
+		static const char *format(out_buffer_t &out, const char *p)
+		{
+			std::uint32_t size = 0;
+			std::memcpy(&size, p, sizeof(size));
+			out.append(p + sizeof(size), size);
+			return p + sizeof(size) + size;
+		}
+	};
+
+	template < typename T >
+	struct arg_traits_t<T, typename std::enable_if<std::is_same<T, const char *>::value || std::is_same<T, char *>::value>::type>
+	{
+		static std::size_t size(const char *val)
+		{
+			return string_traits_t::size(val, val == nullptr ? 0 : std::strlen(val));
+		}
+
+		static char *encode(char *p, const char *val)
+		{
+			return string_traits_t::encode(p, val, val == nullptr ? 0 : std::strlen(val));
+		}
+
+		static const char *format(out_buffer_t &out, const char *p)
+		{
+			return string_traits_t::format(out, p);
+		}
+	};
+
+	template < >
+	struct arg_traits_t<std::string, void>
+	{
+		static std::size_t size(const std::string &val)
+		{
+			return string_traits_t::size(val.data(), val.size());
+		}
+
+		static char *encode(char *p, const std::string &val)
+		{
+			return string_traits_t::encode(p, val.data(), val.size());
+		}
+
+		static const char *format(out_buffer_t &out, const char *p)
+		{
+			return string_traits_t::format(out, p);
+		}
+	};
+
+
+	// ͣ˻Ϊָ
+	template < typename T >
+	struct arg_type_t
+	{
+		typedef typename std::decay<T>::type type;
+	};
+
+
+	inline std::size_t args_size()
+	{
+		return 0;
+	}
+
+	template < typename T, typename ...Args >
+	std::size_t args_size(const T &val, const Args &...args)
+	{
+		typedef typename arg_type_t<T>::type type;
+		return arg_traits_t<type>::size(val) + args_size(args...);
+	}
+
+	inline char *encode_args(char *p)
+	{
+		return p;
+	}
+
+	template < typename T, typename ...Args >
+	char *encode_args(char *p, const T &val, const Args &...args)
+	{
+		typedef typename arg_type_t<T>::type type;
+		return encode_args(arg_traits_t<type>::encode(p, val), args...);
+	}
+
+
+	// ʽе{}滻ΪĲԿոָĩβ
+	inline void format_text(out_buffer_t &out, const char *&fmt, bool to_end)
+	{
+		const char *pos = to_end ? nullptr : std::strstr(fmt, "{}");
+		if( pos == nullptr )
+		{
+			out.append(fmt);
+			fmt += std::strlen(fmt);
+			if( !to_end )
+				out.push_back(' ');
+			return;
+		}
+
+		out.append(fmt, pos - fmt);
+		fmt = pos + 2;
+	}
+
+	template < typename ...Args >
+	struct formatter_t;
+
+	template < >
+	struct formatter_t<>
+	{
+		static void format(out_buffer_t &out, const char *fmt, const char *)
+		{
+			format_text(out, fmt, true);
+		}
+	};
+
+	template < typename T, typename ...Args >
+	struct formatter_t<T, Args...>
+	{
+		static void format(out_buffer_t &out, const char *fmt, const char *p)
+		{
+			format_text(out, fmt, false);
+			p = arg_traits_t<T>::format(out, p);
+			formatter_t<Args...>::format(out, fmt, p);
+		}
+	};
+
+	typedef void (*format_t)(out_buffer_t &, const char *, const char *);
+
+
+	// -------------------------------------------------
+	// ¼ͷ¼Ȱ8ֽڶ
+
+	struct record_t
+	{
+		static const std::uint32_t PADDING = 0x80000000;	// βŲʱ
+
+		std::uint32_t size_;
+		std::uint32_t level_;
+		std::uint64_t time_us_;
+		format_t format_;
+		const char *fmt_;
+	};
+
+	inline std::uint32_t record_size(std::size_t args)
+	{
+		return static_cast<std::uint32_t>((sizeof(record_t) + args + 7) & ~std::size_t(7));
+	}
+
+
+	// -------------------------------------------------
+	// class thread_buffer_t
+
+	// ߵ߻λÿд־߳һֻдhead_ֻдtail_
+	struct thread_buffer_t
+	{
+		char *data_;
+		const std::uint32_t capacity_;
+		const std::uint32_t thread_id_;
+		char padding0_[52];
+
+		std::atomic<std::uint64_t> head_;
+		std::uint64_t cached_tail_;							// ߿tail_ռ䲻ʱض
+		std::atomic<std::uint64_t> dropped_;
+		char padding1_[40];
+
+		std::atomic<std::uint64_t> tail_;
+		std::uint64_t reported_;							// ѱĶ
+
+		thread_buffer_t(std::uint32_t capacity, std::uint32_t thread_id)
+			: data_(static_cast<char *>(::_aligned_malloc(capacity, 64)))
+			, capacity_(capacity)
+			, thread_id_(thread_id)
+			, head_(0)
+			, cached_tail_(0)
+			, dropped_(0)
+			, tail_(0)
+			, reported_(0)
+		{
+			if( data_ == nullptr )
+				throw std::bad_alloc();
+		}
+
+		~thread_buffer_t()
+		{
+			::_aligned_free(data_);
+		}
+
+		// Ԥsizeֽڣռ䲻㷵nullptrβŲʱд䣬¼ͷʼ
+		char *reserve(std::uint32_t size, std::uint64_t &next)
+		{
+			const std::uint64_t head = head_.load(std::memory_order_relaxed);
+			const std::uint32_t offset = static_cast<std::uint32_t>(head & (capacity_ - 1));
+			const std::uint32_t tail_room = capacity_ - offset;
+			const std::uint32_t total = size <= tail_room ? size : size + tail_room;
+
+			if( head + total - cached_tail_ > capacity_ )
+			{
+				cached_tail_ = tail_.load(std::memory_order_acquire);
+				if( head + total - cached_tail_ > capacity_ )
+					return nullptr;
+			}
+
+			next = head + total;
+			if( size <= tail_room )
+				return data_ + offset;
+
+			reinterpret_cast<record_t *>(data_ + offset)->size_ = tail_room | record_t::PADDING;
+			return data_;
+		}
+
+		void commit(std::uint64_t next)
+		{
+			head_.store(next, std::memory_order_release);
+		}
+
+		std::uint32_t used() const
+		{
+			return static_cast<std::uint32_t>(head_.load(std::memory_order_relaxed) - cached_tail_);
+		}
+
+	private:
+		thread_buffer_t(const thread_buffer_t &);
+		thread_buffer_t &operator=(const thread_buffer_t &);
+	};
+}
+}
+}
+
+
+#endif
@@ -0,0 +1,349 @@
+#include "logger.hpp"
+
+#include <cassert>
+
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+
+namespace async { namespace logger {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		// ÿloggerһţ̻߳Ļ֣loggerloggerĵַ
+		std::atomic<std::uint64_t> next_id(1);
+
+		__declspec(thread) std::uint64_t local_owner = 0;
+		__declspec(thread) detail::thread_buffer_t *local_buffer = nullptr;
+
+		const char *const LEVEL_NAMES[] = { "TRACE", "DEBUG", "INFO ", "WARN ", "ERROR" };
+	}
+
+
+	logger_t::logger_t(dispatcher_type &io, const std::wstring &path, const logger_config_t &config)
+		: io_(io)
+		, config_(config)
+		, id_(next_id++)
+		, level_(config.level_)
+		, file_(io, path, filesystem::file_engine_t::WRITE | filesystem::file_engine_t::CREATE)
+		, offset_(0)
+		, event_(nullptr)
+		, stop_(false)
+		, flush_requested_(0)
+		, flush_done_(0)
+		, writing_(false)
+		, base_us_(0)
+		, base_filetime_(0)
+		, cached_second_(0)
+		, records_(0)
+		, bytes_(0)
+		, batches_(0)
+		, errors_(0)
+	{
+		assert(config_.buffer_size_ != 0 && (config_.buffer_size_ & (config_.buffer_size_ - 1)) == 0);
+
+		offset_ = file_.size();
+
+		FILETIME now = {0}, local = {0};
+		::GetSystemTimeAsFileTime(&now);
+		::FileTimeToLocalFileTime(&now, &local);
+		base_filetime_ = (static_cast<std::uint64_t>(local.dwHighDateTime) << 32) | local.dwLowDateTime;
+		base_us_ = service::monotonic_us();
+		cached_prefix_[0] = 0;
+
+		batch_.reserve(config_.batch_size_ + 4096);
+		writing_batch_.reserve(config_.batch_size_ + 4096);
+
+		event_ = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+		if( event_ == nullptr )
+			throw service::win32_exception_t("CreateEvent");
+
+		thread_ = std::thread([this]() { _run(); });
+	}
+
+	logger_t::~logger_t()
+	{
+		stop_ = true;
+		::SetEvent(event_);
+		thread_.join();
+
+		::CloseHandle(event_);
+	}
+
+	void logger_t::flush()
+	{
+		Lock lock(flush_mutex_);
+		const std::uint64_t target = ++flush_requested_;
+		::SetEvent(event_);
+
+		flush_cond_.wait(lock, [this, target]() { return flush_done_ >= target; });
+	}
+
+	logger_stats_t logger_t::stats()
+	{
+		logger_stats_t stats = {0};
+		stats.records_ = records_;
+		stats.bytes_ = bytes_;
+		stats.batches_ = batches_;
+		stats.errors_ = errors_;
+
+		Lock lock(buffers_mutex_);
+		stats.threads_ = static_cast<std::uint32_t>(buffers_.size());
+		for(auto &buffer : buffers_)
+			stats.dropped_ += buffer->dropped_.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
+	detail::thread_buffer_t *logger_t::_local()
+	{
+		if( local_owner == id_ )
+			return local_buffer;
+
+		return _register();
+	}
+
+	detail::thread_buffer_t *logger_t::_register()
+	{
+		const std::uint32_t thread_id = ::GetCurrentThreadId();
+
+		Lock lock(buffers_mutex_);
+
+		// ߳̽ʹöloggerʱʧЧ̺߳һأ̺߳űʱ߳˳ǵ
+		detail::thread_buffer_t *buffer = nullptr;
+		for(auto &val : buffers_)
+		{
+			if( val->thread_id_ == thread_id )
+			{
+				buffer = val.get();
+				break;
+			}
+		}
+
+		if( buffer == nullptr )
+		{
+			buffers_.emplace_back(new detail::thread_buffer_t(config_.buffer_size_, thread_id));
+			buffer = buffers_.back().get();
+		}
+
+		local_owner = id_;
+		local_buffer = buffer;
+		return buffer;
+	}
+
+	char *logger_t::_overflow(detail::thread_buffer_t *buffer, std::uint32_t size, std::uint64_t &next)
+	{
+		// ļ¼޷֤ŵ
+		if( config_.overflow_ == OVERFLOW_BLOCK && size <= buffer->capacity_ / 2 )
+		{
+			while( !stop_.load(std::memory_order_relaxed) )
+			{
+				::SetEvent(event_);
+				::SwitchToThread();
+
+				char *p = buffer->reserve(size, next);
+				if( p != nullptr )
+					return p;
+			}
+		}
+
+		buffer->dropped_.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	void logger_t::_notify(detail::thread_buffer_t *buffer)
+	{
+		// used()߻tail_㣬ˢ£̨߳ȡߺÿλ
+		buffer->cached_tail_ = buffer->tail_.load(std::memory_order_acquire);
+		if( buffer->used() > buffer->capacity_ / 2 )
+			::SetEvent(event_);
+	}
+
+	void logger_t::_run()
+	{
+		std::vector<detail::thread_buffer_t *> buffers;
+
+		for(;;)
+		{
+			::WaitForSingleObject(event_, config_.flush_interval_ms_);
+			const bool stop = stop_.load();
+
+			std::uint64_t requested = 0;
+			{
+				Lock lock(flush_mutex_);
+				requested = flush_requested_;
+			}
+
+			{
+				Lock lock(buffers_mutex_);
+				buffers.clear();
+				for(auto &buffer : buffers_)
+					buffers.push_back(buffer.get());
+			}
+
+			// ȡ̵߳ļ¼ֱȫΪ
+			for(bool more = true; more; )
+			{
+				more = false;
+				for(auto buffer : buffers)
+					more = _drain(buffer) || more;
+			}
+
+			_write(true);
+
+			{
+				Lock lock(flush_mutex_);
+				flush_done_ = requested;
+			}
+			flush_cond_.notify_all();
+
+			if( stop )
+				break;
+		}
+	}
+
+	bool logger_t::_drain(detail::thread_buffer_t *buffer)
+	{
+		_format_dropped(buffer);
+
+		const std::uint64_t head = buffer->head_.load(std::memory_order_acquire);
+		std::uint64_t tail = buffer->tail_.load(std::memory_order_relaxed);
+		if( head == tail )
+			return false;
+
+		while( tail != head )
+		{
+			const detail::record_t *record = reinterpret_cast<const detail::record_t *>(buffer->data_ + (tail & (buffer->capacity_ - 1)));
+			if( record->size_ & detail::record_t::PADDING )
+			{
+				tail += record->size_ & ~detail::record_t::PADDING;
+				continue;
+			}
+
+			_format(record, buffer->thread_id_);
+			tail += record->size_;
+
+			// ܹһȹ黹ռде߿Լ
+			if( batch_.size() >= config_.batch_size_ )
+			{
+				buffer->tail_.store(tail, std::memory_order_release);
+				_write(false);
+			}
+		}
+
+		buffer->tail_.store(tail, std::memory_order_release);
+		return true;
+	}
+
+	void logger_t::_prefix(std::uint64_t time_us, std::uint32_t level, std::uint32_t thread_id)
+	{
+		const std::int64_t diff = static_cast<std::int64_t>(time_us - base_us_);
+		const std::uint64_t filetime = base_filetime_ + diff * 10;
+		const std::uint64_t second = filetime / 10000000;
+
+		// ͬһڵļ¼ڲ
+		if( second != cached_second_ || cached_prefix_[0] == 0 )
+		{
+			FILETIME val = {0};
+			val.dwLowDateTime = static_cast<DWORD>(filetime);
+			val.dwHighDateTime = static_cast<DWORD>(filetime >> 32);
+
+			SYSTEMTIME time = {0};
+			::FileTimeToSystemTime(&val, &time);
+			::_snprintf_s(cached_prefix_, _countof(cached_prefix_), _TRUNCATE, "%04u-%02u-%02u %02u:%02u:%02u",
+				time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond);
+			cached_second_ = second;
+		}
+
+		char buf[64] = {0};
+		const int len = ::_snprintf_s(buf, _countof(buf), _TRUNCATE, "%s.%06u %s [%u] ", cached_prefix_,
+			static_cast<std::uint32_t>(filetime % 10000000 / 10), LEVEL_NAMES[level < _countof(LEVEL_NAMES) ? level : LEVEL_ERROR], thread_id);
+		batch_.append(buf, len < 0 ? std::strlen(buf) : len);
+	}
+
+	void logger_t::_format(const detail::record_t *record, std::uint32_t thread_id)
+	{
+		_prefix(record->time_us_, record->level_, thread_id);
+		record->format_(batch_, record->fmt_, reinterpret_cast<const char *>(record + 1));
+		batch_.push_back('\n');
+
+		records_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void logger_t::_format_dropped(detail::thread_buffer_t *buffer)
+	{
+		const std::uint64_t dropped = buffer->dropped_.load(std::memory_order_relaxed);
+		if( dropped == buffer->reported_ )
+			return;
+
+		if( config_.overflow_ == OVERFLOW_COUNT )
+		{
+			_prefix(service::monotonic_us(), LEVEL_WARN, buffer->thread_id_);
+			batch_.append("log buffer overflow, records dropped: ");
+			detail::append(batch_, dropped - buffer->reported_);
+			batch_.push_back('\n');
+		}
+
+		buffer->reported_ = dropped;
+	}
+
+	void logger_t::_write(bool wait)
+	{
+		if( !batch_.empty() )
+		{
+			// һдܸĻ
+			_wait_write();
+
+			batch_.swap(writing_batch_);
+			batch_.clear();
+
+			{
+				Lock lock(write_mutex_);
+				writing_ = true;
+			}
+
+			const std::uint64_t offset = offset_;
+			offset_ += writing_batch_.size();
+
+			try
+			{
+				service::const_buffer_t buf(writing_batch_.data(), writing_batch_.size());
+				file_.async_write(buf, offset, [this](const std::error_code &error, std::uint32_t size)
+				{
+					if( error )
+						errors_.fetch_add(1, std::memory_order_relaxed);
+					else
+						bytes_.fetch_add(size, std::memory_order_relaxed);
+					batches_.fetch_add(1, std::memory_order_relaxed);
+
+					// ̨֪ͨ߳logger漴
+					Lock lock(write_mutex_);
+					writing_ = false;
+					write_cond_.notify_all();
+				}, callback_pool());
+			}
+			catch(const exception::exception_base &)
+			{
+				errors_.fetch_add(1, std::memory_order_relaxed);
+
+				Lock lock(write_mutex_);
+				writing_ = false;
+			}
+		}
+
+		if( wait )
+			_wait_write();
+	}
+
+	void logger_t::_wait_write()
+	{
+		Lock lock(write_mutex_);
+		write_cond_.wait(lock, [this]() { return !writing_; });
+	}
+}
+}
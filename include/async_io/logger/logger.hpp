@@ -0,0 +1,218 @@
+#ifndef __ASYNC_LOGGER_LOGGER_HPP
+#define __ASYNC_LOGGER_LOGGER_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <string>
+#include <vector>
+#include <system_error>
+
+#include "../service/dispatcher.hpp"
+#include "../service/clock.hpp"
+#include "../file/file_engine.hpp"
+#include "detail/log_record.hpp"
+
+
+namespace async { namespace logger {
+
+	enum level_t
+	{
+		LEVEL_TRACE,
+		LEVEL_DEBUG,
+		LEVEL_INFO,
+		LEVEL_WARN,
+		LEVEL_ERROR
+	};
+
+	// ̻߳ʱĴ
+	enum overflow_t
+	{
+		OVERFLOW_BLOCK,		// ȴ̨߳ڳռ
+		OVERFLOW_DROP,		// ֻͳ
+		OVERFLOW_COUNT		// ־м¼
+	};
+
+	struct logger_config_t
+	{
+		std::uint32_t buffer_size_;			// ÿ̵߳Ļ2
+		std::uint32_t batch_size_;			// ܹóȼдļ
+		std::uint32_t flush_interval_ms_;	// ûܹʱȴ
+		overflow_t overflow_;
+		level_t level_;
+
+		logger_config_t()
+			: buffer_size_(1024 * 1024)
+			, batch_size_(1024 * 1024)
+			, flush_interval_ms_(10)
+			, overflow_(OVERFLOW_COUNT)
+			, level_(LEVEL_INFO)
+		{}
+	};
+
+	struct logger_stats_t
+	{
+		std::uint64_t records_;		// Ѹʽд
+		std::uint64_t dropped_;
+		std::uint64_t bytes_;
+		std::uint64_t batches_;		// дļ
+		std::uint64_t errors_;		// дļʧܴ
+		std::uint32_t threads_;
+	};
+
+
+	// -------------------------------------------------
+	// class logger_t
+
+	// 첽־д־̰߳ѸʽָͲĶƿ뱾̵߳λأ
+	// ʽϵͳą̃߳ȡ̵߳ļ¼ʽܳɴ龭file_engine_t׷д롣
+	// ʽе{}滻ΪʽΪ̬洢()Ϊ͡ö١ַָ()
+	// ͬһ̵߳ļ¼˳򣬲֮ͬ߳䰴̵̨߳ѯ˳
+	class logger_t
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+	public:
+		typedef service::io_dispatcher_t	dispatcher_type;
+
+	private:
+		dispatcher_type &io_;
+		const logger_config_t config_;
+		const std::uint64_t id_;
+		std::atomic<std::uint32_t> level_;
+
+		filesystem::file_engine_t file_;
+		std::uint64_t offset_;
+
+		// עֻ̻߳
+		Mutex buffers_mutex_;
+		std::vector<std::unique_ptr<detail::thread_buffer_t>> buffers_;
+
+		// ̨߳
+		HANDLE event_;
+		std::thread thread_;
+		std::atomic<bool> stop_;
+
+		// flushɵ
+		Mutex flush_mutex_;
+		std::condition_variable flush_cond_;
+		std::uint64_t flush_requested_;
+		std::uint64_t flush_done_;
+
+		// ;ļдͬһʱһ
+		Mutex write_mutex_;
+		std::condition_variable write_cond_;
+		bool writing_;
+		std::string batch_;
+		std::string writing_batch_;
+
+		// ¼ʱΪʱӣʱԹʱıʱΪ׼
+		std::uint64_t base_us_;
+		std::uint64_t base_filetime_;
+		std::uint64_t cached_second_;
+		char cached_prefix_[32];
+
+		std::atomic<std::uint64_t> records_;
+		std::atomic<std::uint64_t> bytes_;
+		std::atomic<std::uint64_t> batches_;
+		std::atomic<std::uint64_t> errors_;
+
+	public:
+		// ׷дpathʱ
+		logger_t(dispatcher_type &io, const std::wstring &path, const logger_config_t &config = logger_config_t());
+		// дȫѼ¼־
+		~logger_t();
+
+	private:
+		logger_t(const logger_t &);
+		logger_t &operator=(const logger_t &);
+
+	public:
+		void set_level(level_t level)
+		{
+			level_.store(level, std::memory_order_relaxed);
+		}
+
+		bool is_enabled(level_t level) const
+		{
+			return static_cast<std::uint32_t>(level) >= level_.load(std::memory_order_relaxed);
+		}
+
+		template < typename ...Args >
+		void log(level_t level, const char *fmt, const Args &...args);
+
+		template < typename ...Args >
+		void trace(const char *fmt, const Args &...args)	{ log(LEVEL_TRACE, fmt, args...); }
+		template < typename ...Args >
+		void debug(const char *fmt, const Args &...args)	{ log(LEVEL_DEBUG, fmt, args...); }
+		template < typename ...Args >
+		void info(const char *fmt, const Args &...args)		{ log(LEVEL_INFO, fmt, args...); }
+		template < typename ...Args >
+		void warn(const char *fmt, const Args &...args)		{ log(LEVEL_WARN, fmt, args...); }
+		template < typename ...Args >
+		void error(const char *fmt, const Args &...args)	{ log(LEVEL_ERROR, fmt, args...); }
+
+		// ǰȫ¼дļ
+		void flush();
+
+		logger_stats_t stats();
+
+	private:
+		detail::thread_buffer_t *_local();
+		detail::thread_buffer_t *_register();
+		char *_overflow(detail::thread_buffer_t *buffer, std::uint32_t size, std::uint64_t &next);
+		void _notify(detail::thread_buffer_t *buffer);
+
+		void _run();
+		bool _drain(detail::thread_buffer_t *buffer);
+		void _prefix(std::uint64_t time_us, std::uint32_t level, std::uint32_t thread_id);
+		void _format(const detail::record_t *record, std::uint32_t thread_id);
+		void _format_dropped(detail::thread_buffer_t *buffer);
+		void _write(bool wait);
+		void _wait_write();
+	};
+
+	typedef std::shared_ptr<logger_t> logger_ptr;
+
+
+	template < typename ...Args >
+	void logger_t::log(level_t level, const char *fmt, const Args &...args)
+	{
+		if( !is_enabled(level) )
+			return;
+
+		detail::thread_buffer_t *buffer = _local();
+
+		const std::uint32_t size = detail::record_size(detail::args_size(args...));
+		std::uint64_t next = 0;
+		char *p = buffer->reserve(size, next);
+		if( p == nullptr )
+		{
+			p = _overflow(buffer, size, next);
+			if( p == nullptr )
+				return;
+		}
+
+		detail::record_t *record = reinterpret_cast<detail::record_t *>(p);
+		record->size_ = size;
+		record->level_ = level;
+		record->time_us_ = service::now_us();
+		record->format_ = &detail::formatter_t<typename detail::arg_type_t<Args>::type...>::format;
+		record->fmt_ = fmt;
+		detail::encode_args(p + sizeof(detail::record_t), args...);
+
+		buffer->commit(next);
+
+		// һʱǰѺ̨߳
+		if( buffer->used() > buffer->capacity_ / 2 )
+			_notify(buffer);
+	}
+}
+}
+
+
+#endif
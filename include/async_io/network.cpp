@@ -2,8 +2,11 @@
 
 #include <sstream>
 #include <memory>
+#include <limits>
+#include <algorithm>
 
 #include "../win32/network/network_helper.hpp"
+#include "service/clock.hpp"
 
 
 
@@ -62,11 +65,29 @@ namespace async { namespace network {
 		session_allocator_pool_t session_allocator_pool_;
 		socket_pool_t socket_pool_;
 
-		std::unique_ptr<std::thread> thread_;
+		accept_engine_t accept_engine_;
+
+		// »ỰĬϵ
+		rate_limiter_ptr read_limiter_;
+		rate_limiter_ptr write_limiter_;
+
+		// Ự
+		std::atomic<std::uint64_t> session_id_;
+		session_registry_t<session> registry_;
+
+		// Ựʱ
+		static const std::uint32_t TIMEOUT_TICK = 100;	// ms
+
+		timer::timing_wheel_t wheel_;
+		std::uint32_t tick_id_;
+		std::uint64_t idle_ticks_;
+		std::uint64_t read_ticks_;
+		std::uint64_t write_ticks_;
+		std::uint64_t check_ticks_;
 
 		impl(server &svr, std::uint16_t port, std::uint32_t thr_cnt)
 			: svr_(svr)
-			, io_([this](const std::string &msg){ error_handle_(nullptr, msg); })
+			, io_([this](const std::string &msg){ error_handle_(nullptr, msg); }, thr_cnt)
 			, acceptor_(io_, tcp::v4(), port, INADDR_ANY, true)
 			, socket_pool_([this]()
 		{
@@ -81,7 +102,40 @@ namespace async { namespace network {
 
 			return sck;
 		})
+			, accept_engine_(acceptor_.get(),
+				[this]() { return socket_pool_.raw_aciquire(); },
+				[this](const std::error_code &error, std::shared_ptr<socket_handle_t> &remote_sck)
+				{
+					_handle_accept(error, remote_sck);
+				})
+			, session_id_(0)
+			, wheel_(service::now_ms(), TIMEOUT_TICK)
+			, tick_id_(0)
+			, idle_ticks_(0)
+			, read_ticks_(0)
+			, write_ticks_(0)
+			, check_ticks_(0)
+		{
+		}
+
+		bool _has_timeout() const
+		{
+			return idle_ticks_ != 0 || read_ticks_ != 0 || write_ticks_ != 0;
+		}
+
+		void _arm_timeout(const session_ptr &val)
 		{
+			if( !_has_timeout() )
+				return;
+
+			auto &node = val->timeout_;
+			node.self_ = val;
+
+			const std::uint64_t now = wheel_.now();
+			if( idle_ticks_ != 0 )
+				node.idle_deadline_ = now + idle_ticks_;
+
+			wheel_.schedule(node, now + std::min(idle_ticks_ != 0 ? idle_ticks_ : check_ticks_, check_ticks_));
 		}
 
 		void _handle_accept(const std::error_code &error, std::shared_ptr<socket_handle_t> &remote_sck)
@@ -95,61 +149,74 @@ namespace async { namespace network {
 				return;
 			}
 
+			if( read_limiter_ || write_limiter_ )
+				val->set_rate_limiter(read_limiter_, write_limiter_);
+
+			registry_.insert(val->id(), val);
+			_arm_timeout(val);
+
 			if( accept_handle_ != nullptr )
 			{
 				auto address = val->get_ip();
 				accept_handle_(val, address);
 			}
 		}
+	};
 
-		void _thread_impl()
-		{
-			static const std::uint32_t MAX_ACCEPT_NUM = 10;
-
-			// ͨʹWSAEventSelectжǷ㹻AcceptEx߼һĿͻ
-			HANDLE accept_event = ::CreateEvent(NULL, FALSE, FALSE, NULL);
-			::WSAEventSelect(acceptor_.native_handle(), accept_event, FD_ACCEPT);
-			tcp v4_ver = tcp::v4();
-
-			typedef stdex::allocator::pool_allocator_t<char, session_allocator_pool_t> pool_allocator_t;
-			pool_allocator_t pool_allocator(session_allocator_pool_);
+	std::uint64_t session::_expire(timer::wheel_node_t &node, std::uint64_t now)
+	{
+		auto &val = static_cast<timeout_node_t &>(node);
+		auto &svr_impl = *val.session_.svr_.impl_;
 
-			while( true )
+		std::uint64_t deadline = 0;
+		auto check = [&deadline](std::uint64_t tick)
+		{
+			if( tick != 0 && (deadline == 0 || tick < deadline) )
+				deadline = tick;
+		};
+		check(val.idle_deadline_.load(std::memory_order_relaxed));
+		check(val.read_deadline_.load(std::memory_order_relaxed));
+		check(val.write_deadline_.load(std::memory_order_relaxed));
+
+		// нֹֻƣֱӹҵֹtickдֹڹãcheck_ticksһ
+		if( deadline == 0 || deadline > now )
+			return std::min(deadline == 0 ? now + svr_impl.check_ticks_ : deadline, now + svr_impl.check_ticks_);
+
+		// ʱֵܳǿãͶݵĶϿȷŵãỰڴ
+		// еwheel_.cancelٴμֻͶweak_ptrIO߳lock
+		// Ựʱweak_ptrʧЧʱֵϵȴλص
+		if( !val.self_.expired() )
+		{
+			session_weak_ptr weak_val = val.self_;
+			svr_impl.io_.post([weak_val](const std::error_code &, std::uint32_t)
 			{
-				DWORD ret = ::WaitForSingleObjectEx(accept_event, INFINITE, TRUE);
-				if( ret == WAIT_FAILED || ret == WAIT_IO_COMPLETION )
-					break;
-				else if( ret != WAIT_OBJECT_0 )
-					continue;
-
-				// Ͷݽ
-				for( std::uint32_t i = 0; i != MAX_ACCEPT_NUM; ++i )
-				{
-					auto sck = socket_pool_.raw_aciquire();
-
-					try
-					{
-						acceptor_.async_accept(std::move(sck),
-											   std::bind(&impl::_handle_accept, this, service::_Error, service::_Socket),
-											   pool_allocator);
-					}
-					catch( std::exception &/*e*/)
-					{
-						assert(0);
-					}
-				}
+				auto this_val = weak_val.lock();
+				if( this_val )
+					this_val->disconnect();
+			}, svr_impl.session_allocator_pool_);
+		}
 
-			}
+		return 0;
+	}
 
-			::CloseHandle(accept_event);
-		}
-	};
+	session::timeout_node_t::timeout_node_t(session &val, expire_handler_t handler)
+		: timer::wheel_node_t(handler)
+		, session_(val)
+		, idle_deadline_(0)
+		, read_deadline_(0)
+		, write_deadline_(0)
+	{}
 
 	session::session(server &svr, std::shared_ptr<socket_handle_t> &&sck, 
 		const error_handler_type &error_handler, const disconnect_handler_type &disconnect_handler)
 		: svr_(svr)
+		, id_(++svr.impl_->session_id_)
 		, sck_(std::move(sck))
+		, stream_(*sck_)
 		, data_(nullptr)
+		, timeout_(*this, &session::_expire)
+		, disconnected_(false)
+		, sending_(false)
 		, error_handler_(error_handler)
 		, disconnect_handler_(disconnect_handler)
 	{
@@ -157,6 +224,8 @@ namespace async { namespace network {
 	}
 	session::~session()
 	{
+		svr_.impl_->registry_.erase(id_);
+		svr_.impl_->wheel_.cancel(timeout_);
 		svr_.impl_->socket_pool_.raw_release(std::move(sck_));
 	}
 
@@ -177,8 +246,93 @@ namespace async { namespace network {
 		sck_->cancel();
 	}
 
+	void session::set_rate_limiter(const rate_limiter_ptr &read_limiter, const rate_limiter_ptr &write_limiter)
+	{
+		stream_.set_limiter(read_limiter, write_limiter, shared_from_this());
+	}
+
+	void session::set_frame_format(const frame_format_t &format)
+	{
+		decoder_.reset(new frame_decoder_t(format));
+	}
+
+	void session::async_send(const payload_ptr &payload)
+	{
+		assert(payload);
+
+		{
+			std::lock_guard<std::mutex> lock(send_mutex_);
+			send_queue_.push_back(payload);
+			if( sending_ )
+				return;
+
+			sending_ = true;
+		}
+
+		_send_next();
+	}
+
+	void session::_send_next()
+	{
+		payload_ptr payload;
+		{
+			std::lock_guard<std::mutex> lock(send_mutex_);
+			if( send_queue_.empty() )
+			{
+				sending_ = false;
+				return;
+			}
+
+			payload = std::move(send_queue_.front());
+			send_queue_.pop_front();
+		}
+
+		// дʧʱص֮ŶӵỰһͷ
+		const service::const_buffer_t buffer(payload->data(), static_cast<std::uint32_t>(payload->size()));
+		if( !async_write(buffer, [payload](const session_ptr &val, std::uint32_t)
+			{
+				val->_send_next();
+			}, svr_.impl_->session_allocator_pool_) )
+		{
+			std::lock_guard<std::mutex> lock(send_mutex_);
+			send_queue_.clear();
+		}
+	}
+
+	void session::_io_begin(bool is_read_op)
+	{
+		auto &svr_impl = *svr_.impl_;
+		const std::uint64_t ticks = is_read_op ? svr_impl.read_ticks_ : svr_impl.write_ticks_;
+		if( ticks == 0 )
+			return;
+
+		auto &deadline = is_read_op ? timeout_.read_deadline_ : timeout_.write_deadline_;
+		deadline.store(svr_impl.wheel_.now() + ticks, std::memory_order_relaxed);
+	}
+
+	void session::_io_end(bool is_read_op)
+	{
+		auto &svr_impl = *svr_.impl_;
+		if( !svr_impl._has_timeout() )
+			return;
+
+		auto &deadline = is_read_op ? timeout_.read_deadline_ : timeout_.write_deadline_;
+		deadline.store(0, std::memory_order_relaxed);
+
+		if( svr_impl.idle_ticks_ != 0 )
+			timeout_.idle_deadline_.store(svr_impl.wheel_.now() + svr_impl.idle_ticks_, std::memory_order_relaxed);
+	}
+
 	void session::disconnect()
 	{
+		// ʱдͬʱ
+		if( disconnected_.exchange(true) )
+			return;
+
+		svr_.impl_->registry_.erase(id_);
+
+		svr_.impl_->wheel_.cancel(timeout_);
+
 		try
 		{
 			if( disconnect_handler_ )
@@ -206,29 +360,41 @@ namespace async { namespace network {
 
 
 	server::server(std::uint16_t port, std::uint32_t thr_cnt)
-		: impl_(std::make_unique<impl>(*this, port, thr_cnt == 0 ? 1 : thr_cnt))
+		: impl_(std::make_shared<impl>(*this, port, thr_cnt == 0 ? 1 : thr_cnt))
 	{
 
 	}
 
 	server::~server()
 	{
+		// IO߳˳ͶеĹ㲥񲻻IO߳ͷimpl
+		stop();
 	}
 
 	bool server::start()
 	{
-		impl_->thread_ = std::make_unique<std::thread>(std::bind(&impl::_thread_impl, impl_.get()));
+		if( impl_->_has_timeout() )
+		{
+			auto impl_val = impl_.get();
+			impl_->tick_id_ = impl_->io_.add_tick_handler(impl::TIMEOUT_TICK, [impl_val]()
+			{
+				impl_val->wheel_.advance(service::now_ms());
+			});
+		}
+
+		impl_->accept_engine_.start();
 		return true;
 	}
 
 
 	bool server::stop()
 	{
-		if( impl_->thread_ )
+		impl_->accept_engine_.stop();
+
+		if( impl_->tick_id_ != 0 )
 		{
-			::QueueUserAPC([](ULONG_PTR){}, impl_->thread_->native_handle(), 0);
-			impl_->thread_->join();
-			impl_->thread_.reset();
+			impl_->io_.remove_tick_handler(impl_->tick_id_);
+			impl_->tick_id_ = 0;
 		}
 
 		impl_->io_.stop();
@@ -240,6 +406,95 @@ namespace async { namespace network {
 		return true;
 	}
 
+	void server::set_rate_limiter(const rate_limiter_ptr &read_limiter, const rate_limiter_ptr &write_limiter)
+	{
+		impl_->read_limiter_ = read_limiter;
+		impl_->write_limiter_ = write_limiter;
+	}
+
+	void server::set_timeout(std::uint32_t idle_ms, std::uint32_t read_ms, std::uint32_t write_ms)
+	{
+		assert(impl_->tick_id_ == 0 && "set_timeout must be called before start");
+
+		auto &wheel = impl_->wheel_;
+		impl_->idle_ticks_	= wheel.ticks(idle_ms);
+		impl_->read_ticks_	= wheel.ticks(read_ms);
+		impl_->write_ticks_	= wheel.ticks(write_ms);
+
+		// дʱӳ1/4ֻ֣пгʱʱڵֱӹҵֹtick
+		std::uint64_t check_ticks = std::numeric_limits<std::uint32_t>::max();
+		if( impl_->read_ticks_ != 0 )
+			check_ticks = std::min(check_ticks, impl_->read_ticks_);
+		if( impl_->write_ticks_ != 0 )
+			check_ticks = std::min(check_ticks, impl_->write_ticks_);
+		if( check_ticks != std::numeric_limits<std::uint32_t>::max() )
+			check_ticks = std::max<std::uint64_t>(check_ticks / 4, 1);
+
+		impl_->check_ticks_ = check_ticks;
+	}
+
+	accept_stats_t server::accept_stats() const
+	{
+		return impl_->accept_engine_.stats();
+	}
+
+	service::io_dispatcher_t &server::io()
+	{
+		return impl_->io_;
+	}
+
+	std::size_t server::session_count() const
+	{
+		return impl_->registry_.size();
+	}
+
+	session_ptr server::find_session(std::uint64_t id) const
+	{
+		return impl_->registry_.find(id);
+	}
+
+	std::vector<session_ptr> server::sessions() const
+	{
+		return impl_->registry_.snapshot();
+	}
+
+	std::size_t server::broadcast(const service::const_buffer_t &buffer)
+	{
+		auto payload = std::make_shared<std::vector<char>>(buffer.data(), buffer.data() + buffer.size());
+		return broadcast(payload);
+	}
+
+	std::size_t server::broadcast(const payload_ptr &payload)
+	{
+		assert(payload);
+
+		const std::size_t cnt = impl_->registry_.size();
+		if( cnt == 0 || payload->empty() )
+			return 0;
+
+		// ÿƬͶһΣɸIO̲߳з͡serverʱֹͣIỌ߳геimplһ
+		std::weak_ptr<impl> impl_weak = impl_;
+		for( std::uint32_t i = 0; i != session_registry_t<session>::SHARD_COUNT; ++i )
+		{
+			impl_->io_.post([impl_weak, payload, i](const std::error_code &, std::uint32_t)
+			{
+				auto impl_val = impl_weak.lock();
+				if( !impl_val )
+					return;
+
+				std::vector<session_ptr> sessions;
+				impl_val->registry_.snapshot(i, sessions);
+
+				std::for_each(sessions.begin(), sessions.end(), [&payload](const session_ptr &val)
+				{
+					val->async_send(payload);
+				});
+			}, impl_->session_allocator_pool_);
+		}
+
+		return cnt;
+	}
+
 	void server::register_error_handler(const error_handler_type &handler)
 	{
 		impl_->error_handle_ = handler;
@@ -8,12 +8,21 @@
 #include <chrono>
 #include <list>
 #include <atomic>
+#include <vector>
+#include <deque>
+#include <mutex>
 
 #include "basic.hpp"
 #include "service/read_write_buffer.hpp"
 #include "service/multi_buffer.hpp"
 #include "network/tcp.hpp"
+#include "network/accept_engine.hpp"
+#include "network/connection_pool.hpp"
+#include "network/session_registry.hpp"
+#include "network/throttled_stream.hpp"
+#include "network/frame_codec.hpp"
 #include "timer/timer.hpp"
+#include "timer/timing_wheel.hpp"
 
 #include "../utility/move_wrapper.hpp"
 #include "../memory_pool/sgi_memory_pool.hpp"
@@ -70,6 +79,9 @@ namespace async { namespace network {
 	typedef std::shared_ptr<session> session_ptr;
 	typedef std::weak_ptr<session> session_weak_ptr;
 
+	// Ŷӷ㲥ݣỰһ
+	typedef std::shared_ptr<const std::vector<char>> payload_ptr;
+
 	typedef std::function<void(const session_ptr &, const std::string &msg)>	error_handler_type;
 	typedef std::function<bool(const session_ptr &, const std::string &ip)>		accept_handler_type;
 	typedef std::function<void(const session_ptr &)>							disconnect_handler_type;
@@ -84,6 +96,8 @@ namespace async { namespace network {
 	class session
 		: public std::enable_shared_from_this<session>
 	{
+		friend class server;
+
 		struct holder_t
 		{
 			virtual ~holder_t() {}
@@ -106,9 +120,35 @@ namespace async { namespace network {
 			}
 		};
 
+	public:
+		// Сдʱserverʱϣдʱֻ½ֹtick(0ʾδ)
+		struct timeout_node_t
+			: timer::wheel_node_t
+		{
+			session &session_;
+			session_weak_ptr self_;
+			std::atomic<std::uint64_t> idle_deadline_;
+			std::atomic<std::uint64_t> read_deadline_;
+			std::atomic<std::uint64_t> write_deadline_;
+
+			timeout_node_t(session &val, expire_handler_t handler);
+		};
+
+	private:
 		server &svr_;
+		const std::uint64_t id_;
 		mutable std::shared_ptr<socket_handle_t> sck_;
+		throttled_stream_t<socket_handle_t> stream_;
 		std::shared_ptr<holder_t> data_;
+		std::unique_ptr<frame_decoder_t> decoder_;
+
+		timeout_node_t timeout_;
+		std::atomic<bool> disconnected_;
+
+		// Ŷӷͣͬһʱֻһд
+		std::mutex send_mutex_;
+		std::deque<payload_ptr> send_queue_;
+		bool sending_;
 
 	public:
 		const error_handler_type &error_handler_;
@@ -126,17 +166,40 @@ namespace async { namespace network {
 	public:
 		socket_handle_t &get() { return *sck_; }
 		std::string get_ip() const;
+		// serverΨһ1ʼ
+		std::uint64_t id() const { return id_; }
+
+		// д٣limiterԱỰΪձʾ١ֻӦûδɵĶдʱ
+		void set_rate_limiter(const rate_limiter_ptr &read_limiter, const rate_limiter_ptr &write_limiter);
+		const rate_limiter_ptr &read_limiter() const { return stream_.read_limiter(); }
+		const rate_limiter_ptr &write_limiter() const { return stream_.write_limiter(); }
 
 		template < typename HandlerT, typename AllocatorT>
 		bool async_read(service::mutable_buffer_t &, HandlerT &&, AllocatorT &allocator);
 		template < typename HandlerT, typename AllocatorT>
 		bool async_read_some(service::mutable_buffer_t &, std::uint32_t min_len, HandlerT &&, AllocatorT &allocator);
 
+		// ǰ׺֡ȡøʽhandler(session_ptr, const frame_decoder_t::batch_t &)
+		// һζɵõ֡һص֡ͼֻڻصЧֻյ֡ʱԶ
+		void set_frame_format(const frame_format_t &format);
+		template < typename HandlerT, typename AllocatorT>
+		bool async_read_frames(service::mutable_buffer_t &, HandlerT &&, AllocatorT &allocator);
+
 		template < typename HandlerT, typename AllocatorT>
 		bool async_write(const service::const_buffer_t &, HandlerT &&, AllocatorT &allocator);
 		template < typename HandlerT, typename AllocatorT, typename ...Args >
 		typename std::enable_if<!std::is_same<HandlerT, service::const_buffer_t>::value, bool>::type
 			async_write(HandlerT &&, AllocatorT &, const Args &...);
+		// ۼдbuffersֻڵڼЧ뱣ֵص
+		template < typename HandlerT, typename AllocatorT >
+		bool async_writev(const service::const_buffer_t *buffers, std::uint32_t count, HandlerT &&, AllocatorT &allocator);
+		// ڴļϷͣļ㿽elementsָݡļ뱣ֵص
+		template < typename HandlerT, typename AllocatorT >
+		bool async_transmit(TRANSMIT_PACKETS_ELEMENT *elements, std::uint32_t count, HandlerT &&, AllocatorT &allocator);
+
+		// ŶӷͣǰһдſʼһŶӵ֮䲻ύ
+		// ֱд֮ûл⣬չ㲥ĻỰӦֻŶӷֱ֤ͣд֮
+		void async_send(const payload_ptr &payload);
 
 		template < typename T, typename AlocatorT >
 		void additional_data(const T &t, AlocatorT &allocator);
@@ -147,6 +210,11 @@ namespace async { namespace network {
 		void shutdown();
 		void disconnect();
 
+		void _io_begin(bool is_read_op);
+		void _io_end(bool is_read_op);
+		void _send_next();
+		static std::uint64_t _expire(timer::wheel_node_t &node, std::uint64_t now);
+
 		template < typename HandlerT >
 		void _handle_read(const std::error_code &error, std::uint32_t size, const HandlerT &read_handler);
 
@@ -189,7 +257,8 @@ namespace async { namespace network {
 			auto this_val = shared_from_this();
 			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(read_handler));
 
-			service::async_read(*sck_,
+			_io_begin(true);
+			service::async_read(stream_,
 				buffer,
 				service::transfer_all(),
 				[this_val, handler_val](const std::error_code &err, std::uint32_t len)
@@ -207,7 +276,8 @@ namespace async { namespace network {
 			auto this_val = shared_from_this();
 			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
 
-			sck_->async_read(buffer, 
+			_io_begin(true);
+			stream_.async_read(buffer, 
 				[this_val, handler_val](const std::error_code &err, std::uint32_t len)
 			{
 				this_val->_handle_read(err, len, handler_val.value_);
@@ -215,6 +285,39 @@ namespace async { namespace network {
 		}, true);
 	}
 
+	template < typename HandlerT, typename AllocatorT >
+	bool session::async_read_frames(service::mutable_buffer_t &buffer, HandlerT &&handler, AllocatorT &allocator)
+	{
+		assert(decoder_ && "set_frame_format must be called before async_read_frames");
+
+		char *data = buffer.data();
+		const std::size_t len = buffer.size();
+		auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
+
+		return async_read_some(buffer, 0, [data, len, handler_val, &allocator](const session_ptr &val, std::uint32_t size)
+		{
+			auto &decoder = *val->decoder_;
+			if( !decoder.feed(data, size) )
+			{
+				if( val->error_handler_ )
+					val->error_handler_(val, "frame decode error");
+
+				val->disconnect();
+				return;
+			}
+
+			// ֡ѿdecoderУջֱӸ
+			if( decoder.frames().empty() )
+			{
+				service::mutable_buffer_t buf(data, len);
+				val->async_read_frames(buf, std::move(handler_val.value_), allocator);
+				return;
+			}
+
+			handler_val.value_(val, decoder.frames());
+		}, allocator);
+	}
+
 	template < typename HandlerT, typename AllocatorT >
 	bool session::async_write(const service::const_buffer_t &buffer, HandlerT &&write_handler, AllocatorT &allocator)
 	{
@@ -223,8 +326,9 @@ namespace async { namespace network {
 			auto this_val = shared_from_this();
 			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(write_handler));
 
+			_io_begin(false);
 			service::async_write(
-				*sck_, 
+				stream_, 
 				buffer, 
 				service::transfer_all(), 
 				[this_val, handler_val](const std::error_code &err, std::uint32_t len) 
@@ -240,7 +344,50 @@ namespace async { namespace network {
 	{
 		return _run_impl([&]()
 		{
-			sck_->async_write(handler, allocator, args...);
+			auto this_val = shared_from_this();
+			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
+
+			// ص(error, size)ʽֻʱдʱ
+			_io_begin(false);
+			stream_.async_write([this_val, handler_val](const std::error_code &err, std::uint32_t len)
+			{
+				this_val->_io_end(false);
+				handler_val.value_(err, len);
+			}, allocator, args...);
+		}, false);
+	}
+
+	template < typename HandlerT, typename AllocatorT >
+	bool session::async_writev(const service::const_buffer_t *buffers, std::uint32_t count, HandlerT &&write_handler, AllocatorT &allocator)
+	{
+		return _run_impl([&]()
+		{
+			auto this_val = shared_from_this();
+			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(write_handler));
+
+			_io_begin(false);
+			stream_.async_writev(buffers, count, 
+				[this_val, handler_val](const std::error_code &err, std::uint32_t len) 
+			{ 
+				this_val->_handle_write(err, len, handler_val.value_);
+			}, allocator);
+		}, false);
+	}
+
+	template < typename HandlerT, typename AllocatorT >
+	bool session::async_transmit(TRANSMIT_PACKETS_ELEMENT *elements, std::uint32_t count, HandlerT &&write_handler, AllocatorT &allocator)
+	{
+		return _run_impl([&]()
+		{
+			auto this_val = shared_from_this();
+			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(write_handler));
+
+			_io_begin(false);
+			stream_.async_transmit(elements, count, 
+				[this_val, handler_val](const std::error_code &err, std::uint32_t len) 
+			{ 
+				this_val->_handle_write(err, len, handler_val.value_);
+			}, allocator);
 		}, false);
 	}
 
@@ -280,6 +427,8 @@ namespace async { namespace network {
 	void session::_handle_read(const std::error_code &error, std::uint32_t size, 
 		const HandlerT &read_handler)
 	{
+		_io_end(true);
+
 		try
 		{
 			if( !error )	// success
@@ -312,6 +461,8 @@ namespace async { namespace network {
 	template < typename HandlerT >
 	void session::_handle_write(const std::error_code &error, std::uint32_t size, const HandlerT &write_handler)
 	{
+		_io_end(false);
+
 		try
 		{
 			if( !error )	// success
@@ -354,7 +505,7 @@ namespace async { namespace network {
 		friend class session;
 	private:	
 		struct impl;
-		std::unique_ptr<impl> impl_;
+		std::shared_ptr<impl> impl_;
 
 	public:
 		explicit server(std::uint16_t port, std::uint32_t thr_cnt = 0);
@@ -368,6 +519,28 @@ namespace async { namespace network {
 		bool start();
 		bool stop();
 
+		// »ỰĬʹõлỰserver
+		void set_rate_limiter(const rate_limiter_ptr &read_limiter, const rate_limiter_ptr &write_limiter);
+
+		// Ựʱ(ms)0Ϊãstart֮ǰáʱsession::disconnect
+		void set_timeout(std::uint32_t idle_ms, std::uint32_t read_ms = 0, std::uint32_t write_ms = 0);
+
+		accept_stats_t accept_stats() const;
+
+		// IOͶעtickص
+		service::io_dispatcher_t &io();
+
+		// ǰĻỰ
+		std::size_t session_count() const;
+		session_ptr find_session(std::uint64_t id) const;
+		std::vector<session_ptr> sessions() const;
+
+		// лỰһݣƬͶݵIO߳Ͼsession::async_sendŶӷͣĿỰ
+		// Ựд֮䲻֤˳
+		typedef network::payload_ptr payload_ptr;
+		std::size_t broadcast(const service::const_buffer_t &buffer);
+		std::size_t broadcast(const payload_ptr &payload);
+
 		void register_error_handler(const error_handler_type &);
 		void register_accept_handler(const accept_handler_type &);
 		void register_disconnect_handler(const disconnect_handler_type &);
@@ -17,7 +17,8 @@ namespace async {
 
 	namespace network { namespace details {
 
-		static const size_t SOCKET_ADDR_SIZE = sizeof(sockaddr_in) + 16;
+		// ĵַṹԤAF_UNIXsockaddr_unԶsockaddr_in
+		static const size_t SOCKET_ADDR_SIZE = sizeof(SOCKADDR_STORAGE) + 16;
 
 		// Hook User Accept Callback
 		template < typename HandlerT >
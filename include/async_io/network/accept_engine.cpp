@@ -0,0 +1,250 @@
+#include "accept_engine.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+#include "../service/clock.hpp"
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+
+namespace async { namespace network {
+
+	namespace {
+
+		// صڷغͷţʹengineڵڴ
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+	}
+
+	accept_engine_t::accept_engine_t(socket_handle_t &acceptor,
+		const create_handler_t &create_handler,
+		const accept_handler_t &accept_handler,
+		std::uint32_t min_pending,
+		std::uint32_t max_pending)
+		: acceptor_(acceptor)
+		, create_handler_(create_handler)
+		, accept_handler_(accept_handler)
+		, min_pending_(min_pending != 0 ? min_pending : std::max(std::uint32_t(DEFAULT_MIN_PENDING), 4 * std::thread::hardware_concurrency()))
+		, max_pending_(std::max(max_pending, min_pending_))
+		, outstanding_(0)
+		, target_(min_pending_)
+		, accepted_(0)
+		, failed_(0)
+		, overflows_(0)
+		, window_start_(service::now_ms())
+		, window_accepted_(0)
+		, window_overflows_(0)
+		, stopped_(true)
+		, pending_(0)
+	{
+		assert(create_handler_ != nullptr);
+		assert(accept_handler_ != nullptr);
+	}
+
+	accept_engine_t::~accept_engine_t()
+	{
+		stop();
+	}
+
+	void accept_engine_t::start()
+	{
+		if( !stopped_.exchange(false) )
+			return;
+
+		_replenish();
+		thread_ = std::make_unique<std::thread>(std::bind(&accept_engine_t::_thread_impl, this));
+	}
+
+	void accept_engine_t::stop()
+	{
+		stopped_ = true;
+
+		if( thread_ )
+		{
+			::QueueUserAPC([](ULONG_PTR){}, thread_->native_handle(), 0);
+			thread_->join();
+			thread_.reset();
+		}
+
+		// صthisȡȴȫ
+		if( acceptor_.is_open() )
+			acceptor_.cancel();
+
+		Lock lock(mutex_);
+		cond_.wait(lock, [this]() { return pending_ == 0; });
+	}
+
+	accept_stats_t accept_engine_t::stats() const
+	{
+		accept_stats_t val = {0};
+		val.outstanding_	= outstanding_;
+		val.target_			= target_;
+		val.accepted_		= accepted_;
+		val.failed_			= failed_;
+		val.overflows_		= overflows_;
+
+		return val;
+	}
+
+	void accept_engine_t::_replenish()
+	{
+		// Ͷֱoutstandingﵽtarget̲߳ͶʱCAS֤Ͷ
+		std::uint32_t cur = outstanding_;
+		while( !stopped_ && cur < target_ )
+		{
+			if( !outstanding_.compare_exchange_weak(cur, cur + 1) )
+				continue;
+
+			// ʧʱڴԣʧܻʹ߳̿ת
+			if( !_post_one() )
+				break;
+
+			cur = outstanding_;
+		}
+	}
+
+	bool accept_engine_t::_post_one()
+	{
+		{
+			Lock lock(mutex_);
+			++pending_;
+		}
+
+		socket_ptr_t sck;
+		try
+		{
+			sck = create_handler_();
+			acceptor_.async_accept(socket_ptr_t(sck),
+				[this](const std::error_code &error, socket_ptr_t &remote_sck)
+			{
+				_handle_accept(error, remote_sck);
+			}, callback_pool());
+		}
+		catch( ::exception::exception_base &e )
+		{
+			e.dump();
+			_post_failed(sck);
+
+			return false;
+		}
+		catch( std::exception &/*e*/ )
+		{
+			_post_failed(sck);
+
+			return false;
+		}
+
+		// stopʱͶݿȡ
+		if( stopped_ && acceptor_.is_open() )
+			acceptor_.cancel();
+
+		return true;
+	}
+
+	void accept_engine_t::_post_failed(const socket_ptr_t &sck)
+	{
+		// Ͷʧܵsocketٹ黹
+		if( sck )
+			sck->close();
+
+		--outstanding_;
+		++failed_;
+		_release();
+	}
+
+	void accept_engine_t::_release()
+	{
+		// ֪ͨstopغengine漴
+		Lock lock(mutex_);
+		--pending_;
+		cond_.notify_all();
+	}
+
+	void accept_engine_t::_shrink()
+	{
+		// ÿֻһ߳һж
+		auto now = service::now_ms();
+		std::uint64_t start = window_start_;
+		if( now < start || now - start < SHRINK_WINDOW || !window_start_.compare_exchange_strong(start, now) )
+			return;
+
+		std::uint32_t accepted = window_accepted_.exchange(0);
+		std::uint64_t overflows = overflows_;
+		std::uint64_t last_overflows = window_overflows_.exchange(overflows);
+
+		// ûҽյͶ𲽻
+		std::uint32_t target = target_;
+		if( overflows == last_overflows && accepted < target && target > min_pending_ )
+			target_ = std::max(min_pending_, target - target / 4);
+	}
+
+	void accept_engine_t::_handle_accept(const std::error_code &error, socket_ptr_t &remote_sck)
+	{
+		--outstanding_;
+
+		if( error )
+		{
+			// socketرջԶAcceptExǰλsocket
+			++failed_;
+			remote_sck.reset();
+		}
+		else
+		{
+			++accepted_;
+			++window_accepted_;
+		}
+
+		if( !stopped_ )
+		{
+			// ȲͶٻصûAcceptExȴʱ
+			_shrink();
+			_replenish();
+
+			if( !error )
+				accept_handler_(error, remote_sck);
+		}
+
+		_release();
+	}
+
+	void accept_engine_t::_thread_impl()
+	{
+		// ֻûеȴеAcceptExʱFD_ACCEPTŻᱻ
+		HANDLE accept_event = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+		::WSAEventSelect(acceptor_.native_handle(), accept_event, FD_ACCEPT);
+
+		while( true )
+		{
+			DWORD ret = ::WaitForSingleObjectEx(accept_event, RETRY_INTERVAL, TRUE);
+			if( ret == WAIT_FAILED || ret == WAIT_IO_COMPLETION )
+				break;
+
+			if( stopped_ )
+				break;
+
+			// ֮ǰͶʧܵĲ
+			if( ret == WAIT_TIMEOUT )
+			{
+				_replenish();
+				continue;
+			}
+			else if( ret != WAIT_OBJECT_0 )
+				continue;
+
+			++overflows_;
+
+			// ɱͶ
+			std::uint32_t target = target_;
+			target_ = std::min(max_pending_, std::max(target * 2, min_pending_));
+
+			_replenish();
+		}
+
+		::WSAEventSelect(acceptor_.native_handle(), NULL, 0);
+		::CloseHandle(accept_event);
+	}
+}
+}
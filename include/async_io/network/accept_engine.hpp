@@ -0,0 +1,113 @@
+#ifndef __ASYNC_NETWORK_ACCEPT_ENGINE_HPP
+#define __ASYNC_NETWORK_ACCEPT_ENGINE_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <system_error>
+
+#include "socket.hpp"
+
+
+namespace async { namespace network {
+
+	// accept ͳϢ
+	struct accept_stats_t
+	{
+		std::uint32_t outstanding_;		// ǰͶݵAcceptEx
+		std::uint32_t target_;			// ӦĿͶ
+		std::uint64_t accepted_;		// ɹյ
+		std::uint64_t failed_;			// ʧܵAcceptEx
+		std::uint64_t overflows_;		// ûAcceptExȴʱ(accept)
+	};
+
+
+	// -------------------------------------------------
+	// class accept_engine_t
+
+	// ʼձtargetAcceptExͶ״̬ÿһ߳ϲͶһ
+	// ӵʱûеȴеAcceptExFD_ACCEPTΪһɱtarget
+	// ½target𲽻䵽min_pendingͶʧ(WSAENOBUFS)ʱͣͶһɻRETRY_INTERVAL
+	class accept_engine_t
+	{
+	public:
+		typedef std::shared_ptr<socket_handle_t>								socket_ptr_t;
+		typedef std::function<socket_ptr_t()>									create_handler_t;
+		typedef std::function<void(const std::error_code &, socket_ptr_t &)>	accept_handler_t;
+
+		static const std::uint32_t DEFAULT_MIN_PENDING	= 16;
+		static const std::uint32_t DEFAULT_MAX_PENDING	= 2048;
+		static const std::uint32_t SHRINK_WINDOW		= 1000;		// ms
+		static const std::uint32_t RETRY_INTERVAL		= 100;		// msͶʧܺԼ
+
+	private:
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+		socket_handle_t &acceptor_;
+		create_handler_t create_handler_;
+		accept_handler_t accept_handler_;
+
+		const std::uint32_t min_pending_;
+		const std::uint32_t max_pending_;
+
+		std::atomic<std::uint32_t> outstanding_;
+		std::atomic<std::uint32_t> target_;
+		std::atomic<std::uint64_t> accepted_;
+		std::atomic<std::uint64_t> failed_;
+		std::atomic<std::uint64_t> overflows_;
+
+		// 
+		std::atomic<std::uint64_t> window_start_;
+		std::atomic<std::uint32_t> window_accepted_;
+		std::atomic<std::uint64_t> window_overflows_;
+
+		std::atomic<bool> stopped_;
+
+		// ͶһصδصAcceptExstopʱȴ
+		Mutex mutex_;
+		std::condition_variable cond_;
+		std::uint32_t pending_;
+
+		std::unique_ptr<std::thread> thread_;
+
+	public:
+		accept_engine_t(socket_handle_t &acceptor,
+			const create_handler_t &create_handler,
+			const accept_handler_t &accept_handler,
+			std::uint32_t min_pending = 0,
+			std::uint32_t max_pending = DEFAULT_MAX_PENDING);
+		~accept_engine_t();
+
+	private:
+		accept_engine_t(const accept_engine_t &);
+		accept_engine_t &operator=(const accept_engine_t &);
+
+	public:
+		void start();
+		// ȡδɵAcceptExȴصأdispatcherֹ֮ͣǰ
+		void stop();
+
+		accept_stats_t stats() const;
+
+	private:
+		void _replenish();
+		bool _post_one();
+		void _post_failed(const socket_ptr_t &sck);
+		void _release();
+		void _shrink();
+
+		void _handle_accept(const std::error_code &error, socket_ptr_t &remote_sck);
+		void _thread_impl();
+	};
+}
+}
+
+
+
+
+#endif
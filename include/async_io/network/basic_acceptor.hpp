@@ -45,6 +45,11 @@ namespace async { namespace network {
 			return impl_.native_handle();
 		}
 
+		socket_handle_t &get()
+		{
+			return impl_;
+		}
+
 		void open(const protocol_type &protocol = protocol_type::v4())
 		{
 			if( protocol.Type() == SOCK_STREAM )
@@ -90,6 +95,12 @@ namespace async { namespace network {
 			impl_.bind(family, port, addr);
 		}
 
+		template < typename EndpointT >
+		void bind(const EndpointT &endpoint)
+		{
+			impl_.bind(endpoint.data(), endpoint.size());
+		}
+
 		void listen(int backlog = SOMAXCONN)
 		{
 			impl_.listen(backlog);
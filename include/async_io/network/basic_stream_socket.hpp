@@ -92,6 +92,14 @@ namespace async { namespace network {
 		}
 
 
+		// ЭԼĵַ(local_endpoint)
+		template < typename EndpointT >
+		void bind(const EndpointT &endpoint)
+		{
+			impl_.bind(endpoint.data(), endpoint.size());
+		}
+
+
 		// Զ̷
 		void connect(std::uint16_t port, const ip_address &addr)
 		{
@@ -99,16 +107,28 @@ namespace async { namespace network {
 			impl_.connect(protocol.family(), addr, port);
 		}
 
+		template < typename EndpointT >
+		void connect(const EndpointT &endpoint)
+		{
+			impl_.connect(endpoint.data(), endpoint.size());
+		}
+
 		void dis_connect(int shut = SD_BOTH)
 		{
 			impl_.dis_connect(shut, true);
 		}
 
 		// 첽
-		template < typename HandlerT >
-		void async_connect(const ip_address &addr, std::uint16_t port, HandlerT &&handler)
+		template < typename HandlerT, typename AllocatorT >
+		void async_connect(const ip_address &addr, std::uint16_t port, HandlerT &&handler, AllocatorT &allocator)
+		{
+			return impl_.async_connect(addr, port, std::forward<HandlerT>(handler), allocator);
+		}
+
+		template < typename EndpointT, typename HandlerT, typename AllocatorT >
+		void async_connect(const EndpointT &endpoint, HandlerT &&handler, AllocatorT &allocator)
 		{
-			return impl_.async_connect(addr, port, std::forward<HandlerT>(handler));
+			return impl_.async_connect(endpoint.data(), endpoint.size(), std::forward<HandlerT>(handler), allocator);
 		}
 
 
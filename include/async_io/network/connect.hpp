@@ -23,7 +23,8 @@ namespace async { namespace network { namespace details {
 		void operator()(std::error_code error, std::uint32_t size)
 		{
 			// socket
-			remote_.set_option(update_connect_context());
+			if( !error )
+				remote_.set_option(update_connect_context());
 
 			handler_(error);
 		}
@@ -0,0 +1,508 @@
+#include "connection_pool.hpp"
+
+#include <cassert>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+#include "tcp.hpp"
+#include "../service/clock.hpp"
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+
+namespace async { namespace network {
+
+	namespace {
+
+		inline std::uint64_t endpoint_key(std::uint32_t address, std::uint16_t port)
+		{
+			return (static_cast<std::uint64_t>(address) << 16) | port;
+		}
+
+		// ϲӦκοɶ¼ɶ˵Զѹرաλδݣɸ
+		bool is_alive(socket_handle_t &sck)
+		{
+			if( !sck.is_open() )
+				return false;
+
+			fd_set rd_set;
+			FD_ZERO(&rd_set);
+			FD_SET(sck.native_handle(), &rd_set);
+
+			timeval tv = {0, 0};
+			return ::select(0, &rd_set, 0, 0, &tv) == 0;
+		}
+
+		// ɻصֻзãصʱͷimpl˲ʹimplڵڴ
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		void close_socket(socket_handle_t &sck)
+		{
+			try
+			{
+				if( sck.is_open() )
+					sck.close();
+			}
+			catch( ::exception::exception_base &e )
+			{
+				e.dump();
+			}
+		}
+	}
+
+
+	struct connection_pool_t::impl
+		: std::enable_shared_from_this<impl>
+	{
+		struct idle_t
+		{
+			socket_ptr_t sck_;
+			std::uint64_t tick_;
+		};
+
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+		struct endpoint_t
+		{
+			const std::uint32_t address_;
+			const std::uint16_t port_;
+
+			Mutex mutex_;
+			std::deque<idle_t> idle_;
+			std::deque<checkout_handler_t> waiters_;
+
+			std::uint32_t total_;			//  + ʹ + 
+			std::uint32_t connecting_;
+			bool prewarm_;
+
+			std::uint64_t created_;
+			std::uint64_t reused_;
+			std::uint64_t evicted_;
+
+			endpoint_t(std::uint32_t address, std::uint16_t port)
+				: address_(address)
+				, port_(port)
+				, total_(0)
+				, connecting_(0)
+				, prewarm_(false)
+				, created_(0)
+				, reused_(0)
+				, evicted_(0)
+			{}
+		};
+		typedef std::shared_ptr<endpoint_t>							endpoint_ptr;
+		typedef std::unordered_map<std::uint64_t, endpoint_ptr>		endpoints_t;
+
+		service::io_dispatcher_t &io_;
+		const connection_pool_config_t config_;
+
+		mutable Mutex mutex_;
+		endpoints_t endpoints_;
+
+		std::unique_ptr<timer::timer_handle> timer_;
+
+		impl(service::io_dispatcher_t &io, const connection_pool_config_t &config)
+			: io_(io)
+			, config_(config)
+		{}
+
+		endpoint_ptr _endpoint(std::uint32_t address, std::uint16_t port, bool create)
+		{
+			auto key = endpoint_key(address, port);
+
+			Lock lock(mutex_);
+			auto iter = endpoints_.find(key);
+			if( iter != endpoints_.end() )
+				return iter->second;
+
+			if( !create )
+				return endpoint_ptr();
+
+			auto ep = std::make_shared<endpoint_t>(address, port);
+			endpoints_.insert(std::make_pair(key, ep));
+			return ep;
+		}
+
+		// ep->mutex_ʱãҪ·
+		std::uint32_t _connect_count(endpoint_t &ep)
+		{
+			std::uint32_t want = static_cast<std::uint32_t>(ep.waiters_.size());
+			if( ep.prewarm_ && ep.idle_.size() < config_.min_idle_ )
+				want += config_.min_idle_ - static_cast<std::uint32_t>(ep.idle_.size());
+
+			if( want <= ep.connecting_ )
+				return 0;
+
+			std::uint32_t cnt = want - ep.connecting_;
+			cnt = std::min(cnt, config_.max_connecting_ > ep.connecting_ ? config_.max_connecting_ - ep.connecting_ : 0);
+			cnt = std::min(cnt, config_.max_total_ > ep.total_ ? config_.max_total_ - ep.total_ : 0);
+
+			ep.connecting_ += cnt;
+			ep.total_ += cnt;
+
+			return cnt;
+		}
+
+		void _connect(const endpoint_ptr &ep, std::uint32_t cnt)
+		{
+			auto this_val = shared_from_this();
+
+			for( std::uint32_t i = 0; i != cnt; ++i )
+			{
+				try
+				{
+					tcp v4_ver = tcp::v4();
+					auto sck = std::make_shared<socket_handle_t>(io_, v4_ver.family(), v4_ver.type(), v4_ver.protocol());
+
+					sck->async_connect(ip_address(ep->address_), ep->port_,
+						[this_val, ep, sck](const std::error_code &error)
+					{
+						this_val->_handle_connect(ep, sck, error);
+					}, callback_pool());
+				}
+				catch( ::exception::exception_base &e )
+				{
+					e.dump();
+
+					std::error_code error(::WSAGetLastError(), std::system_category());
+					if( !error )
+						error = std::make_error_code(std::errc::connection_aborted);
+
+					_handle_connect(ep, socket_ptr_t(), error);
+				}
+			}
+		}
+
+		void _handle_connect(const endpoint_ptr &ep, const socket_ptr_t &sck, const std::error_code &error)
+		{
+			checkout_handler_t handler;
+			std::uint32_t cnt = 0;
+
+			if( !error )
+			{
+				sck->set_option(network::no_delay(true));
+				sck->set_option(network::linger(true, 0));
+			}
+			else if( sck )
+			{
+				close_socket(*sck);
+			}
+
+			{
+				Lock lock(ep->mutex_);
+				--ep->connecting_;
+
+				if( error )
+				{
+					--ep->total_;
+
+					// ÿʧֻĵȴʧܣȴ߼ɺ
+					if( !ep->waiters_.empty() )
+					{
+						handler = std::move(ep->waiters_.front());
+						ep->waiters_.pop_front();
+					}
+				}
+				else
+				{
+					++ep->created_;
+
+					if( !ep->waiters_.empty() )
+					{
+						handler = std::move(ep->waiters_.front());
+						ep->waiters_.pop_front();
+					}
+					else
+					{
+						idle_t val = { sck, service::now_ms() };
+						ep->idle_.push_back(std::move(val));
+					}
+				}
+
+				cnt = _connect_count(*ep);
+			}
+
+			if( cnt != 0 )
+				_connect(ep, cnt);
+
+			if( handler )
+				handler(error, error ? socket_ptr_t() : sck);
+		}
+
+		void _checkout(const endpoint_ptr &ep, const checkout_handler_t &handler)
+		{
+			std::uint32_t cnt = 0;
+
+			{
+				Lock lock(ep->mutex_);
+
+				// ȳȸ黹
+				while( !ep->idle_.empty() )
+				{
+					auto sck = std::move(ep->idle_.back().sck_);
+					ep->idle_.pop_back();
+
+					if( is_alive(*sck) )
+					{
+						++ep->reused_;
+						lock.unlock();
+
+						handler(std::error_code(), sck);
+						return;
+					}
+
+					--ep->total_;
+					++ep->evicted_;
+					close_socket(*sck);
+				}
+
+				ep->waiters_.push_back(handler);
+				cnt = _connect_count(*ep);
+			}
+
+			if( cnt != 0 )
+				_connect(ep, cnt);
+		}
+
+		void _checkin(const endpoint_ptr &ep, const socket_ptr_t &sck, bool reusable)
+		{
+			checkout_handler_t handler;
+			std::uint32_t cnt = 0;
+
+			{
+				Lock lock(ep->mutex_);
+
+				if( !reusable || !sck->is_open() )
+				{
+					--ep->total_;
+					close_socket(*sck);
+
+					cnt = _connect_count(*ep);
+				}
+				else if( !ep->waiters_.empty() )
+				{
+					handler = std::move(ep->waiters_.front());
+					ep->waiters_.pop_front();
+				}
+				else if( ep->idle_.size() >= config_.max_idle_ )
+				{
+					--ep->total_;
+					close_socket(*sck);
+				}
+				else
+				{
+					idle_t val = { sck, service::now_ms() };
+					ep->idle_.push_back(std::move(val));
+				}
+			}
+
+			if( cnt != 0 )
+				_connect(ep, cnt);
+
+			// ڹ黹ߵĵջִеȴ߻ص
+			if( handler )
+			{
+				io_.post([handler, sck](const std::error_code &, std::uint32_t)
+				{
+					handler(std::error_code(), sck);
+				}, callback_pool());
+			}
+		}
+
+		void _sweep()
+		{
+			std::vector<endpoint_ptr> eps;
+			{
+				Lock lock(mutex_);
+				eps.reserve(endpoints_.size());
+				for( auto iter = endpoints_.begin(); iter != endpoints_.end(); ++iter )
+					eps.push_back(iter->second);
+			}
+
+			const std::uint64_t now = service::now_ms();
+			std::for_each(eps.begin(), eps.end(), [this, now](const endpoint_ptr &ep)
+			{
+				std::uint32_t cnt = 0;
+				{
+					Lock lock(ep->mutex_);
+
+					// δʹãʱҶmin_idleĻ
+					while( !ep->idle_.empty()
+						&& ep->idle_.size() > config_.min_idle_
+						&& now >= ep->idle_.front().tick_
+						&& now - ep->idle_.front().tick_ >= config_.idle_timeout_ )
+					{
+						close_socket(*ep->idle_.front().sck_);
+						ep->idle_.pop_front();
+
+						--ep->total_;
+						++ep->evicted_;
+					}
+
+					// ޳ѱԶ˹رյĿ
+					auto iter = std::remove_if(ep->idle_.begin(), ep->idle_.end(), [](const idle_t &val)
+					{
+						return !is_alive(*val.sck_);
+					});
+					std::for_each(iter, ep->idle_.end(), [](const idle_t &val)
+					{
+						close_socket(*val.sck_);
+					});
+
+					auto dead = static_cast<std::uint32_t>(std::distance(iter, ep->idle_.end()));
+					ep->idle_.erase(iter, ep->idle_.end());
+					ep->total_ -= dead;
+					ep->evicted_ += dead;
+
+					cnt = _connect_count(*ep);
+				}
+
+				if( cnt != 0 )
+					_connect(ep, cnt);
+			});
+		}
+
+		void _clear()
+		{
+			std::vector<endpoint_ptr> eps;
+			{
+				Lock lock(mutex_);
+				for( auto iter = endpoints_.begin(); iter != endpoints_.end(); ++iter )
+					eps.push_back(iter->second);
+			}
+
+			const std::error_code canceled = std::make_error_code(std::errc::operation_canceled);
+			std::for_each(eps.begin(), eps.end(), [&canceled](const endpoint_ptr &ep)
+			{
+				std::deque<checkout_handler_t> waiters;
+				{
+					Lock lock(ep->mutex_);
+
+					ep->prewarm_ = false;
+					std::for_each(ep->idle_.begin(), ep->idle_.end(), [](const idle_t &val)
+					{
+						close_socket(*val.sck_);
+					});
+
+					ep->total_ -= static_cast<std::uint32_t>(ep->idle_.size());
+					ep->idle_.clear();
+					waiters.swap(ep->waiters_);
+				}
+
+				std::for_each(waiters.begin(), waiters.end(), [&canceled](const checkout_handler_t &handler)
+				{
+					handler(canceled, socket_ptr_t());
+				});
+			});
+		}
+	};
+
+
+	connection_pool_t::connection_pool_t(service::io_dispatcher_t &io,
+		timer::win_timer_service_t &timer_svr,
+		const connection_pool_config_t &config)
+		: impl_(std::make_shared<impl>(io, config))
+	{
+		assert(config.max_total_ != 0);
+		assert(config.max_connecting_ != 0);
+		assert(config.min_idle_ <= config.max_idle_);
+
+		// δɵӳimplʱֻ
+		std::weak_ptr<impl> weak_val = impl_;
+		impl_->timer_ = std::make_unique<timer::timer_handle>(timer_svr,
+			std::chrono::milliseconds(config.sweep_interval_),
+			std::chrono::milliseconds(config.sweep_interval_),
+			[weak_val]()
+		{
+			auto val = weak_val.lock();
+			if( val )
+				val->_sweep();
+		});
+		impl_->timer_->async_wait();
+	}
+
+	connection_pool_t::~connection_pool_t()
+	{
+		impl_->timer_.reset();
+		impl_->_clear();
+	}
+
+	void connection_pool_t::prewarm(const std::string &ip, std::uint16_t port)
+	{
+		prewarm(ip_address::parse(ip), port);
+	}
+
+	void connection_pool_t::prewarm(const ip_address &addr, std::uint16_t port)
+	{
+		auto ep = impl_->_endpoint(addr.address(), port, true);
+
+		std::uint32_t cnt = 0;
+		{
+			impl::Lock lock(ep->mutex_);
+			ep->prewarm_ = true;
+			cnt = impl_->_connect_count(*ep);
+		}
+
+		if( cnt != 0 )
+			impl_->_connect(ep, cnt);
+	}
+
+	void connection_pool_t::async_checkout(const std::string &ip, std::uint16_t port, const checkout_handler_t &handler)
+	{
+		async_checkout(ip_address::parse(ip), port, handler);
+	}
+
+	void connection_pool_t::async_checkout(const ip_address &addr, std::uint16_t port, const checkout_handler_t &handler)
+	{
+		assert(handler != nullptr);
+		impl_->_checkout(impl_->_endpoint(addr.address(), port, true), handler);
+	}
+
+	void connection_pool_t::checkin(const ip_address &addr, std::uint16_t port, const socket_ptr_t &sck, bool reusable)
+	{
+		assert(sck);
+
+		auto ep = impl_->_endpoint(addr.address(), port, false);
+		if( !ep )
+		{
+			assert(0 && "checkin a connection not from this pool");
+			close_socket(*sck);
+			return;
+		}
+
+		impl_->_checkin(ep, sck, reusable);
+	}
+
+	void connection_pool_t::clear()
+	{
+		impl_->_clear();
+	}
+
+	connection_pool_stats_t connection_pool_t::stats(const ip_address &addr, std::uint16_t port) const
+	{
+		connection_pool_stats_t val = {0};
+
+		auto ep = impl_->_endpoint(addr.address(), port, false);
+		if( !ep )
+			return val;
+
+		impl::Lock lock(ep->mutex_);
+		val.idle_		= static_cast<std::uint32_t>(ep->idle_.size());
+		val.connecting_	= ep->connecting_;
+		val.busy_		= ep->total_ - val.idle_ - ep->connecting_;
+		val.waiting_	= static_cast<std::uint32_t>(ep->waiters_.size());
+		val.created_	= ep->created_;
+		val.reused_		= ep->reused_;
+		val.evicted_	= ep->evicted_;
+
+		return val;
+	}
+}
+}
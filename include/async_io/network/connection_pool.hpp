@@ -0,0 +1,99 @@
+#ifndef __ASYNC_NETWORK_CONNECTION_POOL_HPP
+#define __ASYNC_NETWORK_CONNECTION_POOL_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <functional>
+#include <system_error>
+
+#include "socket.hpp"
+#include "ip_address.hpp"
+#include "../timer/timer.hpp"
+
+
+namespace async { namespace network {
+
+	// ӳãԵendpoint
+	struct connection_pool_config_t
+	{
+		std::uint32_t min_idle_;		// Ԥȼպ󱣳ֵٿ
+		std::uint32_t max_idle_;		// Ĺ黹ֱӹر
+		std::uint32_t max_total_;		// +ʹ+е
+		std::uint32_t max_connecting_;	// ͬʱеConnectEx
+		std::uint32_t idle_timeout_;	// msгʱӱ
+		std::uint32_t sweep_interval_;	// msռ
+
+		connection_pool_config_t()
+			: min_idle_(0)
+			, max_idle_(64)
+			, max_total_(256)
+			, max_connecting_(16)
+			, idle_timeout_(60 * 1000)
+			, sweep_interval_(5 * 1000)
+		{}
+	};
+
+	// endpointͳϢ
+	struct connection_pool_stats_t
+	{
+		std::uint32_t idle_;
+		std::uint32_t busy_;
+		std::uint32_t connecting_;
+		std::uint32_t waiting_;
+		std::uint64_t created_;			// ½
+		std::uint64_t reused_;			// ÿӴ
+		std::uint64_t evicted_;			// ʱʧЧرյ
+	};
+
+
+	// -------------------------------------------------
+	// class connection_pool_t
+
+	// ip:portάӡcheckoutȸÿ(ȡǰԶǷѹر)
+	// ûпʱŶӵȴͬһendpointmax_connectingConnectEx
+	// ӻ黹ӰFIFOȴߡɶʱԻղ㵽min_idle
+	class connection_pool_t
+	{
+	public:
+		typedef std::shared_ptr<socket_handle_t>										socket_ptr_t;
+		typedef std::function<void(const std::error_code &, const socket_ptr_t &)>		checkout_handler_t;
+
+	private:
+		struct impl;
+		std::shared_ptr<impl> impl_;
+
+	public:
+		connection_pool_t(service::io_dispatcher_t &io,
+			timer::win_timer_service_t &timer_svr,
+			const connection_pool_config_t &config = connection_pool_config_t());
+		~connection_pool_t();
+
+	private:
+		connection_pool_t(const connection_pool_t &);
+		connection_pool_t &operator=(const connection_pool_t &);
+
+	public:
+		// ֱﵽmin_idle˺ʱҲᲹ
+		void prewarm(const std::string &ip, std::uint16_t port);
+		void prewarm(const ip_address &addr, std::uint16_t port);
+
+		// ӿʱhandlerڵֱִ߳УIOִ߳
+		void async_checkout(const std::string &ip, std::uint16_t port, const checkout_handler_t &handler);
+		void async_checkout(const ip_address &addr, std::uint16_t port, const checkout_handler_t &handler);
+
+		// 黹ӣԶѹرյӦreusable = false黹
+		void checkin(const ip_address &addr, std::uint16_t port, const socket_ptr_t &sck, bool reusable = true);
+
+		// رпӣȴoperation_canceledʧ
+		void clear();
+
+		connection_pool_stats_t stats(const ip_address &addr, std::uint16_t port) const;
+	};
+}
+}
+
+
+
+
+#endif
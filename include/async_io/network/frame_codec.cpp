@@ -0,0 +1,181 @@
+#include "frame_codec.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+#ifdef min
+#undef min
+#endif
+
+
+namespace async { namespace network {
+
+	frame_header_t make_frame_header(const frame_format_t &format, std::uint64_t len)
+	{
+		frame_header_t header = {{0}, 0};
+
+		if( format.prefix_ == frame_format_t::VARINT )
+		{
+			do
+			{
+				std::uint8_t val = static_cast<std::uint8_t>(len & 0x7F);
+				len >>= 7;
+				if( len != 0 )
+					val |= 0x80;
+
+				header.data_[header.size_++] = static_cast<char>(val);
+			} while( len != 0 );
+
+			return header;
+		}
+
+		assert(format.prefix_ == 1 || format.prefix_ == 2 || format.prefix_ == 4 || format.prefix_ == 8);
+		assert(format.prefix_ == 8 || len < (1ULL << (format.prefix_ * 8)));
+
+		header.size_ = format.prefix_;
+		for(std::uint32_t i = 0; i != format.prefix_; ++i)
+		{
+			const std::uint32_t shift = format.big_endian_ ? (format.prefix_ - 1 - i) * 8 : i * 8;
+			header.data_[i] = static_cast<char>((len >> shift) & 0xFF);
+		}
+
+		return header;
+	}
+
+
+	frame_decoder_t::frame_decoder_t(const frame_format_t &format)
+		: format_(format)
+		, header_len_(0)
+		, in_body_(false)
+		, body_len_(0)
+	{
+	}
+
+	void frame_decoder_t::reset()
+	{
+		header_len_ = 0;
+		in_body_ = false;
+		body_len_ = 0;
+		partial_.clear();
+		complete_.clear();
+		frames_.clear();
+	}
+
+	bool frame_decoder_t::feed(const char *data, std::uint32_t len)
+	{
+		frames_.clear();
+
+		const char *cur = data;
+		const char *const last = data + len;
+
+		while( cur != last )
+		{
+			// ϴδ֡壬󻻵complete_ֻһƴ֡
+			if( in_body_ )
+			{
+				const std::size_t cnt = static_cast<std::size_t>(std::min<std::uint64_t>(body_len_ - partial_.size(), last - cur));
+				partial_.insert(partial_.end(), cur, cur + cnt);
+				cur += cnt;
+
+				if( partial_.size() == body_len_ )
+				{
+					partial_.swap(complete_);
+					partial_.clear();
+					in_body_ = false;
+
+					frames_.push_back(service::const_buffer_t(complete_.data(), complete_.size()));
+				}
+				continue;
+			}
+
+			std::uint64_t body = 0;
+			if( header_len_ != 0 )
+			{
+				// 𿪵ǰ׺ֽڲ룬MAX_SIZEֽ
+				header_[header_len_++] = *cur++;
+
+				const int ret = _parse_header(header_, header_ + header_len_, body);
+				if( ret < 0 )
+					return false;
+				if( ret == 0 )
+					continue;
+
+				header_len_ = 0;
+			}
+			else
+			{
+				const int ret = _parse_header(cur, last, body);
+				if( ret < 0 )
+					return false;
+				if( ret == 0 )
+				{
+					header_len_ = static_cast<std::uint32_t>(last - cur);
+					std::copy(cur, last, header_);
+					break;
+				}
+
+				cur += ret;
+			}
+
+			if( body > format_.max_frame_ )
+				return false;
+
+			if( static_cast<std::uint64_t>(last - cur) >= body )
+			{
+				frames_.push_back(service::const_buffer_t(cur, static_cast<std::size_t>(body)));
+				cur += body;
+			}
+			else
+			{
+				partial_.reserve(static_cast<std::size_t>(body));
+				partial_.assign(cur, last);
+				body_len_ = body;
+				in_body_ = true;
+				cur = last;
+			}
+		}
+
+		return true;
+	}
+
+	int frame_decoder_t::_parse_header(const char *first, const char *last, std::uint64_t &len) const
+	{
+		if( format_.prefix_ == frame_format_t::VARINT )
+		{
+			std::uint64_t val = 0;
+			for(std::uint32_t i = 0; i != frame_header_t::MAX_SIZE; ++i)
+			{
+				if( first + i == last )
+					return 0;
+
+				const std::uint8_t byte = static_cast<std::uint8_t>(first[i]);
+				val |= static_cast<std::uint64_t>(byte & 0x7F) << (7 * i);
+
+				if( (byte & 0x80) == 0 )
+				{
+					len = val;
+					return static_cast<int>(i + 1);
+				}
+			}
+
+			return -1;
+		}
+
+		if( static_cast<std::uint32_t>(last - first) < format_.prefix_ )
+			return 0;
+
+		std::uint64_t val = 0;
+		for(std::uint32_t i = 0; i != format_.prefix_; ++i)
+		{
+			const std::uint8_t byte = static_cast<std::uint8_t>(first[i]);
+			if( format_.big_endian_ )
+				val = (val << 8) | byte;
+			else
+				val |= static_cast<std::uint64_t>(byte) << (8 * i);
+		}
+
+		len = val;
+		return static_cast<int>(format_.prefix_);
+	}
+}
+}
@@ -0,0 +1,118 @@
+#ifndef __ASYNC_NETWORK_FRAME_CODEC_HPP
+#define __ASYNC_NETWORK_FRAME_CODEC_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "../service/read_write_buffer.hpp"
+
+
+namespace async { namespace network {
+
+	// -------------------------------------------------
+	// struct frame_format_t
+
+	// ǰ׺ʽǰ׺еĳȲǰ׺
+	struct frame_format_t
+	{
+		static const std::uint32_t VARINT = 0;
+
+		std::uint32_t prefix_;		// 1/2/4/8ֽڣVARINTΪprotobufı䳤
+		bool big_endian_;			// ֻԶǰ׺Ч
+		std::uint64_t max_frame_;	// ΪЭ
+
+		frame_format_t(std::uint32_t prefix = 4, bool big_endian = false, std::uint64_t max_frame = 16 * 1024 * 1024)
+			: prefix_(prefix)
+			, big_endian_(big_endian)
+			, max_frame_(max_frame)
+		{}
+	};
+
+
+	// -------------------------------------------------
+	// struct frame_header_t
+
+	// õĳǰ׺֡һö໺дͣдǰЧ
+	struct frame_header_t
+	{
+		static const std::uint32_t MAX_SIZE = 10;
+
+		char data_[MAX_SIZE];
+		std::uint32_t size_;
+
+		service::const_buffer_t buffer() const
+		{
+			return service::const_buffer_t(data_, size_);
+		}
+	};
+
+	frame_header_t make_frame_header(const frame_format_t &format, std::uint64_t len);
+
+
+	// -------------------------------------------------
+	// class frame_decoder_t
+
+	// ǰ׺зһζɵݡڽջڵֱ֡ͼأ
+	// ֻпԽζ֡ſƴӡһfeed֡Ϊһأ
+	// ͼһfeedջǰЧڸãȶٷڴ
+	class frame_decoder_t
+	{
+	public:
+		typedef std::vector<service::const_buffer_t> batch_t;
+
+	private:
+		frame_format_t format_;
+
+		// 𿪵ĳǰ׺
+		char header_[frame_header_t::MAX_SIZE];
+		std::uint32_t header_len_;
+
+		// 𿪵֡
+		bool in_body_;
+		std::uint64_t body_len_;
+		std::vector<char> partial_;
+		std::vector<char> complete_;
+
+		batch_t frames_;
+
+	public:
+		explicit frame_decoder_t(const frame_format_t &format = frame_format_t());
+
+	private:
+		frame_decoder_t(const frame_decoder_t &);
+		frame_decoder_t &operator=(const frame_decoder_t &);
+
+	public:
+		const frame_format_t &format() const
+		{
+			return format_;
+		}
+
+		// falseʾЭ(֡䳤)ӦϿ
+		bool feed(const char *data, std::uint32_t len);
+
+		// һfeedõ֡
+		const batch_t &frames() const
+		{
+			return frames_;
+		}
+
+		// Ƿδ֡
+		bool has_partial() const
+		{
+			return in_body_ || header_len_ != 0;
+		}
+
+		void reset();
+
+	private:
+		// ǰ׺ȣ0ʾݲ㣬-1ʾʽ
+		int _parse_header(const char *first, const char *last, std::uint64_t &len) const;
+	};
+}
+}
+
+
+
+
+#endif
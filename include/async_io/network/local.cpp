@@ -0,0 +1,143 @@
+#include "local.hpp"
+
+#include <cstring>
+#include <cstddef>
+
+#include "../service/exception.hpp"
+
+
+namespace async { namespace network {
+
+	namespace {
+
+		// ntifs.hеĶ壬Windows 8.1ʼ֧FileReplaceCompletionInformation
+		struct file_completion_information_t
+		{
+			HANDLE port_;
+			PVOID key_;
+		};
+
+		struct io_status_block_t
+		{
+			union
+			{
+				LONG status_;
+				PVOID pointer_;
+			};
+			ULONG_PTR information_;
+		};
+
+		typedef LONG (NTAPI *nt_set_information_file_t)(HANDLE, io_status_block_t *, PVOID, ULONG, ULONG);
+
+		const ULONG FILE_REPLACE_COMPLETION_INFORMATION = 61;
+
+		// Ƶõľԭsocketһļԭ̹ɶ˿Ƚܰ󶨵
+		void detach_completion_port(SOCKET sck)
+		{
+			static const nt_set_information_file_t set_information =
+				reinterpret_cast<nt_set_information_file_t>(::GetProcAddress(::GetModuleHandleW(L"ntdll.dll"), "NtSetInformationFile"));
+			if( set_information == nullptr )
+				return;
+
+			io_status_block_t status = {0};
+			file_completion_information_t info = {0};
+			set_information(reinterpret_cast<HANDLE>(sck), &status, &info, sizeof(info), FILE_REPLACE_COMPLETION_INFORMATION);
+		}
+	}
+
+
+	local_endpoint::local_endpoint(const std::string &path)
+	{
+		std::memset(&addr_, 0, sizeof(addr_));
+		addr_.sun_family = AF_UNIX;
+
+		if( path.empty() || path.size() >= sizeof(addr_.sun_path) )
+			throw service::network_exception("local endpoint path length invalid");
+
+		std::memcpy(addr_.sun_path, path.c_str(), path.size());
+	}
+
+	int local_endpoint::size() const
+	{
+		return static_cast<int>(offsetof(sockaddr_un, sun_path) + std::strlen(addr_.sun_path) + 1);
+	}
+
+	void local_endpoint::remove() const
+	{
+		::DeleteFileA(addr_.sun_path);
+	}
+
+
+	std::uint32_t local_peer_pid(const socket_handle_t &channel)
+	{
+		ULONG pid = 0;
+		DWORD ret = 0;
+		if( 0 != ::WSAIoctl(channel.native_handle(), SIO_AF_UNIX_GETPEERPID, nullptr, 0, &pid, sizeof(pid), &ret, nullptr, nullptr) )
+			throw service::win32_exception_t("WSAIoctl");
+
+		return pid;
+	}
+
+	local_descriptor_t duplicate_socket(const socket_handle_t &sck, std::uint32_t pid)
+	{
+		local_descriptor_t descriptor = {0};
+		if( 0 != ::WSADuplicateSocketW(sck.native_handle(), pid, &descriptor.info_) )
+			throw service::win32_exception_t("WSADuplicateSocket");
+
+		return descriptor;
+	}
+
+	std::shared_ptr<socket_handle_t> adopt_socket(socket_handle_t::dispatcher_type &io, const local_descriptor_t &descriptor)
+	{
+		SOCKET sck = ::WSASocketW(FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO,
+			const_cast<WSAPROTOCOL_INFOW *>(&descriptor.info_), 0, WSA_FLAG_OVERLAPPED);
+		if( sck == INVALID_SOCKET )
+			throw service::win32_exception_t("WSASocket");
+
+		detach_completion_port(sck);
+
+		auto val = std::make_shared<socket_handle_t>(io);
+		try
+		{
+			val->assign(sck);
+		}
+		catch(...)
+		{
+			if( !val->is_open() )
+				::closesocket(sck);
+			throw;
+		}
+
+		return val;
+	}
+
+	void send_socket(socket_handle_t &channel, const socket_handle_t &sck)
+	{
+		const local_descriptor_t descriptor = duplicate_socket(sck, local_peer_pid(channel));
+
+		auto buf = descriptor.buffer();
+		std::uint32_t transfers = 0;
+		while( transfers < buf.size() )
+			transfers += static_cast<std::uint32_t>(channel.write(buf + transfers, 0));
+	}
+
+	std::shared_ptr<socket_handle_t> recv_socket(socket_handle_t &channel)
+	{
+		local_descriptor_t descriptor = {0};
+
+		auto buf = descriptor.buffer();
+		std::uint32_t transfers = 0;
+		while( transfers < buf.size() )
+		{
+			auto left = buf + transfers;
+			const std::size_t ret = channel.read(left, 0);
+			if( ret == 0 )
+				throw service::network_exception("local channel closed");
+
+			transfers += static_cast<std::uint32_t>(ret);
+		}
+
+		return adopt_socket(channel.get_dispatcher(), descriptor);
+	}
+}
+}
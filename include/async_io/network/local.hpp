@@ -0,0 +1,156 @@
+#ifndef __ASYNC_NETWORK_LOCAL_HPP
+#define __ASYNC_NETWORK_LOCAL_HPP
+
+#include <cstdint>
+#include <string>
+#include <memory>
+
+#include "../basic.hpp"
+
+// afunix.hWindows 10 1803(RS4)SDKУ8.1 SDK°䶨
+#ifdef NTDDI_WIN10_RS4
+#include <afunix.h>
+#else
+#define UNIX_PATH_MAX 108
+
+typedef struct sockaddr_un
+{
+	ADDRESS_FAMILY sun_family;
+	char sun_path[UNIX_PATH_MAX];
+} SOCKADDR_UN, *PSOCKADDR_UN;
+#endif
+
+#include "basic_acceptor.hpp"
+#include "basic_stream_socket.hpp"
+#include "socket_option.hpp"
+
+#include "../service/read_write_buffer.hpp"
+#include "../service/write.hpp"
+#include "../service/read.hpp"
+
+
+
+namespace async { namespace network {
+
+	// --------------------------------------------------
+	// class local_endpoint
+
+	// AF_UNIXļ·ַ
+	class local_endpoint
+	{
+		sockaddr_un addr_;
+
+	public:
+		explicit local_endpoint(const std::string &path);
+
+	public:
+		const sockaddr *data() const
+		{
+			return reinterpret_cast<const sockaddr *>(&addr_);
+		}
+
+		int size() const;
+
+		std::string path() const
+		{
+			return addr_.sun_path;
+		}
+
+		// bind֮ǰɾϴsocketļbindʧ
+		void remove() const;
+	};
+
+
+	// --------------------------------------------------
+	// class local
+
+	// ̼ͬʽ䣬÷tcpַͬΪlocal_endpoint
+	// WindowsAF_UNIXֻ֧SOCK_STREAMûݱ͡network.hppļʹʱ
+	class local
+	{
+	public:
+		typedef basic_acceptor_t<local>			accpetor;
+		typedef basic_stream_socket_t<local>	socket;
+		typedef local_endpoint					endpoint;
+
+	private:
+		local()
+		{}
+
+	public:
+		int type() const
+		{
+			return SOCK_STREAM;
+		}
+
+		int protocol() const
+		{
+			return 0;
+		}
+
+		int family() const
+		{
+			return AF_UNIX;
+		}
+
+	public:
+		static local stream()
+		{
+			return local();
+		}
+
+	public:
+		friend bool operator==(const local &, const local &)
+		{
+			return true;
+		}
+		friend bool operator!=(const local &lhs, const local &rhs)
+		{
+			return !(lhs == rhs);
+		}
+	};
+
+
+	// --------------------------------------------------
+	// 
+
+	// WindowsAF_UNIX֧SCM_RIGHTSΪWSADuplicateSocketΪԶ˽
+	// WSAPROTOCOL_INFOWΪͨݾlocal socketԶˣԶ˾ݴ˴Լsocket
+	// Զ˽ӹ֮ͷӦرԼĸҲͶIO
+	struct local_descriptor_t
+	{
+		WSAPROTOCOL_INFOW info_;
+
+		service::mutable_buffer_t buffer()
+		{
+			return service::buffer(reinterpret_cast<char *>(&info_), sizeof(info_));
+		}
+
+		service::const_buffer_t buffer() const
+		{
+			return service::buffer(reinterpret_cast<const char *>(&info_), sizeof(info_));
+		}
+	};
+
+	// ӵlocal socketԶ˽ID
+	std::uint32_t local_peer_pid(const socket_handle_t &channel);
+
+	// Ϊpid̸sck
+	local_descriptor_t duplicate_socket(const socket_handle_t &sck, std::uint32_t pid);
+
+	// socket󶨵ioԭsocketѹɶ˿ڻᱻ
+	std::shared_ptr<socket_handle_t> adopt_socket(socket_handle_t::dispatcher_type &io, const local_descriptor_t &descriptor);
+
+	// ͬշchannelsckԶ˽
+	void send_socket(socket_handle_t &channel, const socket_handle_t &sck);
+	std::shared_ptr<socket_handle_t> recv_socket(socket_handle_t &channel);
+}
+}
+
+
+
+
+
+
+
+#endif
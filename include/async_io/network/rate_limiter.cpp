@@ -0,0 +1,221 @@
+#include "rate_limiter.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+#include "../basic.hpp"
+#include "../service/clock.hpp"
+
+
+namespace async { namespace network {
+
+	namespace {
+
+		std::int64_t default_burst(std::uint64_t rate, std::uint64_t burst)
+		{
+			if( burst != 0 )
+				return static_cast<std::int64_t>(burst);
+
+			return std::max<std::int64_t>(static_cast<std::int64_t>(rate / 10), 1);
+		}
+	}
+
+	rate_limiter_t::rate_limiter_t(service::io_dispatcher_t &io, std::uint64_t rate, std::uint64_t burst)
+		: io_(io)
+		, tick_id_(0)
+		, ticking_(false)
+		, rate_(rate)
+		, burst_(default_burst(rate, burst))
+		, tokens_(burst_)
+		, last_refill_(service::now_ms())
+		, total_(0)
+		, window_start_(last_refill_)
+		, window_total_(0)
+		, throughput_(0)
+	{
+	}
+
+	rate_limiter_t::~rate_limiter_t()
+	{
+		std::uint32_t id = 0;
+		{
+			Lock lock(mutex_);
+			id = tick_id_;
+		}
+
+		if( id != 0 )
+			io_.remove_tick_handler(id);
+	}
+
+	void rate_limiter_t::set_rate(std::uint64_t rate, std::uint64_t burst)
+	{
+		Lock lock(mutex_);
+
+		_refill(service::now_ms());
+
+		rate_	= rate;
+		burst_	= default_burst(rate, burst);
+		tokens_	= std::min(tokens_, burst_);
+	}
+
+	std::uint64_t rate_limiter_t::rate() const
+	{
+		Lock lock(mutex_);
+		return rate_;
+	}
+
+	std::uint32_t rate_limiter_t::try_acquire(std::uint32_t want)
+	{
+		Lock lock(mutex_);
+
+		if( rate_ == 0 )
+		{
+			total_ += want;
+			return want;
+		}
+
+		// еȴʱ
+		if( !waiters_.empty() )
+			return 0;
+
+		_refill(service::now_ms());
+		if( tokens_ <= 0 )
+			return 0;
+
+		const std::uint32_t cnt = static_cast<std::uint32_t>(std::min<std::int64_t>(want, tokens_));
+		tokens_ -= cnt;
+		total_ += cnt;
+
+		return cnt;
+	}
+
+	void rate_limiter_t::refund(std::uint32_t cnt)
+	{
+		Lock lock(mutex_);
+
+		assert(total_ >= cnt);
+		total_ -= cnt;
+
+		if( rate_ != 0 )
+			tokens_ = std::min(tokens_ + cnt, burst_);
+	}
+
+	void rate_limiter_t::consume(std::uint32_t cnt)
+	{
+		Lock lock(mutex_);
+
+		total_ += cnt;
+		if( rate_ != 0 )
+			tokens_ -= cnt;
+	}
+
+	memory_pool::mt_memory_pool &rate_limiter_t::callback_pool()
+	{
+		static memory_pool::mt_memory_pool pool;
+		return pool;
+	}
+
+	void rate_limiter_t::defer(const resume_handler_t &handler)
+	{
+		{
+			Lock lock(mutex_);
+			waiters_.push_back(handler);
+
+			if( ticking_ )
+				return;
+
+			ticking_ = true;
+		}
+
+		// ܳmutex_עᣬڻصлᷴ
+		const std::uint32_t id = io_.add_tick_handler(TICK_PERIOD, [this]()
+		{
+			_on_tick();
+		});
+
+		Lock lock(mutex_);
+		tick_id_ = id;
+	}
+
+	std::uint64_t rate_limiter_t::throughput() const
+	{
+		Lock lock(mutex_);
+
+		_measure(service::now_ms());
+		return throughput_;
+	}
+
+	std::uint64_t rate_limiter_t::total() const
+	{
+		Lock lock(mutex_);
+		return total_;
+	}
+
+	void rate_limiter_t::_refill(std::uint64_t now)
+	{
+		if( now <= last_refill_ )
+			return;
+
+		const std::uint64_t add = rate_ * (now - last_refill_) / 1000;
+
+		// ʺܵʱһƵʱ䲻룬ⶪʧ
+		if( add == 0 )
+			return;
+
+		tokens_ = std::min<std::int64_t>(tokens_ + static_cast<std::int64_t>(add), burst_);
+		last_refill_ = now;
+	}
+
+	void rate_limiter_t::_measure(std::uint64_t now) const
+	{
+		// ѯһʱΪʱƽֵ
+		if( now < window_start_ || now - window_start_ < MEASURE_WINDOW )
+			return;
+
+		throughput_ = (total_ - window_total_) * 1000 / (now - window_start_);
+		window_total_ = total_;
+		window_start_ = now;
+	}
+
+	void rate_limiter_t::_on_tick()
+	{
+		const std::uint64_t now = service::now_ms();
+
+		std::deque<resume_handler_t> ready;
+		std::uint32_t remove_id = 0;
+		{
+			Lock lock(mutex_);
+
+			_measure(now);
+
+			if( waiters_.empty() )
+			{
+				// tick_id_Ϊ0˵עδأһ
+				if( tick_id_ != 0 )
+				{
+					remove_id = tick_id_;
+					tick_id_ = 0;
+					ticking_ = false;
+				}
+			}
+			else
+			{
+				_refill(now);
+
+				// ȡĵȴƣȻĻٴιҵβ
+				if( rate_ == 0 || tokens_ > 0 )
+					ready.swap(waiters_);
+			}
+		}
+
+		// ڻصעǰȫ
+		if( remove_id != 0 )
+			io_.remove_tick_handler(remove_id);
+
+		std::for_each(ready.begin(), ready.end(), [](const resume_handler_t &handler)
+		{
+			handler();
+		});
+	}
+}
+}
@@ -0,0 +1,95 @@
+#ifndef __ASYNC_NETWORK_RATE_LIMITER_HPP
+#define __ASYNC_NETWORK_RATE_LIMITER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <functional>
+
+#include "../service/dispatcher.hpp"
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+
+namespace async { namespace network {
+
+	// -------------------------------------------------
+	// class rate_limiter_t
+
+	// ͰλΪֽڡֻһỰҲͨshared_ptrһỰ
+	// ƲĲͨdeferdispatcherڻصڲƺFIFO·𣬲IO̡߳
+	// ֻйʱעڻصеlimiterûп
+	class rate_limiter_t
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+	public:
+		typedef std::function<void()>		resume_handler_t;
+
+		static const std::uint32_t TICK_PERIOD		= 10;		// ms
+		static const std::uint32_t MEASURE_WINDOW	= 1000;		// ms
+
+	private:
+		service::io_dispatcher_t &io_;
+		std::uint32_t tick_id_;
+		bool ticking_;
+
+		mutable Mutex mutex_;
+		std::uint64_t rate_;			// ֽ/룬0Ϊ
+		std::int64_t burst_;
+		std::int64_t tokens_;			// Ϊʾº˲Ƿ
+		std::uint64_t last_refill_;
+
+		std::deque<resume_handler_t> waiters_;
+
+		// ͳ
+		std::uint64_t total_;
+		mutable std::uint64_t window_start_;
+		mutable std::uint64_t window_total_;
+		mutable std::uint64_t throughput_;
+
+	public:
+		// burstΪ0ʱȡ100ms
+		rate_limiter_t(service::io_dispatcher_t &io, std::uint64_t rate, std::uint64_t burst = 0);
+		~rate_limiter_t();
+
+	private:
+		rate_limiter_t(const rate_limiter_t &);
+		rate_limiter_t &operator=(const rate_limiter_t &);
+
+	public:
+		void set_rate(std::uint64_t rate, std::uint64_t burst = 0);
+		std::uint64_t rate() const;
+
+		// ȡwantƣʵȡõ0ʾҪȴ
+		std::uint32_t try_acquire(std::uint32_t want);
+		// 黹δ
+		void refund(std::uint32_t cnt);
+		// ºˣȴܲǷ
+		void consume(std::uint32_t cnt);
+
+		// ƲIO߳ϵhandler
+		void defer(const resume_handler_t &handler);
+
+		// ·Ĳʹõķصlimiter÷ķͷ֮Ź黹Ϊ̬
+		static memory_pool::mt_memory_pool &callback_pool();
+
+		// һͳƴڵ£ֽ/
+		std::uint64_t throughput() const;
+		std::uint64_t total() const;
+
+	private:
+		void _refill(std::uint64_t now);
+		void _measure(std::uint64_t now) const;
+		void _on_tick();
+	};
+
+	typedef std::shared_ptr<rate_limiter_t> rate_limiter_ptr;
+}
+}
+
+
+
+
+#endif
@@ -0,0 +1,342 @@
+#include "relay.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+#include "../service/exception.hpp"
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+
+namespace async { namespace network {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		// дʱصڷֱִ߳Уת᲻ϼջȺΪͶ
+		const std::uint32_t MAX_INLINE_DEPTH = 8;
+		__declspec(thread) std::uint32_t inline_depth = 0;
+
+		struct depth_guard_t
+		{
+			depth_guard_t()		{ ++inline_depth; }
+			~depth_guard_t()	{ --inline_depth; }
+		};
+
+		std::error_code last_error()
+		{
+			std::error_code error(::WSAGetLastError(), std::system_category());
+			if( !error )
+				error = std::make_error_code(std::errc::connection_aborted);
+
+			return error;
+		}
+	}
+
+
+	relay_t::relay_t(const std::shared_ptr<socket_handle_t> &a, const std::shared_ptr<socket_handle_t> &b, std::uint32_t buffer_size)
+		: a_(a)
+		, b_(b)
+		, capacity_(buffer_size)
+		, buffer_(new char[buffer_size * 2])
+		, failed_(false)
+		, finished_(false)
+	{
+		assert(buffer_size != 0);
+
+		for(std::uint32_t i = 0; i != 2; ++i)
+		{
+			direction_t &dir = dirs_[i];
+			dir.src_ = i == 0 ? a_.get() : b_.get();
+			dir.dst_ = i == 0 ? b_.get() : a_.get();
+			dir.buffer_ = buffer_.get() + i * buffer_size;
+			dir.head_ = 0;
+			dir.size_ = 0;
+			dir.reading_ = false;
+			dir.writing_ = false;
+			dir.eof_ = false;
+			dir.done_ = false;
+			dir.bytes_ = 0;
+		}
+	}
+
+	void relay_t::start(const done_handler_type &handler)
+	{
+		{
+			AutoLock lock(mutex_);
+			done_handler_ = handler;
+		}
+
+		_pump(0);
+		_pump(1);
+	}
+
+	void relay_t::stop()
+	{
+		{
+			AutoLock lock(mutex_);
+			if( failed_ || finished_ )
+				return;
+
+			_fail(std::make_error_code(std::errc::operation_canceled));
+		}
+
+		_abort();
+	}
+
+	relay_stats_t relay_t::stats(std::uint32_t index)
+	{
+		assert(index < 2);
+
+		AutoLock lock(mutex_);
+		relay_stats_t val = { dirs_[index].bytes_, dirs_[index].done_ };
+		return val;
+	}
+
+	void relay_t::_pump(std::uint32_t index)
+	{
+		if( inline_depth >= MAX_INLINE_DEPTH )
+		{
+			auto this_val = shared_from_this();
+			a_->get_dispatcher().post([this_val, index](const std::error_code &, std::uint32_t)
+			{
+				this_val->_pump(index);
+			}, callback_pool());
+			return;
+		}
+
+		depth_guard_t guard;
+
+		char *read_buf = nullptr;
+		std::uint32_t read_len = 0;
+		service::const_buffer_t write_bufs[2];
+		std::uint32_t write_count = 0;
+		bool shutdown = false;
+		bool finished = false;
+
+		direction_t &dir = dirs_[index];
+		{
+			AutoLock lock(mutex_);
+
+			if( !failed_ )
+			{
+				// û;Ķʱص㣬֤һζ
+				if( dir.size_ == 0 && !dir.reading_ )
+					dir.head_ = 0;
+
+				if( !dir.reading_ && !dir.eof_ && dir.size_ != capacity_ )
+				{
+					const std::uint32_t tail = (dir.head_ + dir.size_) % capacity_;
+					read_buf = dir.buffer_ + tail;
+					read_len = tail < dir.head_ ? dir.head_ - tail : capacity_ - tail;
+					dir.reading_ = true;
+				}
+
+				if( !dir.writing_ && dir.size_ != 0 )
+				{
+					const std::uint32_t first = std::min(dir.size_, capacity_ - dir.head_);
+					write_bufs[write_count++] = service::const_buffer_t(dir.buffer_ + dir.head_, first);
+					if( dir.size_ > first )
+						write_bufs[write_count++] = service::const_buffer_t(dir.buffer_, dir.size_ - first);
+					dir.writing_ = true;
+				}
+
+				// Դѹرд꣬Ŀתر
+				if( dir.eof_ && !dir.done_ && !dir.reading_ && !dir.writing_ )
+				{
+					assert(dir.size_ == 0);
+					dir.done_ = true;
+					shutdown = true;
+				}
+			}
+
+			if( shutdown || failed_ )
+				finished = _finished();
+		}
+
+		if( write_count != 0 )
+			_write(index, write_bufs, write_count);
+
+		if( read_buf != nullptr )
+			_read(index, read_buf, read_len);
+
+		if( shutdown )
+			dir.dst_->shutdown(SD_SEND);
+
+		if( finished )
+			_done();
+	}
+
+	void relay_t::_read(std::uint32_t index, char *buf, std::uint32_t len)
+	{
+		auto this_val = shared_from_this();
+		service::mutable_buffer_t buffer(buf, len);
+
+		try
+		{
+			dirs_[index].src_->async_read(buffer, [this_val, index](const std::error_code &error, std::uint32_t size)
+			{
+				this_val->_on_read(index, error, size);
+			}, callback_pool());
+		}
+		catch(::exception::exception_base &e)
+		{
+			e.dump();
+			_on_read(index, last_error(), 0);
+		}
+	}
+
+	void relay_t::_write(std::uint32_t index, const service::const_buffer_t *buffers, std::uint32_t count)
+	{
+		auto this_val = shared_from_this();
+
+		try
+		{
+			dirs_[index].dst_->async_writev(buffers, count, [this_val, index](const std::error_code &error, std::uint32_t size)
+			{
+				this_val->_on_written(index, error, size);
+			}, callback_pool());
+		}
+		catch(::exception::exception_base &e)
+		{
+			e.dump();
+			_on_written(index, last_error(), 0);
+		}
+	}
+
+	void relay_t::_on_read(std::uint32_t index, const std::error_code &error, std::uint32_t size)
+	{
+		bool abort = false;
+		{
+			AutoLock lock(mutex_);
+
+			direction_t &dir = dirs_[index];
+			dir.reading_ = false;
+
+			if( error )
+				abort = _fail(error);
+			else if( size == 0 )
+				dir.eof_ = true;
+			else
+				dir.size_ += size;
+		}
+
+		if( abort )
+			_abort();
+
+		_pump(index);
+	}
+
+	void relay_t::_on_written(std::uint32_t index, const std::error_code &error, std::uint32_t size)
+	{
+		bool abort = false;
+		{
+			AutoLock lock(mutex_);
+
+			direction_t &dir = dirs_[index];
+			dir.writing_ = false;
+
+			if( error )
+				abort = _fail(error);
+			else
+			{
+				assert(size <= dir.size_);
+				dir.head_ = (dir.head_ + size) % capacity_;
+				dir.size_ -= size;
+				dir.bytes_ += size;
+			}
+		}
+
+		if( abort )
+			_abort();
+
+		_pump(index);
+	}
+
+	bool relay_t::_fail(const std::error_code &error)
+	{
+		if( failed_ )
+			return false;
+
+		failed_ = true;
+		error_ = error;
+		return true;
+	}
+
+	void relay_t::_abort()
+	{
+		// ȡδɵĶдԴ󷵻أ_pumpͳƽ
+		socket_handle_t *sockets[] = { a_.get(), b_.get() };
+		for(std::uint32_t i = 0; i != 2; ++i)
+		{
+			try
+			{
+				if( sockets[i]->is_open() )
+					sockets[i]->cancel();
+			}
+			catch(::exception::exception_base &e)
+			{
+				e.dump();
+			}
+		}
+	}
+
+	bool relay_t::_finished()
+	{
+		if( finished_ )
+			return false;
+
+		for(std::uint32_t i = 0; i != 2; ++i)
+		{
+			const direction_t &dir = dirs_[i];
+			if( dir.reading_ || dir.writing_ || !(dir.done_ || failed_) )
+				return false;
+		}
+
+		finished_ = true;
+		return true;
+	}
+
+	void relay_t::_done()
+	{
+		done_handler_type handler;
+		std::error_code error;
+		relay_stats_t stats[2] = {0};
+		{
+			AutoLock lock(mutex_);
+
+			// صͨrelayѭ
+			handler.swap(done_handler_);
+			error = error_;
+			for(std::uint32_t i = 0; i != 2; ++i)
+			{
+				stats[i].bytes_ = dirs_[i].bytes_;
+				stats[i].eof_ = dirs_[i].done_;
+			}
+		}
+
+		if( !handler )
+			return;
+
+		try
+		{
+			handler(error, stats[0], stats[1]);
+		}
+		catch(::exception::exception_base &e)
+		{
+			e.dump();
+		}
+		catch(std::exception &)
+		{
+		}
+	}
+}
+}
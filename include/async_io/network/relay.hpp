@@ -0,0 +1,118 @@
+#ifndef __ASYNC_NETWORK_RELAY_HPP
+#define __ASYNC_NETWORK_RELAY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <system_error>
+
+#include "socket.hpp"
+
+
+namespace async { namespace network {
+
+	// תͳ
+	struct relay_stats_t
+	{
+		std::uint64_t bytes_;		// дĿ˵ֽ
+		bool eof_;					// Դرգת겢Ŀshutdown(SD_SEND)
+	};
+
+
+	// -------------------------------------------------
+	// class relay_t
+
+	// ӵTCP socket֮˫תWindowsûspliceÿһλ
+	// Ļһη䣻ݴӽջֱдû̬ٿ
+	// ÿͬʱһһдʱֹͣԴˣγɱѹڴ̶Ϊ2 * buffer_size
+	// ԴEOFյдٶĿshutdown(SD_SEND)һתְ֧رգ
+	// 򶼽صdoneһʱȡ˵IOԵһصdone
+	// relayرsocketdoneصĵߴ(session::disconnect)
+	class relay_t
+		: public std::enable_shared_from_this<relay_t>
+	{
+		typedef std::mutex					Mutex;
+		typedef std::lock_guard<Mutex>		AutoLock;
+
+	public:
+		// firstΪabķsecondΪbaķ
+		typedef std::function<void(const std::error_code &error, const relay_stats_t &first, const relay_stats_t &second)>	done_handler_type;
+
+		static const std::uint32_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+	private:
+		struct direction_t
+		{
+			socket_handle_t *src_;
+			socket_handle_t *dst_;
+
+			// [head_, head_ + size_)Σд
+			char *buffer_;
+			std::uint32_t head_;
+			std::uint32_t size_;
+
+			bool reading_;
+			bool writing_;
+			bool eof_;
+			bool done_;
+			std::uint64_t bytes_;
+		};
+
+		std::shared_ptr<socket_handle_t> a_;
+		std::shared_ptr<socket_handle_t> b_;
+
+		const std::uint32_t capacity_;
+		std::unique_ptr<char[]> buffer_;
+
+		Mutex mutex_;
+		direction_t dirs_[2];
+		std::error_code error_;
+		bool failed_;
+		bool finished_;
+
+		done_handler_type done_handler_;
+
+	public:
+		// sessionsocketñ챣ֻỰstd::shared_ptr<socket_handle_t>(session, &session->get())
+		// ʱӦڸsessionϷд
+		relay_t(const std::shared_ptr<socket_handle_t> &a, const std::shared_ptr<socket_handle_t> &b,
+			std::uint32_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+	private:
+		relay_t(const relay_t &);
+		relay_t &operator=(const relay_t &);
+
+	public:
+		// ֻܵһ
+		void start(const done_handler_type &handler);
+
+		// ȡδɵIOdoneĴΪoperation_canceled
+		void stop();
+
+		relay_stats_t stats(std::uint32_t index);
+
+	private:
+		void _pump(std::uint32_t index);
+		void _read(std::uint32_t index, char *buf, std::uint32_t len);
+		void _write(std::uint32_t index, const service::const_buffer_t *buffers, std::uint32_t count);
+
+		void _on_read(std::uint32_t index, const std::error_code &error, std::uint32_t size);
+		void _on_written(std::uint32_t index, const std::error_code &error, std::uint32_t size);
+
+		// ʱ_failǷΪһ_finishedֻڽʱһtrue
+		bool _fail(const std::error_code &error);
+		bool _finished();
+
+		void _abort();
+		void _done();
+	};
+
+	typedef std::shared_ptr<relay_t> relay_ptr;
+}
+}
+
+
+
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef __ASYNC_NETWORK_SESSION_REGISTRY_HPP
+#define __ASYNC_NETWORK_SESSION_REGISTRY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+
+
+namespace async { namespace network {
+
+	// -------------------------------------------------
+	// class session_registry_t
+
+	// ỰIDƬעֻweak_ptrӳỰڡ
+	// ÿƬһ롢ɾֻڷƬƬθƴĻỰ
+	template < typename SessionT, std::uint32_t ShardBits = 6 >
+	class session_registry_t
+	{
+	public:
+		typedef std::shared_ptr<SessionT>	session_ptr_t;
+		typedef std::weak_ptr<SessionT>		session_weak_ptr_t;
+
+		static const std::uint32_t SHARD_COUNT = 1 << ShardBits;
+
+	private:
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+		struct shard_t
+		{
+			Mutex mutex_;
+			std::unordered_map<std::uint64_t, session_weak_ptr_t> sessions_;
+
+			// ڷƬͬһ
+			char padding_[64];
+		};
+
+		mutable shard_t shards_[SHARD_COUNT];
+		std::atomic<std::size_t> size_;
+
+	public:
+		session_registry_t()
+			: size_(0)
+		{}
+
+	private:
+		session_registry_t(const session_registry_t &);
+		session_registry_t &operator=(const session_registry_t &);
+
+	public:
+		std::size_t size() const
+		{
+			return size_;
+		}
+
+		void insert(std::uint64_t id, const session_ptr_t &val)
+		{
+			auto &shard = _shard(id);
+
+			Lock lock(shard.mutex_);
+			if( shard.sessions_.insert(std::make_pair(id, session_weak_ptr_t(val))).second )
+				++size_;
+		}
+
+		void erase(std::uint64_t id)
+		{
+			auto &shard = _shard(id);
+
+			Lock lock(shard.mutex_);
+			if( shard.sessions_.erase(id) != 0 )
+				--size_;
+		}
+
+		session_ptr_t find(std::uint64_t id) const
+		{
+			auto &shard = _shard(id);
+
+			Lock lock(shard.mutex_);
+			auto iter = shard.sessions_.find(id);
+			if( iter == shard.sessions_.end() )
+				return session_ptr_t();
+
+			return iter->second.lock();
+		}
+
+		// һƬдĻỰ׷ӵout
+		void snapshot(std::uint32_t shard_index, std::vector<session_ptr_t> &out) const
+		{
+			auto &shard = shards_[shard_index & (SHARD_COUNT - 1)];
+
+			Lock lock(shard.mutex_);
+			out.reserve(out.size() + shard.sessions_.size());
+			for( auto iter = shard.sessions_.begin(); iter != shard.sessions_.end(); ++iter )
+			{
+				auto val = iter->second.lock();
+				if( val )
+					out.push_back(std::move(val));
+			}
+		}
+
+		// дỰĿգȫһµʱ
+		std::vector<session_ptr_t> snapshot() const
+		{
+			std::vector<session_ptr_t> out;
+			out.reserve(size_);
+
+			for( std::uint32_t i = 0; i != SHARD_COUNT; ++i )
+				snapshot(i, out);
+
+			return out;
+		}
+
+	private:
+		shard_t &_shard(std::uint64_t id) const
+		{
+			// IDȡλɾȷֲ
+			return shards_[id & (SHARD_COUNT - 1)];
+		}
+	};
+}
+}
+
+
+
+
+#endif
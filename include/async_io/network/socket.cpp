@@ -51,10 +51,20 @@ namespace async { namespace network {
 		if( is_open() )
 			throw service::network_exception("Socket already opened!");
 
-		socket_ = ::WSASocket(family, nType, nProtocol, NULL, 0, WSA_FLAG_OVERLAPPED);
-		if( socket_ == INVALID_SOCKET )
+		SOCKET sck = ::WSASocket(family, nType, nProtocol, NULL, 0, WSA_FLAG_OVERLAPPED);
+		if( sck == INVALID_SOCKET )
 			throw service::win32_exception_t("WSASocket");
 
+		assign(sck);
+	}
+
+	void socket_handle_t::assign(native_handle_type sck)
+	{
+		if( is_open() )
+			throw service::network_exception("Socket already opened!");
+
+		socket_ = sck;
+
 		// 󶨵IOCP
 		io_.bind(reinterpret_cast<HANDLE>(socket_));
 
@@ -102,6 +112,15 @@ namespace async { namespace network {
 			throw service::win32_exception_t("bind");
 	}
 
+	void socket_handle_t::bind(const sockaddr *addr, int len)
+	{
+		if( !is_open() )
+			throw service::network_exception("Socket not open");
+
+		if( SOCKET_ERROR == ::bind(socket_, addr, len) )
+			throw service::win32_exception_t("bind");
+	}
+
 	void socket_handle_t::listen(int nMax)
 	{
 		if( !is_open() )
@@ -138,6 +157,15 @@ namespace async { namespace network {
 			throw service::win32_exception_t("connect");
 	}
 
+	void socket_handle_t::connect(const sockaddr *addr, int len)
+	{
+		if( !is_open() )
+			throw service::network_exception("Socket not open");
+
+		if( SOCKET_ERROR == ::connect(socket_, addr, len) )
+			throw service::win32_exception_t("connect");
+	}
+
 	void socket_handle_t::dis_connect(int shut, bool bReuseSocket/* = true*/)
 	{
 		if( !is_open() )
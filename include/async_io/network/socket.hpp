@@ -1,9 +1,12 @@
 #ifndef __ASYNC_NETWORK_SOCKET_HPP
 #define __ASYNC_NETWORK_SOCKET_HPP
 
+#include <memory>
+
 #include "../service/dispatcher.hpp"
 #include "../service/read_write_buffer.hpp"
 #include "../service/multi_buffer.hpp"
+#include "../../utility/move_wrapper.hpp"
 
 #include "ip_address.hpp"
 #include "socket_provider.hpp"
@@ -65,6 +68,8 @@ namespace async { namespace network {
 
 		// WSASocket
 		void open(int family, int nType, int nProtocol);
+		// ӹеsocket(WSADuplicateSocketõ)󶨵IOCP
+		void assign(native_handle_type sck);
 		// shutdown
 		void shutdown(int shut);
 		// closesocket
@@ -76,6 +81,7 @@ namespace async { namespace network {
 
 		// bind
 		void bind(int family, std::uint16_t uPort, const ip_address &addr);
+		void bind(const sockaddr *addr, int len);
 		// listen
 		void listen(int nMax);
 
@@ -88,6 +94,7 @@ namespace async { namespace network {
 	public:
 		socket_handle_ptr accept();
 		void connect(int family, const ip_address &addr, std::uint16_t uPort);
+		void connect(const sockaddr *addr, int len);
 		void dis_connect(int shut, bool bReuseSocket = true);
 
 		size_t read(service::mutable_buffer_t &buffer, DWORD flag);
@@ -104,6 +111,9 @@ namespace async { namespace network {
 		// 첽ҪȰ󶨶˿
 		template < typename HandlerT, typename AllocatorT >
 		void async_connect(const ip_address &addr, std::uint16_t uPort, HandlerT &&callback, AllocatorT &allocator);
+		// ַӣAF_UNIX֧ConnectExͬӺͨdispatcherصַbind
+		template < typename HandlerT, typename AllocatorT >
+		void async_connect(const sockaddr *addr, int len, HandlerT &&callback, AllocatorT &allocator);
 
 		// 첽Ͽ
 		template < typename HandlerT, typename AllocatorT >
@@ -118,6 +128,13 @@ namespace async { namespace network {
 		void async_write(const service::const_buffer_t &buf, HandlerT &&callback, AllocatorT &allocator);
 		template < typename HandlerT, typename AllocatorT, typename ...Args >
 		void async_write(HandlerT &&callback, AllocatorT &allocator, const Args &...args);
+		// ʱľۼдWSABUFֻڵڼʹã뱣ֵص
+		template < typename HandlerT, typename AllocatorT >
+		void async_writev(const service::const_buffer_t *buffers, std::uint32_t count, HandlerT &&callback, AllocatorT &allocator);
+		// TransmitPacketsϷڴļļںֱӶͣû̬
+		// Ԫ顢ļ뱣ֵص
+		template < typename HandlerT, typename AllocatorT >
+		void async_transmit(TRANSMIT_PACKETS_ELEMENT *elements, std::uint32_t count, HandlerT &&callback, AllocatorT &allocator);
 
 		// 첽UDPȡ
 		template < typename HandlerT >
@@ -226,7 +243,7 @@ namespace async { namespace network {
 		remoteAddr.sin_port			= ::htons(uPort);
 		remoteAddr.sin_addr.s_addr	= ::htonl(addr.address());
 
-		typedef detail::connect_handle_t<HandlerT> HookConnect;
+		typedef details::connect_handle_t<HandlerT> HookConnect;
 		HookConnect connect_hook(*this, std::forward<HandlerT>(callback));
 		service::async_callback_base_ptr async_result(service::make_async_callback(std::move(connect_hook), allocator));
 
@@ -237,6 +254,38 @@ namespace async { namespace network {
 		async_result.release();
 	}
 
+	template < typename HandlerT, typename AllocatorT >
+	void socket_handle_t::async_connect(const sockaddr *addr, int len, HandlerT &&callback, AllocatorT &allocator)
+	{
+		if( !is_open() )
+			throw service::network_exception("Socket not open");
+
+		if( addr->sa_family == AF_UNIX )
+		{
+			// Ӳʧʱ쳣ConnectExһͨصش
+			std::error_code error;
+			if( SOCKET_ERROR == ::connect(socket_, addr, len) )
+				error = std::error_code(::WSAGetLastError(), std::system_category());
+
+			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(callback));
+			io_.post([handler_val, error](const std::error_code &, std::uint32_t)
+			{
+				handler_val.value_(error);
+			}, allocator);
+			return;
+		}
+
+		typedef details::connect_handle_t<HandlerT> HookConnect;
+		HookConnect connect_hook(*this, std::forward<HandlerT>(callback));
+		service::async_callback_base_ptr async_result(service::make_async_callback(std::move(connect_hook), allocator));
+
+		if( !socket_provider::singleton().ConnectEx(socket_, addr, len, 0, 0, 0, async_result.get())
+			&& ::WSAGetLastError() != WSA_IO_PENDING )
+			throw service::win32_exception_t("ConnectionEx");
+
+		async_result.release();
+	}
+
 
 	// 첽ӽ
 	template < typename HandlerT, typename AllocatorT >
@@ -307,6 +356,64 @@ namespace async { namespace network {
 			asynResult.release();
 	}
 
+	template < typename HandlerT, typename AllocatorT >
+	void socket_handle_t::async_writev(const service::const_buffer_t *buffers, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator)
+	{
+		static const std::uint32_t STACK_BUFFERS = 64;
+
+		WSABUF stack_buffers[STACK_BUFFERS];
+		std::unique_ptr<WSABUF[]> heap_buffers;
+
+		WSABUF *wsabufs = stack_buffers;
+		if( count > STACK_BUFFERS )
+		{
+			heap_buffers.reset(new WSABUF[count]);
+			wsabufs = heap_buffers.get();
+		}
+
+		for(std::uint32_t i = 0; i != count; ++i)
+		{
+			wsabufs[i].buf = const_cast<char *>(buffers[i].data());
+			wsabufs[i].len = static_cast<ULONG>(buffers[i].size());
+		}
+
+		service::async_callback_base_ptr asynResult(service::make_async_callback(std::forward<HandlerT>(handler), allocator));
+
+		DWORD dwFlag = 0;
+		DWORD dwSize = 0;
+
+		int ret = ::WSASend(socket_, wsabufs, count, &dwSize, dwFlag, asynResult.get(), NULL);
+		if( 0 != ret
+			&& ::WSAGetLastError() != WSA_IO_PENDING )
+			throw service::win32_exception_t("WSASend");
+		else if( ret == 0 )
+			asynResult->invoke(std::error_code(), dwSize);
+		else
+			asynResult.release();
+	}
+
+
+	template < typename HandlerT, typename AllocatorT >
+	void socket_handle_t::async_transmit(TRANSMIT_PACKETS_ELEMENT *elements, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator)
+	{
+		service::async_callback_base_ptr asynResult(service::make_async_callback(std::forward<HandlerT>(handler), allocator));
+
+		BOOL ret = socket_provider::singleton().TransmitPackets(socket_, elements, count, 0, asynResult.get(), TF_USE_KERNEL_APC);
+		if( !ret
+			&& ::WSAGetLastError() != WSA_IO_PENDING )
+			throw service::win32_exception_t("TransmitPackets");
+		else if( ret )
+		{
+			// ͬʱͶɰ(FILE_SKIP_COMPLETION_PORT_ON_SUCCESS)ͳȴOVERLAPPEDȡ
+			DWORD dwSize = 0;
+			DWORD dwFlag = 0;
+			::WSAGetOverlappedResult(socket_, asynResult.get(), &dwSize, FALSE, &dwFlag);
+			asynResult->invoke(std::error_code(), dwSize);
+		}
+		else
+			asynResult.release();
+	}
+
 
 	// 첽ر
 	template < typename HandlerT, typename AllocatorT >
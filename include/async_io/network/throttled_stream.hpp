@@ -0,0 +1,220 @@
+#ifndef __ASYNC_NETWORK_THROTTLED_STREAM_HPP
+#define __ASYNC_NETWORK_THROTTLED_STREAM_HPP
+
+#include <cstdint>
+#include <memory>
+#include <system_error>
+#include <type_traits>
+#include <functional>
+
+#include "rate_limiter.hpp"
+#include "../service/read_write_buffer.hpp"
+#include "../service/exception.hpp"
+#include "../../utility/move_wrapper.hpp"
+
+
+namespace async { namespace network {
+
+	// -------------------------------------------------
+	// class throttled_stream_t
+
+	// StreamTϰÿͶݵĳȡservice::async_read/async_writeϲ
+	// ÿͶƲʱͶҵlimiterϣȴڻص·
+	// limiterΪʱֱתstreamδɵĲólimiterϵͶֻownerweak_ptr
+	// ·ǰownerͷʱERROR_OPERATION_ABORTEDص
+	template < typename StreamT >
+	class throttled_stream_t
+	{
+		typedef std::function<void(const std::error_code &, std::uint32_t)> resume_t;
+
+		// ڵײstreamͶһΣ_runԲͬɻص͵
+		struct read_issue_t
+		{
+			StreamT *stream_;
+
+			template < typename CompletionT, typename AllocatorT >
+			void operator()(service::mutable_buffer_t &part, CompletionT &&completion, AllocatorT &allocator) const
+			{
+				stream_->async_read(part, std::forward<CompletionT>(completion), allocator);
+			}
+		};
+
+		struct write_issue_t
+		{
+			StreamT *stream_;
+
+			template < typename CompletionT, typename AllocatorT >
+			void operator()(const service::const_buffer_t &part, CompletionT &&completion, AllocatorT &allocator) const
+			{
+				stream_->async_write(part, std::forward<CompletionT>(completion), allocator);
+			}
+		};
+
+		StreamT &stream_;
+		rate_limiter_ptr read_limiter_;
+		rate_limiter_ptr write_limiter_;
+		std::weak_ptr<void> owner_;
+
+	public:
+		explicit throttled_stream_t(StreamT &stream)
+			: stream_(stream)
+		{}
+
+	private:
+		throttled_stream_t(const throttled_stream_t &);
+		throttled_stream_t &operator=(const throttled_stream_t &);
+
+	public:
+		StreamT &next_layer()
+		{
+			return stream_;
+		}
+
+		// ֻӦûδɲʱáownerΪͬʱбstreamĶ(Ự)
+		void set_limiter(const rate_limiter_ptr &read_limiter, const rate_limiter_ptr &write_limiter, const std::shared_ptr<void> &owner)
+		{
+			read_limiter_ = read_limiter;
+			write_limiter_ = write_limiter;
+			owner_ = owner;
+		}
+
+		const rate_limiter_ptr &read_limiter() const
+		{
+			return read_limiter_;
+		}
+
+		const rate_limiter_ptr &write_limiter() const
+		{
+			return write_limiter_;
+		}
+
+	public:
+		template < typename HandlerT, typename AllocatorT >
+		void async_read(service::mutable_buffer_t &buf, HandlerT &&handler, AllocatorT &allocator)
+		{
+			if( !read_limiter_ )
+				return stream_.async_read(buf, std::forward<HandlerT>(handler), allocator);
+
+			const read_issue_t issue = { &stream_ };
+			_run(read_limiter_, buf, std::forward<HandlerT>(handler), allocator, issue);
+		}
+
+		template < typename HandlerT, typename AllocatorT >
+		void async_write(const service::const_buffer_t &buf, HandlerT &&handler, AllocatorT &allocator)
+		{
+			if( !write_limiter_ )
+				return stream_.async_write(buf, std::forward<HandlerT>(handler), allocator);
+
+			const write_issue_t issue = { &stream_ };
+			_run(write_limiter_, buf, std::forward<HandlerT>(handler), allocator, issue);
+		}
+
+		// ໺д֣ɺʵʳȼˣǷ֮Ĳȴ
+		template < typename HandlerT, typename AllocatorT, typename ...Args >
+		void async_write(HandlerT &&handler, AllocatorT &allocator, const Args &...args)
+		{
+			if( !write_limiter_ )
+				return stream_.async_write(std::forward<HandlerT>(handler), allocator, args...);
+
+			auto limiter = write_limiter_;
+			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
+			stream_.async_write([limiter, handler_val](const std::error_code &error, std::uint32_t size)
+			{
+				limiter->consume(size);
+				handler_val.value_(error, size);
+			}, allocator, args...);
+		}
+
+		template < typename HandlerT, typename AllocatorT >
+		void async_writev(const service::const_buffer_t *buffers, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator)
+		{
+			if( !write_limiter_ )
+				return stream_.async_writev(buffers, count, std::forward<HandlerT>(handler), allocator);
+
+			auto limiter = write_limiter_;
+			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
+			stream_.async_writev(buffers, count, [limiter, handler_val](const std::error_code &error, std::uint32_t size)
+			{
+				limiter->consume(size);
+				handler_val.value_(error, size);
+			}, allocator);
+		}
+
+		template < typename HandlerT, typename AllocatorT >
+		void async_transmit(TRANSMIT_PACKETS_ELEMENT *elements, std::uint32_t count, HandlerT &&handler, AllocatorT &allocator)
+		{
+			if( !write_limiter_ )
+				return stream_.async_transmit(elements, count, std::forward<HandlerT>(handler), allocator);
+
+			auto limiter = write_limiter_;
+			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
+			stream_.async_transmit(elements, count, [limiter, handler_val](const std::error_code &error, std::uint32_t size)
+			{
+				limiter->consume(size);
+				handler_val.value_(error, size);
+			}, allocator);
+		}
+
+	private:
+		template < typename BufferT, typename HandlerT, typename AllocatorT, typename IssueT >
+		void _run(const rate_limiter_ptr &limiter, BufferT &buf, HandlerT &&handler, AllocatorT &allocator, const IssueT &issue)
+		{
+			typedef typename std::decay<HandlerT>::type handler_t;
+
+			const std::uint32_t want = static_cast<std::uint32_t>(buf.size());
+			const std::uint32_t granted = limiter->try_acquire(want);
+
+			if( granted == 0 )
+			{
+				// ʱhandlershared_ptrУ·ʧʱԿɻص
+				// ·ʹù̶resume_t뾲̬أ_runʵ޵ݹ飻
+				// limiterowner÷ķͷ֮ŵãֻweak_ptrallocator
+				auto buf_val = typename std::remove_const<BufferT>::type(buf);
+				auto handler_val = std::make_shared<handler_t>(std::forward<HandlerT>(handler));
+				std::weak_ptr<void> owner = owner_;
+
+				limiter->defer([this, owner, limiter, handler_val, buf_val, issue]() mutable
+				{
+					auto owner_val = owner.lock();
+					if( !owner_val )
+					{
+						(*handler_val)(std::error_code(ERROR_OPERATION_ABORTED, std::system_category()), 0);
+						return;
+					}
+
+					try
+					{
+						_run(limiter, buf_val, resume_t([handler_val](const std::error_code &error, std::uint32_t size)
+						{
+							(*handler_val)(error, size);
+						}), rate_limiter_t::callback_pool(), issue);
+					}
+					catch( ::exception::exception_base &e )
+					{
+						e.dump();
+						(*handler_val)(e.code(), 0);
+					}
+				});
+				return;
+			}
+
+			auto part = typename std::remove_const<BufferT>::type(buf.data(), granted);
+			auto handler_val = utility::make_move_obj(std::forward<HandlerT>(handler));
+
+			issue(part, [limiter, granted, handler_val](const std::error_code &error, std::uint32_t size)
+			{
+				// ʵʴĲֹ黹
+				if( size < granted )
+					limiter->refund(granted - size);
+
+				handler_val.value_(error, size);
+			}, allocator);
+		}
+	};
+}
+}
+
+
+
+
+#endif
@@ -0,0 +1,240 @@
+#include "channel.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <future>
+
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+
+namespace async { namespace rpc {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		void signal_done(std::promise<void> *done)
+		{
+			done->set_value();
+		}
+	}
+
+	channel_t::channel_t(service::io_dispatcher_t &io, std::uint32_t recv_buffer_size)
+		: client_(io)
+		, decoder_(rpc_frame_format())
+		, recv_buffer_(recv_buffer_size)
+		, next_id_(0)
+		, connected_(false)
+	{
+		client_.register_disconnect_handler([this]()
+		{
+			_on_disconnect();
+		});
+	}
+
+	channel_t::~channel_t()
+	{
+		stop();
+	}
+
+	bool channel_t::start(const std::string &ip, std::uint16_t port)
+	{
+		if( !client_.start(ip, port) )
+			return false;
+
+		decoder_.reset();
+		{
+			Lock lock(mutex_);
+			connected_ = true;
+		}
+
+		_read();
+		return true;
+	}
+
+	void channel_t::stop()
+	{
+		bool connected = false;
+		{
+			Lock lock(mutex_);
+			connected = connected_;
+		}
+
+		if( connected )
+			client_.disconnect();
+	}
+
+	std::size_t channel_t::pending()
+	{
+		Lock lock(mutex_);
+		return calls_.size();
+	}
+
+	void channel_t::CallMethod(const google::protobuf::MethodDescriptor *method,
+		google::protobuf::RpcController *controller,
+		const google::protobuf::Message *request,
+		google::protobuf::Message *response,
+		google::protobuf::Closure *done)
+	{
+		std::promise<void> sync_done;
+		const bool sync = done == nullptr;
+		if( sync )
+			done = google::protobuf::NewCallback(&signal_done, &sync_done);
+
+		rpc_header_t header = {0};
+		header.type_ = RPC_REQUEST;
+		header.method_ = static_cast<std::uint16_t>(method->index());
+		header.service_ = service_id(method->service()->full_name());
+
+		{
+			Lock lock(mutex_);
+			if( !connected_ )
+			{
+				lock.unlock();
+
+				controller->SetFailed("rpc channel not connected");
+				done->Run();
+				return;
+			}
+
+			header.call_id_ = ++next_id_;
+
+			const call_t call = { controller, response, done };
+			calls_.insert(std::make_pair(header.call_id_, call));
+		}
+
+		const std::vector<char> *buf = nullptr;
+		try
+		{
+			buf = outbound_.append(header, *request);
+		}
+		catch(::exception::exception_base &e)
+		{
+			e.dump();
+
+			bool found = false;
+			{
+				Lock lock(mutex_);
+				found = calls_.erase(header.call_id_) != 0;
+			}
+
+			// ϿʱѾ_on_disconnect
+			if( found )
+			{
+				controller->SetFailed(e.what());
+				done->Run();
+			}
+		}
+
+		_write(buf);
+
+		if( sync )
+			sync_done.get_future().wait();
+	}
+
+	void channel_t::_read()
+	{
+		service::mutable_buffer_t buf(recv_buffer_.data(), recv_buffer_.size());
+		client_.async_read_some(buf, 0, [this](std::uint32_t size)
+		{
+			_on_read(size);
+		}, callback_pool());
+	}
+
+	void channel_t::_on_read(std::uint32_t size)
+	{
+		if( !decoder_.feed(recv_buffer_.data(), size) )
+		{
+			client_.disconnect();
+			return;
+		}
+
+		for(auto &frame : decoder_.frames())
+		{
+			if( !_dispatch(frame) )
+			{
+				client_.disconnect();
+				return;
+			}
+		}
+
+		_read();
+	}
+
+	bool channel_t::_dispatch(const service::const_buffer_t &frame)
+	{
+		if( frame.size() < sizeof(rpc_header_t) )
+			return false;
+
+		rpc_header_t header;
+		std::memcpy(&header, frame.data(), sizeof(header));
+
+		call_t call = {0};
+		{
+			Lock lock(mutex_);
+			auto iter = calls_.find(header.call_id_);
+			if( iter == calls_.end() )
+				return false;
+
+			call = iter->second;
+			calls_.erase(iter);
+		}
+
+		const char *body = frame.data() + sizeof(header);
+		const int len = static_cast<int>(frame.size() - sizeof(header));
+
+		switch( header.type_ )
+		{
+		case RPC_RESPONSE:
+			if( !call.response_->ParseFromArray(body, len) )
+				call.controller_->SetFailed("rpc response parse failed");
+			break;
+		case RPC_ERROR:
+			call.controller_->SetFailed(std::string(body, len));
+			break;
+		default:
+			call.controller_->SetFailed("rpc unexpected message type");
+			break;
+		}
+
+		call.done_->Run();
+		return true;
+	}
+
+	void channel_t::_write(const std::vector<char> *buf)
+	{
+		if( buf == nullptr )
+			return;
+
+		client_.async_send(service::const_buffer_t(buf->data(), buf->size()), [this](std::uint32_t)
+		{
+			_write(outbound_.written());
+		}, callback_pool());
+	}
+
+	void channel_t::_on_disconnect()
+	{
+		calls_t calls;
+		{
+			Lock lock(mutex_);
+			if( !connected_ )
+				return;
+
+			connected_ = false;
+			calls.swap(calls_);
+		}
+
+		outbound_.reset();
+
+		for(auto &val : calls)
+		{
+			val.second.controller_->SetFailed("rpc channel disconnected");
+			val.second.done_->Run();
+		}
+	}
+}
+}
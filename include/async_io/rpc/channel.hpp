@@ -0,0 +1,82 @@
+#ifndef __ASYNC_RPC_CHANNEL_HPP
+#define __ASYNC_RPC_CHANNEL_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+#include "rpc_codec.hpp"
+#include "controller.hpp"
+#include "../network.hpp"
+
+
+namespace async { namespace rpc {
+
+	// -------------------------------------------------
+	// class channel_t
+
+	// һϵRpcChannelðcall_idӣд󲻵ȴӦ
+	// ͬһϿδɵĵãӦ򷵻ء
+	// doneIO̻߳صdoneΪnullptrʱCallMethodýIO߳á
+	// ӶϿʱδɵĵFaileddispatcherֹ֮ͣ
+	class channel_t
+		: public google::protobuf::RpcChannel
+	{
+		typedef std::mutex				Mutex;
+		typedef std::unique_lock<Mutex>	Lock;
+
+		struct call_t
+		{
+			google::protobuf::RpcController *controller_;
+			google::protobuf::Message *response_;
+			google::protobuf::Closure *done_;
+		};
+		typedef std::unordered_map<std::uint64_t, call_t> calls_t;
+
+		network::client client_;
+		network::frame_decoder_t decoder_;
+		std::vector<char> recv_buffer_;
+		outbound_t outbound_;
+
+		Mutex mutex_;
+		calls_t calls_;
+		std::uint64_t next_id_;
+		bool connected_;
+
+	public:
+		explicit channel_t(service::io_dispatcher_t &io, std::uint32_t recv_buffer_size = 64 * 1024);
+		virtual ~channel_t();
+
+	private:
+		channel_t(const channel_t &);
+		channel_t &operator=(const channel_t &);
+
+	public:
+		bool start(const std::string &ip, std::uint16_t port);
+		void stop();
+
+		// δɵĵ
+		std::size_t pending();
+
+		virtual void CallMethod(const google::protobuf::MethodDescriptor *method,
+			google::protobuf::RpcController *controller,
+			const google::protobuf::Message *request,
+			google::protobuf::Message *response,
+			google::protobuf::Closure *done);
+
+	private:
+		void _read();
+		void _on_read(std::uint32_t size);
+		bool _dispatch(const service::const_buffer_t &frame);
+		void _write(const std::vector<char> *buf);
+		void _on_disconnect();
+	};
+}
+}
+
+
+
+
+#endif
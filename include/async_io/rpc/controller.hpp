@@ -0,0 +1,100 @@
+#ifndef __ASYNC_RPC_CONTROLLER_HPP
+#define __ASYNC_RPC_CONTROLLER_HPP
+
+#include <string>
+
+#include <google/protobuf/service.h>
+
+
+namespace async { namespace rpc {
+
+	// -------------------------------------------------
+	// class controller_t
+
+	// һεõ״̬ͻɵ÷ֱdoneصɿֱܳdoneص
+	// ֧ȡһдStartCancelֻ
+	class controller_t
+		: public google::protobuf::RpcController
+	{
+		bool failed_;
+		bool canceled_;
+		std::string error_;
+		google::protobuf::Closure *cancel_callback_;
+
+	public:
+		controller_t()
+			: failed_(false)
+			, canceled_(false)
+			, cancel_callback_(nullptr)
+		{}
+		~controller_t()
+		{
+			finish();
+		}
+
+	private:
+		controller_t(const controller_t &);
+		controller_t &operator=(const controller_t &);
+
+	public:
+		virtual void Reset()
+		{
+			finish();
+
+			failed_ = false;
+			canceled_ = false;
+			error_.clear();
+		}
+
+		virtual bool Failed() const
+		{
+			return failed_;
+		}
+
+		virtual std::string ErrorText() const
+		{
+			return error_;
+		}
+
+		virtual void StartCancel()
+		{
+			canceled_ = true;
+			finish();
+		}
+
+		virtual void SetFailed(const std::string &reason)
+		{
+			failed_ = true;
+			error_ = reason;
+		}
+
+		virtual bool IsCanceled() const
+		{
+			return canceled_;
+		}
+
+		// protobufԼcallbackǡõһΣýʱûȡҲ
+		virtual void NotifyOnCancel(google::protobuf::Closure *callback)
+		{
+			cancel_callback_ = callback;
+			if( canceled_ )
+				finish();
+		}
+
+		// ýdone֮
+		void finish()
+		{
+			google::protobuf::Closure *callback = cancel_callback_;
+			cancel_callback_ = nullptr;
+
+			if( callback != nullptr )
+				callback->Run();
+		}
+	};
+}
+}
+
+
+
+
+#endif
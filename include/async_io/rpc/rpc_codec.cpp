@@ -0,0 +1,156 @@
+#include "rpc_codec.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#ifdef max
+#undef max
+#endif
+
+
+namespace async { namespace rpc {
+
+	namespace {
+
+		const std::size_t PREFIX_SIZE = 4;
+		const std::size_t MIN_CHUNK = 256;
+	}
+
+	std::uint32_t service_id(const std::string &full_name)
+	{
+		std::uint32_t hash = 2166136261U;
+		for(auto c : full_name)
+		{
+			hash ^= static_cast<std::uint8_t>(c);
+			hash *= 16777619U;
+		}
+
+		return hash;
+	}
+
+
+	output_stream_t::output_stream_t(std::vector<char> &buffer)
+		: buffer_(buffer)
+		, start_(buffer.size())
+	{
+	}
+
+	bool output_stream_t::Next(void **data, int *size)
+	{
+		// resize㽻ֽڣÿֻд൱һ飬Ϣȳȣ
+		// ʣòBackUp˻
+		const std::size_t used = buffer_.size();
+		const std::size_t chunk = std::max(used - start_, MIN_CHUNK);
+		if( used + chunk > buffer_.capacity() )
+			buffer_.reserve(std::max(buffer_.capacity() * 2, used + chunk));
+
+		buffer_.resize(used + chunk);
+
+		*data = &buffer_[used];
+		*size = static_cast<int>(chunk);
+		return true;
+	}
+
+	void output_stream_t::BackUp(int count)
+	{
+		assert(static_cast<std::size_t>(count) <= buffer_.size() - start_);
+		buffer_.resize(buffer_.size() - count);
+	}
+
+	google::protobuf::int64 output_stream_t::ByteCount() const
+	{
+		return static_cast<google::protobuf::int64>(buffer_.size() - start_);
+	}
+
+
+	outbound_t::outbound_t()
+		: writing_(false)
+	{
+	}
+
+	const std::vector<char> *outbound_t::append(const rpc_header_t &header, const google::protobuf::MessageLite &msg)
+	{
+		Lock lock(mutex_);
+
+		const std::size_t start = _begin_frame(header);
+		{
+			output_stream_t stream(pending_);
+			if( !msg.SerializeToZeroCopyStream(&stream) )
+			{
+				pending_.resize(start);
+				throw service::network_exception("rpc message serialize failed: " + msg.InitializationErrorString());
+			}
+		}
+		_end_frame(start);
+
+		return _kick();
+	}
+
+	const std::vector<char> *outbound_t::append_error(const rpc_header_t &header, const std::string &error)
+	{
+		Lock lock(mutex_);
+
+		const std::size_t start = _begin_frame(header);
+		pending_.insert(pending_.end(), error.begin(), error.end());
+		_end_frame(start);
+
+		return _kick();
+	}
+
+	const std::vector<char> *outbound_t::written()
+	{
+		Lock lock(mutex_);
+
+		sending_.clear();
+		writing_ = false;
+
+		return _kick();
+	}
+
+	void outbound_t::reset()
+	{
+		Lock lock(mutex_);
+
+		pending_.clear();
+		sending_.clear();
+		writing_ = false;
+	}
+
+	std::size_t outbound_t::_begin_frame(const rpc_header_t &header)
+	{
+		// Ԥǰ׺лɺ
+		const std::size_t start = pending_.size();
+		pending_.resize(start + PREFIX_SIZE + sizeof(header));
+		std::memcpy(&pending_[start + PREFIX_SIZE], &header, sizeof(header));
+
+		return start;
+	}
+
+	void outbound_t::_end_frame(std::size_t start)
+	{
+		const std::uint64_t len = pending_.size() - start - PREFIX_SIZE;
+		if( len > MAX_MESSAGE_SIZE )
+		{
+			pending_.resize(start);
+			throw service::network_exception("rpc message too large");
+		}
+
+		const network::frame_header_t prefix = network::make_frame_header(rpc_frame_format(), len);
+		assert(prefix.size_ == PREFIX_SIZE);
+		std::memcpy(&pending_[start], prefix.data_, PREFIX_SIZE);
+	}
+
+	const std::vector<char> *outbound_t::_kick()
+	{
+		if( writing_ || pending_.empty() )
+			return nullptr;
+
+		pending_.swap(sending_);
+		pending_.clear();
+		writing_ = true;
+
+		return &sending_;
+	}
+}
+}
@@ -0,0 +1,123 @@
+#ifndef __ASYNC_RPC_RPC_CODEC_HPP
+#define __ASYNC_RPC_RPC_CODEC_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+
+// protobufڲ<google/protobuf/...>໥include/third_party·
+#include <google/protobuf/message.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+#include "../network/frame_codec.hpp"
+#include "../service/exception.hpp"
+
+
+namespace async { namespace rpc {
+
+	// -------------------------------------------------
+	// ϸʽ
+
+	// ÿ֡: 4ֽС˳ | rpc_header_t | protobufϢ(ERRORʱΪı)
+	enum message_type_t
+	{
+		RPC_REQUEST		= 1,
+		RPC_RESPONSE	= 2,
+		RPC_ERROR		= 3
+	};
+
+#pragma pack(push, 1)
+	struct rpc_header_t
+	{
+		std::uint8_t type_;
+		std::uint8_t reserved_;
+		std::uint16_t method_;		// MethodDescriptor::index()
+		std::uint32_t service_;		// service_id(ServiceDescriptor::full_name())
+		std::uint64_t call_id_;		// ͬһΨһӦƥ䣬Ҫ򷵻
+	};
+#pragma pack(pop)
+
+	static_assert(sizeof(rpc_header_t) == 16, "rpc header size");
+
+	const std::uint32_t MAX_MESSAGE_SIZE = 64 * 1024 * 1024;
+
+	inline network::frame_format_t rpc_frame_format()
+	{
+		return network::frame_format_t(4, false, MAX_MESSAGE_SIZE);
+	}
+
+	// FNV-1aɢ
+	std::uint32_t service_id(const std::string &full_name);
+
+
+	// -------------------------------------------------
+	// class output_stream_t
+
+	// ׷ӵvectorβZeroCopyOutputStreamϢֱлͻʱstring
+	class output_stream_t
+		: public google::protobuf::io::ZeroCopyOutputStream
+	{
+		std::vector<char> &buffer_;
+		const std::size_t start_;
+
+	public:
+		explicit output_stream_t(std::vector<char> &buffer);
+
+	private:
+		output_stream_t(const output_stream_t &);
+		output_stream_t &operator=(const output_stream_t &);
+
+	public:
+		virtual bool Next(void **data, int *size);
+		virtual void BackUp(int count);
+		virtual google::protobuf::int64 ByteCount() const;
+	};
+
+
+	// -------------------------------------------------
+	// class outbound_t
+
+	// ӵķͶС̰߳֡pending_ͬһʱһдڽУ
+	// дɺڼۻ֡sending_һдˮϵĵȻϲһη͡
+	// 渴ãȶٷڴ档
+	// append/writtenҪдĻnullptrʾдڽлû
+	class outbound_t
+	{
+		typedef std::mutex				Mutex;
+		typedef std::unique_lock<Mutex>	Lock;
+
+		Mutex mutex_;
+		std::vector<char> pending_;
+		std::vector<char> sending_;
+		bool writing_;
+
+	public:
+		outbound_t();
+
+	private:
+		outbound_t(const outbound_t &);
+		outbound_t &operator=(const outbound_t &);
+
+	public:
+		const std::vector<char> *append(const rpc_header_t &header, const google::protobuf::MessageLite &msg);
+		const std::vector<char> *append_error(const rpc_header_t &header, const std::string &error);
+
+		// дɺ
+		const std::vector<char> *written();
+
+		// ӶϿδ͵
+		void reset();
+
+	private:
+		std::size_t _begin_frame(const rpc_header_t &header);
+		void _end_frame(std::size_t start);
+		const std::vector<char> *_kick();
+	};
+}
+}
+
+
+
+
+#endif
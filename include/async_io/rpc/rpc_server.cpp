@@ -0,0 +1,208 @@
+#include "rpc_server.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+
+#include "../../memory_pool/sgi_memory_pool.hpp"
+
+
+namespace async { namespace rpc {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+	}
+
+	// δɵĶص͵ùͬУỰϿҵöͷ
+	struct server_t::connection_t
+		: std::enable_shared_from_this<connection_t>
+	{
+		server_t &server_;
+		network::session_ptr session_;
+		std::vector<char> recv_buffer_;
+		outbound_t outbound_;
+
+		connection_t(server_t &server, const network::session_ptr &session)
+			: server_(server)
+			, session_(session)
+			, recv_buffer_(server.recv_buffer_size_)
+		{}
+
+		void read()
+		{
+			auto this_val = shared_from_this();
+
+			service::mutable_buffer_t buf(recv_buffer_.data(), recv_buffer_.size());
+			session_->async_read_frames(buf, [this_val](const network::session_ptr &session, const network::frame_decoder_t::batch_t &frames)
+			{
+				for(auto &frame : frames)
+				{
+					if( !this_val->dispatch(frame) )
+					{
+						session->disconnect();
+						return;
+					}
+				}
+
+				this_val->read();
+			}, callback_pool());
+		}
+
+		bool dispatch(const service::const_buffer_t &frame);
+		void reply(const rpc_header_t &header, const controller_t &controller, const google::protobuf::Message &response);
+
+		void write(const std::vector<char> *buf)
+		{
+			if( buf == nullptr )
+				return;
+
+			auto this_val = shared_from_this();
+			session_->async_write(service::const_buffer_t(buf->data(), buf->size()), [this_val](const network::session_ptr &, std::uint32_t)
+			{
+				this_val->write(this_val->outbound_.written());
+			}, callback_pool());
+		}
+	};
+
+	// һεãdoneصʱͷ
+	struct server_t::call_t
+	{
+		std::shared_ptr<connection_t> connection_;
+		rpc_header_t header_;
+		controller_t controller_;
+		std::unique_ptr<google::protobuf::Message> request_;
+		std::unique_ptr<google::protobuf::Message> response_;
+	};
+
+
+	bool server_t::connection_t::dispatch(const service::const_buffer_t &frame)
+	{
+		if( frame.size() < sizeof(rpc_header_t) )
+			return false;
+
+		rpc_header_t header;
+		std::memcpy(&header, frame.data(), sizeof(header));
+		if( header.type_ != RPC_REQUEST )
+			return false;
+
+		header.type_ = RPC_ERROR;
+
+		google::protobuf::Service *impl = server_._find(header.service_);
+		if( impl == nullptr )
+		{
+			write(outbound_.append_error(header, "rpc unknown service"));
+			return true;
+		}
+
+		const google::protobuf::ServiceDescriptor *descriptor = impl->GetDescriptor();
+		if( header.method_ >= descriptor->method_count() )
+		{
+			write(outbound_.append_error(header, "rpc unknown method"));
+			return true;
+		}
+
+		const google::protobuf::MethodDescriptor *method = descriptor->method(header.method_);
+
+		std::unique_ptr<call_t> call(new call_t);
+		call->connection_ = shared_from_this();
+		call->header_ = header;
+		call->request_.reset(impl->GetRequestPrototype(method).New());
+		call->response_.reset(impl->GetResponsePrototype(method).New());
+
+		const char *body = frame.data() + sizeof(header);
+		const int len = static_cast<int>(frame.size() - sizeof(header));
+		if( !call->request_->ParseFromArray(body, len) )
+		{
+			write(outbound_.append_error(header, "rpc request parse failed"));
+			return true;
+		}
+
+		// ֻڱλصЧѽrequest_У첽
+		call_t *val = call.release();
+		impl->CallMethod(method, &val->controller_, val->request_.get(), val->response_.get(),
+			google::protobuf::NewCallback(&server_t::_on_done, val));
+
+		return true;
+	}
+
+	void server_t::connection_t::reply(const rpc_header_t &header, const controller_t &controller, const google::protobuf::Message &response)
+	{
+		rpc_header_t val = header;
+
+		const std::vector<char> *buf = nullptr;
+		if( controller.Failed() )
+		{
+			val.type_ = RPC_ERROR;
+			buf = outbound_.append_error(val, controller.ErrorText());
+		}
+		else
+		{
+			try
+			{
+				val.type_ = RPC_RESPONSE;
+				buf = outbound_.append(val, response);
+			}
+			catch(::exception::exception_base &e)
+			{
+				e.dump();
+
+				val.type_ = RPC_ERROR;
+				buf = outbound_.append_error(val, e.what());
+			}
+		}
+
+		write(buf);
+	}
+
+
+	server_t::server_t(std::uint32_t recv_buffer_size)
+		: recv_buffer_size_(recv_buffer_size)
+	{
+	}
+
+	void server_t::add_service(google::protobuf::Service *val)
+	{
+		const std::string &name = val->GetDescriptor()->full_name();
+		if( !services_.insert(std::make_pair(service_id(name), val)).second )
+			throw service::network_exception("rpc service id conflict: " + name);
+	}
+
+	void server_t::attach(network::server &svr)
+	{
+		svr.register_accept_handler([this](const network::session_ptr &session, const std::string &)
+		{
+			serve(session);
+			return true;
+		});
+	}
+
+	void server_t::serve(const network::session_ptr &session)
+	{
+		session->set_frame_format(rpc_frame_format());
+
+		auto connection = std::make_shared<connection_t>(*this, session);
+		connection->read();
+	}
+
+	google::protobuf::Service *server_t::_find(std::uint32_t id) const
+	{
+		auto iter = services_.find(id);
+		return iter == services_.end() ? nullptr : iter->second;
+	}
+
+	void server_t::_on_done(call_t *call)
+	{
+		std::unique_ptr<call_t> val(call);
+
+		val->connection_->reply(val->header_, val->controller_, *val->response_);
+		val->controller_.finish();
+	}
+}
+}
@@ -0,0 +1,57 @@
+#ifndef __ASYNC_RPC_RPC_SERVER_HPP
+#define __ASYNC_RPC_RPC_SERVER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "rpc_codec.hpp"
+#include "controller.hpp"
+#include "../network.hpp"
+
+
+namespace async { namespace rpc {
+
+	// -------------------------------------------------
+	// class server_t
+
+	// network::serverĻỰprotobufÿCallMethod
+	// ǰһɣ̵߳doneӦ˳дء
+	// serve֮ǰעᣬɵ÷
+	class server_t
+	{
+		struct connection_t;
+		struct call_t;
+
+		typedef std::unordered_map<std::uint32_t, google::protobuf::Service *> services_t;
+		services_t services_;
+		std::uint32_t recv_buffer_size_;
+
+	public:
+		explicit server_t(std::uint32_t recv_buffer_size = 64 * 1024);
+
+	private:
+		server_t(const server_t &);
+		server_t &operator=(const server_t &);
+
+	public:
+		void add_service(google::protobuf::Service *val);
+
+		// ӹsvracceptص»ỰΪrpc
+		void attach(network::server &svr);
+
+		// ڻỰϿʼrpcҲԼacceptصе
+		void serve(const network::session_ptr &session);
+
+	private:
+		google::protobuf::Service *_find(std::uint32_t id) const;
+
+		static void _on_done(call_t *call);
+	};
+}
+}
+
+
+
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef __ASYNC_SERVICE_CLOCK_HPP
+#define __ASYNC_SERVICE_CLOCK_HPP
+
+#include <cstdint>
+
+#include "../basic.hpp"
+
+
+namespace async { namespace service {
+
+	// ʱӣ΢룬QueryPerformanceCounterdispatcherĽֹʱ붨ʱʹøʱ
+	inline std::uint64_t monotonic_us()
+	{
+		LARGE_INTEGER freq = {0};
+		LARGE_INTEGER counter = {0};
+		::QueryPerformanceFrequency(&freq);
+		::QueryPerformanceCounter(&counter);
+
+		// μ㣬counter * 1000000
+		const std::uint64_t val = counter.QuadPart;
+		const std::uint64_t f = freq.QuadPart;
+		return val / f * 1000000 + val % f * 1000000 / f;
+	}
+
+	namespace detail
+	{
+		// IO̱֪߳ͨĲʱ䣬0Ϊδdispatcher.cpp
+		extern __declspec(thread) std::uint64_t batch_now_us;
+	}
+
+	// dispatcherÿ֪ͨغһ
+	inline void sample_now()
+	{
+		detail::batch_now_us = monotonic_us();
+	}
+
+	inline void clear_now()
+	{
+		detail::batch_now_us = 0;
+	}
+
+	// ʱӣmonotonic_usͬһʱ׼IO߳ϷرʼʱĲٶ
+	// ֱ߳Ӷȡͬһ߳ڵͬIO̵߳ĲһĴʱ䣬
+	// ̱߳Ƚʱʱֹ
+	inline std::uint64_t now_us()
+	{
+		const std::uint64_t val = detail::batch_now_us;
+		return val != 0 ? val : monotonic_us();
+	}
+
+	inline std::uint64_t now_ms()
+	{
+		return now_us() / 1000;
+	}
+
+}
+}
+
+
+#endif
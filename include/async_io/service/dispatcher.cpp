@@ -4,13 +4,26 @@
 #include <thread>
 #include <type_traits>
 #include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <iterator>
 
 #include "iocp.hpp"
 #include "exception.hpp"
+#include "clock.hpp"
+
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
 
 
 namespace async { namespace service {
 
+	namespace detail
+	{
+		__declspec(thread) std::uint64_t batch_now_us = 0;
+	}
+
 	size_t get_fit_thread_num(size_t perCPU)
 	{
 		return perCPU * std::thread::hardware_concurrency();
@@ -41,11 +54,45 @@ namespace async { namespace service {
 		// Ϣص
 		error_msg_handler_t error_handler_;
 
+		// ڻصֹʱصʱΪmonotonic_us
+		struct tick_t
+		{
+			std::uint32_t id_;
+			std::uint64_t period_;				// ֹʱصΪ0
+			std::uint64_t due_;
+			bool removed_;
+			tick_handler_t handler_;
+			deadline_handler_t deadline_;
+		};
+
+		std::mutex tick_mutex_;
+		std::vector<tick_t> ticks_;
+		std::vector<tick_t> new_ticks_;			// صִڼ
+		std::uint32_t tick_id_;
+		std::atomic<DWORD> tick_thread_;		// ִлص߳
+
+		// Ľֹʱ䣬ɶ˿ڵĵȴʱ
+		std::atomic<std::uint64_t> next_due_;
+		// һֻصʼwake_atǰĽֹʱ䣬ֵֹĽ
+		std::atomic<std::uint64_t> requested_due_;
+
+		// æȾ
+		std::atomic<std::uint32_t> spin_us_;
+		std::atomic<bool> spinner_;				// ߳æ
+		std::atomic<bool> high_resolution_;		// ѵtimeBeginPeriod
+
 
 		impl(size_t numThreads, const error_msg_handler_t &error_handler, const init_handler_t &init, const uninit_handler_t &unint)
 			: error_handler_(error_handler)
 			, uninit_handler_(unint)
 			, init_handler_(init)
+			, tick_id_(0)
+			, tick_thread_(0)
+			, next_due_(DEADLINE_NONE)
+			, requested_due_(DEADLINE_NONE)
+			, spin_us_(0)
+			, spinner_(false)
+			, high_resolution_(false)
 		{
 			if( !iocp_.create(numThreads) )
 				throw win32_exception_t("iocp_.Create()");
@@ -69,6 +116,9 @@ namespace async { namespace service {
 			{		
 				stop();
 				iocp_.close();
+
+				if( high_resolution_ )
+					::timeEndPeriod(1);
 			}
 			catch(...)
 			{
@@ -109,6 +159,221 @@ namespace async { namespace service {
 			return true;
 		}
 
+		std::uint32_t add_tick_handler(std::uint32_t period_ms, const tick_handler_t &handler)
+		{
+			assert(handler != nullptr);
+
+			const std::uint64_t period = (period_ms == 0 ? 1 : period_ms) * 1000ULL;
+			tick_t val = { 0, period, monotonic_us() + period, false, handler, nullptr };
+
+			return _add_tick(std::move(val));
+		}
+
+		std::uint32_t add_deadline_handler(const deadline_handler_t &handler)
+		{
+			assert(handler != nullptr);
+
+			// һΣhandlerصһֹʱ
+			tick_t val = { 0, 0, monotonic_us(), false, nullptr, handler };
+
+			return _add_tick(std::move(val));
+		}
+
+		std::uint32_t _add_tick(tick_t &&val)
+		{
+			const std::uint64_t due = val.due_;
+
+			// ڻصעᣬ߳ѳֺٺϲ
+			if( tick_thread_ == ::GetCurrentThreadId() )
+			{
+				val.id_ = ++tick_id_;
+				new_ticks_.push_back(std::move(val));
+				wake_at(due);
+				return tick_id_;
+			}
+
+			std::uint32_t id = 0;
+			{
+				std::lock_guard<std::mutex> lock(tick_mutex_);
+
+				val.id_ = id = ++tick_id_;
+				ticks_.push_back(std::move(val));
+			}
+
+			// һIỌ߳ʹ䰴µĽֹʱȴ
+			wake_at(due);
+
+			return id;
+		}
+
+		void wake_at(std::uint64_t due_us)
+		{
+			_lower(requested_due_, due_us);
+
+			if( _lower(next_due_, due_us) )
+				_wake();
+		}
+
+		void set_timer_precision(std::uint32_t spin_us)
+		{
+			// ڻصеãtick_mutex_
+			spin_us_ = spin_us;
+			if( high_resolution_.exchange(spin_us != 0) != (spin_us != 0) )
+			{
+				if( spin_us != 0 )
+					::timeBeginPeriod(1);
+				else
+					::timeEndPeriod(1);
+			}
+		}
+
+		// valdueǷ񽵵
+		static bool _lower(std::atomic<std::uint64_t> &val, std::uint64_t due)
+		{
+			std::uint64_t cur = val.load();
+			while( due < cur )
+			{
+				if( val.compare_exchange_weak(cur, due) )
+					return true;
+			}
+
+			return false;
+		}
+
+		// յֻ֪ͨΪһ߳¼ȴʱ䣬ڴ
+		void _wake()
+		{
+			if( !iocp_.post_status(0, 0, nullptr) )
+				throw win32_exception_t("iocp_.PostStatus");
+		}
+
+		void remove_tick_handler(std::uint32_t id)
+		{
+			auto pred = [id](const tick_t &val)
+			{
+				return val.id_ == id;
+			};
+
+			// ڻصעֻǣֽɾ
+			if( tick_thread_ == ::GetCurrentThreadId() )
+			{
+				auto iter = std::find_if(ticks_.begin(), ticks_.end(), pred);
+				if( iter != ticks_.end() )
+					iter->removed_ = true;
+
+				new_ticks_.erase(std::remove_if(new_ticks_.begin(), new_ticks_.end(), pred), new_ticks_.end());
+				return;
+			}
+
+			// ִеĻصȴ
+			std::lock_guard<std::mutex> lock(tick_mutex_);
+
+			ticks_.erase(std::remove_if(ticks_.begin(), ticks_.end(), pred), ticks_.end());
+			_update_ticks();
+		}
+
+		// tick_mutex_ʱ
+		void _update_ticks()
+		{
+			std::uint64_t next_due = DEADLINE_NONE;
+			std::for_each(ticks_.begin(), ticks_.end(), [&](const tick_t &val)
+			{
+				next_due = std::min(next_due, val.due_);
+			});
+
+			// ڼwake_atǰĽֹʱ䲻ܱǣдضwake_atд˳෴
+			next_due_ = next_due;
+			_lower(next_due_, requested_due_.load());
+		}
+
+		void _run_ticks()
+		{
+			if( now_us() < next_due_ )
+				return;
+
+			// ͬһʱֻһִ߳
+			std::unique_lock<std::mutex> lock(tick_mutex_, std::try_to_lock);
+			if( !lock.owns_lock() )
+				return;
+
+			tick_thread_ = ::GetCurrentThreadId();
+			requested_due_ = DEADLINE_NONE;
+
+			// صпעµĻصʹõ
+			const std::uint64_t now = now_us();
+			for( std::size_t i = 0; i != ticks_.size(); ++i )
+			{
+				tick_t &val = ticks_[i];
+
+				// ֹʱصܱwake_atǰÿֶãж
+				if( val.removed_ || (val.period_ != 0 && now < val.due_) )
+					continue;
+
+				try
+				{
+					if( val.period_ != 0 )
+					{
+						val.due_ = now + val.period_;
+						val.handler_();
+					}
+					else
+						val.due_ = val.deadline_(now);
+				}
+				catch(const exception::exception_base &e)
+				{
+					e.dump();
+					error_handler_(e.what());
+				}
+				catch(const std::exception &e)
+				{
+					error_handler_(e.what());
+				}
+			}
+
+			tick_thread_ = 0;
+
+			ticks_.erase(std::remove_if(ticks_.begin(), ticks_.end(), [](const tick_t &val)
+			{
+				return val.removed_;
+			}), ticks_.end());
+			std::move(new_ticks_.begin(), new_ticks_.end(), std::back_inserter(ticks_));
+			new_ticks_.clear();
+
+			_update_ticks();
+		}
+
+		// Ľֹʱȴʱæȴʱһ߳0ʱѯ
+		DWORD _wait_ms(bool &spinning)
+		{
+			const std::uint64_t due = next_due_;
+			const std::uint64_t now = due == DEADLINE_NONE ? 0 : monotonic_us();
+			const std::uint64_t remain = due > now ? due - now : 0;
+
+			if( due != DEADLINE_NONE && remain <= spin_us_ )
+			{
+				if( !spinning )
+				{
+					bool expected = false;
+					spinning = spinner_.compare_exchange_strong(expected, true);
+				}
+
+				if( spinning )
+					return 0;
+			}
+			else if( spinning )
+			{
+				spinner_ = false;
+				spinning = false;
+			}
+
+			if( due == DEADLINE_NONE )
+				return INFINITE;
+
+			// ȡʱڽֹʱ
+			const std::uint64_t ms = (remain + 999) / 1000;
+			return ms >= INFINITE ? INFINITE - 1 : static_cast<DWORD>(ms);
+		}
+
 		void _thread_io()
 		{
 			if( init_handler_ != nullptr )
@@ -116,23 +381,37 @@ namespace async { namespace service {
 
 			OVERLAPPED_ENTRY entrys[64] = {0};
 			DWORD ret_number = 0;
+			bool spinning = false;
 			while(true)
 			{
 				::SetLastError(0);
-				bool suc = iocp_.get_status_ex(entrys, ret_number);
+				bool suc = iocp_.get_status_ex(entrys, ret_number, _wait_ms(spinning));
 				auto err = ::GetLastError();
 
 				if( err == WAIT_IO_COMPLETION )
 					break;
 
+				// صһβ
+				sample_now();
+
+				// ʱ
+				if( !suc )
+					ret_number = 0;
+
 				try
 				{
 					for(auto i = 0; i != ret_number; ++i)
 					{
+						// wake_atĿ֪ͨ
+						if( entrys[i].lpOverlapped == nullptr )
+							continue;
+
 						call(entrys[i].lpOverlapped, 
 							entrys[i].dwNumberOfBytesTransferred,
 							std::make_error_code((std::errc)entrys[i].Internal));
 					}
+
+					_run_ticks();
 				}
 				catch(const exception::exception_base &e)
 				{
@@ -154,6 +433,11 @@ namespace async { namespace service {
 				}
 			}
 
+			if( spinning )
+				spinner_ = false;
+
+			clear_now();
+
 			if( uninit_handler_ != nullptr )
 				uninit_handler_();
 
@@ -182,6 +466,31 @@ namespace async { namespace service {
 		impl_->stop();
 	}
 
+	std::uint32_t io_dispatcher_t::add_tick_handler(std::uint32_t period_ms, const tick_handler_t &handler)
+	{
+		return impl_->add_tick_handler(period_ms, handler);
+	}
+
+	void io_dispatcher_t::remove_tick_handler(std::uint32_t id)
+	{
+		impl_->remove_tick_handler(id);
+	}
+
+	std::uint32_t io_dispatcher_t::add_deadline_handler(const deadline_handler_t &handler)
+	{
+		return impl_->add_deadline_handler(handler);
+	}
+
+	void io_dispatcher_t::wake_at(std::uint64_t due_us)
+	{
+		impl_->wake_at(due_us);
+	}
+
+	void io_dispatcher_t::set_timer_precision(std::uint32_t spin_us)
+	{
+		impl_->set_timer_precision(spin_us);
+	}
+
 	bool io_dispatcher_t::_post_impl(const async_callback_base_ptr &val)
 	{
 		return impl_->post_impl(val);
@@ -24,6 +24,10 @@ namespace async { namespace service {
 			typedef std::function<void()>			init_handler_t;
 			typedef std::function<void()>			uninit_handler_t;
 			typedef std::function<void(const std::string &)> error_msg_handler_t;
+			typedef std::function<void()>			tick_handler_t;
+			typedef std::function<std::uint64_t(std::uint64_t now_us)>	deadline_handler_t;
+
+			static const std::uint64_t DEADLINE_NONE = ~0ULL;
 
 		private:
 			struct impl;
@@ -46,6 +50,20 @@ namespace async { namespace service {
 			// ֹͣ
 			void stop();
 
+			// עڻصĳһIOִ֪֮߳ͨУɶ˿ڵĵȴʱ䲻С
+			std::uint32_t add_tick_handler(std::uint32_t period_ms, const tick_handler_t &handler);
+			// غصٱִУڻصڵãҲעֹʱص
+			void remove_tick_handler(std::uint32_t id);
+
+			// עֹʱصڻصͬһִСhandlerһԽֹʱ(΢룬monotonic_us)
+			// ûʱDEADLINE_NONEĽֹʱ伴ɶ˿ڵĵȴʱֹʱ䵽ʱҲܱǰ
+			std::uint32_t add_deadline_handler(const deadline_handler_t &handler);
+			// ֹʱǰʱã̡߳ҪʱһIO̰߳µĳʱȴ
+			void wake_at(std::uint64_t due_us);
+			// Ľֹʱspin_usʱһIO߳0ʱѯɶ˿ֱڣõǺ뾫ȣ
+			// 0Ϊر(Ĭ)ڼϵͳʱӾߵ1ms
+			void set_timer_precision(std::uint32_t spin_us);
+
 		private:
 			bool _post_impl(const async_callback_base_ptr &);
 		};
@@ -0,0 +1,256 @@
+#ifndef __ASYNC_TIMER_HIERARCHICAL_WHEEL_HPP
+#define __ASYNC_TIMER_HIERARCHICAL_WHEEL_HPP
+
+#include <cstdint>
+#include <cassert>
+#include <utility>
+
+#include "timing_wheel.hpp"
+
+
+namespace async { namespace timer {
+
+	// ---------------------------------------
+	// class hierarchical_wheel_t
+
+	// ֲʱ֣0256ۣÿ1tick464ۣÿۿΪһһȦ2^32tick
+	// ڵ㸴wheel_node_t(ֻʹָtick_handler_ʹ)롢ժO(1)Ҳڴ棻
+	// 0תһȦʱһһɢе²(cascade)̯ÿڵΪO()
+	// 2^32tickĽڵȹ߲㣬cascadeʱʵtick¼λá
+	// ʹ֤߱з
+	class hierarchical_wheel_t
+	{
+	public:
+		static const std::uint32_t ROOT_BITS	= 8;
+		static const std::uint32_t LEVEL_BITS	= 6;
+		static const std::uint32_t LEVELS		= 4;
+		static const std::uint32_t ROOT_SIZE	= 1 << ROOT_BITS;
+		static const std::uint32_t LEVEL_SIZE	= 1 << LEVEL_BITS;
+
+		static const std::uint64_t MAX_SPAN		= (1ULL << (ROOT_BITS + LEVELS * LEVEL_BITS)) - 1;
+
+	private:
+		wheel_node_t root_[ROOT_SIZE];
+		wheel_node_t levels_[LEVELS][LEVEL_SIZE];
+
+		// һtickѴnext_ - 1
+		std::uint64_t next_;
+		std::uint32_t size_;
+
+	public:
+		explicit hierarchical_wheel_t(std::uint64_t now = 0)
+			: next_(now + 1)
+			, size_(0)
+		{
+			for(std::uint32_t i = 0; i != ROOT_SIZE; ++i)
+				_init(root_[i]);
+
+			for(std::uint32_t i = 0; i != LEVELS; ++i)
+				for(std::uint32_t j = 0; j != LEVEL_SIZE; ++j)
+					_init(levels_[i][j]);
+		}
+
+		~hierarchical_wheel_t()
+		{
+			// ʹǰժнڵ
+			assert(size_ == 0);
+		}
+
+	private:
+		hierarchical_wheel_t(const hierarchical_wheel_t &);
+		hierarchical_wheel_t &operator=(const hierarchical_wheel_t &);
+
+	public:
+		std::uint64_t now() const
+		{
+			return next_ - 1;
+		}
+
+		std::uint32_t size() const
+		{
+			return size_;
+		}
+
+		// Ҫadvancetickڼȴʱ䣻Ϊʱ~0
+		// 0ȡķǿղۣϲȡһΰƷǿղ۵tick֮advanceκζ
+		std::uint64_t next_expire() const
+		{
+			if( size_ == 0 )
+				return ~0ULL;
+
+			std::uint64_t expire = ~0ULL;
+			for(std::uint64_t tick = next_; tick != next_ + ROOT_SIZE; ++tick)
+			{
+				const wheel_node_t &head = root_[tick & (ROOT_SIZE - 1)];
+				if( head.next_ != &head )
+				{
+					expire = tick;
+					break;
+				}
+			}
+
+			// leveltickΪ2^bitsʱ
+			for(std::uint32_t level = 0; level != LEVELS; ++level)
+			{
+				const std::uint32_t bits = ROOT_BITS + level * LEVEL_BITS;
+				std::uint64_t tick = ((next_ + (1ULL << bits) - 1) >> bits) << bits;
+
+				for(std::uint32_t i = 0; i != LEVEL_SIZE && tick < expire; ++i, tick += 1ULL << bits)
+				{
+					const wheel_node_t &head = levels_[level][_level_index(tick, level)];
+					if( head.next_ != &head )
+					{
+						expire = tick;
+						break;
+					}
+				}
+			}
+
+			return expire;
+		}
+
+		// ¹ڵ㣬tickΪڵľticknowĽڵһtick
+		void schedule(wheel_node_t &node, std::uint64_t tick)
+		{
+			if( node.is_linked() )
+				node._unlink();
+			else
+				++size_;
+
+			node.tick_ = tick < next_ ? next_ : tick;
+			_insert(node);
+		}
+
+		// ڵڱʱϣδ
+		void cancel(wheel_node_t &node)
+		{
+			if( !node.is_linked() )
+				return;
+
+			node._unlink();
+			--size_;
+		}
+
+		// ƽnowtick˳ÿڽڵhandler(wheel_node_t &)
+		// ǰڵѱժhandlerпԶڵschedule/cancel
+		template < typename HandlerT >
+		void advance(std::uint64_t now, HandlerT &&handler)
+		{
+			while( next_ <= now )
+			{
+				// ֱһжtickⳤʱȴtickת
+				const std::uint64_t expire = next_expire();
+				if( expire > now )
+				{
+					next_ = now + 1;
+					break;
+				}
+				next_ = expire;
+
+				const std::uint32_t index = static_cast<std::uint32_t>(next_ & (ROOT_SIZE - 1));
+
+				// 0תһȦϲӦĲɢ
+				if( index == 0 )
+				{
+					for(std::uint32_t level = 0; level != LEVELS; ++level)
+					{
+						if( _cascade(level) != 0 )
+							break;
+					}
+				}
+
+				const std::uint64_t cur = next_++;
+				_expire(root_[index], cur, handler);
+			}
+		}
+
+	private:
+		static void _init(wheel_node_t &head)
+		{
+			head.prev_ = head.next_ = &head;
+		}
+
+		static std::uint32_t _level_index(std::uint64_t tick, std::uint32_t level)
+		{
+			return static_cast<std::uint32_t>((tick >> (ROOT_BITS + level * LEVEL_BITS)) & (LEVEL_SIZE - 1));
+		}
+
+		void _insert(wheel_node_t &node)
+		{
+			const std::uint64_t span = node.tick_ - next_;
+			if( span < ROOT_SIZE )
+			{
+				node._link_before(root_[node.tick_ & (ROOT_SIZE - 1)]);
+				return;
+			}
+
+			// ΧȰԶ
+			const std::uint64_t tick = span > MAX_SPAN ? next_ + MAX_SPAN : node.tick_;
+			const std::uint64_t distance = tick - next_;
+
+			std::uint32_t level = 0;
+			while( level != LEVELS - 1 && distance >= (1ULL << (ROOT_BITS + (level + 1) * LEVEL_BITS)) )
+				++level;
+
+			node._link_before(levels_[level][_level_index(tick, level)]);
+		}
+
+		std::uint32_t _cascade(std::uint32_t level)
+		{
+			const std::uint32_t index = _level_index(next_, level);
+			wheel_node_t &head = levels_[level][index];
+
+			if( head.next_ != &head )
+			{
+				wheel_node_t pending;
+				_take(head, pending);
+
+				while( pending.next_ != &pending )
+				{
+					wheel_node_t &node = *pending.next_;
+					node._unlink();
+					_insert(node);
+				}
+			}
+
+			return index;
+		}
+
+		template < typename HandlerT >
+		void _expire(wheel_node_t &head, std::uint64_t cur, HandlerT &handler)
+		{
+			if( head.next_ == &head )
+				return;
+
+			// Ȱժ£ص¹Ľڵͬһ
+			wheel_node_t pending;
+			_take(head, pending);
+
+			while( pending.next_ != &pending )
+			{
+				wheel_node_t &node = *pending.next_;
+				node._unlink();
+
+				assert(node.tick_ <= cur);
+				--size_;
+
+				handler(node);
+			}
+		}
+
+		static void _take(wheel_node_t &head, wheel_node_t &pending)
+		{
+			pending.prev_ = head.prev_;
+			pending.next_ = head.next_;
+			pending.prev_->next_ = &pending;
+			pending.next_->prev_ = &pending;
+			_init(head);
+		}
+	};
+}
+}
+
+
+
+
+#endif
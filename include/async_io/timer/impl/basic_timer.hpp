@@ -1,8 +1,11 @@
 #ifndef __TIMER_BASIC_TIMER_HPP
 #define __TIMER_BASIC_TIMER_HPP
 
+#include <cstdint>
+#include <cassert>
 #include <chrono>
 #include <limits>
+#include <utility>
 
 #ifdef min
 #undef min
@@ -21,15 +24,21 @@ namespace async { namespace timer {
 	class basic_timer_t
 	{
 		typedef ServiceT timer_service_t;
+		typedef typename timer_service_t::timer_node_t timer_node_t;
 
 	private:
 		timer_service_t &service_;		// service
-		std::uint32_t id_;
+		timer_node_t node_;				// ʽڵ㣬񲻷ڴ
+		long period_;
+		long due_;
+		bool valid_;
 
 	public:
 		explicit basic_timer_t(timer_service_t &service)
 			: service_(service)
-			, id_(0)
+			, period_(0)
+			, due_(0)
+			, valid_(false)
 		{}
 
 		// ܻصעһTimer
@@ -39,17 +48,19 @@ namespace async { namespace timer {
 					  const std::chrono::milliseconds &delay_time,
 					  HandlerT &&handler)
 			: service_(service)
-			, id_(0)
+			, period_(0)
+			, due_(0)
+			, valid_(false)
 		{
 			assert(duration_time.count() <= std::numeric_limits<long>::max());
-			assert(-(delay_time.count() * 10000) >= std::numeric_limits<long long>::min());
+			assert(delay_time.count() <= std::numeric_limits<long>::max());
 
-			id_ = service_.add_timer(static_cast<long>(duration_time.count()), static_cast<long>(delay_time.count()), std::forward<HandlerT>(handler));
+			_init(static_cast<long>(duration_time.count()), static_cast<long>(delay_time.count()), std::forward<HandlerT>(handler));
 		}
+		// صʱʱ֮ٷʻصĶ
 		~basic_timer_t()
 		{
-			if( id_ != 0 )
-				service_.erase_timer(id_);
+			service_.cancel(node_);
 		}
 
 	private:
@@ -59,41 +70,44 @@ namespace async { namespace timer {
 	public:
 		explicit operator bool() const
 		{
-			return id_ != 0;
+			return valid_;
 		}
-		// ʱ
+		// ʱЧ
 		// period ʱ
 		// delay ӳʱ
 		void set_timer(long period, long delay = 0)
 		{
-			assert(id_ != 0);
-			service_.set_timer(id_, period, delay);
+			assert(valid_);
+
+			period_ = period;
+			due_ = delay;
+			service_.schedule(node_, _clamp(period_), _clamp(due_));
 		}
 
-		// ȡTimer
+		// ȡTimerغصٱִ
 		void cancel()
 		{
-			assert(id_ != 0);
-			service_.erase_timer(id_);
-			id_ = 0;
+			assert(valid_);
+			service_.cancel(node_);
+			valid_ = false;
 		}
 
 		// 첽ȴ
 		void async_wait()
 		{
-			assert(id_ != 0);
-			service_.async_wait(id_);
+			assert(valid_);
+			service_.schedule(node_, _clamp(period_), _clamp(due_));
 		}
 
 		template < typename HandlerT >
 		void async_wait(HandlerT &&handler, const std::chrono::milliseconds& duration_time, const std::chrono::milliseconds &delay_time = std::chrono::milliseconds(0))
 		{
 			assert(duration_time.count() <= std::numeric_limits<long>::max());
-			assert(-(delay_time.count() * 10000) >= std::numeric_limits<long long>::min());
+			assert(delay_time.count() <= std::numeric_limits<long>::max());
 
-			if( id_ == 0 )
+			if( !valid_ )
 			{
-				id_ = service_.add_timer(static_cast<long>(duration_time.count()), 
+				_init(static_cast<long>(duration_time.count()), 
 					static_cast<long>(delay_time.count()), 
 					std::forward<HandlerT>(handler));
 			}
@@ -104,17 +118,34 @@ namespace async { namespace timer {
 		template < typename HandlerT, typename ClockT, typename DurationT >
 		void async_wait(HandlerT && handler, const std::chrono::milliseconds& duration_time, const std::chrono::time_point<ClockT, DurationT>& abs_time)
 		{
-			if( id_ == 0 )
+			if( !valid_ )
 			{
 				std::chrono::milliseconds real_time = std::chrono::duration_cast<std::chrono::milliseconds>(abs_time - ClockT::now());
 				
-				id_ = service_.add_timer(static_cast<long>(duration_time.count()),
+				_init(static_cast<long>(duration_time.count()),
 					static_cast<long>(real_time.count()), 
 					std::forward<HandlerT>(handler));
 			}
 
 			async_wait();
 		}
+
+	private:
+		// δȡʱܸصʱ񲻻ٷʽڵ
+		template < typename HandlerT >
+		void _init(long period, long due, HandlerT &&handler)
+		{
+			period_ = period;
+			due_ = due;
+			node_.handler_ = std::forward<HandlerT>(handler);
+			valid_ = true;
+		}
+
+		// תΪʱʹõ΢
+		static std::uint64_t _clamp(long val)
+		{
+			return val < 0 ? 0 : static_cast<std::uint64_t>(val) * 1000;
+		}
 	};
 }
 }
@@ -0,0 +1,169 @@
+#include "timer_service.hpp"
+
+#include <cassert>
+
+#include "../../basic.hpp"
+#include "../../service/clock.hpp"
+#include "../../../exception/exception_base.hpp"
+
+
+namespace async { namespace timer {
+
+	timer_service_t::timer_service_t(service_type &io, std::uint32_t tick_us)
+		: io_(io)
+		, tick_us_(tick_us == 0 ? 1 : tick_us)
+		, start_us_(service::monotonic_us())
+		, tick_id_(0)
+		, wheel_(0)
+		, current_(nullptr)
+		, current_thread_(0)
+		, due_us_(service_type::DEADLINE_NONE)
+	{
+		ready_.prev_ = ready_.next_ = &ready_;
+
+		tick_id_ = io_.add_deadline_handler([this](std::uint64_t now_us)
+		{
+			return _on_deadline(now_us);
+		});
+	}
+
+	timer_service_t::~timer_service_t()
+	{
+		stop();
+
+		// ʱڷ
+		assert(ready_.next_ == &ready_);
+	}
+
+	void timer_service_t::stop()
+	{
+		if( tick_id_ == 0 )
+			return;
+
+		io_.remove_tick_handler(tick_id_);
+		tick_id_ = 0;
+	}
+
+	std::uint32_t timer_service_t::size()
+	{
+		Lock lock(mutex_);
+		return wheel_.size();
+	}
+
+	void timer_service_t::schedule(timer_node_t &node, std::uint64_t period, std::uint64_t delay)
+	{
+		// ȡָ֤ʱ䵽
+		const std::uint64_t elapsed = service::monotonic_us() - start_us_;
+		const std::uint64_t expire = (elapsed + delay + tick_us_ - 1) / tick_us_;
+
+		std::uint64_t due = 0;
+		{
+			Lock lock(mutex_);
+
+			if( node.ready_ )
+			{
+				node._unlink();
+				node.ready_ = false;
+			}
+
+			node.period_ = period == 0 ? 0 : (period + tick_us_ - 1) / tick_us_;
+			wheel_.schedule(node, expire);
+
+			due = _due_us(node.tick_);
+			if( due >= due_us_ )
+				return;
+
+			due_us_ = due;
+		}
+
+		// dispatcherǰĽֹʱ䣬֪ͨwake_atܻIO߳
+		io_.wake_at(due);
+	}
+
+	void timer_service_t::cancel(timer_node_t &node)
+	{
+		Lock lock(mutex_);
+
+		if( node.ready_ )
+		{
+			node._unlink();
+			node.ready_ = false;
+		}
+		else
+			wheel_.cancel(node);
+
+		// ִ߳иýڵĻصȴ䷵
+		if( current_thread_ != ::GetCurrentThreadId() )
+		{
+			fired_.wait(lock, [this, &node]()
+			{
+				return current_ != &node;
+			});
+		}
+	}
+
+	std::uint64_t timer_service_t::_on_deadline(std::uint64_t now_us)
+	{
+		const std::uint64_t now = now_us < start_us_ ? 0 : (now_us - start_us_) / tick_us_;
+
+		Lock lock(mutex_);
+
+		// ֽʱ¼ֹʱ䣬صڼĶʱwake_at
+		due_us_ = 0;
+
+		// ȰѵڵĽڵȫƵصУصڼ䲻ʱֿɱ߳޸
+		wheel_.advance(now, [this](wheel_node_t &val)
+		{
+			static_cast<timer_node_t &>(val).ready_ = true;
+			val._link_before(ready_);
+		});
+
+		while( ready_.next_ != &ready_ )
+		{
+			timer_node_t &node = static_cast<timer_node_t &>(*ready_.next_);
+			node._unlink();
+			node.ready_ = false;
+
+			// ڶʱ¹룬صпcancel󳬹һʱĴ
+			if( node.period_ != 0 )
+			{
+				std::uint64_t next = node.tick_ + node.period_;
+				if( next <= wheel_.now() )
+					next = wheel_.now() + node.period_;
+
+				wheel_.schedule(node, next);
+			}
+
+			current_ = &node;
+			current_thread_ = ::GetCurrentThreadId();
+			lock.unlock();
+
+			try
+			{
+				node.handler_();
+			}
+			catch(const exception::exception_base &e)
+			{
+				e.dump();
+			}
+			catch(const std::exception &)
+			{
+			}
+
+			// صпٽڵ㣬˺ٷnode
+			lock.lock();
+			current_ = nullptr;
+			current_thread_ = 0;
+			fired_.notify_all();
+		}
+
+		due_us_ = _due_us(wheel_.next_expire());
+		return due_us_;
+	}
+
+	std::uint64_t timer_service_t::_due_us(std::uint64_t tick) const
+	{
+		return tick == ~0ULL ? service_type::DEADLINE_NONE : start_us_ + tick * tick_us_;
+	}
+}
+}
@@ -0,0 +1,231 @@
+#ifndef __ASYNC_TIMER_TIMING_WHEEL_HPP
+#define __ASYNC_TIMER_TIMING_WHEEL_HPP
+
+#include <cstdint>
+#include <cassert>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+
+namespace async { namespace timer {
+
+	// ---------------------------------------
+	// struct wheel_node_t
+
+	// ʽڵ㣬ʹǶԼĶУ/ժʱֲڴ档
+	// handlerʱֵڱãһμtick(now)¹룬ڵ㱻ժ
+	// handlerвٵͬһʱֵĽӿ
+	struct wheel_node_t
+	{
+		typedef std::uint64_t (*expire_handler_t)(wheel_node_t &, std::uint64_t now);
+
+		wheel_node_t *prev_;
+		wheel_node_t *next_;
+		std::uint64_t tick_;
+		expire_handler_t handler_;
+
+		explicit wheel_node_t(expire_handler_t handler = nullptr)
+			: prev_(nullptr)
+			, next_(nullptr)
+			, tick_(0)
+			, handler_(handler)
+		{}
+
+		bool is_linked() const
+		{
+			return prev_ != nullptr;
+		}
+
+		void _link_before(wheel_node_t &pos)
+		{
+			prev_ = pos.prev_;
+			next_ = &pos;
+			pos.prev_->next_ = this;
+			pos.prev_ = this;
+		}
+
+		void _unlink()
+		{
+			prev_->next_ = next_;
+			next_->prev_ = prev_;
+			prev_ = next_ = nullptr;
+		}
+
+	private:
+		wheel_node_t(const wheel_node_t &);
+		wheel_node_t &operator=(const wheel_node_t &);
+	};
+
+
+	// ---------------------------------------
+	// class timing_wheel_t
+
+	// ϣʱ֣Ϊ2ݣڵ㰴tick & maskɢУһȦĽڵ۱ɨʱ
+	// 롢ժΪO(1)advanceĿ뵽ڲеĽڵȡ
+	// Ƶˢµĳʱ(Ựгʱ)ʹֻԼĽֹtick
+	// ڽڵ㵽ڻصбȽϺ󷵻µtickˢ±
+	class timing_wheel_t
+	{
+		typedef std::mutex					Mutex;
+		typedef std::unique_lock<Mutex>		Lock;
+
+	private:
+		const std::uint32_t tick_ms_;
+		const std::uint64_t mask_;
+		std::unique_ptr<wheel_node_t[]> slots_;
+
+		std::atomic<std::uint64_t> now_;
+		std::uint64_t start_ms_;
+		std::uint32_t size_;
+
+		Mutex mutex_;
+
+	public:
+		timing_wheel_t(std::uint64_t start_ms, std::uint32_t tick_ms = 100, std::uint32_t slot_bits = 12)
+			: tick_ms_(tick_ms == 0 ? 1 : tick_ms)
+			, mask_((1ULL << slot_bits) - 1)
+			, slots_(new wheel_node_t[std::size_t(1) << slot_bits])
+			, now_(0)
+			, start_ms_(start_ms)
+			, size_(0)
+		{
+			for( std::uint64_t i = 0; i <= mask_; ++i )
+				slots_[i].prev_ = slots_[i].next_ = &slots_[i];
+		}
+
+		~timing_wheel_t()
+		{
+			// ʹǰժнڵ
+			assert(size_ == 0);
+		}
+
+	private:
+		timing_wheel_t(const timing_wheel_t &);
+		timing_wheel_t &operator=(const timing_wheel_t &);
+
+	public:
+		std::uint32_t tick_ms() const
+		{
+			return tick_ms_;
+		}
+
+		// ǰtickֻ߳
+		std::uint64_t now() const
+		{
+			return now_.load(std::memory_order_relaxed);
+		}
+
+		// תΪtickȡ
+		std::uint64_t ticks(std::uint64_t ms) const
+		{
+			return (ms + tick_ms_ - 1) / tick_ms_;
+		}
+
+		std::uint32_t size() const
+		{
+			return size_;
+		}
+
+		// ¹ڵ㣬tickΪڵľtick
+		void schedule(wheel_node_t &node, std::uint64_t tick)
+		{
+			assert(node.handler_ != nullptr);
+
+			Lock lock(mutex_);
+			_schedule(node, tick);
+		}
+
+		void cancel(wheel_node_t &node)
+		{
+			Lock lock(mutex_);
+			if( !node.is_linked() )
+				return;
+
+			node._unlink();
+			--size_;
+		}
+
+		// ƽnow_msڼ侭в
+		void advance(std::uint64_t now_ms)
+		{
+			if( now_ms < start_ms_ )
+				return;
+
+			const std::uint64_t target = (now_ms - start_ms_) / tick_ms_;
+
+			Lock lock(mutex_);
+
+			std::uint64_t cur = now_.load(std::memory_order_relaxed);
+			if( cur >= target )
+				return;
+
+			// 󳬹һȦʱÿֻɨһ
+			if( target - cur > mask_ + 1 )
+				cur = target - (mask_ + 1);
+
+			while( cur != target )
+			{
+				++cur;
+				now_.store(cur, std::memory_order_relaxed);
+
+				_expire(slots_[cur & mask_], cur);
+			}
+		}
+
+	private:
+		void _schedule(wheel_node_t &node, std::uint64_t tick)
+		{
+			const std::uint64_t cur = now_.load(std::memory_order_relaxed);
+			if( tick <= cur )
+				tick = cur + 1;
+
+			if( node.is_linked() )
+				node._unlink();
+			else
+				++size_;
+
+			node.tick_ = tick;
+			node._link_before(slots_[tick & mask_]);
+		}
+
+		void _expire(wheel_node_t &head, std::uint64_t cur)
+		{
+			// Ȱժ£ص¹Ľڵͬһ
+			if( head.next_ == &head )
+				return;
+
+			wheel_node_t pending;
+			pending.prev_ = head.prev_;
+			pending.next_ = head.next_;
+			pending.prev_->next_ = &pending;
+			pending.next_->prev_ = &pending;
+			head.prev_ = head.next_ = &head;
+
+			while( pending.next_ != &pending )
+			{
+				wheel_node_t &node = *pending.next_;
+				node._unlink();
+
+				// δת
+				if( node.tick_ > cur )
+				{
+					node._link_before(head);
+					continue;
+				}
+
+				--size_;
+
+				const std::uint64_t next = node.handler_(node, cur);
+				if( next > cur )
+					_schedule(node, next);
+			}
+		}
+	};
+}
+}
+
+
+
+
+#endif
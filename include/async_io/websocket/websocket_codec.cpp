@@ -0,0 +1,301 @@
+#include "websocket_codec.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include <emmintrin.h>
+
+
+namespace async { namespace websocket {
+
+	namespace {
+
+		inline std::uint32_t rotl(std::uint32_t val, std::uint32_t bits)
+		{
+			return (val << bits) | (val >> (32 - bits));
+		}
+
+		// ֻҪSHA-1С׷ٶ
+		void sha1(const std::string &msg, unsigned char (&digest)[20])
+		{
+			std::uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+			std::string data = msg;
+			const std::uint64_t bits = static_cast<std::uint64_t>(msg.size()) * 8;
+			data.push_back(static_cast<char>(0x80));
+			while( data.size() % 64 != 56 )
+				data.push_back(0);
+			for(int i = 7; i >= 0; --i)
+				data.push_back(static_cast<char>(bits >> (i * 8)));
+
+			for(std::size_t block = 0; block != data.size(); block += 64)
+			{
+				const unsigned char *p = reinterpret_cast<const unsigned char *>(data.data() + block);
+
+				std::uint32_t w[80] = {0};
+				for(int i = 0; i != 16; ++i)
+					w[i] = (p[i * 4] << 24) | (p[i * 4 + 1] << 16) | (p[i * 4 + 2] << 8) | p[i * 4 + 3];
+				for(int i = 16; i != 80; ++i)
+					w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+				std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+				for(int i = 0; i != 80; ++i)
+				{
+					std::uint32_t f = 0, k = 0;
+					if( i < 20 )
+						f = (b & c) | (~b & d), k = 0x5A827999;
+					else if( i < 40 )
+						f = b ^ c ^ d, k = 0x6ED9EBA1;
+					else if( i < 60 )
+						f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+					else
+						f = b ^ c ^ d, k = 0xCA62C1D6;
+
+					const std::uint32_t tmp = rotl(a, 5) + f + e + k + w[i];
+					e = d;
+					d = c;
+					c = rotl(b, 30);
+					b = a;
+					a = tmp;
+				}
+
+				h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+			}
+
+			for(int i = 0; i != 20; ++i)
+				digest[i] = static_cast<unsigned char>(h[i / 4] >> (24 - (i % 4) * 8));
+		}
+
+		std::string base64(const unsigned char *data, std::size_t len)
+		{
+			static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+			std::string out;
+			out.reserve((len + 2) / 3 * 4);
+			for(std::size_t i = 0; i < len; i += 3)
+			{
+				const std::uint32_t val = (data[i] << 16)
+					| (i + 1 < len ? data[i + 1] << 8 : 0)
+					| (i + 2 < len ? data[i + 2] : 0);
+
+				out.push_back(table[(val >> 18) & 0x3F]);
+				out.push_back(table[(val >> 12) & 0x3F]);
+				out.push_back(i + 1 < len ? table[(val >> 6) & 0x3F] : '=');
+				out.push_back(i + 2 < len ? table[val & 0x3F] : '=');
+			}
+
+			return out;
+		}
+	}
+
+
+	std::string accept_key(const view_t &key)
+	{
+		static const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+		std::string val(key.data(), key.size());
+		val.append(GUID);
+
+		unsigned char digest[20] = {0};
+		sha1(val, digest);
+
+		return base64(digest, sizeof(digest));
+	}
+
+	void apply_mask(char *data, std::size_t len, const char (&key)[4], std::size_t offset)
+	{
+		// 164ıչÿ16ֽڿͬ
+		char pattern[16] = {0};
+		for(std::size_t i = 0; i != 16; ++i)
+			pattern[i] = key[(offset + i) & 3];
+
+		const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern));
+
+		std::size_t i = 0;
+		for(; i + 64 <= len; i += 64)
+		{
+			__m128i *p = reinterpret_cast<__m128i *>(data + i);
+			const __m128i v0 = _mm_loadu_si128(p);
+			const __m128i v1 = _mm_loadu_si128(p + 1);
+			const __m128i v2 = _mm_loadu_si128(p + 2);
+			const __m128i v3 = _mm_loadu_si128(p + 3);
+			_mm_storeu_si128(p, _mm_xor_si128(v0, mask));
+			_mm_storeu_si128(p + 1, _mm_xor_si128(v1, mask));
+			_mm_storeu_si128(p + 2, _mm_xor_si128(v2, mask));
+			_mm_storeu_si128(p + 3, _mm_xor_si128(v3, mask));
+		}
+
+		for(; i + 16 <= len; i += 16)
+		{
+			__m128i *p = reinterpret_cast<__m128i *>(data + i);
+			_mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), mask));
+		}
+
+		for(; i != len; ++i)
+			data[i] ^= pattern[i & 15];
+	}
+
+	std::uint32_t encode_header(char (&header)[MAX_HEADER_SIZE], opcode_t opcode, bool fin, std::uint64_t size)
+	{
+		header[0] = static_cast<char>((fin ? 0x80 : 0) | opcode);
+
+		if( size < 126 )
+		{
+			header[1] = static_cast<char>(size);
+			return 2;
+		}
+
+		if( size <= 0xFFFF )
+		{
+			header[1] = 126;
+			header[2] = static_cast<char>(size >> 8);
+			header[3] = static_cast<char>(size);
+			return 4;
+		}
+
+		header[1] = 127;
+		for(int i = 0; i != 8; ++i)
+			header[2 + i] = static_cast<char>(size >> (56 - i * 8));
+		return 10;
+	}
+
+
+	frame_decoder_t::frame_decoder_t(std::uint64_t max_message, bool require_mask)
+		: max_message_(max_message)
+		, require_mask_(require_mask)
+	{
+		reset();
+	}
+
+	void frame_decoder_t::reset()
+	{
+		pos_ = 0;
+		opcode_ = OP_CONTINUATION;
+		msg_start_ = 0;
+		msg_end_ = 0;
+		error_ = 0;
+	}
+
+	frame_decoder_t::result_t frame_decoder_t::decode(char *data, std::size_t len, frame_t &frame, std::size_t &consumed)
+	{
+		assert(len < 0xFFFFFFFF);
+		const std::uint32_t size = static_cast<std::uint32_t>(len);
+
+		consumed = 0;
+		for(;;)
+		{
+			if( size - pos_ < 2 )
+				return DECODE_MORE;
+
+			const unsigned char *head = reinterpret_cast<const unsigned char *>(data + pos_);
+			const bool fin = (head[0] & 0x80) != 0;
+			const std::uint32_t opcode = head[0] & 0x0F;
+			const bool masked = (head[1] & 0x80) != 0;
+
+			// ûЭչRSVΪ0
+			if( (head[0] & 0x70) != 0 || masked != require_mask_ )
+				return _error(CLOSE_PROTOCOL_ERROR);
+
+			std::uint64_t payload = head[1] & 0x7F;
+			std::uint32_t header = 2;
+			if( payload == 126 )
+			{
+				header = 4;
+				if( size - pos_ < header )
+					return DECODE_MORE;
+
+				payload = (head[2] << 8) | head[3];
+			}
+			else if( payload == 127 )
+			{
+				header = 10;
+				if( size - pos_ < header )
+					return DECODE_MORE;
+
+				payload = 0;
+				for(std::uint32_t i = 2; i != 10; ++i)
+					payload = (payload << 8) | head[i];
+				if( (payload >> 63) != 0 )
+					return _error(CLOSE_PROTOCOL_ERROR);
+			}
+
+			const std::uint32_t key_pos = header;
+			if( masked )
+				header += 4;
+
+			const bool control = (opcode & 0x8) != 0;
+			if( control )
+			{
+				if( opcode != OP_CLOSE && opcode != OP_PING && opcode != OP_PONG )
+					return _error(CLOSE_PROTOCOL_ERROR);
+				if( !fin || payload > 125 )
+					return _error(CLOSE_PROTOCOL_ERROR);
+			}
+			else
+			{
+				if( opcode == OP_CONTINUATION ? !in_message() : (in_message() || (opcode != OP_TEXT && opcode != OP_BINARY)) )
+					return _error(CLOSE_PROTOCOL_ERROR);
+
+				const std::uint64_t received = in_message() ? msg_end_ - msg_start_ : 0;
+				if( payload > max_message_ - received )
+					return _error(CLOSE_TOO_BIG);
+			}
+
+			// ֡ȥ룬ÿֻֽһ
+			if( size - pos_ < header || size - pos_ - header < payload )
+				return DECODE_MORE;
+
+			char *body = data + pos_ + header;
+			const std::uint32_t body_size = static_cast<std::uint32_t>(payload);
+			if( masked )
+			{
+				char key[4] = {0};
+				std::memcpy(key, head + key_pos, sizeof(key));
+				apply_mask(body, body_size, key);
+			}
+
+			pos_ += header + body_size;
+
+			if( control )
+			{
+				frame.opcode_ = static_cast<opcode_t>(opcode);
+				frame.payload_ = view_t(body, body_size);
+
+				if( !in_message() )
+				{
+					consumed = pos_;
+					reset();
+				}
+
+				return DECODE_CONTROL;
+			}
+
+			const std::uint32_t offset = static_cast<std::uint32_t>(body - data);
+			if( opcode != OP_CONTINUATION )
+			{
+				opcode_ = static_cast<opcode_t>(opcode);
+				msg_start_ = offset;
+				msg_end_ = offset + body_size;
+			}
+			else
+			{
+				// Ƭӵи֮󣬸ǵм֡ͷ֡
+				if( msg_end_ != offset )
+					std::memmove(data + msg_end_, body, body_size);
+				msg_end_ += body_size;
+			}
+
+			if( fin )
+			{
+				frame.opcode_ = opcode_;
+				frame.payload_ = view_t(data + msg_start_, msg_end_ - msg_start_);
+
+				consumed = pos_;
+				reset();
+
+				return DECODE_MESSAGE;
+			}
+		}
+	}
+}
+}
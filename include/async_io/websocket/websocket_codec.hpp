@@ -0,0 +1,118 @@
+#ifndef __ASYNC_WEBSOCKET_WEBSOCKET_CODEC_HPP
+#define __ASYNC_WEBSOCKET_WEBSOCKET_CODEC_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "../service/read_write_buffer.hpp"
+
+
+namespace async { namespace websocket {
+
+	typedef service::const_buffer_t view_t;
+
+	enum opcode_t
+	{
+		OP_CONTINUATION	= 0x0,
+		OP_TEXT			= 0x1,
+		OP_BINARY		= 0x2,
+		OP_CLOSE		= 0x8,
+		OP_PING			= 0x9,
+		OP_PONG			= 0xA
+	};
+
+	enum close_code_t
+	{
+		CLOSE_NORMAL			= 1000,
+		CLOSE_GOING_AWAY		= 1001,
+		CLOSE_PROTOCOL_ERROR	= 1002,
+		CLOSE_NO_STATUS			= 1005,
+		CLOSE_ABNORMAL			= 1006,
+		CLOSE_TOO_BIG			= 1009
+	};
+
+	// ֡ͷ10ֽ
+	static const std::uint32_t MAX_HEADER_SIZE = 10;
+
+	// Sec-WebSocket-KeyӦSec-WebSocket-Accept
+	std::string accept_key(const view_t &key);
+
+	// 4ֽSSE2ÿδ16ֽڡoffsetΪdataеƫ
+	void apply_mask(char *data, std::size_t len, const char (&key)[4], std::size_t offset = 0);
+
+	// ɲ֡ͷس
+	std::uint32_t encode_header(char (&header)[MAX_HEADER_SIZE], opcode_t opcode, bool fin, std::uint64_t size);
+
+
+	// -------------------------------------------------
+	// class frame_decoder_t
+
+	// ֡룬÷http::request_parser_tͬÿδӵǰϢʼĩβȫݡ
+	// ڻԭȥ룻ƬϢĺƬǰƴӵһƬ֮󣬵õĸأ
+	// δƬϢƶݡƬ֮Ŀ֡
+	class frame_decoder_t
+	{
+	public:
+		enum result_t
+		{
+			DECODE_MORE,
+			DECODE_MESSAGE,		// Ϣ
+			DECODE_CONTROL,		// ֡
+			DECODE_ERROR
+		};
+
+		struct frame_t
+		{
+			opcode_t opcode_;
+			view_t payload_;
+		};
+
+		static const std::uint64_t DEFAULT_MAX_MESSAGE = 16 * 1024 * 1024;
+
+	private:
+		std::uint64_t max_message_;
+		bool require_mask_;
+
+		std::uint32_t pos_;			// һ֡ʼ
+		opcode_t opcode_;			// δɵķƬϢOP_CONTINUATIONʾû
+		std::uint32_t msg_start_;
+		std::uint32_t msg_end_;
+		std::uint16_t error_;
+
+	public:
+		// Ҫͻ˵֡
+		explicit frame_decoder_t(std::uint64_t max_message = DEFAULT_MAX_MESSAGE, bool require_mask = true);
+
+	public:
+		// consumed0ʱ֮ǰݶѴ꣬ǰʼλãá
+		// ƬмĿ֡consumedΪ0frameĸͼһdecode֮ǰЧ
+		result_t decode(char *data, std::size_t len, frame_t &frame, std::size_t &consumed);
+
+		void reset();
+
+		// DECODE_ERRORʱĹر룺1002/1009
+		std::uint16_t error_code() const
+		{
+			return error_;
+		}
+
+		// յƬϢһ
+		bool in_message() const
+		{
+			return opcode_ != OP_CONTINUATION;
+		}
+
+	private:
+		result_t _error(std::uint16_t code)
+		{
+			error_ = code;
+			return DECODE_ERROR;
+		}
+	};
+}
+}
+
+
+
+
+#endif
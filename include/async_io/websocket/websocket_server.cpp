@@ -0,0 +1,451 @@
+#include "websocket_server.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "../../memory_pool/sgi_memory_pool.hpp"
+#include "../service/clock.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+
+namespace async { namespace websocket {
+
+	namespace {
+
+		memory_pool::mt_memory_pool &callback_pool()
+		{
+			static memory_pool::mt_memory_pool pool;
+			return pool;
+		}
+
+		// Ƭ֡ͷڷƬ֮Ŀ֡ԭض󲻻գ
+		const std::size_t BUFFER_SLACK = 64 * 1024;
+	}
+
+
+	// ֻδɵĶУʱ֪ͨӹر
+	struct connection_t::reader_t
+	{
+		connection_ptr connection_;
+
+		explicit reader_t(const connection_ptr &connection)
+			: connection_(connection)
+		{}
+
+		~reader_t()
+		{
+			connection_->_on_closed();
+		}
+	};
+
+
+	connection_t::connection_t(server_t &server, const network::session_ptr &session)
+		: server_(server)
+		, session_(session)
+		, buffer_(DEFAULT_BUFFER_SIZE)
+		, begin_(0)
+		, end_(0)
+		, decoder_(server.max_message_)
+		, keepalive_(&connection_t::_expire)
+		, active_(0)
+		, close_code_(CLOSE_ABNORMAL)
+		, writing_(false)
+		, close_sent_(false)
+		, close_written_(false)
+		, close_done_(false)
+	{
+	}
+
+	bool connection_t::send_text(std::string &&text)
+	{
+		return _send(OP_TEXT, std::move(text), view_t(), nullptr);
+	}
+
+	bool connection_t::send_binary(std::string &&data)
+	{
+		return _send(OP_BINARY, std::move(data), view_t(), nullptr);
+	}
+
+	bool connection_t::send(opcode_t opcode, const view_t &payload, const std::shared_ptr<const void> &holder)
+	{
+		return _send(opcode, std::string(), payload, holder);
+	}
+
+	bool connection_t::ping()
+	{
+		return _send(OP_PING, std::string(), view_t(), nullptr);
+	}
+
+	void connection_t::close(std::uint16_t code, const std::string &reason)
+	{
+		_close(code, reason, false);
+	}
+
+	void connection_t::_start(const service::const_buffer_t &rest)
+	{
+		// Ӧ֮ͬһζ
+		if( rest.size() > buffer_.size() )
+			buffer_.resize(rest.size());
+		std::memcpy(buffer_.data(), rest.data(), rest.size());
+		end_ = rest.size();
+
+		auto this_val = shared_from_this();
+		if( server_.ping_ticks_ != 0 )
+		{
+			active_ = server_.wheel_.now();
+			keepalive_.self_ = this_val;
+			server_.wheel_.schedule(keepalive_, server_.wheel_.now() + server_.ping_ticks_);
+		}
+
+		if( server_.open_handler_ )
+			server_.open_handler_(this_val);
+
+		_process(std::make_shared<reader_t>(this_val));
+	}
+
+	void connection_t::_read(const reader_ptr &reader)
+	{
+		// δɵϢᵽͷֻ¼ƫ
+		if( begin_ != 0 )
+		{
+			std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+			end_ -= begin_;
+			begin_ = 0;
+		}
+
+		if( end_ == buffer_.size() )
+		{
+			const std::size_t limit = static_cast<std::size_t>(server_.max_message_) + BUFFER_SLACK;
+			if( buffer_.size() >= limit )
+			{
+				_close(CLOSE_TOO_BIG, std::string(), true);
+				return;
+			}
+
+			buffer_.resize(std::min(buffer_.size() * 2, limit));
+		}
+
+		service::mutable_buffer_t buf(buffer_.data() + end_, buffer_.size() - end_);
+		session_->async_read_some(buf, 0, [reader](const network::session_ptr &, std::uint32_t size)
+		{
+			auto &connection = *reader->connection_;
+			connection.active_.store(connection.server_.wheel_.now(), std::memory_order_relaxed);
+			connection.end_ += size;
+			connection._process(reader);
+		}, callback_pool());
+	}
+
+	void connection_t::_process(const reader_ptr &reader)
+	{
+		auto this_val = reader->connection_;
+
+		while( begin_ != end_ )
+		{
+			frame_decoder_t::frame_t frame;
+			std::size_t consumed = 0;
+
+			const frame_decoder_t::result_t ret = decoder_.decode(buffer_.data() + begin_, end_ - begin_, frame, consumed);
+			if( ret == frame_decoder_t::DECODE_MORE )
+				break;
+
+			if( ret == frame_decoder_t::DECODE_ERROR )
+			{
+				_close(decoder_.error_code(), std::string(), true);
+				return;
+			}
+
+			// ͼһζ֮ǰЧ
+			begin_ += consumed;
+
+			if( ret == frame_decoder_t::DECODE_CONTROL )
+			{
+				if( !_control(frame) )
+					return;
+				continue;
+			}
+
+			try
+			{
+				server_.message_handler_(this_val, frame.opcode_, frame.payload_);
+			}
+			catch(::exception::exception_base &e)
+			{
+				e.dump();
+			}
+			catch(std::exception &)
+			{
+			}
+		}
+
+		_read(reader);
+	}
+
+	bool connection_t::_control(const frame_decoder_t::frame_t &frame)
+	{
+		switch( frame.opcode_ )
+		{
+		case OP_PING:
+			_send(OP_PONG, std::string(frame.payload_.data(), frame.payload_.size()), view_t(), nullptr);
+			return true;
+
+		case OP_PONG:
+			return true;
+
+		case OP_CLOSE:
+			{
+				std::uint16_t code = CLOSE_NO_STATUS;
+				if( frame.payload_.size() >= 2 )
+				{
+					const unsigned char *p = reinterpret_cast<const unsigned char *>(frame.payload_.data());
+					code = static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+				}
+				else if( frame.payload_.size() == 1 )
+				{
+					_close(CLOSE_PROTOCOL_ERROR, std::string(), true);
+					return false;
+				}
+
+				// ظͬĹر룬ٶȡ
+				close_code_ = code;
+				_close(code == CLOSE_NO_STATUS ? static_cast<std::uint16_t>(CLOSE_NORMAL) : code, std::string(), true);
+			}
+			return false;
+
+		default:
+			assert(0);
+			return false;
+		}
+	}
+
+	void connection_t::_on_closed()
+	{
+		if( server_.ping_ticks_ != 0 )
+			server_.wheel_.cancel(keepalive_);
+
+		if( !server_.close_handler_ )
+			return;
+
+		try
+		{
+			server_.close_handler_(shared_from_this(), close_code_);
+		}
+		catch(::exception::exception_base &e)
+		{
+			e.dump();
+		}
+		catch(std::exception &)
+		{
+		}
+	}
+
+	bool connection_t::_send(opcode_t opcode, std::string &&data, const view_t &payload, const std::shared_ptr<const void> &holder)
+	{
+		out_frame_t frame;
+		frame.data_ = std::move(data);
+		frame.payload_ = payload;
+		frame.holder_ = holder;
+		frame.header_size_ = encode_header(frame.header_, opcode, true, frame.data_.size() + payload.size());
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		if( close_sent_ )
+			return false;
+
+		if( opcode == OP_CLOSE )
+			close_sent_ = true;
+
+		pending_.push_back(std::move(frame));
+		if( writing_ )
+			return true;
+
+		writing_ = true;
+		sending_.swap(pending_);
+		lock.unlock();
+
+		_write();
+		return true;
+	}
+
+	void connection_t::_close(std::uint16_t code, const std::string &reason, bool done)
+	{
+		std::string payload;
+		payload.push_back(static_cast<char>(code >> 8));
+		payload.push_back(static_cast<char>(code));
+		payload.append(reason, 0, 123);
+
+		bool disconnect = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if( done )
+			{
+				close_done_ = true;
+				disconnect = close_written_;
+			}
+		}
+
+		// ر֡Ѿдֱ꣬ӶϿ
+		if( disconnect )
+		{
+			session_->disconnect();
+			return;
+		}
+
+		_send(OP_CLOSE, std::move(payload), view_t(), nullptr);
+	}
+
+	void connection_t::_write()
+	{
+		buffers_.clear();
+		for(auto iter = sending_.begin(); iter != sending_.end(); ++iter)
+		{
+			buffers_.push_back(service::const_buffer_t(iter->header_, iter->header_size_));
+			if( !iter->data_.empty() )
+				buffers_.push_back(service::const_buffer_t(iter->data_.data(), iter->data_.size()));
+			if( iter->payload_.size() != 0 )
+				buffers_.push_back(iter->payload_);
+		}
+
+		auto this_val = shared_from_this();
+		session_->async_writev(buffers_.data(), static_cast<std::uint32_t>(buffers_.size()),
+			[this_val](const network::session_ptr &, std::uint32_t)
+		{
+			this_val->_on_written();
+		}, callback_pool());
+	}
+
+	void connection_t::_on_written()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		sending_.clear();
+		if( close_sent_ && pending_.empty() )
+		{
+			// ر֡һ֡
+			close_written_ = true;
+			writing_ = false;
+
+			const bool done = close_done_;
+			lock.unlock();
+
+			if( done )
+				session_->disconnect();
+			return;
+		}
+
+		if( pending_.empty() )
+		{
+			writing_ = false;
+			return;
+		}
+
+		sending_.swap(pending_);
+		lock.unlock();
+
+		_write();
+	}
+
+	std::uint64_t connection_t::_expire(timer::wheel_node_t &node, std::uint64_t now)
+	{
+		auto &val = static_cast<keepalive_t &>(node);
+
+		// ʱժڵ㣬lockɹʱһ
+		auto this_val = val.self_.lock();
+		if( !this_val )
+			return 0;
+
+		server_t &svr = this_val->server_;
+		const std::uint64_t active = this_val->active_.load(std::memory_order_relaxed);
+
+		if( now < active + svr.ping_ticks_ )
+			return active + svr.ping_ticks_;
+
+		if( now >= active + svr.ping_ticks_ * 2 )
+		{
+			svr.io_.post([this_val](const std::error_code &, std::uint32_t)
+			{
+				this_val->session_->disconnect();
+			}, callback_pool());
+			return 0;
+		}
+
+		svr.io_.post([this_val](const std::error_code &, std::uint32_t)
+		{
+			this_val->ping();
+		}, callback_pool());
+		return now + svr.ping_ticks_;
+	}
+
+
+	server_t::server_t(service::io_dispatcher_t &io, const message_handler_type &handler, std::uint32_t ping_interval, std::uint64_t max_message)
+		: io_(io)
+		, message_handler_(handler)
+		, max_message_(max_message)
+		, wheel_(service::now_ms(), KEEPALIVE_TICK)
+		, ping_ticks_(wheel_.ticks(ping_interval))
+		, tick_id_(0)
+	{
+		if( ping_ticks_ != 0 )
+		{
+			tick_id_ = io_.add_tick_handler(KEEPALIVE_TICK, [this]()
+			{
+				wheel_.advance(service::now_ms());
+			});
+		}
+	}
+
+	server_t::~server_t()
+	{
+		if( tick_id_ != 0 )
+			io_.remove_tick_handler(tick_id_);
+	}
+
+	void server_t::register_open_handler(const open_handler_type &handler)
+	{
+		open_handler_ = handler;
+	}
+
+	void server_t::register_close_handler(const close_handler_type &handler)
+	{
+		close_handler_ = handler;
+	}
+
+	bool server_t::upgrade(const http::request_t &req, http::response_t &resp)
+	{
+		if( !http::has_token(req.header("Upgrade"), "websocket") )
+			return false;
+
+		const view_t key = req.header("Sec-WebSocket-Key");
+		if( !req.is_method("GET") || req.version_minor_ < 1
+			|| !http::has_token(req.header("Connection"), "upgrade")
+			|| key.size() != 24 )
+		{
+			http::stock_response(resp, 400);
+			return true;
+		}
+
+		if( !http::equals(req.header("Sec-WebSocket-Version"), "13") )
+		{
+			http::stock_response(resp, 426);
+			resp.add_header("Sec-WebSocket-Version", "13");
+			return true;
+		}
+
+		// ֧չЭЭ
+		resp.set_status(101);
+		resp.add_header("Upgrade", "websocket");
+		resp.add_header("Connection", "Upgrade");
+		resp.add_header("Sec-WebSocket-Accept", accept_key(key));
+
+		resp.set_upgrade([this](const network::session_ptr &session, const service::const_buffer_t &rest)
+		{
+			auto connection = std::make_shared<connection_t>(*this, session);
+			connection->_start(rest);
+		});
+
+		return true;
+	}
+}
+}
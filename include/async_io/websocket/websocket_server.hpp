@@ -0,0 +1,190 @@
+#ifndef __ASYNC_WEBSOCKET_WEBSOCKET_SERVER_HPP
+#define __ASYNC_WEBSOCKET_WEBSOCKET_SERVER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+#include "websocket_codec.hpp"
+#include "../network.hpp"
+#include "../http/http_parser.hpp"
+#include "../http/http_response.hpp"
+#include "../timer/timing_wheel.hpp"
+
+
+namespace async { namespace websocket {
+
+	class server_t;
+
+
+	// -------------------------------------------------
+	// class connection_t
+
+	// WebSocketӡͿ̵߳ã֡˳Ŷӣ
+	// ûдڽʱŶӵ֡һξۼдزƴӿ
+	// δɵĶ֣(Զ˶Ͽյر֡Э)ʱصclose
+	// Ӧcloseص֮Ӧͷųеconnection_ptr
+	class connection_t
+		: public std::enable_shared_from_this<connection_t>
+	{
+		friend class server_t;
+
+		struct reader_t;
+		typedef std::shared_ptr<reader_t> reader_ptr;
+
+		struct keepalive_t
+			: timer::wheel_node_t
+		{
+			std::weak_ptr<connection_t> self_;
+
+			explicit keepalive_t(expire_handler_t handler)
+				: timer::wheel_node_t(handler)
+			{}
+		};
+
+		struct out_frame_t
+		{
+			char header_[MAX_HEADER_SIZE];
+			std::uint32_t header_size_;
+			std::string data_;
+			view_t payload_;
+			std::shared_ptr<const void> holder_;
+		};
+
+	public:
+		static const std::uint32_t DEFAULT_BUFFER_SIZE = 8 * 1024;
+
+	private:
+		server_t &server_;
+		network::session_ptr session_;
+
+		// [begin_, end_)Ϊδݣbegin_ǵǰϢʼ
+		std::vector<char> buffer_;
+		std::size_t begin_;
+		std::size_t end_;
+		frame_decoder_t decoder_;
+
+		keepalive_t keepalive_;
+		std::atomic<std::uint64_t> active_;
+		std::uint16_t close_code_;
+
+		std::mutex mutex_;
+		std::vector<out_frame_t> pending_;
+		std::vector<out_frame_t> sending_;
+		std::vector<service::const_buffer_t> buffers_;
+		bool writing_;
+		bool close_sent_;		// ر֡Ŷӣ֮ķͱ
+		bool close_written_;
+		bool close_done_;		// յԶ˹ر֡ر֡дϿ
+
+	public:
+		connection_t(server_t &server, const network::session_ptr &session);
+
+	private:
+		connection_t(const connection_t &);
+		connection_t &operator=(const connection_t &);
+
+	public:
+		std::uint64_t id() const
+		{
+			return session_->id();
+		}
+
+		const network::session_ptr &session() const
+		{
+			return session_;
+		}
+
+		// ӹرպ󷵻false
+		bool send_text(std::string &&text);
+		bool send_binary(std::string &&data);
+		// زholderݵдɣӹ㲥ͬһ
+		bool send(opcode_t opcode, const view_t &payload, const std::shared_ptr<const void> &holder);
+
+		bool ping();
+
+		// ͹ر֡յԶ˵Ĺر֡Ͽ
+		void close(std::uint16_t code = CLOSE_NORMAL, const std::string &reason = std::string());
+
+	private:
+		void _start(const service::const_buffer_t &rest);
+
+		void _read(const reader_ptr &reader);
+		void _process(const reader_ptr &reader);
+		bool _control(const frame_decoder_t::frame_t &frame);
+		void _on_closed();
+
+		bool _send(opcode_t opcode, std::string &&data, const view_t &payload, const std::shared_ptr<const void> &holder);
+		void _close(std::uint16_t code, const std::string &reason, bool done);
+		void _write();
+		void _on_written();
+
+		static std::uint64_t _expire(timer::wheel_node_t &node, std::uint64_t now);
+	};
+
+	typedef std::shared_ptr<connection_t> connection_ptr;
+
+
+	// -------------------------------------------------
+	// class server_t
+
+	// http::server_thandlerеupgrade֣ӦдỰתΪWebSocketӡ
+	// ping/pongIOtickƽʱping_intervalûյκʱping
+	// ûϿserver_tͷ֮
+	class server_t
+	{
+		friend class connection_t;
+
+	public:
+		typedef std::function<void(const connection_ptr &)>									open_handler_type;
+		// payloadֻڻصЧ
+		typedef std::function<void(const connection_ptr &, opcode_t, const view_t &payload)>	message_handler_type;
+		// ûյر֡ʱcodeΪCLOSE_ABNORMAL
+		typedef std::function<void(const connection_ptr &, std::uint16_t code)>				close_handler_type;
+
+		static const std::uint32_t DEFAULT_PING_INTERVAL = 30 * 1000;
+
+	private:
+		static const std::uint32_t KEEPALIVE_TICK = 500;	// ms
+
+		service::io_dispatcher_t &io_;
+		message_handler_type message_handler_;
+		open_handler_type open_handler_;
+		close_handler_type close_handler_;
+
+		std::uint64_t max_message_;
+		timer::timing_wheel_t wheel_;
+		std::uint64_t ping_ticks_;
+		std::uint32_t tick_id_;
+
+	public:
+		// ioһΪnetwork::server::io()ping_intervalΪ0ʱ
+		server_t(service::io_dispatcher_t &io, const message_handler_type &handler,
+			std::uint32_t ping_interval = DEFAULT_PING_INTERVAL,
+			std::uint64_t max_message = frame_decoder_t::DEFAULT_MAX_MESSAGE);
+		~server_t();
+
+	private:
+		server_t(const server_t &);
+		server_t &operator=(const server_t &);
+
+	public:
+		// upgrade֮ǰ
+		void register_open_handler(const open_handler_type &handler);
+		void register_close_handler(const close_handler_type &handler);
+
+		// WebSocketʱfalseɵ߼
+		// д101ӦʧܵĴӦtrue
+		bool upgrade(const http::request_t &req, http::response_t &resp);
+	};
+}
+}
+
+
+
+
+#endif
@@ -3,6 +3,8 @@
 
 
 #include <fstream>
+#include <algorithm>
+#include <limits>
 
 #pragma warning(disable: 4996)
 
@@ -60,6 +62,56 @@ namespace serialize { namespace detail {
 		}
 	};
 
+	// 󶨵ڴӳļ(ṩdata()/size()Ķasync::filesystem::mapped_file_t)
+	// дڴ濽ļIOȱҳɣֻӳֻڶȡ4GĲֲɷ
+	template < typename CharT >
+	class mapped_t
+	{
+	public:
+		typedef CharT				value_type;
+		typedef CharT *				pointer;
+		typedef value_type &		reference;
+		typedef const CharT *		const_pointer;
+		typedef const value_type &	const_reference;
+
+	private:
+		pointer buf_;
+		const std::uint32_t buf_len_;
+
+	public:
+		template < typename MappingT >
+		explicit mapped_t(MappingT &mapping)
+			: buf_(reinterpret_cast<pointer>(mapping.data()))
+			, buf_len_(static_cast<std::uint32_t>(std::min<std::uint64_t>(mapping.size() / sizeof(CharT), std::numeric_limits<std::uint32_t>::max())))
+		{}
+
+	public:
+		pointer buffer()
+		{
+			return buf_;
+		}
+
+		const_pointer buffer() const
+		{
+			return buf_;
+		}
+
+		std::uint32_t buffer_length() const
+		{
+			return buf_len_;
+		}
+
+		void read(pointer buf, std::uint32_t len, std::uint32_t pos) const
+		{
+			::memmove(buf, buf_ + pos, len);
+		}
+
+		void write(const_pointer buf, std::uint32_t len, std::uint32_t pos)
+		{
+			::memmove(buf_ + pos, buf, len);
+		}
+	};
+
 	template < typename CharT >
 	class file_t
 	{
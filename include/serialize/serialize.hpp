@@ -14,6 +14,7 @@
 
 	mem_serialize\mem_wserialize
 	file_serialize
+	mapped_serialize	ڴӳļ
 
 
 */
@@ -101,6 +102,7 @@ namespace serialize {
 	typedef serialize_t<wchar_t, detail::memory_t>	mem_wserialize;
 
 	typedef serialize_t<char, detail::file_t>		file_serialize;
+	typedef serialize_t<char, detail::mapped_t>		mapped_serialize;
 
 	typedef serialize_t<char, detail::memory_t, detail::text_in_t<char, detail::memory_t>> text_serialize; 
 
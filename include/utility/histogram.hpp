@@ -0,0 +1,170 @@
+#ifndef __UTILITY_HISTOGRAM_HPP
+#define __UTILITY_HISTOGRAM_HPP
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+#ifdef max
+#undef max
+#endif
+
+#ifdef min
+#undef min
+#endif
+
+
+namespace utility {
+
+	// -------------------------------------------------
+	// class histogram_t
+
+	// HDRĶ-ֱͼÿ2ٵȷΪSUB_BUCKETSݣ1/SUB_BUCKETS
+	// uint64Χڴ̶(Լ58KB)¼O(1)ӷ
+	// һÿ߳һmergeһͳƷλ
+	class histogram_t
+	{
+	public:
+		static const std::uint32_t SUB_BITS		= 7;
+		static const std::uint32_t SUB_BUCKETS	= 1 << SUB_BITS;
+		// [0, 2 * SUB_BUCKETS)ȷ¼֮ÿ2SUB_BUCKETSͰ
+		static const std::uint32_t BUCKETS		= 2 * SUB_BUCKETS + (64 - SUB_BITS - 1) * SUB_BUCKETS;
+
+	private:
+		std::vector<std::uint64_t> counts_;
+		std::uint64_t total_;
+		std::uint64_t min_;
+		std::uint64_t max_;
+		double sum_;
+
+	public:
+		histogram_t()
+			: counts_(BUCKETS)
+		{
+			reset();
+		}
+
+	public:
+		void record(std::uint64_t value, std::uint64_t count = 1)
+		{
+			counts_[index(value)] += count;
+			total_ += count;
+			sum_ += static_cast<double>(value) * count;
+
+			if( value < min_ )
+				min_ = value;
+			if( value > max_ )
+				max_ = value;
+		}
+
+		void merge(const histogram_t &rhs)
+		{
+			for(std::uint32_t i = 0; i != BUCKETS; ++i)
+				counts_[i] += rhs.counts_[i];
+
+			total_ += rhs.total_;
+			sum_ += rhs.sum_;
+			min_ = std::min(min_, rhs.min_);
+			max_ = std::max(max_, rhs.max_);
+		}
+
+		void reset()
+		{
+			std::fill(counts_.begin(), counts_.end(), 0);
+			total_ = 0;
+			min_ = ~0ULL;
+			max_ = 0;
+			sum_ = 0;
+		}
+
+		std::uint64_t count() const
+		{
+			return total_;
+		}
+
+		std::uint64_t min() const
+		{
+			return total_ == 0 ? 0 : min_;
+		}
+
+		std::uint64_t max() const
+		{
+			return max_;
+		}
+
+		double mean() const
+		{
+			return total_ == 0 ? 0 : sum_ / total_;
+		}
+
+		// percentȡ[0, 100]ͰϽ(ֵ)Сڸ÷λʵֵСɱʾֵ
+		std::uint64_t percentile(double percent) const
+		{
+			if( total_ == 0 )
+				return 0;
+
+			percent = std::min(std::max(percent, 0.0), 100.0);
+			std::uint64_t rank = static_cast<std::uint64_t>(percent / 100.0 * total_ + 0.5);
+			rank = std::min(std::max<std::uint64_t>(rank, 1), total_);
+
+			std::uint64_t seen = 0;
+			for(std::uint32_t i = 0; i != BUCKETS; ++i)
+			{
+				seen += counts_[i];
+				if( seen >= rank )
+					return std::max(std::min(upper(i), max_), min_);
+			}
+
+			return max_;
+		}
+
+		static std::uint32_t index(std::uint64_t value)
+		{
+			if( value < 2 * SUB_BUCKETS )
+				return static_cast<std::uint32_t>(value);
+
+			const std::uint32_t shift = msb(value) - SUB_BITS;
+			const std::uint32_t top = static_cast<std::uint32_t>(value >> shift);
+			return 2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS + (top - SUB_BUCKETS);
+		}
+
+		static std::uint64_t lower(std::uint32_t index)
+		{
+			if( index < 2 * SUB_BUCKETS )
+				return index;
+
+			const std::uint32_t shift = (index - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+			const std::uint64_t top = (index - 2 * SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+			return top << shift;
+		}
+
+		static std::uint64_t upper(std::uint32_t index)
+		{
+			if( index < 2 * SUB_BUCKETS )
+				return index;
+
+			const std::uint32_t shift = (index - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+			return lower(index) + ((1ULL << shift) - 1);
+		}
+
+	private:
+		// Win32û_BitScanReverse64
+		static std::uint32_t msb(std::uint64_t value)
+		{
+			assert(value != 0);
+
+			std::uint32_t pos = 0;
+			if( value >> 32 )	{ value >>= 32; pos += 32; }
+			if( value >> 16 )	{ value >>= 16; pos += 16; }
+			if( value >> 8 )	{ value >>= 8; pos += 8; }
+			if( value >> 4 )	{ value >>= 4; pos += 4; }
+			if( value >> 2 )	{ value >>= 2; pos += 2; }
+			if( value >> 1 )	{ pos += 1; }
+
+			return pos;
+		}
+	};
+}
+
+#endif
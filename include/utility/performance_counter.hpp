@@ -1,24 +1,43 @@
 #ifndef __UTILITY_PERFORMANCE_COUNTER_HPP
 #define __UTILITY_PERFORMANCE_COUNTER_HPP
 
-#include <chrono>
+#include <cstdint>
+#include <windows.h>
 
 namespace utility {
 
+	// QueryPerformanceCounterʱVS2013high_resolution_clock/steady_clockΪsystem_clock
+	// Ȳһϵͳʱ
 	struct performance_t
 	{
-		std::chrono::system_clock::time_point start_;
+		LARGE_INTEGER start_;
 
 		performance_t()
 		{
-			start_ = std::chrono::high_resolution_clock::now();
+			reset();
+		}
+
+		void reset()
+		{
+			::QueryPerformanceCounter(&start_);
+		}
+
+		std::uint64_t elapsed_us() const
+		{
+			LARGE_INTEGER freq = {0};
+			LARGE_INTEGER now = {0};
+			::QueryPerformanceFrequency(&freq);
+			::QueryPerformanceCounter(&now);
+
+			const std::uint64_t val = now.QuadPart - start_.QuadPart;
+			const std::uint64_t f = freq.QuadPart;
+			return val / f * 1000000 + val % f * 1000000 / f;
 		}
 
 		template < typename StreamT >
 		void time(StreamT &os) const
 		{
-			auto sec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_);
-			os << "milliseconds: " << sec.count() << "\n";
+			os << "milliseconds: " << elapsed_us() / 1000 << "\n";
 		}
 	};
 }
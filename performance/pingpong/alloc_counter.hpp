@@ -0,0 +1,71 @@
+#ifndef __PINGPONG_ALLOC_COUNTER_HPP
+#define __PINGPONG_ALLOC_COUNTER_HPP
+
+// 滻ȫoperator new/deleteͳ̵Ķѷbench_compareԱʵ
+// 滻inlineÿִгֻһcppаļ
+// ֻͳƾoperator newķ䣬mallocڴĿ䲻
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <iostream>
+
+
+namespace alloc_counter {
+
+	inline std::atomic<std::uint64_t> &allocations()
+	{
+		static std::atomic<std::uint64_t> val(0);
+		return val;
+	}
+
+	inline std::atomic<std::uint64_t> &allocated_bytes()
+	{
+		static std::atomic<std::uint64_t> val(0);
+		return val;
+	}
+
+	// ʽpingpongͳһ£"<ֵ> <>"bench_compare
+	inline void print()
+	{
+		std::cout << allocations().load() << " allocations" << std::endl;
+		std::cout << allocated_bytes().load() << " allocated bytes" << std::endl;
+	}
+
+	inline void *allocate(std::size_t size)
+	{
+		allocations().fetch_add(1, std::memory_order_relaxed);
+		allocated_bytes().fetch_add(size, std::memory_order_relaxed);
+
+		void *p = std::malloc(size == 0 ? 1 : size);
+		if( p == nullptr )
+			throw std::bad_alloc();
+
+		return p;
+	}
+}
+
+
+void *operator new(std::size_t size)
+{
+	return alloc_counter::allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+	return alloc_counter::allocate(size);
+}
+
+void operator delete(void *p) throw()
+{
+	std::free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+	std::free(p);
+}
+
+
+#endif
@@ -4,6 +4,7 @@
 #include "stdafx.h"
 #include "server.hpp"
 #include "client.hpp"
+#include "../alloc_counter.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -12,6 +13,8 @@ int main(int argc, char* argv[])
 	else if( *argv[1] == 'c' )
 		cli::cli_start(argc - 1, argv + 1);
 
+	alloc_counter::print();
+
 	system("pause");
 	return 0;
 }
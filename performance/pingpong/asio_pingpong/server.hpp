@@ -213,6 +213,14 @@ int svr_start(int argc, char* argv[])
 			threads.push_back(new_thread);
 		}
 
+		// Stop on a line (or EOF) from stdin, like the native pingpong server,
+		// so that the benchmark driver can shut it down and collect its stats.
+		std::thread stopper([&ios]()
+		{
+			std::cin.get();
+			ios.stop();
+		});
+
 		ios.run();
 
 		while (!threads.empty())
@@ -221,6 +229,8 @@ int svr_start(int argc, char* argv[])
 			delete threads.front();
 			threads.pop_front();
 		}
+
+		stopper.join();
 	}
 	catch (std::exception& e)
 	{
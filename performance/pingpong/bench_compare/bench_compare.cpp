@@ -0,0 +1,499 @@
+// bench_compare.cpp : ڱػpingpongasio_pingpongɨС//߳Աȱ
+//
+// bench_compare [seconds] [blocks] [sessions] [threads] [csv]
+//		blocks/sessions/threadsΪŷָб 64,1024,16384
+//		뱾λͬһĿ¼(ͬһĿ¼)
+//
+// ÿ˽̣˿ڿͻ˽̣ͻ˰ʱرշstdin˳
+// ȡͻ˶ֽCPUΪ̵û̬+ں̬ʱ֮(GetProcessTimes)
+// Ϊ̾operator newĴ֮(alloc_counter.hpp)ʱԽԽӽ̬
+//
+
+#include "stdafx.h"
+
+#include <winsock2.h>
+#include <windows.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+
+#pragma comment(lib, "ws2_32.lib")
+
+
+struct scenario_t
+{
+	std::uint32_t block_;
+	std::uint32_t sessions_;
+	std::uint32_t threads_;
+};
+
+struct result_t
+{
+	bool ok_;
+	std::uint64_t msgs_;
+	std::uint64_t bytes_;
+	std::uint64_t allocs_;
+	double cpu_ms_;
+
+	result_t()
+		: ok_(false)
+		, msgs_(0)
+		, bytes_(0)
+		, allocs_(0)
+		, cpu_ms_(0)
+	{}
+
+	double mib_s(std::uint32_t seconds) const
+	{
+		return static_cast<double>(bytes_) / seconds / (1024 * 1024);
+	}
+
+	double ns_per_byte() const
+	{
+		return bytes_ == 0 ? 0 : cpu_ms_ * 1000000 / bytes_;
+	}
+
+	double allocs_per_msg() const
+	{
+		return msgs_ == 0 ? 0 : static_cast<double>(allocs_) / msgs_;
+	}
+};
+
+// ʵֵв˳ͬ
+struct impl_t
+{
+	std::string name_;
+	std::string exe_;
+	std::string (*svr_args_)(std::uint16_t port, const scenario_t &sc);
+	std::string (*cli_args_)(std::uint16_t port, const scenario_t &sc, std::uint32_t seconds);
+};
+
+
+std::string native_svr_args(std::uint16_t port, const scenario_t &sc)
+{
+	std::ostringstream os;
+	os << "s " << port << " " << sc.threads_ << " " << sc.block_;
+	return os.str();
+}
+
+std::string native_cli_args(std::uint16_t port, const scenario_t &sc, std::uint32_t seconds)
+{
+	std::ostringstream os;
+	os << "c 127.0.0.1 " << port << " " << sc.sessions_ << " " << sc.threads_ << " " << sc.block_ << " " << seconds;
+	return os.str();
+}
+
+std::string asio_svr_args(std::uint16_t port, const scenario_t &sc)
+{
+	std::ostringstream os;
+	os << "s 127.0.0.1 " << port << " " << sc.threads_ << " " << sc.block_;
+	return os.str();
+}
+
+std::string asio_cli_args(std::uint16_t port, const scenario_t &sc, std::uint32_t seconds)
+{
+	std::ostringstream os;
+	os << "c 127.0.0.1 " << port << " " << sc.threads_ << " " << sc.block_ << " " << sc.sessions_ << " " << seconds;
+	return os.str();
+}
+
+
+// -------------------------------------------------
+// class process_t
+
+// ӽ̵stdin/stdout/stderrض򵽹̨ܵ߳ռȫ
+class process_t
+{
+	HANDLE process_;
+	HANDLE stdin_;
+	HANDLE stdout_;
+
+	std::thread reader_;
+	std::string output_;
+
+public:
+	process_t()
+		: process_(nullptr)
+		, stdin_(nullptr)
+		, stdout_(nullptr)
+	{}
+
+	~process_t()
+	{
+		if( process_ != nullptr && !wait(0) )
+			kill();
+
+		close_stdin();
+		if( reader_.joinable() )
+			reader_.join();
+
+		if( stdout_ != nullptr )
+			::CloseHandle(stdout_);
+		if( process_ != nullptr )
+			::CloseHandle(process_);
+	}
+
+private:
+	process_t(const process_t &);
+	process_t &operator=(const process_t &);
+
+public:
+	bool start(const std::string &cmd)
+	{
+		SECURITY_ATTRIBUTES sa = { sizeof(sa), nullptr, TRUE };
+
+		HANDLE in_r = nullptr, in_w = nullptr;
+		if( !::CreatePipe(&in_r, &in_w, &sa, 0) )
+			return false;
+
+		HANDLE out_r = nullptr, out_w = nullptr;
+		if( !::CreatePipe(&out_r, &out_w, &sa, 0) )
+		{
+			::CloseHandle(in_r);
+			::CloseHandle(in_w);
+			return false;
+		}
+
+		// ̳еһ˲ܱ̳Уӽ̶EOF
+		::SetHandleInformation(in_w, HANDLE_FLAG_INHERIT, 0);
+		::SetHandleInformation(out_r, HANDLE_FLAG_INHERIT, 0);
+
+		STARTUPINFOA si = { sizeof(si) };
+		si.dwFlags = STARTF_USESTDHANDLES;
+		si.hStdInput = in_r;
+		si.hStdOutput = out_w;
+		si.hStdError = out_w;
+
+		PROCESS_INFORMATION pi = { 0 };
+		std::vector<char> cmdline(cmd.begin(), cmd.end());
+		cmdline.push_back(0);
+
+		const BOOL suc = ::CreateProcessA(nullptr, cmdline.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &si, &pi);
+		::CloseHandle(in_r);
+		::CloseHandle(out_w);
+
+		if( !suc )
+		{
+			::CloseHandle(in_w);
+			::CloseHandle(out_r);
+			return false;
+		}
+
+		::CloseHandle(pi.hThread);
+		process_ = pi.hProcess;
+		stdin_ = in_w;
+		stdout_ = out_r;
+
+		reader_ = std::thread([this]()
+		{
+			char buf[4096] = {0};
+			DWORD read = 0;
+			while( ::ReadFile(stdout_, buf, sizeof(buf), &read, nullptr) && read != 0 )
+				output_.append(buf, read);
+		});
+
+		return true;
+	}
+
+	// ӽ̵cin.get()system("pause")EOF
+	void close_stdin()
+	{
+		if( stdin_ != nullptr )
+		{
+			::CloseHandle(stdin_);
+			stdin_ = nullptr;
+		}
+	}
+
+	bool wait(DWORD ms)
+	{
+		return ::WaitForSingleObject(process_, ms) == WAIT_OBJECT_0;
+	}
+
+	void kill()
+	{
+		::TerminateProcess(process_, 1);
+		::WaitForSingleObject(process_, INFINITE);
+	}
+
+	double cpu_ms() const
+	{
+		FILETIME create = {0}, exit = {0}, kernel = {0}, user = {0};
+		if( !::GetProcessTimes(process_, &create, &exit, &kernel, &user) )
+			return 0;
+
+		ULARGE_INTEGER k = {0}, u = {0};
+		k.LowPart = kernel.dwLowDateTime;
+		k.HighPart = kernel.dwHighDateTime;
+		u.LowPart = user.dwLowDateTime;
+		u.HighPart = user.dwHighDateTime;
+
+		// FILETIMEλΪ100ns
+		return static_cast<double>(k.QuadPart + u.QuadPart) / 10000;
+	}
+
+	// ˳
+	const std::string &output()
+	{
+		if( reader_.joinable() )
+			reader_.join();
+
+		return output_;
+	}
+};
+
+
+// в"<ֵ> <>"
+bool find_value(const std::string &text, const std::string &name, double &val)
+{
+	const std::string key = " " + name;
+
+	std::istringstream in(text);
+	std::string line;
+	while( std::getline(in, line) )
+	{
+		if( !line.empty() && line.back() == '\r' )
+			line.pop_back();
+
+		if( line.size() > key.size() && line.compare(line.size() - key.size(), key.size(), key) == 0 )
+		{
+			val = std::strtod(line.c_str(), nullptr);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool wait_port(std::uint16_t port, std::uint32_t timeout_ms)
+{
+	sockaddr_in addr = {0};
+	addr.sin_family = AF_INET;
+	addr.sin_port = ::htons(port);
+	addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+
+	for(std::uint32_t waited = 0; waited < timeout_ms; waited += 50)
+	{
+		SOCKET sck = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		const bool suc = ::connect(sck, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) == 0;
+		::closesocket(sck);
+
+		if( suc )
+			return true;
+
+		::Sleep(50);
+	}
+
+	return false;
+}
+
+std::vector<std::uint32_t> parse_list(const std::string &text)
+{
+	std::vector<std::uint32_t> vals;
+
+	std::istringstream in(text);
+	std::string item;
+	while( std::getline(in, item, ',') )
+	{
+		const std::uint32_t val = std::atoi(item.c_str());
+		if( val != 0 )
+			vals.push_back(val);
+	}
+
+	return vals;
+}
+
+std::string exe_dir()
+{
+	char path[MAX_PATH] = {0};
+	::GetModuleFileNameA(nullptr, path, MAX_PATH);
+
+	std::string dir(path);
+	const std::string::size_type pos = dir.find_last_of("\\/");
+	return pos == std::string::npos ? std::string() : dir.substr(0, pos + 1);
+}
+
+
+result_t run_one(const impl_t &impl, const scenario_t &sc, std::uint16_t port, std::uint32_t seconds)
+{
+	result_t result;
+	const std::string exe = "\"" + impl.exe_ + "\" ";
+
+	process_t svr;
+	if( !svr.start(exe + impl.svr_args_(port, sc)) )
+	{
+		std::cerr << impl.name_ << ": start server failed: " << ::GetLastError() << std::endl;
+		return result;
+	}
+
+	if( !wait_port(port, 5000) )
+	{
+		std::cerr << impl.name_ << ": server not listening on " << port << std::endl;
+		return result;
+	}
+
+	process_t cli;
+	if( !cli.start(exe + impl.cli_args_(port, sc, seconds)) )
+	{
+		std::cerr << impl.name_ << ": start client failed: " << ::GetLastError() << std::endl;
+		return result;
+	}
+
+	cli.close_stdin();
+	if( !cli.wait((seconds + 30) * 1000) )
+	{
+		std::cerr << impl.name_ << ": client timeout" << std::endl;
+		cli.kill();
+		return result;
+	}
+
+	svr.close_stdin();
+	if( !svr.wait(10 * 1000) )
+	{
+		std::cerr << impl.name_ << ": server did not stop" << std::endl;
+		svr.kill();
+		return result;
+	}
+
+	double msgs = 0, bytes = 0, cli_allocs = 0, svr_allocs = 0;
+	if( !find_value(cli.output(), "total msg read", msgs)
+		|| !find_value(cli.output(), "total bytes read", bytes)
+		|| !find_value(cli.output(), "allocations", cli_allocs)
+		|| !find_value(svr.output(), "allocations", svr_allocs) )
+	{
+		std::cerr << impl.name_ << ": unexpected output" << std::endl
+			<< cli.output() << std::endl << svr.output() << std::endl;
+		return result;
+	}
+
+	result.ok_ = true;
+	result.msgs_ = static_cast<std::uint64_t>(msgs);
+	result.bytes_ = static_cast<std::uint64_t>(bytes);
+	result.allocs_ = static_cast<std::uint64_t>(cli_allocs + svr_allocs);
+	result.cpu_ms_ = cli.cpu_ms() + svr.cpu_ms();
+
+	return result;
+}
+
+
+int main(int argc, char* argv[])
+{
+	const std::uint32_t seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+	const std::vector<std::uint32_t> blocks = parse_list(argc > 2 ? argv[2] : "64,1024,16384,65536");
+	const std::vector<std::uint32_t> sessions = parse_list(argc > 3 ? argv[3] : "1,16,256");
+	const std::vector<std::uint32_t> threads = parse_list(argc > 4 ? argv[4] : "1,4");
+	const std::string csv = argc > 5 ? argv[5] : "";
+
+	if( seconds == 0 || blocks.empty() || sessions.empty() || threads.empty() )
+	{
+		std::cerr << "usage: bench_compare [seconds] [blocks] [sessions] [threads] [csv]" << std::endl;
+		return -1;
+	}
+
+	WSADATA wsa = {0};
+	::WSAStartup(MAKEWORD(2, 2), &wsa);
+
+	const std::string dir = exe_dir();
+	const impl_t impls[] =
+	{
+		{ "native", dir + "pingpong.exe", &native_svr_args, &native_cli_args },
+		{ "asio", dir + "asio_pingpong.exe", &asio_svr_args, &asio_cli_args }
+	};
+	const std::uint32_t IMPL_CNT = _countof(impls);
+
+	std::vector<scenario_t> scenarios;
+	for(auto block : blocks)
+		for(auto session : sessions)
+			for(auto thread : threads)
+			{
+				const scenario_t sc = { block, session, thread };
+				scenarios.push_back(sc);
+			}
+
+	// ÿлһ˿ڣܿһTIME_WAIT
+	std::uint16_t port = 7000;
+	std::vector<result_t> results(scenarios.size() * IMPL_CNT);
+	for(std::size_t i = 0; i != scenarios.size(); ++i)
+	{
+		const scenario_t &sc = scenarios[i];
+		for(std::uint32_t j = 0; j != IMPL_CNT; ++j)
+		{
+			std::cerr << impls[j].name_ << " block " << sc.block_ << " sessions " << sc.sessions_
+				<< " threads " << sc.threads_ << "..." << std::endl;
+
+			results[i * IMPL_CNT + j] = run_one(impls[j], sc, port, seconds);
+			port = port == 7999 ? 7000 : port + 1;
+		}
+	}
+
+	// Աȱ
+	std::cout << std::endl
+		<< std::setw(8) << "block" << std::setw(10) << "sessions" << std::setw(9) << "threads"
+		<< std::setw(14) << "native MiB/s" << std::setw(12) << "asio MiB/s" << std::setw(8) << "ratio"
+		<< std::setw(13) << "native ns/B" << std::setw(11) << "asio ns/B"
+		<< std::setw(18) << "native allocs/msg" << std::setw(16) << "asio allocs/msg" << std::endl;
+
+	std::uint32_t faster = 0, compared = 0;
+	std::cout << std::fixed;
+	for(std::size_t i = 0; i != scenarios.size(); ++i)
+	{
+		const scenario_t &sc = scenarios[i];
+		const result_t &native = results[i * IMPL_CNT];
+		const result_t &asio = results[i * IMPL_CNT + 1];
+
+		std::cout << std::setw(8) << sc.block_ << std::setw(10) << sc.sessions_ << std::setw(9) << sc.threads_;
+
+		if( native.ok_ )
+			std::cout << std::setw(14) << std::setprecision(1) << native.mib_s(seconds);
+		else
+			std::cout << std::setw(14) << "-";
+		if( asio.ok_ )
+			std::cout << std::setw(12) << std::setprecision(1) << asio.mib_s(seconds);
+		else
+			std::cout << std::setw(12) << "-";
+
+		if( native.ok_ && asio.ok_ && asio.bytes_ != 0 )
+		{
+			++compared;
+			if( native.bytes_ > asio.bytes_ )
+				++faster;
+
+			std::cout << std::setw(8) << std::setprecision(2) << static_cast<double>(native.bytes_) / asio.bytes_;
+		}
+		else
+			std::cout << std::setw(8) << "-";
+
+		std::cout << std::setprecision(2)
+			<< std::setw(13) << native.ns_per_byte() << std::setw(11) << asio.ns_per_byte()
+			<< std::setw(18) << native.allocs_per_msg() << std::setw(16) << asio.allocs_per_msg() << std::endl;
+	}
+
+	std::cout << std::endl << "native faster in " << faster << " of " << compared << " scenarios" << std::endl;
+
+	if( !csv.empty() )
+	{
+		std::ofstream out(csv.c_str());
+		out << "impl,block,sessions,threads,ok,msgs,bytes,mib_s,cpu_ms,ns_per_byte,allocs,allocs_per_msg\n";
+		for(std::size_t i = 0; i != scenarios.size(); ++i)
+		{
+			for(std::uint32_t j = 0; j != IMPL_CNT; ++j)
+			{
+				const scenario_t &sc = scenarios[i];
+				const result_t &r = results[i * IMPL_CNT + j];
+				out << impls[j].name_ << "," << sc.block_ << "," << sc.sessions_ << "," << sc.threads_ << ","
+					<< (r.ok_ ? 1 : 0) << "," << r.msgs_ << "," << r.bytes_ << "," << r.mib_s(seconds) << ","
+					<< r.cpu_ms_ << "," << r.ns_per_byte() << "," << r.allocs_ << "," << r.allocs_per_msg() << "\n";
+			}
+		}
+	}
+
+	::WSACleanup();
+	return 0;
+}
@@ -0,0 +1,734 @@
+// loadgen.cpp : ѹӳͳ
+//
+// loadgen s <port> <threads>
+//		Է񣬶ʲôдʲô
+// loadgen c <ip> <port> <connections> <threads> <seconds> <rate> <depth> <sizes> [json]
+//		rateΪÿ0Ϊջ(ÿӱdepth;)
+//		sizesΪСֲfixed:N | uniform:MIN:MAX | exp:MEAN:MAX | bimodal:SMALL:LARGE:LARGE_PERCENT
+// loadgen loopback [json]
+//		Է񣬰̶ĳѹ⣬ڰ汾Ա
+//
+
+#include "stdafx.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include <async_io/network.hpp>
+#include <memory_pool/sgi_memory_pool.hpp>
+#include <utility/histogram.hpp>
+
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+
+
+using namespace async;
+
+
+memory_pool::mt_memory_pool pool;
+
+std::uint64_t now_us()
+{
+	static LARGE_INTEGER freq = {0};
+	if( freq.QuadPart == 0 )
+		::QueryPerformanceFrequency(&freq);
+
+	LARGE_INTEGER counter = {0};
+	::QueryPerformanceCounter(&counter);
+	return counter.QuadPart / freq.QuadPart * 1000000 + counter.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart;
+}
+
+
+// -------------------------------------------------
+// Сֲ
+
+struct size_dist_t
+{
+	enum kind_t { FIXED, UNIFORM, EXP, BIMODAL };
+
+	kind_t kind_;
+	std::uint32_t a_;
+	std::uint32_t b_;
+	std::uint32_t percent_;
+	std::string text_;
+
+	size_dist_t()
+		: kind_(FIXED)
+		, a_(64)
+		, b_(64)
+		, percent_(0)
+		, text_("fixed:64")
+	{}
+
+	static bool parse(const std::string &text, size_dist_t &dist)
+	{
+		std::vector<std::string> parts;
+		std::istringstream is(text);
+		for(std::string part; std::getline(is, part, ':'); )
+			parts.push_back(part);
+
+		if( parts.empty() )
+			return false;
+
+		std::vector<std::uint32_t> vals;
+		for(std::size_t i = 1; i != parts.size(); ++i)
+			vals.push_back(static_cast<std::uint32_t>(std::strtoul(parts[i].c_str(), nullptr, 10)));
+
+		dist.text_ = text;
+		if( parts[0] == "fixed" && vals.size() == 1 )
+		{
+			dist.kind_ = FIXED;
+			dist.a_ = dist.b_ = vals[0];
+		}
+		else if( parts[0] == "uniform" && vals.size() == 2 && vals[0] <= vals[1] )
+		{
+			dist.kind_ = UNIFORM;
+			dist.a_ = vals[0];
+			dist.b_ = vals[1];
+		}
+		else if( parts[0] == "exp" && vals.size() == 2 && vals[0] <= vals[1] )
+		{
+			dist.kind_ = EXP;
+			dist.a_ = vals[0];
+			dist.b_ = vals[1];
+		}
+		else if( parts[0] == "bimodal" && vals.size() == 3 && vals[2] <= 100 )
+		{
+			dist.kind_ = BIMODAL;
+			dist.a_ = vals[0];
+			dist.b_ = vals[1];
+			dist.percent_ = vals[2];
+		}
+		else
+			return false;
+
+		return dist.a_ != 0 && dist.b_ != 0;
+	}
+
+	std::uint32_t upper() const
+	{
+		return std::max(a_, b_);
+	}
+
+	template < typename RandomT >
+	std::uint32_t operator()(RandomT &rng) const
+	{
+		switch( kind_ )
+		{
+		case UNIFORM:
+			return std::uniform_int_distribution<std::uint32_t>(a_, b_)(rng);
+		case EXP:
+			{
+				const double val = std::exponential_distribution<double>(1.0 / a_)(rng);
+				return std::min(std::max(static_cast<std::uint32_t>(val), 1U), b_);
+			}
+		case BIMODAL:
+			return std::uniform_int_distribution<std::uint32_t>(0, 99)(rng) < percent_ ? b_ : a_;
+		default:
+			return a_;
+		}
+	}
+};
+
+
+// -------------------------------------------------
+// ÿIO߳һֱͼ¼ϲ
+
+class recorder_t
+{
+	static std::atomic<std::uint32_t> next_id_;
+
+	const std::uint32_t id_;
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<utility::histogram_t>> histograms_;
+
+public:
+	recorder_t()
+		: id_(++next_id_)
+	{}
+
+	void record(std::uint64_t latency)
+	{
+		// ֲ߳̾recorderidһѹµָ벻ᱻ
+		static __declspec(thread) std::uint32_t local_id = 0;
+		static __declspec(thread) utility::histogram_t *local = nullptr;
+
+		if( local_id != id_ )
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			histograms_.emplace_back(new utility::histogram_t);
+			local = histograms_.back().get();
+			local_id = id_;
+		}
+
+		local->record(latency);
+	}
+
+	// IOֹ߳ͣ
+	utility::histogram_t merge()
+	{
+		utility::histogram_t total;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for(auto &val : histograms_)
+			total.merge(*val);
+
+		return total;
+	}
+};
+
+std::atomic<std::uint32_t> recorder_t::next_id_(0);
+
+
+// -------------------------------------------------
+// ѹ
+
+struct config_t
+{
+	std::string name_;
+	std::string ip_;
+	std::uint16_t port_;
+	std::uint32_t connections_;
+	std::uint32_t threads_;
+	std::uint32_t seconds_;
+	std::uint32_t warmup_;		// 룬ʱڷ󲻼
+	std::uint64_t rate_;		// /룬0Ϊջ
+	std::uint32_t depth_;
+	size_dist_t sizes_;
+	std::uint32_t seed_;
+
+	config_t()
+		: port_(5060)
+		, connections_(100)
+		, threads_(0)
+		, seconds_(10)
+		, warmup_(1)
+		, rate_(0)
+		, depth_(1)
+		, seed_(20130101)
+	{}
+};
+
+struct result_t
+{
+	std::uint32_t connected_;
+	std::uint32_t errors_;
+	std::uint64_t requests_;
+	std::uint64_t bytes_;
+	double seconds_;
+	utility::histogram_t latency_;
+};
+
+
+// ӦȳۼֽжϵڼأҪķ֡
+struct shared_state_t
+{
+	const config_t &config_;
+	recorder_t recorder_;
+	std::vector<char> pattern_;		// ޹ؽҪӹ
+
+	std::atomic<bool> running_;
+	std::uint64_t measure_start_;
+	std::uint64_t interval_;		// ʱӵus
+
+	shared_state_t(const config_t &config)
+		: config_(config)
+		, pattern_(std::max<std::uint32_t>(config.sizes_.upper(), 64 * 1024), 'p')
+		, running_(false)
+		, measure_start_(0)
+		, interval_(0)
+	{
+		if( config.rate_ != 0 )
+			interval_ = std::max<std::uint64_t>(config.connections_ * 1000000ULL / config.rate_, 1);
+	}
+};
+
+
+// -------------------------------------------------
+// class connection_t
+
+class connection_t
+{
+	struct request_t
+	{
+		std::uint64_t end_;		// ֮ǰ()ۼֽ
+		std::uint64_t start_;	// ƻʱ䡣±depthסĵȴҲӳ
+		std::uint32_t size_;
+	};
+
+	shared_state_t &state_;
+	network::client client_;
+	std::mt19937 rng_;
+
+	std::mutex mutex_;
+	std::deque<request_t> inflight_;
+	std::uint64_t sent_total_;
+	std::uint64_t recv_total_;
+	std::uint64_t unsent_;			// Ŷӻûsendֽ
+	bool sending_;
+	std::uint64_t next_due_;
+
+	std::vector<char> read_buf_;
+
+public:
+	std::atomic<bool> closed_;
+	std::uint64_t completed_;		// ͳƵ
+	std::uint64_t bytes_;
+
+public:
+	connection_t(shared_state_t &state, service::io_dispatcher_t &io, std::uint32_t index)
+		: state_(state)
+		, client_(io)
+		, rng_(state.config_.seed_ + index)
+		, sent_total_(0)
+		, recv_total_(0)
+		, unsent_(0)
+		, sending_(false)
+		, next_due_(0)
+		, read_buf_(16 * 1024)
+		, closed_(false)
+		, completed_(0)
+		, bytes_(0)
+	{
+		client_.register_disconnect_handler([this]()
+		{
+			closed_ = true;
+		});
+		client_.register_error_handler([](const std::string &)
+		{
+		});
+	}
+
+	bool connect()
+	{
+		return client_.start(state_.config_.ip_, state_.config_.port_);
+	}
+
+	void stop()
+	{
+		client_.stop();
+	}
+
+	void start(std::uint64_t now)
+	{
+		read();
+
+		std::uint32_t size = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if( state_.interval_ == 0 )
+			{
+				for(std::uint32_t i = 0; i != state_.config_.depth_; ++i)
+					_issue(now);
+			}
+			else
+			{
+				// λͬʱ
+				next_due_ = now + rng_() % state_.interval_;
+			}
+
+			size = _take_send();
+		}
+
+		_send(size);
+	}
+
+	// ߳ڵ
+	void pump(std::uint64_t now)
+	{
+		if( closed_ )
+			return;
+
+		std::uint32_t size = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			_issue_due(now);
+			size = _take_send();
+		}
+
+		_send(size);
+	}
+
+	std::size_t inflight()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return inflight_.size();
+	}
+
+private:
+	void _issue(std::uint64_t start)
+	{
+		const std::uint32_t size = state_.config_.sizes_(rng_);
+
+		sent_total_ += size;
+		unsent_ += size;
+
+		request_t req = { sent_total_, start, size };
+		inflight_.push_back(req);
+	}
+
+	void _issue_due(std::uint64_t now)
+	{
+		while( state_.running_ && next_due_ <= now && inflight_.size() < state_.config_.depth_ )
+		{
+			_issue(next_due_);
+			next_due_ += state_.interval_;
+		}
+	}
+
+	// ͬһʱֻһsend;Ŷӵϲʱ0ʾҪ
+	std::uint32_t _take_send()
+	{
+		if( sending_ || unsent_ == 0 )
+			return 0;
+
+		const std::uint32_t size = static_cast<std::uint32_t>(std::min<std::uint64_t>(unsent_, state_.pattern_.size()));
+		unsent_ -= size;
+		sending_ = true;
+		return size;
+	}
+
+	// Ϳɲڵǰ̻߳صܳ
+	void _send(std::uint32_t size)
+	{
+		if( size == 0 )
+			return;
+
+		client_.async_send(service::const_buffer_t(state_.pattern_.data(), size), [this](std::uint32_t)
+		{
+			std::uint32_t size = 0;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				sending_ = false;
+				size = _take_send();
+			}
+
+			_send(size);
+		}, pool);
+	}
+
+	void read()
+	{
+		service::mutable_buffer_t buf(read_buf_.data(), read_buf_.size());
+		client_.async_read_some(buf, 0, [this](std::uint32_t size)
+		{
+			_on_read(size);
+		}, pool);
+	}
+
+	void _on_read(std::uint32_t size)
+	{
+		const std::uint64_t now = now_us();
+		std::uint32_t send_size = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			recv_total_ += size;
+			std::uint32_t done = 0;
+			while( !inflight_.empty() && inflight_.front().end_ <= recv_total_ )
+			{
+				const request_t &req = inflight_.front();
+				if( req.start_ >= state_.measure_start_ && state_.running_ )
+				{
+					state_.recorder_.record(now > req.start_ ? now - req.start_ : 0);
+					++completed_;
+					bytes_ += req.size_;
+				}
+
+				inflight_.pop_front();
+				++done;
+			}
+
+			if( state_.interval_ == 0 )
+			{
+				for(std::uint32_t i = 0; i != done && state_.running_; ++i)
+					_issue(now);
+			}
+			else
+				_issue_due(now);
+
+			send_size = _take_send();
+		}
+
+		_send(send_size);
+		read();
+	}
+};
+
+
+// -------------------------------------------------
+
+result_t run(const config_t &config)
+{
+	result_t result = {0};
+
+	shared_state_t state(config);
+	service::io_dispatcher_t io([](const std::string &msg){ std::cerr << msg << std::endl; },
+		config.threads_ == 0 ? service::get_fit_thread_num() : config.threads_);
+
+	std::vector<std::unique_ptr<connection_t>> connections;
+	for(std::uint32_t i = 0; i != config.connections_; ++i)
+	{
+		std::unique_ptr<connection_t> conn(new connection_t(state, io, i));
+		if( !conn->connect() )
+		{
+			++result.errors_;
+			continue;
+		}
+
+		connections.push_back(std::move(conn));
+	}
+	result.connected_ = static_cast<std::uint32_t>(connections.size());
+
+	const std::uint64_t start = now_us();
+	state.measure_start_ = start + config.warmup_ * 1000000ULL;
+	state.running_ = true;
+
+	for(auto &conn : connections)
+		conn->start(start);
+
+	const std::uint64_t end = state.measure_start_ + config.seconds_ * 1000000ULL;
+	if( config.rate_ != 0 )
+	{
+		::timeBeginPeriod(1);
+		while( now_us() < end )
+		{
+			const std::uint64_t now = now_us();
+			for(auto &conn : connections)
+				conn->pump(now);
+
+			::Sleep(1);
+		}
+		::timeEndPeriod(1);
+	}
+	else
+	{
+		::Sleep(static_cast<DWORD>((end - start) / 1000));
+	}
+
+	// 󷵻صټ룬ȴ;ſպٶϿ
+	state.running_ = false;
+	const std::uint64_t stopped = now_us();
+	for(auto &conn : connections)
+	{
+		while( !conn->closed_ && conn->inflight() != 0 && now_us() - stopped < 5000000 )
+			::Sleep(1);
+	}
+
+	for(auto &conn : connections)
+	{
+		if( conn->closed_ )
+			++result.errors_;
+
+		result.requests_ += conn->completed_;
+		result.bytes_ += conn->bytes_;
+		conn->stop();
+	}
+
+	io.stop();
+
+	result.seconds_ = static_cast<double>(std::min(stopped, end) - state.measure_start_) / 1000000.0;
+	result.latency_ = state.recorder_.merge();
+	return result;
+}
+
+std::string to_json(const config_t &config, const result_t &result)
+{
+	const utility::histogram_t &lat = result.latency_;
+	const double seconds = result.seconds_ > 0 ? result.seconds_ : 1;
+
+	std::ostringstream os;
+	os << "{\"name\":\"" << config.name_ << "\""
+		<< ",\"connections\":" << config.connections_
+		<< ",\"connected\":" << result.connected_
+		<< ",\"threads\":" << config.threads_
+		<< ",\"rate\":" << config.rate_
+		<< ",\"depth\":" << config.depth_
+		<< ",\"sizes\":\"" << config.sizes_.text_ << "\""
+		<< ",\"seed\":" << config.seed_
+		<< ",\"seconds\":" << seconds
+		<< ",\"requests\":" << result.requests_
+		<< ",\"errors\":" << result.errors_
+		<< ",\"throughput_rps\":" << static_cast<std::uint64_t>(result.requests_ / seconds)
+		<< ",\"throughput_mib_s\":" << result.bytes_ * 2 / seconds / (1024 * 1024)
+		<< ",\"latency_us\":{"
+		<< "\"min\":" << lat.min()
+		<< ",\"mean\":" << lat.mean()
+		<< ",\"p50\":" << lat.percentile(50)
+		<< ",\"p90\":" << lat.percentile(90)
+		<< ",\"p99\":" << lat.percentile(99)
+		<< ",\"p999\":" << lat.percentile(99.9)
+		<< ",\"max\":" << lat.max()
+		<< "}}";
+
+	return os.str();
+}
+
+void output(const std::vector<std::string> &results, const char *file)
+{
+	std::ostringstream os;
+	os << "[\n";
+	for(std::size_t i = 0; i != results.size(); ++i)
+		os << "  " << results[i] << (i + 1 == results.size() ? "\n" : ",\n");
+	os << "]\n";
+
+	std::cout << os.str();
+	if( file != nullptr )
+	{
+		std::ofstream out(file);
+		out << os.str();
+	}
+}
+
+
+// -------------------------------------------------
+// Է
+
+void echo(const network::session_ptr &session, const std::shared_ptr<std::vector<char>> &buffer)
+{
+	service::mutable_buffer_t buf(buffer->data(), buffer->size());
+	session->async_read_some(buf, 0, [buffer](const network::session_ptr &session, std::uint32_t size)
+	{
+		session->async_write(service::const_buffer_t(buffer->data(), size), [buffer](const network::session_ptr &session, std::uint32_t)
+		{
+			echo(session, buffer);
+		}, pool);
+	}, pool);
+}
+
+void start_echo(network::server &svr)
+{
+	svr.register_accept_handler([](const network::session_ptr &session, const std::string &)
+	{
+		session->get().set_option(network::no_delay(true));
+		echo(session, std::make_shared<std::vector<char>>(64 * 1024));
+		return true;
+	});
+	svr.register_error_handler([](const network::session_ptr &, const std::string &)
+	{
+	});
+
+	svr.start();
+}
+
+
+// -------------------------------------------------
+
+int usage()
+{
+	std::cerr << "usage: loadgen s <port> <threads>" << std::endl
+		<< "       loadgen c <ip> <port> <connections> <threads> <seconds> <rate> <depth> <sizes> [json]" << std::endl
+		<< "       loadgen loopback [json]" << std::endl;
+	return -1;
+}
+
+int loopback(const char *file)
+{
+	const std::uint16_t port = 5060;
+
+	network::server svr(port, 2);
+	start_echo(svr);
+
+	struct scenario_t
+	{
+		const char *name_;
+		std::uint32_t connections_;
+		std::uint64_t rate_;
+		std::uint32_t depth_;
+		const char *sizes_;
+	};
+
+	// ޸ĳʹɱȣֻӲ޸
+	static const scenario_t scenarios[] =
+	{
+		{ "closed_1c_d1_64",		1,		0,		1,	"fixed:64" },
+		{ "closed_64c_d1_64",		64,		0,		1,	"fixed:64" },
+		{ "closed_64c_d16_64",		64,		0,		16,	"fixed:64" },
+		{ "closed_64c_d4_exp",		64,		0,		4,	"exp:1024:65536" },
+		{ "closed_16c_d1_64k",		16,		0,		1,	"fixed:65536" },
+		{ "open_1000c_20k_bimodal",	1000,	20000,	8,	"bimodal:128:16384:5" },
+		{ "open_4000c_50k_64",		4000,	50000,	4,	"fixed:64" },
+	};
+
+	std::vector<std::string> results;
+	for(auto &val : scenarios)
+	{
+		config_t config;
+		config.name_ = val.name_;
+		config.ip_ = "127.0.0.1";
+		config.port_ = port;
+		config.connections_ = val.connections_;
+		config.threads_ = 2;
+		config.seconds_ = 10;
+		config.rate_ = val.rate_;
+		config.depth_ = val.depth_;
+		size_dist_t::parse(val.sizes_, config.sizes_);
+
+		std::cerr << "running " << val.name_ << std::endl;
+		results.push_back(to_json(config, run(config)));
+	}
+
+	svr.stop();
+
+	output(results, file);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if( argc < 2 )
+		return usage();
+
+	const std::string mode = argv[1];
+	if( mode == "s" )
+	{
+		if( argc < 4 )
+			return usage();
+
+		network::server svr(static_cast<std::uint16_t>(std::atoi(argv[2])), std::atoi(argv[3]));
+		start_echo(svr);
+
+		std::cin.get();
+		svr.stop();
+		return 0;
+	}
+	else if( mode == "c" )
+	{
+		if( argc < 10 )
+			return usage();
+
+		config_t config;
+		config.name_ = "custom";
+		config.ip_ = argv[2];
+		config.port_ = static_cast<std::uint16_t>(std::atoi(argv[3]));
+		config.connections_ = std::atoi(argv[4]);
+		config.threads_ = std::atoi(argv[5]);
+		config.seconds_ = std::atoi(argv[6]);
+		config.rate_ = std::strtoull(argv[7], nullptr, 10);
+		config.depth_ = std::max(std::atoi(argv[8]), 1);
+		if( !size_dist_t::parse(argv[9], config.sizes_) )
+			return usage();
+
+		std::vector<std::string> results(1, to_json(config, run(config)));
+		output(results, argc > 10 ? argv[10] : nullptr);
+		return 0;
+	}
+	else if( mode == "loopback" )
+	{
+		return loopback(argc > 2 ? argv[2] : nullptr);
+	}
+
+	return usage();
+}
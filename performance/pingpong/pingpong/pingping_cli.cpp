@@ -3,6 +3,10 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <list>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 
 #include <async_io/network.hpp>
 #include "handler_allocator.hpp"
@@ -149,9 +153,6 @@ void client_start(char **argv)
 	std::list<session_t *> sessions;
 
 	service::io_dispatcher_t io([](const std::string &msg){ std::cout << msg << std::endl;}, thr_cnt);
-	service::io_dispatcher_t timer_io([](const std::string &){}, 1);
-
-	timer::win_timer_service_t timer_svr(timer_io);
 
 	for(auto i = 0; i != session_cnt; ++i)
 	{
@@ -159,28 +160,6 @@ void client_start(char **argv)
 		sessions.push_back(session);
 	}
 
-	timer::timer_handle timer(timer_svr, std::chrono::minutes(timeout), std::chrono::seconds(0), 
-		[&sessions, &io]()
-	{
-		/*std::for_each(sessions.begin(), sessions.end(), 
-		[](session_t *s)
-		{
-		io.post([](const std::error_code &, std::uint32_t)
-		{
-		s->stop();
-		delete s;
-		});
-
-		});*/
-
-		io.stop();
-
-		sessions.clear();
-		std::cout << "press any key exit..." << std::endl;
-	});
-
-	timer.async_wait();
-
 	std::allocator<char> allocator;
 	std::for_each(sessions.begin(), sessions.end(), 
 		[ip, port, &io, &allocator](session_t *session)
@@ -188,9 +167,17 @@ void client_start(char **argv)
 		io.post(std::bind(&session_t::start, session, ip, port), allocator);
 	});
 
-	std::cin.get();
-	timer.cancel();
-	timer_svr.stop();
-	stats.print(timeout);
+	// ʱԶbench_compareֵص
+	std::this_thread::sleep_for(std::chrono::seconds(timeout));
 
-}
\ No newline at end of file
+	// ͣIO߳sessionʱܸԵĶ
+	io.stop();
+	std::for_each(sessions.begin(), sessions.end(), [](session_t *session)
+	{
+		session->stop();
+		delete session;
+	});
+	sessions.clear();
+
+	stats.print(timeout);
+}
@@ -5,12 +5,13 @@
 #include <iostream>
 #include "pingpong_svr.hpp"
 #include "pingpong_cli.hpp"
+#include "../alloc_counter.hpp"
 
 int main(int argc, char* argv[])
 {
 	if( *argv[1] == 's' )
 	{
-		if( argc < 4 )
+		if( argc < 5 )
 		{
 			std::cerr << "usage: <s> <port> <threads> <block_size>" << std::endl;
 			return -1;
@@ -20,15 +21,17 @@ int main(int argc, char* argv[])
 	}
 	else if( *argv[1] == 'c' )
 	{
-		if( argc < 4 )
+		if( argc < 8 )
 		{
-			std::cerr << "usage: <c> <ip> <port> <sessions> <threads> <block_size> <timeout>" << std::endl;
+			std::cerr << "usage: <c> <ip> <port> <sessions> <threads> <block_size> <seconds>" << std::endl;
 			return -1;
 		}
 
 		client_start(argv + 2);
 	}
 
+	alloc_counter::print();
+
 	system("pause");
 	return 0;
 }
@@ -0,0 +1,516 @@
+// file_engine_test.cpp : direct (NO_BUFFERING) file io through the completion port; batch round trip, 4K random read IOPS, chunked sequential pipeline, mapped reads, coalesced change notifications and write-ahead log group commit
+//
+
+#include "stdafx.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "../../../include/async_io/file/file_engine.hpp"
+#include "../../../include/async_io/file/file_pipeline.hpp"
+#include "../../../include/async_io/file/mapped_file.hpp"
+#include "../../../include/async_io/file/file_monitor.hpp"
+#include "../../../include/async_io/file/wal.hpp"
+#include "../../../include/async_io/service/clock.hpp"
+#include "../../../include/serialize/serialize.hpp"
+#include "../../../include/memory_pool/sgi_memory_pool.hpp"
+
+
+using namespace async;
+
+
+const std::uint32_t BLOCK = 4096;
+
+memory_pool::mt_memory_pool pool;
+
+
+// ȴ첽ص
+struct waiter_t
+{
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	bool done_;
+
+	waiter_t()
+		: done_(false)
+	{}
+
+	void notify()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		done_ = true;
+		cond_.notify_all();
+	}
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		cond_.wait(lock, [this]() { return done_; });
+		done_ = false;
+	}
+};
+
+
+void fill(char *data, std::uint32_t block)
+{
+	std::uint32_t *p = reinterpret_cast<std::uint32_t *>(data);
+	for(std::uint32_t i = 0; i != BLOCK / sizeof(std::uint32_t); ++i)
+		p[i] = block * 2654435761U + i;
+}
+
+bool verify(const char *data, std::uint32_t block)
+{
+	const std::uint32_t *p = reinterpret_cast<const std::uint32_t *>(data);
+	for(std::uint32_t i = 0; i != BLOCK / sizeof(std::uint32_t); ++i)
+	{
+		if( p[i] != block * 2654435761U + i )
+			return false;
+	}
+
+	return true;
+}
+
+
+// дcount飬У
+bool round_trip(filesystem::file_engine_t &file, std::uint32_t count)
+{
+	filesystem::aligned_buffer_pool_t buffers(BLOCK, count * 2, true);
+	std::vector<filesystem::file_request_t> reqs(count);
+	waiter_t waiter;
+
+	for(std::uint32_t i = 0; i != count; ++i)
+	{
+		filesystem::file_request_t req = { i * std::uint64_t(BLOCK), buffers.allocate(), BLOCK, 0 };
+		fill(req.data_, i);
+		reqs[i] = req;
+	}
+
+	std::uint32_t written = 0;
+	file.async_write(reqs.data(), count, [&](const std::error_code &error, std::uint32_t cnt)
+	{
+		written = cnt;
+		waiter.notify();
+	}, pool);
+	waiter.wait();
+
+	std::vector<char *> write_blocks;
+	for(std::uint32_t i = 0; i != count; ++i)
+		write_blocks.push_back(reqs[i].data_);
+
+	std::vector<std::uint32_t> order(count);
+	for(std::uint32_t i = 0; i != count; ++i)
+		order[i] = i;
+	std::shuffle(order.begin(), order.end(), std::mt19937(count));
+
+	for(std::uint32_t i = 0; i != count; ++i)
+	{
+		filesystem::file_request_t req = { order[i] * std::uint64_t(BLOCK), buffers.allocate(), BLOCK, 0 };
+		std::memset(req.data_, 0, BLOCK);
+		reqs[i] = req;
+	}
+
+	std::uint32_t read = 0;
+	file.async_read(reqs.data(), count, [&](const std::error_code &error, std::uint32_t cnt)
+	{
+		read = cnt;
+		waiter.notify();
+	}, pool);
+	waiter.wait();
+
+	bool ok = written == count && read == count;
+	for(std::uint32_t i = 0; i != count; ++i)
+	{
+		ok = ok && reqs[i].size_ == BLOCK && verify(reqs[i].data_, order[i]);
+		buffers.deallocate(reqs[i].data_);
+		buffers.deallocate(write_blocks[i]);
+	}
+
+	std::cout << "batch round trip: " << (ok ? "ok" : "failed") << ", blocks: " << count
+		<< (buffers.is_locked() ? ", locked buffers" : "") << std::endl;
+	return ok;
+}
+
+// δ쳣ԽļβĶԴ
+bool boundaries(filesystem::file_engine_t &file)
+{
+	std::vector<char, filesystem::aligned_allocator_t<char>> buffer(BLOCK * 2);
+
+	bool unaligned = false;
+	try
+	{
+		service::mutable_buffer_t buf(buffer.data() + 1, BLOCK);
+		file.async_read(buf, 0, [](const std::error_code &, std::uint32_t) {}, pool);
+	}
+	catch(const exception::exception_base &)
+	{
+		unaligned = true;
+	}
+
+	waiter_t waiter;
+	std::error_code eof;
+	std::uint32_t eof_size = ~0U;
+	service::mutable_buffer_t buf(buffer.data(), BLOCK);
+	file.async_read(buf, file.size() + BLOCK, [&](const std::error_code &error, std::uint32_t size)
+	{
+		eof = error;
+		eof_size = size;
+		waiter.notify();
+	}, pool);
+	waiter.wait();
+
+	const bool ok = unaligned && eof && eof_size == 0;
+	std::cout << "boundaries: " << (ok ? "ok" : "failed") << std::endl;
+	return ok;
+}
+
+
+// ÿλƫͶһdepth;
+struct random_reader_t
+{
+	filesystem::file_engine_t &file_;
+	filesystem::aligned_buffer_pool_t buffers_;
+	std::uint64_t blocks_;
+	std::uint64_t deadline_;
+	std::atomic<std::uint64_t> reads_;
+	std::atomic<std::uint32_t> outstanding_;
+	std::atomic<std::uint32_t> errors_;
+	waiter_t done_;
+
+	random_reader_t(filesystem::file_engine_t &file, std::uint32_t depth, std::uint64_t blocks)
+		: file_(file)
+		, buffers_(BLOCK, depth, true)
+		, blocks_(blocks)
+		, deadline_(0)
+		, reads_(0)
+		, outstanding_(0)
+		, errors_(0)
+	{}
+
+	void run(std::uint32_t depth, std::uint32_t seconds)
+	{
+		deadline_ = service::monotonic_us() + seconds * 1000000ULL;
+		outstanding_ = depth;
+
+		for(std::uint32_t i = 0; i != depth; ++i)
+			_read(buffers_.allocate(), i);
+
+		done_.wait();
+	}
+
+	void _read(char *data, std::uint32_t seed)
+	{
+		// 򵥵ͬ࣬صмȡ
+		const std::uint64_t block = (std::uint64_t(seed) * 6364136223846793005ULL + 1442695040888963407ULL) % blocks_;
+
+		service::mutable_buffer_t buf(data, BLOCK);
+		file_.async_read(buf, block * BLOCK, [this, data, seed](const std::error_code &error, std::uint32_t size)
+		{
+			if( error || size != BLOCK )
+				++errors_;
+
+			const std::uint64_t cnt = ++reads_;
+			if( service::monotonic_us() < deadline_ && !error )
+			{
+				_read(data, seed + static_cast<std::uint32_t>(cnt));
+				return;
+			}
+
+			buffers_.deallocate(data);
+			if( --outstanding_ == 0 )
+				done_.notify();
+		}, pool);
+	}
+};
+
+void random_read(filesystem::file_engine_t &file, std::uint64_t blocks, std::uint32_t depth, std::uint32_t seconds)
+{
+	random_reader_t reader(file, depth, blocks);
+
+	const std::uint64_t start = service::monotonic_us();
+	reader.run(depth, seconds);
+	const std::uint64_t elapsed = service::monotonic_us() - start;
+
+	std::cout << "random 4K read, depth " << depth << ": " << reader.reads_ * 1000000 / elapsed << " IOPS"
+		<< ", errors: " << reader.errors_ << std::endl;
+}
+
+
+// ˳ļУ飬ԱȲͬ;
+void pipeline_read(filesystem::file_engine_t &file, std::uint32_t chunk_size, std::uint32_t depth)
+{
+	auto pipeline = std::make_shared<filesystem::file_pipeline_t>(file, chunk_size, depth);
+
+	waiter_t waiter;
+	bool ok = true;
+	std::error_code result;
+	filesystem::file_pipeline_stats_t stats = {0};
+
+	pipeline->start(0, ~0ULL, [&](const filesystem::file_chunk_t &chunk)
+	{
+		const std::uint32_t first = static_cast<std::uint32_t>(chunk.offset_ / BLOCK);
+		for(std::uint32_t i = 0; i != chunk.size_ / BLOCK; ++i)
+			ok = ok && verify(chunk.data_ + i * BLOCK, first + i);
+
+		pipeline->release();
+	}, [&](const std::error_code &error, const filesystem::file_pipeline_stats_t &val)
+	{
+		result = error;
+		stats = val;
+		waiter.notify();
+	});
+	waiter.wait();
+
+	std::cout << "pipeline, chunk " << chunk_size / 1024 << "K, depth " << depth << ": "
+		<< (ok && !result ? "ok" : "failed") << ", " << stats.throughput_ / (1024 * 1024) << " MiB/s"
+		<< ", avg depth: " << stats.avg_depth_ << ", max ready: " << stats.max_ready_ << std::endl;
+}
+
+
+// ӳļ̳߳ԤȡлֶζУ飬εReadFile
+void mapped_read(service::io_dispatcher_t &io, const std::wstring &path)
+{
+	filesystem::mapped_file_t file(io, path, filesystem::mapped_file_t::READ | filesystem::mapped_file_t::SEQUENTIAL);
+
+	waiter_t waiter;
+	std::error_code result;
+	std::uint64_t prefetched = 0;
+
+	const std::uint64_t start = service::monotonic_us();
+	file.async_prefetch(0, 0, [&](const std::error_code &error, std::uint64_t size)
+	{
+		result = error;
+		prefetched = size;
+		waiter.notify();
+	}, pool);
+	waiter.wait();
+	const std::uint64_t elapsed = service::monotonic_us() - start + 1;
+
+	serialize::mapped_serialize ser(file);
+
+	bool ok = !result && prefetched == file.size();
+	const std::uint32_t count = static_cast<std::uint32_t>(std::min<std::uint64_t>(file.size(), 64 * 1024 * 1024) / BLOCK);
+	for(std::uint32_t i = 0; i != count && ok; ++i)
+	{
+		for(std::uint32_t j = 0; j != BLOCK / sizeof(std::uint32_t); ++j)
+		{
+			std::uint32_t val = 0;
+			ser >> val;
+			ok = ok && val == i * 2654435761U + j;
+		}
+	}
+
+	file.advise(0, 0, filesystem::mapped_file_t::DONT_NEED);
+
+	std::cout << "mapped prefetch: " << (ok ? "ok" : "failed") << ", "
+		<< prefetched * 1000000 / elapsed / (1024 * 1024) << " MiB/s" << std::endl;
+}
+
+
+// ڶͬһļĴдֻӦõһ֪ͨ
+void monitor_coalesce(service::io_dispatcher_t &io, const std::wstring &dir)
+{
+	const std::wstring sub_dir = dir + L"file_monitor_test";
+	::CreateDirectoryW(sub_dir.c_str(), nullptr);
+
+	auto monitor = std::make_shared<filesystem::change_monitor>(io, sub_dir);
+	monitor->set_coalesce_window(200);
+
+	std::mutex mutex;
+	std::uint32_t notifies = 0;
+	std::uint32_t action = 0;
+	monitor->monitor([&](const std::error_code &error, std::uint32_t val, const std::wstring &path)
+	{
+		if( error || path != L"data.bin" )
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		++notifies;
+		action = val;
+	});
+
+	const std::wstring path = sub_dir + L"\\data.bin";
+	const std::uint32_t writes = 1000;
+	HANDLE file = ::CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	char block[BLOCK] = {0};
+	for(std::uint32_t i = 0; i != writes; ++i)
+	{
+		DWORD written = 0;
+		::WriteFile(file, block, BLOCK, &written, nullptr);
+	}
+	::CloseHandle(file);
+
+	::Sleep(1000);
+	monitor->close();
+
+	::DeleteFileW(path.c_str());
+	::RemoveDirectoryW(sub_dir.c_str());
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::cout << "monitor coalesce: " << (notifies == 1 && action == FILE_ACTION_ADDED ? "ok" : "failed")
+		<< ", " << writes << " writes, " << notifies << " notifies" << std::endl;
+}
+
+// ߳ͬʱ׷ӣÿȵ̲ύ´򿪺replayӦȫ¼
+void wal_group_commit(service::io_dispatcher_t &io, const std::wstring &dir)
+{
+	const std::wstring wal_dir = dir + L"wal_test";
+	const std::uint32_t threads = 8;
+	const std::uint32_t count = 50000;
+
+	std::atomic<std::uint32_t> committed(0);
+	std::atomic<std::uint32_t> failed(0);
+	filesystem::wal_stats_t stats = {0};
+	std::uint64_t elapsed = 0;
+	{
+		filesystem::wal_t wal(io, wal_dir);
+
+		const std::uint64_t start = service::monotonic_us();
+		std::vector<std::thread> workers;
+		for(std::uint32_t i = 0; i != threads; ++i)
+		{
+			workers.emplace_back([&wal, &committed, &failed, i, count]()
+			{
+				char record[100] = {0};
+				for(std::uint32_t j = 0; j != count; ++j)
+				{
+					std::memcpy(record, &j, sizeof(j));
+					record[sizeof(j)] = static_cast<char>(i);
+					wal.append(record, sizeof(record), [&committed, &failed](const std::error_code &error, std::uint64_t)
+					{
+						if( error )
+							++failed;
+						else
+							++committed;
+					});
+				}
+			});
+		}
+
+		for(auto &worker : workers)
+			worker.join();
+		wal.flush();
+
+		elapsed = service::monotonic_us() - start + 1;
+		stats = wal.stats();
+	}
+
+	std::uint64_t replayed = 0;
+	{
+		filesystem::wal_t wal(io, wal_dir);
+		wal.replay([&replayed](std::uint64_t, const char *, std::uint32_t size)
+		{
+			if( size == 100 )
+				++replayed;
+		});
+		wal.remove_before(wal.durable_lsn());
+	}
+
+	// ļ
+	WIN32_FIND_DATAW data = {0};
+	HANDLE find = ::FindFirstFileW((wal_dir + L"\\*.wal").c_str(), &data);
+	if( find != INVALID_HANDLE_VALUE )
+	{
+		do
+		{
+			::DeleteFileW((wal_dir + L"\\" + data.cFileName).c_str());
+		} while( ::FindNextFileW(find, &data) );
+		::FindClose(find);
+	}
+	::RemoveDirectoryW(wal_dir.c_str());
+
+	const std::uint64_t total = std::uint64_t(threads) * count;
+	const bool ok = failed == 0 && committed == total && replayed == total;
+	std::cout << "wal group commit: " << (ok ? "ok" : "failed") << ", " << total * 1000000 / elapsed << " records/s"
+		<< ", " << stats.records_ / (stats.groups_ == 0 ? 1 : stats.groups_) << " records/write" << std::endl;
+}
+
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	// file_engine_test [file] [MiB]ĬʱĿ¼256MiBļ
+	wchar_t temp[MAX_PATH] = {0};
+	::GetTempPathW(MAX_PATH, temp);
+	const std::wstring path = argc > 1 ? argv[1] : std::wstring(temp) + L"file_engine_test.dat";
+	const std::uint64_t mib = argc > 2 ? _ttoi(argv[2]) : 256;
+	const std::uint64_t blocks = mib * 1024 * 1024 / BLOCK;
+
+	service::io_dispatcher_t io([](const std::string &msg)
+	{
+		std::cerr << msg << std::endl;
+	});
+
+	try
+	{
+		filesystem::file_engine_t file(io, path, filesystem::file_engine_t::READ
+			| filesystem::file_engine_t::WRITE
+			| filesystem::file_engine_t::CREATE
+			| filesystem::file_engine_t::DIRECT
+			| filesystem::file_engine_t::RANDOM);
+		std::cout << "sector size: " << file.alignment() << std::endl;
+
+		round_trip(file, 256);
+
+		// дļ֮Ч
+		if( file.size() < blocks * BLOCK )
+		{
+			file.set_size(blocks * BLOCK);
+			filesystem::aligned_buffer_pool_t buffers(BLOCK, 256);
+			for(std::uint64_t i = 0; i < blocks; i += buffers.count())
+			{
+				const std::uint32_t batch = static_cast<std::uint32_t>(std::min<std::uint64_t>(buffers.count(), blocks - i));
+				std::vector<filesystem::file_request_t> reqs(batch);
+				for(std::uint32_t j = 0; j != batch; ++j)
+				{
+					filesystem::file_request_t req = { (i + j) * BLOCK, buffers.allocate(), BLOCK, 0 };
+					fill(req.data_, static_cast<std::uint32_t>(i + j));
+					reqs[j] = req;
+				}
+
+				waiter_t waiter;
+				file.async_write(reqs.data(), batch, [&](const std::error_code &, std::uint32_t)
+				{
+					waiter.notify();
+				}, pool);
+				waiter.wait();
+
+				for(std::uint32_t j = 0; j != batch; ++j)
+					buffers.deallocate(reqs[j].data_);
+			}
+		}
+
+		boundaries(file);
+
+		random_read(file, blocks, 1, 3);
+		random_read(file, blocks, 32, 3);
+		random_read(file, blocks, 128, 3);
+
+		pipeline_read(file, 1024 * 1024, 1);
+		pipeline_read(file, 1024 * 1024, 8);
+
+		mapped_read(io, path);
+
+		monitor_coalesce(io, temp);
+
+		wal_group_commit(io, temp);
+	}
+	catch(const exception::exception_base &e)
+	{
+		e.dump();
+		std::cerr << e.what() << std::endl;
+	}
+
+	io.stop();
+	::DeleteFileW(path.c_str());
+
+	system("pause");
+	return 0;
+}
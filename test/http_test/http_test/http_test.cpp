@@ -0,0 +1,281 @@
+// http_test.cpp : keep-alive/pipelined HTTP load generator, reports req/s and p50/p99 latency
+//
+
+#include "stdafx.h"
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "../../../include/async_io/http/http_server.hpp"
+#include "../../../include/async_io/http/static_files.hpp"
+#include "../../../include/memory_pool/sgi_memory_pool.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+
+using namespace async;
+
+
+const std::uint16_t PORT = 5160;
+
+memory_pool::mt_memory_pool pool;
+
+std::uint64_t now_us()
+{
+	static LARGE_INTEGER freq = {0};
+	if( freq.QuadPart == 0 )
+		::QueryPerformanceFrequency(&freq);
+
+	LARGE_INTEGER counter = {0};
+	::QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000000 / freq.QuadPart;
+}
+
+
+// ÿηdepthˮȫӦٷһ
+struct connection_t
+{
+	network::client client_;
+	std::atomic<bool> &running_;
+	std::atomic<std::uint32_t> &outstanding_;
+
+	std::string requests_;
+	std::uint32_t depth_;
+	std::uint32_t left_;
+
+	std::vector<char> buffer_;
+	std::size_t end_;
+	bool in_body_;
+	std::size_t body_left_;
+
+	std::uint64_t start_;
+	std::uint64_t failed_;
+	std::vector<std::uint32_t> latencies_;
+
+	connection_t(service::io_dispatcher_t &io, const std::string &request, std::uint32_t depth,
+		std::atomic<bool> &running, std::atomic<std::uint32_t> &outstanding)
+		: client_(io)
+		, running_(running)
+		, outstanding_(outstanding)
+		, depth_(depth)
+		, left_(0)
+		, buffer_(64 * 1024)
+		, end_(0)
+		, in_body_(false)
+		, body_left_(0)
+		, start_(0)
+		, failed_(0)
+	{
+		for(std::uint32_t i = 0; i != depth; ++i)
+			requests_.append(request);
+
+		latencies_.reserve(1024 * 1024);
+
+		client_.register_disconnect_handler([this]()
+		{
+			if( left_ != 0 )
+			{
+				++failed_;
+				left_ = 0;
+				--outstanding_;
+			}
+		});
+	}
+
+	void send()
+	{
+		++outstanding_;
+
+		left_ = depth_;
+		start_ = now_us();
+		client_.async_send(service::const_buffer_t(requests_.data(), requests_.size()), [](std::uint32_t){}, pool);
+		read();
+	}
+
+	void read()
+	{
+		service::mutable_buffer_t buf(buffer_.data() + end_, buffer_.size() - end_);
+		client_.async_read_some(buf, 0, [this](std::uint32_t size)
+		{
+			end_ += size;
+			on_read();
+		}, pool);
+	}
+
+	void on_read()
+	{
+		static const char header_end[] = "\r\n\r\n";
+		static const char length_field[] = "Content-Length: ";
+
+		// ֻ棬ļӦŽ
+		std::size_t begin = 0;
+		for(;;)
+		{
+			if( !in_body_ )
+			{
+				const char *first = buffer_.data() + begin;
+				const char *last = buffer_.data() + end_;
+
+				const char *head = std::search(first, last, header_end, header_end + 4);
+				if( head == last )
+					break;
+
+				const char *field = std::search(first, head, length_field, length_field + sizeof(length_field) - 1);
+				body_left_ = field == head ? 0 : std::strtoul(field + sizeof(length_field) - 1, nullptr, 10);
+				in_body_ = true;
+				begin = head + 4 - buffer_.data();
+			}
+
+			const std::size_t size = std::min(body_left_, end_ - begin);
+			begin += size;
+			body_left_ -= size;
+			if( body_left_ != 0 )
+				break;
+
+			in_body_ = false;
+			latencies_.push_back(static_cast<std::uint32_t>(now_us() - start_));
+			--left_;
+		}
+
+		std::memmove(buffer_.data(), buffer_.data() + begin, end_ - begin);
+		end_ -= begin;
+
+		if( left_ != 0 )
+		{
+			read();
+			return;
+		}
+
+		--outstanding_;
+		if( running_ )
+			send();
+	}
+};
+
+
+void http_bench(const std::string &ip, std::uint16_t port, const std::string &uri, std::uint32_t connections, std::uint32_t depth, std::uint32_t seconds)
+{
+	service::io_dispatcher_t io([](const std::string &msg)
+	{
+		std::cerr << msg << std::endl;
+	});
+
+	std::atomic<bool> running(true);
+	std::atomic<std::uint32_t> outstanding(0);
+	const std::string request = "GET " + uri + " HTTP/1.1\r\nHost: " + ip + "\r\n\r\n";
+
+	std::vector<std::unique_ptr<connection_t>> conns;
+	for(std::uint32_t i = 0; i != connections; ++i)
+	{
+		conns.emplace_back(new connection_t(io, request, depth, running, outstanding));
+		if( !conns.back()->client_.start(ip, port) )
+		{
+			std::cerr << "connect failed" << std::endl;
+			return;
+		}
+	}
+
+	const std::uint64_t start = now_us();
+	for(auto &conn : conns)
+		conn->send();
+
+	::Sleep(seconds * 1000);
+	running = false;
+
+	while( outstanding != 0 )
+		::Sleep(10);
+	const std::uint64_t elapsed = now_us() - start;
+
+	std::vector<std::uint32_t> latencies;
+	std::uint64_t failed = 0;
+	for(auto &conn : conns)
+	{
+		latencies.insert(latencies.end(), conn->latencies_.begin(), conn->latencies_.end());
+		failed += conn->failed_;
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	std::cout << uri << " connections: " << connections << " depth: " << depth << std::endl;
+	if( !latencies.empty() )
+	{
+		std::cout << "requests: " << latencies.size() << " failed batches: " << failed << std::endl;
+		std::cout << "req/s: " << latencies.size() * 1000000 / elapsed << std::endl;
+		std::cout << "p50: " << latencies[latencies.size() / 2] << "us"
+			<< " p99: " << latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] << "us"
+			<< " max: " << latencies.back() << "us" << std::endl;
+	}
+
+	for(auto &conn : conns)
+		conn->client_.stop();
+
+	io.stop();
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	// http_test ip port ѹⲿExample/Network/Http
+	if( argc == 3 )
+	{
+		char ip[64] = {0};
+		::WideCharToMultiByte(CP_ACP, 0, argv[1], -1, ip, sizeof(ip), nullptr, nullptr);
+		const std::uint16_t port = static_cast<std::uint16_t>(::_wtoi(argv[2]));
+
+		http_bench(ip, port, "/", 16, 1, 10);
+		http_bench(ip, port, "/", 16, 32, 10);
+
+		system("pause");
+		return 0;
+	}
+
+	static const char body[] = "hello world\r\n";
+
+	// ̬ļ2KСļڴ滺棬4MĴļTransmitPackets
+	::CreateDirectoryA("http_test_root", nullptr);
+	std::ofstream("http_test_root\\index.html", std::ios::binary) << std::string(2 * 1024, 'a');
+	std::ofstream("http_test_root\\large.bin", std::ios::binary) << std::string(4 * 1024 * 1024, 'b');
+	http::static_files_t files("http_test_root");
+
+	network::server svr(PORT);
+	http::server_t http_svr([&files](const http::request_t &req, http::response_t &resp)
+	{
+		if( !req.is_method("GET") && !req.is_method("HEAD") )
+		{
+			http::stock_response(resp, 405);
+			return;
+		}
+
+		if( !http::equals(req.uri_, "/") )
+		{
+			files.serve(req, resp);
+			return;
+		}
+
+		// ̬Ĳ
+		resp.add_header("Content-Type", "text/plain");
+		resp.append_body(service::const_buffer_t(body, sizeof(body) - 1), nullptr);
+	});
+	http_svr.attach(svr);
+	svr.start();
+
+	// ˮˮ߶Ա
+	http_bench("127.0.0.1", PORT, "/", 16, 1, 10);
+	http_bench("127.0.0.1", PORT, "/", 16, 32, 10);
+	http_bench("127.0.0.1", PORT, "/", 64, 128, 10);
+	http_bench("127.0.0.1", PORT, "/index.html", 16, 32, 10);
+	http_bench("127.0.0.1", PORT, "/large.bin", 16, 1, 10);
+
+	svr.stop();
+
+	system("pause");
+	return 0;
+}
@@ -0,0 +1,153 @@
+// logger_test.cpp : per-call cost of the asynchronous logger with one and several threads, flush completeness and overflow accounting
+//
+
+#include "stdafx.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#include "../../../include/async_io/logger/logger.hpp"
+#include "../../../include/async_io/service/clock.hpp"
+
+
+using namespace async;
+
+
+std::uint64_t count_lines(const std::wstring &path)
+{
+	std::ifstream in(path.c_str(), std::ios::binary);
+	std::uint64_t lines = 0;
+	std::string line;
+	while( std::getline(in, line) )
+		++lines;
+
+	return lines;
+}
+
+
+// threads̸߳дcountÿƽʱ(ns)
+double hot_path(logger::logger_t &log, std::uint32_t threads, std::uint32_t count)
+{
+	std::atomic<std::uint64_t> total_us(0);
+	std::vector<std::thread> workers;
+
+	for(std::uint32_t i = 0; i != threads; ++i)
+	{
+		workers.emplace_back([&log, &total_us, i, count]()
+		{
+			const std::string name = "worker";
+			const std::uint64_t start = service::monotonic_us();
+			for(std::uint32_t j = 0; j != count; ++j)
+				log.info("{} {} seq={} value={}", name, i, j, j * 0.5);
+			total_us += service::monotonic_us() - start;
+		});
+	}
+
+	for(auto &worker : workers)
+		worker.join();
+
+	return total_us * 1000.0 / (static_cast<double>(threads) * count);
+}
+
+
+// дflushļӦ¼һ
+bool flush_all(service::io_dispatcher_t &io, const std::wstring &path)
+{
+	::DeleteFileW(path.c_str());
+
+	logger::logger_config_t config;
+	config.overflow_ = logger::OVERFLOW_BLOCK;
+
+	const std::uint32_t threads = 4;
+	const std::uint32_t count = 200000;
+	double ns = 0;
+	logger::logger_stats_t stats = {0};
+	{
+		logger::logger_t log(io, path, config);
+		ns = hot_path(log, threads, count);
+		log.flush();
+		stats = log.stats();
+	}
+
+	const std::uint64_t lines = count_lines(path);
+	const bool ok = stats.dropped_ == 0 && stats.errors_ == 0 && lines == std::uint64_t(threads) * count;
+	std::cout << "block " << threads << " threads: " << ns << " ns/call, batches " << stats.batches_
+		<< ", lines " << lines << (ok ? " ok" : " FAILED") << std::endl;
+	return ok;
+}
+
+// СʱдӶӦڵ
+bool drop_count(service::io_dispatcher_t &io, const std::wstring &path)
+{
+	::DeleteFileW(path.c_str());
+
+	logger::logger_config_t config;
+	config.buffer_size_ = 4096;
+	config.flush_interval_ms_ = 50;
+	config.overflow_ = logger::OVERFLOW_COUNT;
+
+	const std::uint32_t count = 100000;
+	logger::logger_stats_t stats = {0};
+	{
+		logger::logger_t log(io, path, config);
+		for(std::uint32_t i = 0; i != count; ++i)
+			log.warn("overflow {}", i);
+		log.flush();
+		stats = log.stats();
+	}
+
+	const bool ok = stats.dropped_ != 0 && stats.records_ + stats.dropped_ == count;
+	std::cout << "count: records " << stats.records_ << ", dropped " << stats.dropped_
+		<< (ok ? " ok" : " FAILED") << std::endl;
+	return ok;
+}
+
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	wchar_t temp[MAX_PATH] = {0};
+	::GetTempPathW(MAX_PATH, temp);
+	const std::wstring path = argc > 1 ? argv[1] : std::wstring(temp) + L"logger_test.log";
+
+	service::io_dispatcher_t io([](const std::string &msg)
+	{
+		std::cerr << msg << std::endl;
+	});
+
+	bool ok = true;
+	try
+	{
+		// Ĭµĵ̺߳Ͷ̵߳úʱ
+		for(std::uint32_t threads = 1; threads <= 4; threads *= 4)
+		{
+			::DeleteFileW(path.c_str());
+			logger::logger_t log(io, path);
+			const double ns = hot_path(log, threads, 100000);
+			log.flush();
+
+			const logger::logger_stats_t stats = log.stats();
+			std::cout << threads << " threads: " << ns << " ns/call, records " << stats.records_
+				<< ", dropped " << stats.dropped_ << std::endl;
+		}
+
+		ok = flush_all(io, path) && ok;
+		ok = drop_count(io, path) && ok;
+	}
+	catch(const exception::exception_base &e)
+	{
+		e.dump();
+		std::cerr << e.what() << std::endl;
+		ok = false;
+	}
+
+	io.stop();
+	::DeleteFileW(path.c_str());
+
+	system("pause");
+	return ok ? 0 : 1;
+}
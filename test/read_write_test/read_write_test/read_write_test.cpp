@@ -4,6 +4,7 @@
 #include "stdafx.h"
 
 #include <iostream>
+#include <string>
 #include <memory>
 #include <cstdint>
 #include <vector>
@@ -15,7 +16,7 @@
 #include "../../../include/async_io/service/dispatcher.hpp"
 
 #include "../../../include/serialize/serialize.hpp"
-#include "multi_msg_decoder.hpp"
+#include "../../../include/async_io/network/frame_codec.hpp"
 
 #ifdef min
 #undef min
@@ -194,7 +195,15 @@ void read(SocketT &sock, char (&buffer)[N], DecoderT &decoder)
 {
 	sock.async_read(async::service::buffer(buffer), [&](const std::error_code &, std::uint32_t sz)
 	{
-		decoder.handle(sock, buffer, sz);
+		if( !decoder.feed(buffer, sz) )
+		{
+			std::cout << "frame decode error" << std::endl;
+			return;
+		}
+
+		for(auto iter = decoder.frames().begin(); iter != decoder.frames().end(); ++iter)
+			std::cout << std::string(iter->data(), iter->size()) << std::endl;
+
 		read(sock, buffer, decoder);
 	}, std::allocator<char>());
 }
@@ -204,11 +213,8 @@ void read_test()
 {
 	mock_socket_t sock;
 
-	typedef baimo::network::multi_buffer_decode_t<mock_socket_t> msg_decoder_t;
-	msg_decoder_t buffer_decoder([](const mock_socket_t &, const buffer_t &buffer)
-	{
-		
-	});
+	// mock_socket_t4ֽС˳ǰ׺
+	async::network::frame_decoder_t buffer_decoder(async::network::frame_format_t(4, false));
 
 	char buffer[4096] = {0};
 	read(sock, buffer, buffer_decoder);
@@ -0,0 +1,244 @@
+// relay_test.cpp : TCP proxy built on relay_t, echo backend behind it; measures throughput and checks half-close
+//
+
+#include "stdafx.h"
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#include "../../../include/async_io/network.hpp"
+#include "../../../include/async_io/network/relay.hpp"
+#include "../../../include/memory_pool/sgi_memory_pool.hpp"
+
+
+using namespace async;
+
+
+const std::uint16_t PROXY_PORT = 5050;
+const std::uint16_t BACKEND_PORT = 5051;
+
+memory_pool::mt_memory_pool pool;
+
+std::atomic<std::uint32_t> relays_done(0);
+std::atomic<std::uint32_t> relays_eof(0);
+
+
+std::uint64_t now_us()
+{
+	static LARGE_INTEGER freq = {0};
+	if( freq.QuadPart == 0 )
+		::QueryPerformanceFrequency(&freq);
+
+	LARGE_INTEGER counter = {0};
+	::QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000000 / freq.QuadPart;
+}
+
+
+// ˣʲôдʲôдٶ
+void echo(const network::session_ptr &session, const std::shared_ptr<std::vector<char>> &buffer)
+{
+	service::mutable_buffer_t buf(buffer->data(), buffer->size());
+	session->async_read_some(buf, 0, [buffer](const network::session_ptr &session, std::uint32_t size)
+	{
+		session->async_write(service::const_buffer_t(buffer->data(), size), [buffer](const network::session_ptr &session, std::uint32_t)
+		{
+			echo(session, buffer);
+		}, pool);
+	}, pool);
+}
+
+// ÿ˷һӣ֮relayת
+void proxy(const network::session_ptr &session)
+{
+	session->get().set_option(network::no_delay(true));
+
+	const network::tcp v4 = network::tcp::v4();
+	auto backend = std::make_shared<network::socket_handle_t>(session->get().get_dispatcher(), v4.family(), v4.type(), v4.protocol());
+	backend->async_connect(network::ip_address::parse("127.0.0.1"), BACKEND_PORT, [session, backend](const std::error_code &error)
+	{
+		if( error )
+		{
+			session->disconnect();
+			return;
+		}
+
+		backend->set_option(network::no_delay(true));
+
+		// 죬relaysession
+		std::shared_ptr<network::socket_handle_t> client(session, &session->get());
+		auto relay = std::make_shared<network::relay_t>(client, backend);
+		relay->start([session](const std::error_code &error, const network::relay_stats_t &up, const network::relay_stats_t &down)
+		{
+			++relays_done;
+			if( !error && up.eof_ && down.eof_ )
+				++relays_eof;
+
+			session->disconnect();
+		});
+	}, pool);
+}
+
+
+SOCKET connect_proxy()
+{
+	SOCKET sck = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	sockaddr_in addr = {0};
+	addr.sin_family = AF_INET;
+	addr.sin_port = ::htons(PROXY_PORT);
+	addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+	if( ::connect(sck, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 )
+	{
+		::closesocket(sck);
+		return INVALID_SOCKET;
+	}
+
+	BOOL no_delay = TRUE;
+	::setsockopt(sck, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&no_delay), sizeof(no_delay));
+	return sck;
+}
+
+bool recv_all(SOCKET sck, char *buf, int len)
+{
+	while( len != 0 )
+	{
+		const int ret = ::recv(sck, buf, len, 0);
+		if( ret <= 0 )
+			return false;
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+
+// ÿӷһ顢ջһ飬ͳƾ
+void throughput(std::uint32_t connections, std::uint32_t block, std::uint32_t seconds)
+{
+	std::atomic<bool> running(true);
+	std::atomic<std::uint64_t> total(0);
+	std::atomic<std::uint32_t> failed(0);
+
+	std::vector<std::thread> threads;
+	for(std::uint32_t i = 0; i != connections; ++i)
+	{
+		threads.emplace_back([&]()
+		{
+			SOCKET sck = connect_proxy();
+			if( sck == INVALID_SOCKET )
+			{
+				++failed;
+				return;
+			}
+
+			std::vector<char> out(block, 'x'), in(block);
+			while( running )
+			{
+				if( ::send(sck, out.data(), block, 0) != static_cast<int>(block)
+					|| !recv_all(sck, in.data(), block) )
+				{
+					++failed;
+					break;
+				}
+
+				total += block;
+			}
+
+			::closesocket(sck);
+		});
+	}
+
+	const std::uint64_t start = now_us();
+	::Sleep(seconds * 1000);
+	running = false;
+
+	for(auto &thr : threads)
+		thr.join();
+	const std::uint64_t elapsed = now_us() - start;
+
+	std::cout << "connections: " << connections << " block: " << block
+		<< " throughput: " << total * 2 / elapsed << "MB/s"
+		<< " failed: " << failed << std::endl;
+}
+
+// ͻ˷shutdown(SD_SEND)Ӧյȫԣת˵Ĺرգrecv0
+bool half_close(std::uint32_t size)
+{
+	SOCKET sck = connect_proxy();
+	if( sck == INVALID_SOCKET )
+		return false;
+
+	std::thread receiver;
+	std::uint64_t received = 0;
+	bool eof = false;
+
+	receiver = std::thread([&]()
+	{
+		std::vector<char> buf(64 * 1024);
+		for(;;)
+		{
+			const int ret = ::recv(sck, buf.data(), static_cast<int>(buf.size()), 0);
+			if( ret <= 0 )
+			{
+				eof = ret == 0;
+				break;
+			}
+
+			received += ret;
+		}
+	});
+
+	std::vector<char> data(size, 'h');
+	const bool sent = ::send(sck, data.data(), size, 0) == static_cast<int>(size);
+	::shutdown(sck, SD_SEND);
+
+	receiver.join();
+	::closesocket(sck);
+
+	std::cout << "half close: sent " << size << " received " << received << (eof ? " eof" : " error") << std::endl;
+	return sent && eof && received == size;
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	network::server backend(BACKEND_PORT);
+	backend.register_accept_handler([](const network::session_ptr &session, const std::string &)
+	{
+		session->get().set_option(network::no_delay(true));
+		echo(session, std::make_shared<std::vector<char>>(64 * 1024));
+		return true;
+	});
+	backend.start();
+
+	network::server proxy_svr(PROXY_PORT);
+	proxy_svr.register_accept_handler([](const network::session_ptr &session, const std::string &)
+	{
+		proxy(session);
+		return true;
+	});
+	proxy_svr.start();
+
+	if( !half_close(4 * 1024 * 1024) )
+		std::cerr << "half close failed" << std::endl;
+
+	throughput(1, 64 * 1024, 5);
+	throughput(16, 64 * 1024, 5);
+	throughput(256, 4 * 1024, 5);
+
+	::Sleep(1000);
+	std::cout << "relays done: " << relays_done << " clean eof: " << relays_eof << std::endl;
+
+	proxy_svr.stop();
+	backend.stop();
+
+	system("pause");
+	return 0;
+}
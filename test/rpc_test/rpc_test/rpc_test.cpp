@@ -0,0 +1,257 @@
+// rpc_test.cpp : loopback rpc benchmark, reports calls/s and p50/p99 latency
+//
+
+#include "stdafx.h"
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+
+#include "../../../include/async_io/rpc/channel.hpp"
+#include "../../../include/async_io/rpc/rpc_server.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+
+using namespace async;
+namespace gp = google::protobuf;
+
+
+const std::uint16_t PORT = 5150;
+
+
+std::uint64_t now_us()
+{
+	static LARGE_INTEGER freq = {0};
+	if( freq.QuadPart == 0 )
+		::QueryPerformanceFrequency(&freq);
+
+	LARGE_INTEGER counter = {0};
+	::QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000000 / freq.QuadPart;
+}
+
+// protocʱ bench.EchoService.Echo(EchoRequest) returns (EchoResponse)
+const gp::FileDescriptor *build_echo_proto(gp::DescriptorPool &pool)
+{
+	gp::FileDescriptorProto file;
+	file.set_name("echo.proto");
+	file.set_package("bench");
+
+	const char *names[] = { "EchoRequest", "EchoResponse" };
+	for(auto name : names)
+	{
+		auto msg = file.add_message_type();
+		msg->set_name(name);
+
+		auto field = msg->add_field();
+		field->set_name("payload");
+		field->set_number(1);
+		field->set_label(gp::FieldDescriptorProto::LABEL_OPTIONAL);
+		field->set_type(gp::FieldDescriptorProto::TYPE_BYTES);
+	}
+
+	auto svc = file.add_service();
+	svc->set_name("EchoService");
+
+	auto method = svc->add_method();
+	method->set_name("Echo");
+	method->set_input_type(".bench.EchoRequest");
+	method->set_output_type(".bench.EchoResponse");
+
+	return pool.BuildFile(file);
+}
+
+
+class echo_service_t
+	: public gp::Service
+{
+	const gp::ServiceDescriptor *descriptor_;
+	gp::DynamicMessageFactory &factory_;
+
+public:
+	echo_service_t(const gp::ServiceDescriptor *descriptor, gp::DynamicMessageFactory &factory)
+		: descriptor_(descriptor)
+		, factory_(factory)
+	{}
+
+public:
+	virtual const gp::ServiceDescriptor *GetDescriptor()
+	{
+		return descriptor_;
+	}
+
+	virtual void CallMethod(const gp::MethodDescriptor *method, gp::RpcController *,
+		const gp::Message *request, gp::Message *response, gp::Closure *done)
+	{
+		const gp::FieldDescriptor *in = method->input_type()->field(0);
+		const gp::FieldDescriptor *out = method->output_type()->field(0);
+
+		response->GetReflection()->SetString(response, out, request->GetReflection()->GetString(*request, in));
+		done->Run();
+	}
+
+	virtual const gp::Message &GetRequestPrototype(const gp::MethodDescriptor *method) const
+	{
+		return *factory_.GetPrototype(method->input_type());
+	}
+
+	virtual const gp::Message &GetResponsePrototype(const gp::MethodDescriptor *method) const
+	{
+		return *factory_.GetPrototype(method->output_type());
+	}
+};
+
+
+// ÿͬһʱֻһãɺһͬʱ;ĵڲ
+struct slot_t
+{
+	rpc::channel_t &channel_;
+	const gp::MethodDescriptor *method_;
+	std::atomic<bool> &running_;
+	std::atomic<std::uint32_t> &outstanding_;
+
+	rpc::controller_t controller_;
+	std::unique_ptr<gp::Message> request_;
+	std::unique_ptr<gp::Message> response_;
+	std::unique_ptr<gp::Closure> done_;
+
+	std::uint64_t start_;
+	std::uint64_t failed_;
+	std::vector<std::uint32_t> latencies_;
+
+	slot_t(rpc::channel_t &channel, const gp::MethodDescriptor *method, gp::DynamicMessageFactory &factory,
+		const std::string &payload, std::atomic<bool> &running, std::atomic<std::uint32_t> &outstanding)
+		: channel_(channel)
+		, method_(method)
+		, running_(running)
+		, outstanding_(outstanding)
+		, request_(factory.GetPrototype(method->input_type())->New())
+		, response_(factory.GetPrototype(method->output_type())->New())
+		, done_(gp::NewPermanentCallback(this, &slot_t::on_done))
+		, start_(0)
+		, failed_(0)
+	{
+		request_->GetReflection()->SetString(request_.get(), method->input_type()->field(0), payload);
+		latencies_.reserve(1024 * 1024);
+	}
+
+	void call()
+	{
+		++outstanding_;
+
+		controller_.Reset();
+		start_ = now_us();
+		channel_.CallMethod(method_, &controller_, request_.get(), response_.get(), done_.get());
+	}
+
+	void on_done()
+	{
+		if( controller_.Failed() )
+			++failed_;
+		else
+			latencies_.push_back(static_cast<std::uint32_t>(now_us() - start_));
+
+		--outstanding_;
+		if( running_ && !controller_.Failed() )
+			call();
+	}
+};
+
+
+void rpc_bench(std::uint32_t connections, std::uint32_t depth, std::uint32_t payload_size, std::uint32_t seconds)
+{
+	gp::DescriptorPool pool;
+	const gp::FileDescriptor *file = build_echo_proto(pool);
+	gp::DynamicMessageFactory factory(&pool);
+
+	const gp::ServiceDescriptor *descriptor = file->service(0);
+	echo_service_t echo(descriptor, factory);
+
+	network::server svr(PORT);
+	rpc::server_t rpc_svr;
+	rpc_svr.add_service(&echo);
+	rpc_svr.attach(svr);
+	svr.start();
+
+	service::io_dispatcher_t io([](const std::string &msg)
+	{
+		std::cerr << msg << std::endl;
+	});
+
+	std::atomic<bool> running(true);
+	std::atomic<std::uint32_t> outstanding(0);
+	const std::string payload(payload_size, 'x');
+
+	std::vector<std::unique_ptr<rpc::channel_t>> channels;
+	std::vector<std::unique_ptr<slot_t>> slots;
+	for(std::uint32_t i = 0; i != connections; ++i)
+	{
+		channels.emplace_back(new rpc::channel_t(io));
+		if( !channels.back()->start("127.0.0.1", PORT) )
+		{
+			std::cerr << "connect failed" << std::endl;
+			return;
+		}
+
+		for(std::uint32_t j = 0; j != depth; ++j)
+			slots.emplace_back(new slot_t(*channels.back(), descriptor->method(0), factory, payload, running, outstanding));
+	}
+
+	const std::uint64_t start = now_us();
+	for(auto &slot : slots)
+		slot->call();
+
+	::Sleep(seconds * 1000);
+	running = false;
+
+	while( outstanding != 0 )
+		::Sleep(10);
+	const std::uint64_t elapsed = now_us() - start;
+
+	std::vector<std::uint32_t> latencies;
+	std::uint64_t failed = 0;
+	for(auto &slot : slots)
+	{
+		latencies.insert(latencies.end(), slot->latencies_.begin(), slot->latencies_.end());
+		failed += slot->failed_;
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	std::cout << "connections: " << connections << " depth: " << depth << " payload: " << payload_size << std::endl;
+	if( !latencies.empty() )
+	{
+		std::cout << "calls: " << latencies.size() << " failed: " << failed << std::endl;
+		std::cout << "calls/s: " << latencies.size() * 1000000 / elapsed << std::endl;
+		std::cout << "p50: " << latencies[latencies.size() / 2] << "us"
+			<< " p99: " << latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] << "us"
+			<< " max: " << latencies.back() << "us" << std::endl;
+	}
+
+	for(auto &channel : channels)
+		channel->stop();
+
+	io.stop();
+	svr.stop();
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	// ˮˮ߶Ա
+	rpc_bench(1, 1, 64, 5);
+	rpc_bench(4, 64, 64, 10);
+	rpc_bench(4, 64, 4096, 10);
+
+	system("pause");
+	return 0;
+}
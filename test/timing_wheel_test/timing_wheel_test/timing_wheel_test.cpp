@@ -6,6 +6,8 @@
 #include <iostream>
 
 #include "../../../include/utility/circular_buffer.hpp"
+#include "../../../include/async_io/timer/timing_wheel.hpp"
+#include "../../../include/async_io/timer/hierarchical_wheel.hpp"
 
 void test_circular_buffer()
 {
@@ -32,10 +34,157 @@ void test_circular_buffer()
 	}
 }
 
-int _tmain(int argc, _TCHAR* argv[])
+struct wheel_timer_t
+	: async::timer::wheel_node_t
+{
+	int id_;
+	std::uint64_t deadline_;
+	std::uint32_t fired_;
+
+	wheel_timer_t(int id, std::uint64_t deadline)
+		: async::timer::wheel_node_t(&wheel_timer_t::on_expire)
+		, id_(id)
+		, deadline_(deadline)
+		, fired_(0)
+	{}
+
+	static std::uint64_t on_expire(async::timer::wheel_node_t &node, std::uint64_t now)
+	{
+		auto &val = static_cast<wheel_timer_t &>(node);
+
+		// deadline moved forward after scheduling
+		if( val.deadline_ > now )
+			return val.deadline_;
+
+		++val.fired_;
+		std::cout << "timer " << val.id_ << " expired at tick " << now << std::endl;
+		return 0;
+	}
+};
+
+void test_timing_wheel()
+{
+	// 10ms tick, 8 slots
+	async::timer::timing_wheel_t wheel(0, 10, 3);
+
+	wheel_timer_t t1(1, 3);
+	wheel_timer_t t2(2, 20);		// more than one round
+	wheel_timer_t t3(3, 5);
+	wheel_timer_t t4(4, 6);
+
+	wheel.schedule(t1, t1.deadline_);
+	wheel.schedule(t2, t2.deadline_);
+	wheel.schedule(t3, t3.deadline_);
+	wheel.schedule(t4, t4.deadline_);
+
+	// touch: t3 expires at 12 instead of 5
+	t3.deadline_ = 12;
+
+	wheel.cancel(t4);
+
+	for(std::uint64_t ms = 0; ms <= 250; ms += 10)
+		wheel.advance(ms);
+
+	std::cout << "fired: " << t1.fired_ << t2.fired_ << t3.fired_ << t4.fired_ 
+		<< " (expect 1110), linked: " << wheel.size() << std::endl;
+
+	// falling behind more than one round
+	wheel_timer_t t5(5, wheel.now() + 100);
+	wheel.schedule(t5, t5.deadline_);
+	wheel.advance(5000);
+
+	std::cout << "fired: " << t5.fired_ << " (expect 1), now: " << wheel.now() << std::endl;
+}
+
+void test_hierarchical_wheel()
+{
+	async::timer::hierarchical_wheel_t wheel(1000);
+
+	// spans across the root and the first three levels, one beyond 2^32 ticks
+	const std::uint64_t spans[] = { 1, 255, 256, 300, 16384, 70000, 2000000, (1ULL << 32) + 5 };
+	const std::uint32_t count = sizeof(spans) / sizeof(spans[0]);
+
+	async::timer::wheel_node_t nodes[count];
+	std::uint64_t fired_at[count] = {0};
+
+	for(std::uint32_t i = 0; i != count; ++i)
+		wheel.schedule(nodes[i], wheel.now() + spans[i]);
+
+	// re-arm 300 -> 400, cancel 70000
+	wheel.schedule(nodes[3], wheel.now() + 400);
+	wheel.cancel(nodes[5]);
+
+	std::uint32_t periodic = 0;
+	async::timer::wheel_node_t tick;
+	wheel.schedule(tick, wheel.now() + 1000);
+
+	auto handler = [&](async::timer::wheel_node_t &node)
+	{
+		if( &node == &tick )
+		{
+			if( ++periodic != 5 )
+				wheel.schedule(tick, wheel.now() + 1000);
+			return;
+		}
+
+		fired_at[&node - nodes] = wheel.now() - 1000;
+	};
+
+	// jump in uneven steps
+	while( wheel.now() < 1000 + 2000000 )
+		wheel.advance(wheel.now() + 777, handler);
+
+	bool ok = periodic == 5;
+	for(std::uint32_t i = 0; i != count; ++i)
+	{
+		const std::uint64_t expect = i == 3 ? 400 : i == 5 || i == count - 1 ? 0 : spans[i];
+		ok = ok && fired_at[i] == expect;
+	}
+
+	std::cout << "hierarchical wheel: " << (ok ? "ok" : "failed") << ", linked: " << wheel.size() << " (expect 1)" << std::endl;
+	wheel.cancel(nodes[count - 1]);
+}
+
+void test_next_expire()
 {
+	async::timer::hierarchical_wheel_t wheel(5000);
 
-	
+	const std::uint64_t spans[] = { 3, 200, 256, 4000, 70000, 2000000 };
+	const std::uint32_t count = sizeof(spans) / sizeof(spans[0]);
+
+	async::timer::wheel_node_t nodes[count];
+	std::uint64_t fired_at[count] = {0};
+
+	for(std::uint32_t i = 0; i != count; ++i)
+		wheel.schedule(nodes[i], wheel.now() + spans[i]);
+
+	// advance only to the reported deadlines, as the timer service does
+	std::uint32_t steps = 0;
+	bool ok = wheel.next_expire() == wheel.now() + 3;
+	while( wheel.size() != 0 && steps < 100000 )
+	{
+		const std::uint64_t next = wheel.next_expire();
+		ok = ok && next > wheel.now();
+
+		wheel.advance(next, [&](async::timer::wheel_node_t &node)
+		{
+			fired_at[&node - nodes] = wheel.now() - 5000;
+		});
+		++steps;
+	}
+
+	for(std::uint32_t i = 0; i != count; ++i)
+		ok = ok && fired_at[i] == spans[i];
+	ok = ok && wheel.next_expire() == ~0ULL;
+
+	std::cout << "next expire: " << (ok ? "ok" : "failed") << ", steps: " << steps << std::endl;
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	test_timing_wheel();
+	test_hierarchical_wheel();
+	test_next_expire();
 
 	return 0;
 }
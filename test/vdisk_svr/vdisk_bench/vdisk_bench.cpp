@@ -0,0 +1,235 @@
+// vdisk_bench.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+
+#include "../vdisk_svr/vdisk_protocol.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+
+#ifdef min
+#undef min
+#endif
+
+#ifdef max
+#undef max
+#endif
+
+using namespace async;
+
+
+struct bench_config_t
+{
+	std::string ip_;
+	std::uint16_t port_;
+	std::uint32_t threads_;
+	std::uint32_t seconds_;
+	std::uint32_t sectors_;			// ÿζ
+	std::uint32_t seq_percent_;		// ˳ı
+};
+
+struct bench_result_t
+{
+	std::uint64_t ops_;
+	std::uint64_t bytes_;
+	std::uint64_t errors_;
+	std::vector<std::uint32_t> latency_;	// us
+};
+
+
+bool query(network::client &client, std::uint64_t &sectors)
+{
+	VDISKREQUEST req = {0};
+	req.flag = FRAME_START_FLAG;
+	req.length = sizeof(req);
+	req.command = FRAME_CMD_QUERY;
+
+	VDISKACK ack = {0};
+	return client.send((const char *)&req, sizeof(req))
+		&& client.recv((char *)&ack, sizeof(ack))
+		&& ack.status == ACK_STATUS_SUCCESS
+		&& ack.length == sizeof(ack) + sizeof(sectors)
+		&& client.recv((char *)&sectors, sizeof(sectors));
+}
+
+// ÿ߳һӣͬշ˳űһελ
+void run_client(service::io_dispatcher_t &io, const bench_config_t &config, std::uint64_t disk_sectors, std::uint32_t seed, bench_result_t &result)
+{
+	network::client client(io);
+	if( !client.start(config.ip_, config.port_) )
+	{
+		++result.errors_;
+		return;
+	}
+
+	std::mt19937_64 rng(seed);
+	std::vector<char> data(config.sectors_ * VDISK_SECTOR_SIZE);
+	const std::uint64_t max_start = disk_sectors - config.sectors_;
+	std::uint64_t next = rng() % (max_start + 1);
+
+	const auto deadline = std::chrono::high_resolution_clock::now() + std::chrono::seconds(config.seconds_);
+	while( std::chrono::high_resolution_clock::now() < deadline )
+	{
+		std::uint64_t start = rng() % 100 < config.seq_percent_ ? next : rng() % (max_start + 1);
+		if( start > max_start )
+			start = 0;
+
+		VDISKREQUEST req = {0};
+		req.flag = FRAME_START_FLAG;
+		req.length = sizeof(req);
+		req.command = FRAME_CMD_READ;
+		req.Read.start.QuadPart = start;
+		req.Read.number = config.sectors_;
+
+		const auto begin = std::chrono::high_resolution_clock::now();
+
+		VDISKACK ack = {0};
+		if( !client.send((const char *)&req, sizeof(req)) || !client.recv((char *)&ack, sizeof(ack)) )
+		{
+			++result.errors_;
+			break;
+		}
+
+		if( ack.status != ACK_STATUS_SUCCESS )
+		{
+			++result.errors_;
+			continue;
+		}
+
+		// ȲʱѴλټ
+		if( ack.length != sizeof(ack) + data.size() || !client.recv(data.data(), static_cast<std::uint32_t>(data.size())) )
+		{
+			++result.errors_;
+			break;
+		}
+
+		const auto end = std::chrono::high_resolution_clock::now();
+
+		// ÿLBA
+		for(std::uint32_t i = 0; i != config.sectors_; ++i)
+		{
+			if( *reinterpret_cast<const std::uint64_t *>(data.data() + i * VDISK_SECTOR_SIZE) != start + i )
+			{
+				++result.errors_;
+				break;
+			}
+		}
+
+		++result.ops_;
+		result.bytes_ += data.size();
+		result.latency_.push_back(static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()));
+
+		next = start + config.sectors_;
+	}
+
+	client.disconnect();
+}
+
+void run_bench(service::io_dispatcher_t &io, const bench_config_t &config, std::uint64_t disk_sectors)
+{
+	std::vector<bench_result_t> results(config.threads_);
+	std::vector<std::thread> threads;
+
+	const auto begin = std::chrono::high_resolution_clock::now();
+	for(std::uint32_t i = 0; i != config.threads_; ++i)
+	{
+		results[i].ops_ = results[i].bytes_ = results[i].errors_ = 0;
+		threads.emplace_back(std::bind(&run_client, std::ref(io), std::cref(config), disk_sectors, i + 1, std::ref(results[i])));
+	}
+
+	std::for_each(threads.begin(), threads.end(), [](std::thread &thr) { thr.join(); });
+	const double seconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - begin).count() / 1000.0;
+
+	bench_result_t total = {0};
+	std::for_each(results.begin(), results.end(), [&total](const bench_result_t &result)
+	{
+		total.ops_ += result.ops_;
+		total.bytes_ += result.bytes_;
+		total.errors_ += result.errors_;
+		total.latency_.insert(total.latency_.end(), result.latency_.begin(), result.latency_.end());
+	});
+
+	double avg = 0;
+	std::uint32_t p99 = 0;
+	if( !total.latency_.empty() )
+	{
+		avg = std::accumulate(total.latency_.begin(), total.latency_.end(), 0.0) / total.latency_.size();
+
+		auto nth = total.latency_.begin() + total.latency_.size() * 99 / 100;
+		std::nth_element(total.latency_.begin(), nth, total.latency_.end());
+		p99 = *nth;
+	}
+
+	std::cout << std::setw(3) << config.seq_percent_ << "% seq, " << config.threads_ << " threads, " << config.sectors_ << " sectors: "
+		<< std::fixed << std::setprecision(0) << total.ops_ / seconds << " IOPS, "
+		<< std::setprecision(1) << total.bytes_ / seconds / (1024 * 1024) << " MiB/s, "
+		<< "avg " << avg << " us, p99 " << p99 << " us, errors " << total.errors_ << std::endl;
+}
+
+// vdisk_bench [ip] [port] [threads] [seconds] [sectors] [seq percent]
+// ָ˳ʱβϡ˳
+int main(int argc, char *argv[])
+{
+	bench_config_t config;
+	config.ip_ = argc > 1 ? argv[1] : "127.0.0.1";
+	config.port_ = static_cast<std::uint16_t>(argc > 2 ? std::atoi(argv[2]) : 5050);
+	config.threads_ = argc > 3 ? std::atoi(argv[3]) : 16;
+	config.seconds_ = argc > 4 ? std::atoi(argv[4]) : 10;
+	config.sectors_ = argc > 5 ? std::atoi(argv[5]) : 8;
+
+	std::vector<std::uint32_t> mixes;
+	if( argc > 6 )
+		mixes.push_back(std::atoi(argv[6]));
+	else
+		mixes = { 0, 50, 100 };
+
+	if( config.threads_ == 0 || config.sectors_ == 0 || config.sectors_ > VDISK_MAX_READ_SECTORS )
+	{
+		std::cerr << "bad arguments" << std::endl;
+		return -1;
+	}
+
+	service::io_dispatcher_t io([](const std::string &msg)
+	{
+		std::cerr << msg << std::endl;
+	});
+
+	std::uint64_t disk_sectors = 0;
+	{
+		network::client client(io);
+		if( !client.start(config.ip_, config.port_) || !query(client, disk_sectors) )
+		{
+			std::cerr << "query failed" << std::endl;
+			return -1;
+		}
+
+		client.disconnect();
+	}
+
+	if( disk_sectors < config.sectors_ )
+	{
+		std::cerr << "disk too small: " << disk_sectors << " sectors" << std::endl;
+		return -1;
+	}
+
+	std::cout << "disk " << disk_sectors << " sectors" << std::endl;
+
+	std::for_each(mixes.begin(), mixes.end(), [&](std::uint32_t mix)
+	{
+		config.seq_percent_ = std::min<std::uint32_t>(mix, 100);
+		run_bench(io, config, disk_sectors);
+	});
+
+	io.stop();
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef __VDISK_PROTOCOL_HPP
+#define __VDISK_PROTOCOL_HPP
+
+#include <async_io/network.hpp>
+
+
+#define FRAME_START_FLAG				'.mgs'
+
+#define FRAME_CMD_QUERY					0x01
+#define FRAME_CMD_READ					0x02
+#define FRAME_CMD_INFO					0x04
+
+#define CONNECT_TYPE_USERMAIN			2
+
+#define VDISK_SECTOR_SIZE				512
+#define VDISK_MAX_READ_SECTORS			2048		// 1MiB
+
+#define ACK_STATUS_SUCCESS				0
+#define ACK_STATUS_ERROR				1			// Խ硢ʧܣӦ𲻴
+
+typedef struct VDiskRequest
+{
+	ULONG			flag;		// FRAME_START_FLAG
+	ULONG			length;		// total length.
+	ULONG			command;
+	ULONG			status;
+
+	union
+	{
+		struct
+		{
+			ULONG			resv1[8];
+		}Param;
+		struct
+		{
+			LARGE_INTEGER	start;
+			ULONG			number;
+		}Read;
+		struct
+		{
+			LARGE_INTEGER	start;
+			ULONG			number;
+		}Write;
+		struct
+		{
+			UCHAR			type;
+			DWORD			rspid;
+			DWORD			remoteip;
+		}ConnectInfo;
+	};
+
+
+}VDISKREQUEST, *LPVDISKREQUEST;
+
+typedef struct VDiskAck
+{
+	ULONG			flag;			// FRAME_START_FLAG
+	ULONG			length;			// total length.
+	ULONG			command;
+	ULONG			status;
+}VDISKACK, *LPVDISKACK;
+
+
+#endif
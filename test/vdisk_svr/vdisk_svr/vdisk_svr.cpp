@@ -3,136 +3,274 @@
 
 #include "stdafx.h"
 
-#include <async_io\network.hpp>
+#include "vdisk_protocol.hpp"
+
+#include <async_io\file\file_engine.hpp>
+#include <async_io\file\block_cache.hpp>
+
 #include <iostream>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <algorithm>
 
-using namespace async;
+#ifdef min
+#undef min
+#endif
 
-#define FRAME_START_FLAG				'.mgs'
+#ifdef max
+#undef max
+#endif
 
-#define FRAME_CMD_QUERY					0x01
-#define FRAME_CMD_READ					0x02
-#define FRAME_CMD_INFO					0x04
+using namespace async;
 
-#define CONNECT_TYPE_USERMAIN			2	
 
-typedef struct VDiskRequest
-{
-	ULONG			flag;		// FRAME_START_FLAG
-	ULONG			length;		// total length.
-	ULONG			command;	
-	ULONG			status;		
+#define MAX_REQUEST_SIZE				(64 * 1024)
+#define MAX_SEND_BATCH					64					// һξۼдϲӦ
+#define DEFAULT_IMAGE_SIZE				(256ull * 1024 * 1024)
 
-	union
-	{
-		struct
-		{
-			ULONG			resv1[8];
-		}Param;
-		struct
-		{
-			LARGE_INTEGER	start;
-			ULONG			number;
-		}Read;
-		struct
-		{
-			LARGE_INTEGER	start;
-			ULONG			number;
-		}Write;
-		struct
-		{
-			UCHAR			type;		
-			DWORD			rspid;		
-			DWORD			remoteip;	
-		}ConnectInfo;
-	};
 
+std::unique_ptr<filesystem::block_cache_t> disk_cache;
+std::uint64_t disk_sectors = 0;
 
-}VDISKREQUEST, *LPVDISKREQUEST;
 
-typedef struct VDiskAck
+// һӦREADֱû飬дɺͷ
+struct reply_t
 {
-	ULONG			flag;			// FRAME_START_FLAG
-	ULONG			length;			// total length.
-	ULONG			command;	
-	ULONG			status;		
-}VDISKACK, *LPVDISKACK;
-
+	std::uint64_t seq_;
+	VDISKACK ack_;
+	std::uint64_t value_;							// QUERYص
+	std::uint64_t begin_;							// READֽ
+	std::uint64_t end_;
+	std::vector<filesystem::cache_block_ptr> blocks_;
+	std::atomic<std::uint32_t> pending_;
+	std::atomic<bool> failed_;
+};
+typedef std::shared_ptr<reply_t> reply_ptr;
 
 struct session_buffer_t
 {
 	std::vector<char> read_buffer_;
-	std::vector<char> write_buffer_;
 
 	typedef memory_pool::sgi_memory_pool_t<true, 256> pool_allocator_t;
 
 	pool_allocator_t read_allocator_;
 	pool_allocator_t write_allocator_;
+
+	// ֻڶʹ
+	filesystem::block_cache_t::stream_t stream_;
+	std::uint64_t next_seq_;
+
+	// Ӧ˳򷢳ͬһʱֻһд
+	std::mutex mutex_;
+	std::uint64_t send_seq_;
+	std::map<std::uint64_t, reply_ptr> ready_;
+	bool writing_;
+
+	// ֻɷдһ
+	std::vector<reply_ptr> sending_;
+	std::vector<service::const_buffer_t> buffers_;
+
+	session_buffer_t()
+		: next_seq_(0)
+		, send_seq_(0)
+		, writing_(false)
+	{}
 };
+typedef std::shared_ptr<session_buffer_t> session_buffer_ptr;
 
-void msg_complete(const network::session_ptr &session)
-{
-	auto buffer = session->additional_data<session_buffer_t *>();
-	auto req = (VDISKREQUEST *)(buffer->read_buffer_.data());
 
-	VDISKACK ack = {0};
-	ack.command = req->command;
-	ack.flag = req->flag;
+void append_buffers(const reply_t &reply, std::vector<service::const_buffer_t> &buffers)
+{
+	buffers.push_back(service::buffer(reply.ack_));
 
-	switch( req->command )
+	switch( reply.ack_.command )
 	{
 	case FRAME_CMD_QUERY:
+		if( reply.ack_.status == ACK_STATUS_SUCCESS )
+			buffers.push_back(service::buffer(reply.value_));
+		break;
+
+	case FRAME_CMD_READ:
 	{
-		ack.length = sizeof(VDISKACK) + sizeof(std::uint64_t);
-		std::uint64_t length = (100 * 1024ull * 1024 * 1024) / 512;
-		session->async_write([](const auto &err, auto size)
-		{}, buffer->write_allocator_, ack, length);
+		const std::uint64_t block_size = disk_cache->block_size();
+		std::for_each(reply.blocks_.begin(), reply.blocks_.end(), [&](const filesystem::cache_block_ptr &block)
+		{
+			const std::uint64_t block_begin = block->index_ * block_size;
+			const std::uint64_t first = std::max(reply.begin_, block_begin);
+			const std::uint64_t last = std::min(reply.end_, block_begin + block->size_);
+
+			buffers.push_back(service::const_buffer_t(block->data_.data() + (first - block_begin), static_cast<std::size_t>(last - first)));
+		});
 	}
 	break;
 
-	case FRAME_CMD_READ:
+	default:
+		break;
+	}
+}
+
+void send_ready(const network::session_ptr &session, const session_buffer_ptr &buffer)
+{
 	{
-		static std::vector<char> data;
-		data.resize(req->Read.number * 512, 0X01);
+		std::lock_guard<std::mutex> lock(buffer->mutex_);
+		if( buffer->writing_ )
+			return;
+
+		// ѾӦϲΪһξۼд
+		buffer->sending_.clear();
+		buffer->buffers_.clear();
+		for(auto iter = buffer->ready_.find(buffer->send_seq_);
+			iter != buffer->ready_.end() && buffer->sending_.size() < MAX_SEND_BATCH;
+			iter = buffer->ready_.find(buffer->send_seq_))
+		{
+			append_buffers(*iter->second, buffer->buffers_);
+			buffer->sending_.push_back(iter->second);
+			buffer->ready_.erase(iter);
+			++buffer->send_seq_;
+		}
 
-		ack.length = sizeof(VDISKACK) + data.size();
-		session->async_write([](const auto &err, auto size)
-		{}, buffer->write_allocator_, ack, data);
+		if( buffer->sending_.empty() )
+			return;
+
+		buffer->writing_ = true;
 	}
-	break;
 
-	case FRAME_CMD_INFO:
+	session->async_writev(buffer->buffers_.data(), static_cast<std::uint32_t>(buffer->buffers_.size()),
+		[buffer](const network::session_ptr &session, std::uint32_t size)
+	{
+		{
+			std::lock_guard<std::mutex> lock(buffer->mutex_);
+			buffer->writing_ = false;
+		}
+
+		send_ready(session, buffer);
+	}, buffer->write_allocator_);
+}
+
+void reply_ready(const network::session_ptr &session, const session_buffer_ptr &buffer, const reply_ptr &reply)
+{
+	{
+		std::lock_guard<std::mutex> lock(buffer->mutex_);
+		buffer->ready_[reply->seq_] = reply;
+	}
+
+	send_ready(session, buffer);
+}
+
+void read_blocks(const network::session_ptr &session, const session_buffer_ptr &buffer, const reply_ptr &reply)
+{
+	const std::uint64_t block_size = disk_cache->block_size();
+	const std::uint64_t first = reply->begin_ / block_size;
+	const std::uint64_t last = (reply->end_ - 1) / block_size;
+	const std::uint32_t count = static_cast<std::uint32_t>(last - first + 1);
+
+	reply->blocks_.resize(count);
+	reply->pending_ = count;
+
+	for(std::uint32_t i = 0; i != count; ++i)
+	{
+		disk_cache->async_get(first + i, [session, buffer, reply, i](const std::error_code &error, const filesystem::cache_block_ptr &block)
+		{
+			if( error )
+				reply->failed_ = true;
+			else
+				reply->blocks_[i] = block;
+
+			if( --reply->pending_ != 0 )
+				return;
+
+			if( reply->failed_ )
+			{
+				reply->ack_.status = ACK_STATUS_ERROR;
+				reply->ack_.length = sizeof(VDISKACK);
+				reply->blocks_.clear();
+			}
+
+			reply_ready(session, buffer, reply);
+		}, &buffer->stream_);
+	}
+}
+
+void msg_complete(const network::session_ptr &session)
+{
+	const session_buffer_ptr buffer = session->additional_data<session_buffer_ptr>();
+	auto req = (const VDISKREQUEST *)(buffer->read_buffer_.data());
+
+	// ڶһ֮ǰȡᱻ
+	auto reply = std::make_shared<reply_t>();
+	reply->seq_ = buffer->next_seq_++;
+	reply->ack_.flag = req->flag;
+	reply->ack_.length = sizeof(VDISKACK);
+	reply->ack_.command = req->command;
+	reply->ack_.status = ACK_STATUS_SUCCESS;
+	reply->value_ = 0;
+	reply->begin_ = 0;
+	reply->end_ = 0;
+	reply->pending_ = 0;
+	reply->failed_ = false;
+
+	switch( req->command )
+	{
+	case FRAME_CMD_QUERY:
+		reply->ack_.length += sizeof(std::uint64_t);
+		reply->value_ = disk_sectors;
+		reply_ready(session, buffer, reply);
+		break;
+
+	case FRAME_CMD_READ:
 	{
-		ack.length = sizeof(VDISKACK);
-		session->async_write([](const auto &err, auto size)
-		{}, buffer->write_allocator_, ack);
+		const std::uint64_t start = req->Read.start.QuadPart;
+		const std::uint32_t number = req->Read.number;
+		if( number == 0 || number > VDISK_MAX_READ_SECTORS || start >= disk_sectors || number > disk_sectors - start )
+		{
+			reply->ack_.status = ACK_STATUS_ERROR;
+			reply_ready(session, buffer, reply);
+			break;
+		}
+
+		reply->ack_.length += number * VDISK_SECTOR_SIZE;
+		reply->begin_ = start * VDISK_SECTOR_SIZE;
+		reply->end_ = (start + number) * VDISK_SECTOR_SIZE;
+		read_blocks(session, buffer, reply);
 	}
 	break;
 
+	case FRAME_CMD_INFO:
+		reply_ready(session, buffer, reply);
+		break;
+
 	default:
-	assert(0);
-	break;
+		reply->ack_.status = ACK_STATUS_ERROR;
+		reply_ready(session, buffer, reply);
+		break;
 	}
 }
 
 void read(const network::session_ptr &session)
 {
-	session_buffer_t *buffer = session->additional_data<session_buffer_t *>();
+	session_buffer_ptr &buffer = session->additional_data<session_buffer_ptr>();
 	if( buffer->read_buffer_.size() < sizeof(VDISKREQUEST) )
 		buffer->read_buffer_.resize(sizeof(VDISKREQUEST));
 
 	// header
-	network::async_read(session, buffer->read_buffer_.data(), buffer->read_buffer_.size(),
-		[&](const network::session_ptr &session, std::uint32_t len)
+	network::async_read(session, buffer->read_buffer_.data(), sizeof(VDISKREQUEST),
+		[](const network::session_ptr &session, std::uint32_t len)
 	{
 		// body
-		session_buffer_t *buffer = session->additional_data<session_buffer_t *>();
-		auto header = (VDISKREQUEST *)buffer->read_buffer_.data();
-		auto msg_size = header->length;
-		if( buffer->read_buffer_.size() < msg_size )
-			buffer->read_buffer_.resize(msg_size);
+		session_buffer_ptr &buffer = session->additional_data<session_buffer_ptr>();
+		auto header = (const VDISKREQUEST *)buffer->read_buffer_.data();
+		const std::uint32_t msg_size = header->length;
+		if( header->flag != FRAME_START_FLAG || msg_size > MAX_REQUEST_SIZE )
+		{
+			std::cout << "bad request, length " << msg_size << std::endl;
+			session->disconnect();
+			return;
+		}
 
-		if( msg_size = len )
+		if( msg_size <= len )
 		{
 			msg_complete(session);
 			read(session);
@@ -140,7 +278,10 @@ void read(const network::session_ptr &session)
 			return;
 		}
 
-		network::async_read(session, buffer->read_buffer_.data() + sizeof(VDISKREQUEST), 
+		if( buffer->read_buffer_.size() < msg_size )
+			buffer->read_buffer_.resize(msg_size);
+
+		network::async_read(session, buffer->read_buffer_.data() + sizeof(VDISKREQUEST),
 			msg_size - sizeof(VDISKREQUEST),
 			[](const network::session_ptr &session, std::uint32_t len)
 		{
@@ -150,34 +291,110 @@ void read(const network::session_ptr &session)
 	}, buffer->read_allocator_);
 }
 
-int main()
+
+// Ծÿÿ8ֽдLBAڿͻУ
+bool create_image(const std::wstring &path, std::uint64_t size)
 {
-	network::server svr(5050);
+	if( ::GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES )
+		return true;
+
+	HANDLE file = ::CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if( file == INVALID_HANDLE_VALUE )
+		return false;
 
-	
+	std::vector<std::uint64_t> chunk(1024 * 1024 / sizeof(std::uint64_t));
+	const std::uint32_t per_sector = VDISK_SECTOR_SIZE / sizeof(std::uint64_t);
 
-	svr.register_accept_handler([](const network::session_ptr &session, const std::string &ip)->bool
+	bool ret = true;
+	for(std::uint64_t offset = 0; ret && offset < size; offset += chunk.size() * sizeof(std::uint64_t))
 	{
-		session->additional_data(new session_buffer_t, std::allocator<session_buffer_t *>());
-		read(session);
+		const std::uint64_t lba = offset / VDISK_SECTOR_SIZE;
+		for(std::size_t i = 0; i != chunk.size(); ++i)
+			chunk[i] = lba + i / per_sector;
 
-		return true;
-	});
+		DWORD written = 0;
+		const DWORD len = static_cast<DWORD>(std::min<std::uint64_t>(chunk.size() * sizeof(std::uint64_t), size - offset));
+		ret = ::WriteFile(file, chunk.data(), len, &written, nullptr) && written == len;
+	}
+
+	::CloseHandle(file);
+	if( !ret )
+		::DeleteFileW(path.c_str());
+
+	return ret;
+}
 
-	svr.register_disconnect_handler([](const network::session_ptr &session)
+// vdisk_svr [image] [port] [cache MiB]
+int _tmain(int argc, _TCHAR* argv[])
+{
+	const std::wstring path = argc > 1 ? argv[1] : L"vdisk.img";
+	const std::uint16_t port = static_cast<std::uint16_t>(argc > 2 ? _ttoi(argv[2]) : 5050);
+	const std::uint32_t cache_size = argc > 3 ? _ttoi(argv[3]) : 256;
+
+	if( !create_image(path, DEFAULT_IMAGE_SIZE) )
 	{
-		std::cout << "session leave" << std::endl;
-	});
+		std::cerr << "create image failed: " << ::GetLastError() << std::endl;
+		return -1;
+	}
 
-	svr.register_error_handler([](const network::session_ptr &session, const std::string &msg)
+	network::server svr(port);
+
+	try
 	{
-		std::cout << msg << std::endl;
-	});
+		// Լ룬رϵͳԤ
+		filesystem::file_engine_t file(svr.io(), path,
+			filesystem::file_engine_t::READ | filesystem::file_engine_t::DIRECT | filesystem::file_engine_t::RANDOM);
+
+		filesystem::block_cache_config_t config;
+		config.capacity_ = static_cast<std::uint32_t>(cache_size * 1024ull * 1024 / config.block_size_);
+		disk_cache.reset(new filesystem::block_cache_t(file, config));
+		disk_sectors = file.size() / VDISK_SECTOR_SIZE;
+
+		std::cout << "image " << disk_sectors << " sectors, cache " << config.capacity_ << " blocks, port " << port << std::endl;
+
+		svr.register_accept_handler([](const network::session_ptr &session, const std::string &ip)->bool
+		{
+			std::allocator<session_buffer_ptr> allocator;
+			session->additional_data(std::make_shared<session_buffer_t>(), allocator);
+			read(session);
+
+			return true;
+		});
+
+		svr.register_disconnect_handler([](const network::session_ptr &session)
+		{
+			std::cout << "session leave" << std::endl;
+		});
+
+		svr.register_error_handler([](const network::session_ptr &session, const std::string &msg)
+		{
+			std::cout << msg << std::endl;
+		});
+
+		svr.start();
+		std::cin.get();
+
+		// ʱȴδɵĶIOֹ֮߳ͣǰ
+		auto sessions = svr.sessions();
+		std::for_each(sessions.begin(), sessions.end(), [](const network::session_ptr &session)
+		{
+			session->disconnect();
+		});
+
+		const filesystem::block_cache_stats_t stats = disk_cache->stats();
+		std::cout << "hits " << stats.hits_ << ", misses " << stats.misses_ << ", joined " << stats.joined_
+			<< ", readahead " << stats.readahead_ << "/" << stats.readahead_hits_
+			<< ", evictions " << stats.evictions_ << ", errors " << stats.errors_ << std::endl;
+
+		disk_cache.reset();
+	}
+	catch(exception::exception_base &e)
+	{
+		e.dump();
+		std::cerr << e.what() << std::endl;
+	}
 
-	svr.start();
-	std::cin.get();
 	svr.stop();
 
-    return 0;
+	return 0;
 }
-
@@ -0,0 +1,301 @@
+// websocket_test.cpp : WebSocket echo benchmark, reports msg/s and p50/p99 latency
+//
+
+#include "stdafx.h"
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "../../../include/async_io/http/http_server.hpp"
+#include "../../../include/async_io/websocket/websocket_server.hpp"
+#include "../../../include/memory_pool/sgi_memory_pool.hpp"
+
+#ifdef min
+#undef min
+#endif
+
+
+using namespace async;
+
+
+const std::uint16_t PORT = 5170;
+
+memory_pool::mt_memory_pool pool;
+
+std::uint64_t now_us()
+{
+	static LARGE_INTEGER freq = {0};
+	if( freq.QuadPart == 0 )
+		::QueryPerformanceFrequency(&freq);
+
+	LARGE_INTEGER counter = {0};
+	::QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000000 / freq.QuadPart;
+}
+
+// ͻ֡
+std::string client_frame(websocket::opcode_t opcode, const std::string &payload)
+{
+	static const char key[4] = { 0x12, 0x34, 0x56, 0x78 };
+
+	char header[websocket::MAX_HEADER_SIZE] = {0};
+	const std::uint32_t size = websocket::encode_header(header, opcode, true, payload.size());
+	header[1] |= 0x80;
+
+	std::string frame(header, size);
+	frame.append(key, sizeof(key));
+
+	std::string masked = payload;
+	if( !masked.empty() )
+		websocket::apply_mask(&masked[0], masked.size(), key);
+	frame.append(masked);
+
+	return frame;
+}
+
+
+// ÿηdepthϢȫٷһ
+struct connection_t
+{
+	network::client client_;
+	std::atomic<bool> &running_;
+	std::atomic<std::uint32_t> &outstanding_;
+
+	std::string frames_;
+	std::uint32_t depth_;
+	std::uint32_t left_;
+
+	std::vector<char> buffer_;
+	std::size_t begin_;
+	std::size_t end_;
+	websocket::frame_decoder_t decoder_;
+
+	std::uint64_t start_;
+	std::uint64_t failed_;
+	std::vector<std::uint32_t> latencies_;
+
+	connection_t(service::io_dispatcher_t &io, const std::string &payload, std::uint32_t depth,
+		std::atomic<bool> &running, std::atomic<std::uint32_t> &outstanding)
+		: client_(io)
+		, running_(running)
+		, outstanding_(outstanding)
+		, depth_(depth)
+		, left_(0)
+		, buffer_(256 * 1024)
+		, begin_(0)
+		, end_(0)
+		, decoder_(websocket::frame_decoder_t::DEFAULT_MAX_MESSAGE, false)
+		, start_(0)
+		, failed_(0)
+	{
+		const std::string frame = client_frame(websocket::OP_BINARY, payload);
+		for(std::uint32_t i = 0; i != depth; ++i)
+			frames_.append(frame);
+
+		latencies_.reserve(1024 * 1024);
+
+		client_.register_disconnect_handler([this]()
+		{
+			if( left_ != 0 )
+			{
+				++failed_;
+				left_ = 0;
+				--outstanding_;
+			}
+		});
+	}
+
+	bool handshake(const std::string &ip)
+	{
+		const std::string request = "GET /echo HTTP/1.1\r\nHost: " + ip + "\r\n"
+			"Upgrade: websocket\r\nConnection: Upgrade\r\n"
+			"Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+		if( !client_.send(request.data(), static_cast<std::uint32_t>(request.size())) )
+			return false;
+
+		std::string response;
+		while( response.size() < 4 || response.compare(response.size() - 4, 4, "\r\n\r\n") != 0 )
+		{
+			char c = 0;
+			if( !client_.recv(&c, 1) )
+				return false;
+			response.push_back(c);
+		}
+
+		return response.compare(0, 12, "HTTP/1.1 101") == 0
+			&& response.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") != std::string::npos;
+	}
+
+	void send()
+	{
+		++outstanding_;
+
+		left_ = depth_;
+		start_ = now_us();
+		client_.async_send(service::const_buffer_t(frames_.data(), frames_.size()), [](std::uint32_t){}, pool);
+		read();
+	}
+
+	void read()
+	{
+		if( begin_ != 0 )
+		{
+			std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+			end_ -= begin_;
+			begin_ = 0;
+		}
+
+		service::mutable_buffer_t buf(buffer_.data() + end_, buffer_.size() - end_);
+		client_.async_read_some(buf, 0, [this](std::uint32_t size)
+		{
+			end_ += size;
+			on_read();
+		}, pool);
+	}
+
+	void on_read()
+	{
+		while( begin_ != end_ )
+		{
+			websocket::frame_decoder_t::frame_t frame;
+			std::size_t consumed = 0;
+
+			const auto ret = decoder_.decode(buffer_.data() + begin_, end_ - begin_, frame, consumed);
+			if( ret == websocket::frame_decoder_t::DECODE_MORE )
+				break;
+			if( ret == websocket::frame_decoder_t::DECODE_ERROR )
+			{
+				client_.disconnect();
+				return;
+			}
+
+			begin_ += consumed;
+			if( ret == websocket::frame_decoder_t::DECODE_MESSAGE )
+			{
+				latencies_.push_back(static_cast<std::uint32_t>(now_us() - start_));
+				--left_;
+			}
+		}
+
+		if( left_ != 0 )
+		{
+			read();
+			return;
+		}
+
+		--outstanding_;
+		if( running_ )
+			send();
+	}
+};
+
+
+void websocket_bench(std::uint32_t connections, std::uint32_t depth, std::uint32_t payload_size, std::uint32_t seconds)
+{
+	service::io_dispatcher_t io([](const std::string &msg)
+	{
+		std::cerr << msg << std::endl;
+	});
+
+	std::atomic<bool> running(true);
+	std::atomic<std::uint32_t> outstanding(0);
+	const std::string payload(payload_size, 'x');
+
+	std::vector<std::unique_ptr<connection_t>> conns;
+	for(std::uint32_t i = 0; i != connections; ++i)
+	{
+		conns.emplace_back(new connection_t(io, payload, depth, running, outstanding));
+		if( !conns.back()->client_.start("127.0.0.1", PORT) || !conns.back()->handshake("127.0.0.1") )
+		{
+			std::cerr << "handshake failed" << std::endl;
+			return;
+		}
+	}
+
+	const std::uint64_t start = now_us();
+	for(auto &conn : conns)
+		conn->send();
+
+	::Sleep(seconds * 1000);
+	running = false;
+
+	while( outstanding != 0 )
+		::Sleep(10);
+	const std::uint64_t elapsed = now_us() - start;
+
+	std::vector<std::uint32_t> latencies;
+	std::uint64_t failed = 0;
+	for(auto &conn : conns)
+	{
+		latencies.insert(latencies.end(), conn->latencies_.begin(), conn->latencies_.end());
+		failed += conn->failed_;
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	std::cout << "connections: " << connections << " depth: " << depth << " payload: " << payload_size << std::endl;
+	if( !latencies.empty() )
+	{
+		std::cout << "messages: " << latencies.size() << " failed batches: " << failed << std::endl;
+		std::cout << "msg/s: " << latencies.size() * 1000000 / elapsed << std::endl;
+		std::cout << "p50: " << latencies[latencies.size() / 2] << "us"
+			<< " p99: " << latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] << "us"
+			<< " max: " << latencies.back() << "us" << std::endl;
+	}
+
+	for(auto &conn : conns)
+		conn->client_.stop();
+
+	io.stop();
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	network::server svr(PORT);
+
+	// ԣֻڻصЧҪ
+	websocket::server_t ws_svr(svr.io(), [](const websocket::connection_ptr &connection, websocket::opcode_t opcode, const websocket::view_t &payload)
+	{
+		std::string data(payload.data(), payload.size());
+		if( opcode == websocket::OP_TEXT )
+			connection->send_text(std::move(data));
+		else
+			connection->send_binary(std::move(data));
+	}, 5000);
+
+	std::atomic<std::uint32_t> opened(0), closed(0);
+	ws_svr.register_open_handler([&opened](const websocket::connection_ptr &)
+	{
+		++opened;
+	});
+	ws_svr.register_close_handler([&closed](const websocket::connection_ptr &, std::uint16_t)
+	{
+		++closed;
+	});
+
+	http::server_t http_svr([&ws_svr](const http::request_t &req, http::response_t &resp)
+	{
+		if( !ws_svr.upgrade(req, resp) )
+			http::stock_response(resp, 404);
+	});
+	http_svr.attach(svr);
+	svr.start();
+
+	websocket_bench(16, 1, 64, 10);
+	websocket_bench(16, 64, 64, 10);
+	websocket_bench(16, 16, 64 * 1024, 10);
+
+	// ȴ˵ȫر
+	::Sleep(1000);
+	std::cout << "opened: " << opened << " closed: " << closed << std::endl;
+
+	svr.stop();
+
+	system("pause");
+	return 0;
+}